@@ -0,0 +1,44 @@
+// bench.h —— 统一基准驱动（bench/okcolor_bench.c）与各内核垫片之间的约定
+// 每个垫片以 OKCOLOR_EMBED 直接 #include 对应的 .c，从而能在同一编译单元里调用其 static 内核，
+// 并导出一张以 {NULL} 结尾的用例表。
+
+#ifndef OKCOLOR_BENCH_H
+#define OKCOLOR_BENCH_H
+
+#include <stddef.h>
+
+typedef struct
+{
+  const char *name;
+  // 一次性准备输入（不计时，可为 NULL）
+  void (*setup)(void);
+  // 执行 iters 次操作；返回汇总值，驱动会累加它以防循环被优化掉
+  double (*run)(size_t iters);
+  // 每次操作处理的字节数（非 0 时额外报告 MB/s）
+  size_t bytes;
+} BenchCase;
+
+extern const BenchCase bench_oklch2rgb_cases[];
+extern const BenchCase bench_rgb2oklch_cases[];
+extern const BenchCase bench_extract_cases[];
+extern const BenchCase bench_squircle_cases[];
+extern const BenchCase bench_css_cases[];
+extern const BenchCase bench_palette_index_cases[];
+
+// 伪随机输入（各垫片共用，保证跨运行可复现）
+static inline unsigned bench_rand(unsigned *s)
+{
+  unsigned x = *s;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *s = x;
+  return x;
+}
+
+static inline double bench_unit(unsigned *s)
+{
+  return (double)bench_rand(s) * (1.0 / 4294967295.0);
+}
+
+#endif // OKCOLOR_BENCH_H
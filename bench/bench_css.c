@@ -0,0 +1,169 @@
+// css_color.h 编解码吞吐基准（一次操作 = 处理整块约 1 MiB 的文本）
+#include "../css_color.h"
+#include "bench.h"
+
+#define CSS_BUF_BYTES (1u << 20)
+#define FMT_COLORS 32768
+
+static char *s_css = NULL;  // 混合 #hex / rgb() / oklch() 行
+static char *s_nums = NULL; // "R G B" 纯数值行
+static size_t s_css_len = 0, s_nums_len = 0;
+static double s_lch[FMT_COLORS * 3];
+static uint8_t s_rgb[FMT_COLORS * 3];
+static char *s_fmt = NULL;
+
+// 生成恰好 CSS_BUF_BYTES 字节的文本（末尾以空白行补齐），使每次操作的字节数固定
+static char *fill_lines(int css, size_t *len)
+{
+  char *buf = (char *)malloc(CSS_BUF_BYTES + 1);
+  unsigned seed = css ? 0xc55u : 0x4e5u;
+  size_t n = 0;
+  for (;;)
+  {
+    char line[96];
+    unsigned v = bench_rand(&seed);
+    int r = v & 255, g = (v >> 8) & 255, b = (v >> 16) & 255;
+    int k;
+    if (!css)
+      k = snprintf(line, sizeof line, "%d %d %d.%u\n", r, g, b / 2, v >> 28);
+    else if (v % 3 == 0)
+      k = snprintf(line, sizeof line, "#%02x%02x%02x\n", r, g, b);
+    else if (v % 3 == 1)
+      k = snprintf(line, sizeof line, "rgb(%d %d %d / %d%%)\n", r, g, b, (int)(v >> 25));
+    else
+      k = snprintf(line, sizeof line, "oklch(%.1f%% %.4f %.2f)\n", bench_unit(&seed) * 100.0,
+                   bench_unit(&seed) * 0.37, bench_unit(&seed) * 360.0);
+    if (n + (size_t)k > CSS_BUF_BYTES)
+      break;
+    memcpy(buf + n, line, (size_t)k);
+    n += (size_t)k;
+  }
+  memset(buf + n, '\n', CSS_BUF_BYTES - n);
+  buf[CSS_BUF_BYTES] = '\0';
+  *len = CSS_BUF_BYTES;
+  return buf;
+}
+
+static void setup_css(void)
+{
+  if (s_css)
+    return;
+  s_css = fill_lines(1, &s_css_len);
+  s_nums = fill_lines(0, &s_nums_len);
+  unsigned seed = 0xf0f0u;
+  for (int i = 0; i < FMT_COLORS; ++i)
+  {
+    s_lch[i * 3 + 0] = bench_unit(&seed);
+    s_lch[i * 3 + 1] = bench_unit(&seed) * 0.37;
+    s_lch[i * 3 + 2] = bench_unit(&seed) * 360.0;
+    unsigned v = bench_rand(&seed);
+    s_rgb[i * 3 + 0] = (uint8_t)v;
+    s_rgb[i * 3 + 1] = (uint8_t)(v >> 8);
+    s_rgb[i * 3 + 2] = (uint8_t)(v >> 16);
+  }
+  s_fmt = (char *)malloc((size_t)FMT_COLORS * 64);
+}
+
+static double run_parse_css(size_t iters)
+{
+  double acc = 0.0;
+  const char *end = s_css + s_css_len;
+  for (size_t it = 0; it < iters; ++it)
+  {
+    const char *p = s_css;
+    while (p < end)
+    {
+      const char *nl = (const char *)memchr(p, '\n', (size_t)(end - p));
+      CssColor c;
+      if (nl != p && css_parse_color(p, nl, &c))
+        acc += c.v[0];
+      p = nl + 1;
+    }
+  }
+  return acc;
+}
+
+static double run_parse_numbers(size_t iters)
+{
+  double acc = 0.0;
+  const char *end = s_nums + s_nums_len;
+  for (size_t it = 0; it < iters; ++it)
+  {
+    const char *p = s_nums;
+    double v;
+    for (;;)
+    {
+      p = css_skip_space(p, end);
+      if (p >= end || !css_parse_number(&p, end, &v))
+        break;
+      acc += v;
+    }
+  }
+  return acc;
+}
+
+// 对照：同一输入用 strtod 解析（批量模式改造前的做法）
+static double run_parse_numbers_strtod(size_t iters)
+{
+  double acc = 0.0;
+  for (size_t it = 0; it < iters; ++it)
+  {
+    const char *p = s_nums;
+    for (;;)
+    {
+      char *e;
+      double v = strtod(p, &e);
+      if (e == p)
+        break;
+      acc += v;
+      p = e;
+    }
+  }
+  return acc;
+}
+
+static double run_format(size_t iters)
+{
+  double acc = 0.0;
+  for (size_t it = 0; it < iters; ++it)
+  {
+    char *t = s_fmt;
+    for (int i = 0; i < FMT_COLORS; ++i)
+    {
+      t = css_format_hex(t, s_rgb + i * 3, 1.0);
+      *t++ = '\n';
+      t = css_format_oklch(t, s_lch[i * 3], s_lch[i * 3 + 1], s_lch[i * 3 + 2], 1.0);
+      *t++ = '\n';
+    }
+    acc += (double)(t - s_fmt);
+  }
+  return acc;
+}
+
+// 对照：同样的输出用 snprintf 生成
+static double run_format_snprintf(size_t iters)
+{
+  double acc = 0.0;
+  for (size_t it = 0; it < iters; ++it)
+  {
+    char *t = s_fmt;
+    for (int i = 0; i < FMT_COLORS; ++i)
+    {
+      const uint8_t *c = s_rgb + i * 3;
+      t += sprintf(t, "#%02x%02x%02x\noklch(%.6f %.6f %.6f)\n", c[0], c[1], c[2], s_lch[i * 3], s_lch[i * 3 + 1],
+                   s_lch[i * 3 + 2]);
+    }
+    acc += (double)(t - s_fmt);
+  }
+  return acc;
+}
+
+// 序列化用例的字节数取平均输出长度（#rrggbb + oklch(L C h) 两行约 40 字节/色）
+const BenchCase bench_css_cases[] = {
+    {"css/parse_colors", setup_css, run_parse_css, CSS_BUF_BYTES},
+    {"css/parse_numbers", setup_css, run_parse_numbers, CSS_BUF_BYTES},
+    {"css/parse_numbers_strtod", setup_css, run_parse_numbers_strtod, CSS_BUF_BYTES},
+    {"css/format", setup_css, run_format, (size_t)FMT_COLORS * 40},
+    {"css/format_snprintf", setup_css, run_format_snprintf, (size_t)FMT_COLORS * 40},
+    {NULL, NULL, NULL, 0},
+};
@@ -0,0 +1,296 @@
+// extract-colors.c 各阶段基准垫片（一次操作 = 对 1024×1024 合成图执行一次该阶段）
+#define OKCOLOR_EMBED 1
+#include "../extract-colors.c"
+#include "bench.h"
+
+#define IMG_W 1024
+#define IMG_H 1024
+#define K_COLORS 16
+
+static uint8_t *s_img = NULL;
+static int s_step = 1;
+static unsigned s_counts[EC_QSIZE];
+static RGBf *s_samples = NULL;
+static float *s_weights = NULL;
+static int s_n = 0;
+static Cluster s_init[K_COLORS];
+static Cluster s_final[K_COLORS];
+static Options s_opt;
+
+// 平滑渐变叠加噪声，量化后约数千个非零桶，接近真实照片
+static void setup_extract(void)
+{
+  if (s_img)
+    return;
+  s_img = (uint8_t *)malloc((size_t)IMG_W * IMG_H * 4);
+  unsigned seed = 0x13579bdu;
+  for (int y = 0; y < IMG_H; ++y)
+    for (int x = 0; x < IMG_W; ++x)
+    {
+      uint8_t *p = s_img + ((size_t)y * IMG_W + x) * 4;
+      unsigned n = bench_rand(&seed);
+      p[0] = (uint8_t)((x * 255 / IMG_W + (n & 15)) & 255);
+      p[1] = (uint8_t)((y * 255 / IMG_H + ((n >> 4) & 15)) & 255);
+      p[2] = (uint8_t)(((x + y) * 127 / IMG_W + ((n >> 8) & 31)) & 255);
+      p[3] = 255;
+    }
+  s_opt.pixels = 64000;
+  s_opt.distance = 0.22;
+  s_opt.satDist = 0.2;
+  s_opt.lightDist = 0.2;
+  s_opt.hueDist = 1.0 / 12.0;
+  s_opt.alphaThreshold = 250;
+  s_opt.maxColors = K_COLORS;
+  s_step = compute_sample_step(IMG_W, IMG_H, s_opt.pixels);
+
+  // 预先跑一遍各阶段，后续每个用例只计时自己的阶段
+  memset(s_counts, 0, sizeof s_counts);
+  hist_accumulate_rows(s_counts, s_img, IMG_W, IMG_H, (size_t)IMG_W * 4, s_step, s_step, s_opt.alphaThreshold);
+  s_n = hist_export_weighted_samples(s_counts, &s_samples, &s_weights);
+  EcRng rng;
+  ec_rng_seed(&rng, 1);
+  kmeans_pp_init_weighted(s_samples, s_weights, s_n, s_init, K_COLORS, &rng);
+  memcpy(s_final, s_init, sizeof s_init);
+  kmeans_run_weighted(s_samples, s_weights, s_n, s_final, K_COLORS, 12);
+}
+
+static double run_histogram(size_t iters)
+{
+  double acc = 0.0;
+  for (size_t i = 0; i < iters; ++i)
+  {
+    memset(s_counts, 0, sizeof s_counts);
+    hist_accumulate_rows(s_counts, s_img, IMG_W, IMG_H, (size_t)IMG_W * 4, s_step, s_step, s_opt.alphaThreshold);
+    acc += s_counts[i & (EC_QSIZE - 1)];
+  }
+  return acc;
+}
+
+static double run_export(size_t iters)
+{
+  double acc = 0.0;
+  for (size_t i = 0; i < iters; ++i)
+  {
+    RGBf *smp = NULL;
+    float *w = NULL;
+    acc += hist_export_weighted_samples(s_counts, &smp, &w);
+    free(smp);
+    free(w);
+  }
+  return acc;
+}
+
+static double run_kmeans_pp(size_t iters)
+{
+  double acc = 0.0;
+  Cluster c[K_COLORS];
+  EcRng rng;
+  ec_rng_seed(&rng, 1);
+  for (size_t i = 0; i < iters; ++i)
+  {
+    kmeans_pp_init_weighted(s_samples, s_weights, s_n, c, K_COLORS, &rng);
+    acc += c[K_COLORS - 1].color.r;
+  }
+  return acc;
+}
+
+static double run_kmeans(size_t iters)
+{
+  double acc = 0.0;
+  Cluster c[K_COLORS];
+  for (size_t i = 0; i < iters; ++i)
+  {
+    memcpy(c, s_init, sizeof c);
+    kmeans_run_weighted(s_samples, s_weights, s_n, c, K_COLORS, 12);
+    acc += c[0].weight;
+  }
+  return acc;
+}
+
+static double run_merge(size_t iters)
+{
+  double acc = 0.0;
+  double totalW = 0.0;
+  for (int k = 0; k < K_COLORS; ++k)
+    totalW += s_final[k].weight;
+  for (size_t i = 0; i < iters; ++i)
+  {
+    ColorAgg *agg = NULL;
+    int m = 0;
+    merge_colors(s_final, K_COLORS, totalW, &s_opt, &agg, &m);
+    acc += m;
+    free(agg);
+  }
+  return acc;
+}
+
+static double run_end_to_end(size_t iters)
+{
+  double acc = 0.0;
+  okc_color out[K_COLORS];
+  okc_extract_options o;
+  okc_extract_options_default(&o);
+  for (size_t i = 0; i < iters; ++i)
+    acc += okc_extract_colors(s_img, IMG_W, IMG_H, &o, out, K_COLORS);
+  return acc;
+}
+
+// NV12 帧直接累加直方图（同 extract/histogram 的采样点数），对比先转 RGBA 的旧路径
+static uint8_t *s_nv12 = NULL;
+
+static void setup_nv12(void)
+{
+  setup_extract();
+  if (s_nv12)
+    return;
+  s_nv12 = (uint8_t *)malloc((size_t)IMG_W * IMG_H * 3 / 2);
+  unsigned seed = 0x2468aceu;
+  for (size_t i = 0; i < (size_t)IMG_W * IMG_H * 3 / 2; ++i)
+    s_nv12[i] = (uint8_t)(bench_rand(&seed) >> 8);
+}
+
+static double run_histogram_nv12(size_t iters)
+{
+  YuvFrame f = {s_nv12, s_nv12 + (size_t)IMG_W * IMG_H, NULL, IMG_W, IMG_W, 1, 0, 0, IMG_W, IMG_H};
+  yuv_frame_layout(&f, YUV_NV12);
+  double acc = 0.0;
+  for (size_t i = 0; i < iters; ++i)
+  {
+    YuvTables t;
+    yuv_tables_init(&t, 0);
+    memset(s_counts, 0, sizeof s_counts);
+    hist_accumulate_yuv(s_counts, &f, &t, 0, IMG_H, s_step, s_step);
+    acc += s_counts[i & (EC_QSIZE - 1)];
+  }
+  return acc;
+}
+
+// 调色板图：8 位下标直接计数并导出样本（同 extract/histogram + export_samples 的工作量）
+static uint8_t *s_indices = NULL;
+static uint8_t s_palette[256 * 4];
+
+static void setup_indexed(void)
+{
+  setup_extract();
+  if (s_indices)
+    return;
+  s_indices = (uint8_t *)malloc((size_t)IMG_W * IMG_H);
+  unsigned seed = 0x1357bdfu;
+  for (size_t i = 0; i < (size_t)IMG_W * IMG_H; ++i)
+    s_indices[i] = (uint8_t)(bench_rand(&seed) >> 8);
+  for (int i = 0; i < 256 * 4; ++i)
+    s_palette[i] = (i & 3) == 3 ? 255 : (uint8_t)(bench_rand(&seed) >> 8);
+}
+
+static double run_histogram_indexed(size_t iters)
+{
+  double acc = 0.0;
+  for (size_t i = 0; i < iters; ++i)
+  {
+    unsigned counts[EC_MAX_PALETTE] = {0};
+    hist_accumulate_indexed(counts, s_indices, IMG_W, IMG_H, IMG_W, 8, s_step, s_step);
+    RGBf *samples = NULL;
+    float *weights = NULL;
+    acc += indexed_export_weighted_samples(counts, s_palette, 256, 250, &samples, &weights);
+    free(samples);
+    free(weights);
+  }
+  return acc;
+}
+
+// 取色会话只改合并阈值（滑块拖动）：采样与聚类沿用，只重新合并
+static double run_session_merge(size_t iters)
+{
+  static ExtractSession s;
+  Options o = s_opt;
+  session_begin(&s, s_img, IMG_W, IMG_H);
+  session_run(&s, &o);
+  double acc = 0.0;
+  for (size_t i = 0; i < iters; ++i)
+  {
+    o.distance = (i & 1) ? 0.22 : 0.2;
+    session_run(&s, &o);
+    acc += s.m;
+  }
+  session_release(&s);
+  return acc;
+}
+
+// 全部 K：建一次层次树（至多 64 簇）；再取某个 K 的调色板（「颜色数」滑块每个位置的开销）
+static double run_hierarchy_build(size_t iters)
+{
+  static ColorHierarchy hc;
+  double acc = 0.0;
+  for (size_t i = 0; i < iters; ++i)
+  {
+    hierarchy_build_rgba(&hc, s_img, IMG_W, IMG_H, &s_opt, HIER_MAX_K);
+    acc += hc.levels;
+  }
+  return acc;
+}
+
+static double run_hierarchy_palette(size_t iters)
+{
+  static ColorHierarchy hc;
+  if (!hc.levels)
+    hierarchy_build_rgba(&hc, s_img, IMG_W, IMG_H, &s_opt, HIER_MAX_K);
+  double acc = 0.0;
+  for (size_t i = 0; i < iters; ++i)
+  {
+    ColorAgg *agg = NULL;
+    int m = 0;
+    hierarchy_palette(&hc, 1 + (int)(i % (size_t)hc.levels), &s_opt, &agg, &m);
+    acc += m;
+    free(agg);
+  }
+  return acc;
+}
+
+// 渐进取色的第一级（交互预览的首帧延迟）：约 1/64 的样本、热启动前的 k-means++ 与 PROG_ITERS 次迭代
+static double run_progressive_first(size_t iters)
+{
+  static unsigned counts[EC_QSIZE];
+  double acc = 0.0;
+  ProgressiveExtract pe = {0};
+  for (size_t i = 0; i < iters; ++i)
+  {
+    progressive_begin(&pe, counts, s_img, IMG_W, IMG_H, (size_t)IMG_W * 4, &s_opt);
+    progressive_stage(&pe);
+    acc += pe.best_m;
+  }
+  progressive_release(&pe);
+  return acc;
+}
+
+// 渐进取色走完全部级数（与 end_to_end 对比加密的额外开销）
+static double run_progressive_all(size_t iters)
+{
+  static unsigned counts[EC_QSIZE];
+  double acc = 0.0;
+  ProgressiveExtract pe = {0};
+  for (size_t i = 0; i < iters; ++i)
+  {
+    progressive_begin(&pe, counts, s_img, IMG_W, IMG_H, (size_t)IMG_W * 4, &s_opt);
+    progressive_run(&pe, 1e12);
+    acc += pe.best_m;
+  }
+  progressive_release(&pe);
+  return acc;
+}
+
+const BenchCase bench_extract_cases[] = {
+    {"extract/histogram", setup_extract, run_histogram},
+    {"extract/histogram_nv12", setup_nv12, run_histogram_nv12},
+    {"extract/histogram_indexed", setup_indexed, run_histogram_indexed},
+    {"extract/export_samples", setup_extract, run_export},
+    {"extract/kmeans_pp_init", setup_extract, run_kmeans_pp},
+    {"extract/kmeans_run", setup_extract, run_kmeans},
+    {"extract/merge_colors", setup_extract, run_merge},
+    {"extract/end_to_end", setup_extract, run_end_to_end},
+    {"extract/progressive_first", setup_extract, run_progressive_first},
+    {"extract/progressive_all", setup_extract, run_progressive_all},
+    {"extract/session_merge", setup_extract, run_session_merge},
+    {"extract/hierarchy_build", setup_extract, run_hierarchy_build},
+    {"extract/hierarchy_palette", setup_extract, run_hierarchy_palette},
+    {NULL, NULL, NULL},
+};
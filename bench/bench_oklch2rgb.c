@@ -0,0 +1,197 @@
+// oklch2rgb.c 内核基准垫片
+#define OKCOLOR_EMBED 1
+#include "../oklch2rgb.c"
+#include "bench.h"
+
+#define N_INPUTS 4096 // 2 的幂，循环取模用位与
+
+static double s_L[N_INPUTS], s_C[N_INPUTS], s_h[N_INPUTS], s_ch[N_INPUTS], s_sh[N_INPUTS];
+
+static void setup_inputs(void)
+{
+  unsigned seed = 0x1234567u;
+  for (int i = 0; i < N_INPUTS; ++i)
+  {
+    s_L[i] = bench_unit(&seed);
+    s_C[i] = 0.4 * bench_unit(&seed); // 约半数超出 sRGB，覆盖二分路径
+    s_h[i] = 360.0 * bench_unit(&seed);
+    polar_sincos_deg(s_h[i], &s_sh[i], &s_ch[i]);
+  }
+}
+
+static double run_linear_fast(size_t iters)
+{
+  double acc = 0.0;
+  for (size_t i = 0; i < iters; ++i)
+  {
+    size_t k = i & (N_INPUTS - 1);
+    double r, g, b;
+    oklch_to_linear_rgb_fast(s_L[k], s_C[k], s_ch[k], s_sh[k], &r, &g, &b);
+    acc += r + g + b;
+  }
+  return acc;
+}
+
+static double run_gamut_safe(size_t iters)
+{
+  double acc = 0.0;
+  for (size_t i = 0; i < iters; ++i)
+  {
+    size_t k = i & (N_INPUTS - 1);
+    acc += find_gamut_safe_chroma(s_L[k], s_C[k], s_h[k]);
+  }
+  return acc;
+}
+
+static double run_gamut_safe8(size_t iters)
+{
+  double acc = 0.0;
+  for (size_t i = 0; i < iters; ++i)
+  {
+    size_t k = i & (N_INPUTS - 1);
+    acc += find_gamut_safe_chroma8(s_L[k], s_C[k], s_h[k]);
+  }
+  return acc;
+}
+
+static double run_max_chroma(size_t iters)
+{
+  double acc = 0.0;
+  for (size_t i = 0; i < iters; ++i)
+  {
+    size_t k = i & (N_INPUTS - 1);
+    acc += max_chroma_for_srgb(s_L[k], s_h[k]);
+  }
+  return acc;
+}
+
+static double run_rgb8(size_t iters)
+{
+  double acc = 0.0;
+  uint8_t o[3];
+  for (size_t i = 0; i < iters; ++i)
+  {
+    size_t k = i & (N_INPUTS - 1);
+    oklch_to_rgb8(s_L[k], s_C[k], s_h[k], 0, 0.0, o);
+    acc += o[0] + o[1] + o[2];
+  }
+  return acc;
+}
+
+// 批量：一次操作 = 4096 个 [L, C, h] 经按 CPU 分派的批量内核（块内先向量化求 sincos）转为 8 位 sRGB
+static double s_batch_in[N_INPUTS * 3];
+static uint8_t s_batch_out[N_INPUTS * 3];
+
+static void setup_batch(void)
+{
+  setup_inputs();
+  for (int i = 0; i < N_INPUTS; ++i)
+  {
+    s_batch_in[i * 3 + 0] = s_L[i];
+    s_batch_in[i * 3 + 1] = s_C[i];
+    s_batch_in[i * 3 + 2] = s_h[i];
+  }
+}
+
+static double run_rgb8_batch(size_t iters)
+{
+  double acc = 0.0;
+  for (size_t i = 0; i < iters; ++i)
+  {
+    g_oklch8_batch(s_batch_in, N_INPUTS, 0, s_batch_out);
+    acc += s_batch_out[(i * 3) % (N_INPUTS * 3)];
+  }
+  return acc;
+}
+
+// 取色器切片：一次操作 = 一帧 512×512 L×C 平面（单线程，带 mask），每帧换一个色相模拟拖动滑块
+static uint8_t *s_slice = NULL, *s_slice_mask = NULL;
+
+static void setup_slice(void)
+{
+  if (!s_slice)
+  {
+    s_slice = (uint8_t *)malloc(512 * 512 * 4);
+    s_slice_mask = (uint8_t *)malloc(512 * 512);
+  }
+}
+
+static double run_slice_lc(size_t iters)
+{
+  double acc = 0.0;
+  for (size_t i = 0; i < iters; ++i)
+  {
+    render_slice(SLICE_LC, (double)(i % 360), 0.37, 512, 512, 0, 1, s_slice, s_slice_mask);
+    acc += s_slice[(i * 4099) & (512 * 512 * 4 - 1)];
+  }
+  return acc;
+}
+
+// 渐变：一次操作 = 一幅 1024×1024 锥形渐变（含 4096 项查表构建），带蓝噪声抖动，单线程
+static uint8_t *s_grad = NULL;
+static const GradientStop s_grad_stops[3] = {{0.0, 0.45, 0.15, 20.0, 1.0}, {0.5, 0.8, 0.12, 140.0, 1.0},
+                                             {1.0, 0.45, 0.15, 380.0, 1.0}};
+
+static void setup_gradient(void)
+{
+  if (!s_grad)
+    s_grad = (uint8_t *)malloc(1024 * 1024 * 4);
+  ensure_blue_noise();
+}
+
+static double run_gradient_conic(size_t iters)
+{
+  double acc = 0.0;
+  for (size_t i = 0; i < iters; ++i)
+  {
+    GradientDef def = {GRAD_CONIC, 0, 0, 1, 512.0, 512.0, 0.0, 0.0, 0.0, (double)(i % 360)};
+    render_gradient(&def, s_grad_stops, 3, 1024, 1024, 1, s_grad);
+    acc += s_grad[(i * 4099) & (1024 * 1024 * 4 - 1)];
+  }
+  return acc;
+}
+
+// 色域映射：一次操作 = 一幅 1024×1024 Display-P3 图（红绿平面 + 对角蓝，约 37% 像素在 sRGB 之外），单线程；
+// 每次调用新建颜色缓存，计入冷启动开销
+static uint8_t *s_p3_src = NULL, *s_p3_dst = NULL;
+
+static void setup_gamut_map(void)
+{
+  if (s_p3_src)
+    return;
+  s_p3_src = (uint8_t *)malloc(1024 * 1024 * 4);
+  s_p3_dst = (uint8_t *)malloc(1024 * 1024 * 4);
+  for (int y = 0; y < 1024; ++y)
+    for (int x = 0; x < 1024; ++x)
+    {
+      uint8_t *p = s_p3_src + ((size_t)y * 1024 + x) * 4;
+      p[0] = (uint8_t)(x >> 2);
+      p[1] = (uint8_t)(y >> 2);
+      p[2] = (uint8_t)((x + y) >> 3);
+      p[3] = 255;
+    }
+}
+
+static double run_gamut_map_p3(size_t iters)
+{
+  double acc = 0.0;
+  for (size_t i = 0; i < iters; ++i)
+  {
+    acc += (double)gamut_map_image(s_p3_src, s_p3_dst, 1024, 1024, 1, NULL);
+    acc += s_p3_dst[(i * 4099) & (1024 * 1024 * 4 - 1)];
+  }
+  return acc;
+}
+
+const BenchCase bench_oklch2rgb_cases[] = {
+    {"oklch_to_linear_rgb_fast", setup_inputs, run_linear_fast},
+    {"find_gamut_safe_chroma", setup_inputs, run_gamut_safe},
+    {"find_gamut_safe_chroma8", setup_inputs, run_gamut_safe8},
+    {"max_chroma_for_srgb", setup_inputs, run_max_chroma},
+    {"oklch_to_rgb8", setup_inputs, run_rgb8},
+    {"oklch_to_rgb8_batch_4k", setup_batch, run_rgb8_batch, N_INPUTS * 3 * 8},
+    {"slice_lc_512", setup_slice, run_slice_lc, 512 * 512 * 4},
+    {"gradient_conic_1024", setup_gradient, run_gradient_conic, 1024 * 1024 * 4},
+    {"gamut_map_p3_1024", setup_gamut_map, run_gamut_map_p3, 1024 * 1024 * 4},
+    {NULL, NULL, NULL},
+};
@@ -0,0 +1,65 @@
+// palette_index.c 查询基准垫片：内存里的 100k 条签名（不经 mmap），单线程扫描取 top-10
+#define OKCOLOR_EMBED 1
+#include "../palette_index.c"
+#include "bench.h"
+
+#define N_SIGS 100000
+
+static uint8_t *s_sigs;
+static uint8_t s_query[SIG_BINS];
+static PaletteIndex s_ix;
+
+// 每条签名由 6 个随机颜色、随机权重生成，贴近 extract-colors 的输出
+static void setup_index(void)
+{
+  if (s_sigs)
+    return;
+  s_sigs = (uint8_t *)malloc((size_t)N_SIGS * SIG_BINS);
+  unsigned seed = 95;
+  double rgb[6 * 3], w[6];
+  for (size_t i = 0; i <= N_SIGS; ++i)
+  {
+    for (int k = 0; k < 6; ++k)
+    {
+      for (int c = 0; c < 3; ++c)
+        rgb[k * 3 + c] = (double)(bench_rand(&seed) & 255);
+      w[k] = 1.0 + (double)(bench_rand(&seed) & 63);
+    }
+    palette_signature(rgb, w, 6, i < N_SIGS ? s_sigs + i * SIG_BINS : s_query);
+  }
+  s_ix.count = N_SIGS;
+  s_ix.sigs = s_sigs;
+}
+
+static double run_scan(size_t iters)
+{
+  ScanHit hits[10];
+  double acc = 0.0;
+  for (size_t i = 0; i < iters; ++i)
+  {
+    s_query[i % SIG_BINS] ^= 1;
+    int m = index_query(&s_ix, s_query, 10, 1, hits);
+    acc += m > 0 ? (double)hits[0].score : 0.0;
+  }
+  return acc;
+}
+
+static double run_signature(size_t iters)
+{
+  static const double rgb[6 * 3] = {255, 101, 81, 20, 40, 200, 240, 240, 230, 30, 30, 30, 90, 160, 60, 200, 180, 40};
+  static const double w[6] = {0.4, 0.2, 0.15, 0.1, 0.1, 0.05};
+  uint8_t sig[SIG_BINS];
+  double acc = 0.0;
+  for (size_t i = 0; i < iters; ++i)
+  {
+    palette_signature(rgb, w, 6, sig);
+    acc += sig[i % SIG_BINS];
+  }
+  return acc;
+}
+
+const BenchCase bench_palette_index_cases[] = {
+    {"palette_signature_6", NULL, run_signature},
+    {"palette_scan_100k", setup_index, run_scan, (size_t)N_SIGS * SIG_BINS},
+    {NULL, NULL, NULL},
+};
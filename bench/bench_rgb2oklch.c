@@ -0,0 +1,220 @@
+// rgb2oklch.c 内核基准垫片
+#define OKCOLOR_EMBED 1
+#include "../rgb2oklch.c"
+#include "bench.h"
+
+#define N_INPUTS 4096
+
+static RGB255 s_rgb[N_INPUTS];
+static uint8_t s_rgb8[N_INPUTS * 3];
+
+static void setup_inputs(void)
+{
+  unsigned seed = 0x2468aceu;
+  for (int i = 0; i < N_INPUTS; ++i)
+  {
+    unsigned v = bench_rand(&seed);
+    s_rgb8[i * 3 + 0] = (uint8_t)(v & 255);
+    s_rgb8[i * 3 + 1] = (uint8_t)((v >> 8) & 255);
+    s_rgb8[i * 3 + 2] = (uint8_t)((v >> 16) & 255);
+    s_rgb[i] = (RGB255){s_rgb8[i * 3 + 0], s_rgb8[i * 3 + 1], s_rgb8[i * 3 + 2]};
+  }
+  ensure_gamma_lut();
+}
+
+static double run_rgb_to_oklch(size_t iters)
+{
+  double acc = 0.0;
+  for (size_t i = 0; i < iters; ++i)
+  {
+    OKLCH o = rgb_to_oklch(s_rgb[i & (N_INPUTS - 1)]);
+    acc += o.L + o.C + o.h;
+  }
+  return acc;
+}
+
+static double run_rgb8_lut(size_t iters)
+{
+  double acc = 0.0;
+  for (size_t i = 0; i < iters; ++i)
+  {
+    const uint8_t *p = s_rgb8 + (i & (N_INPUTS - 1)) * 3;
+    OKLCH o = linear_srgb_to_oklch(g_srgb_u8_to_linear[p[0]], g_srgb_u8_to_linear[p[1]],
+                                   g_srgb_u8_to_linear[p[2]]);
+    acc += o.L + o.C + o.h;
+  }
+  return acc;
+}
+
+// 去重：16k 个在少量基色附近抖动的颜色（类似取色得到的候选调色板），一次操作 = 一次完整分组
+#define N_DEDUP 16384
+static uint8_t s_dedup[N_DEDUP * 3];
+static uint32_t s_labels[N_DEDUP];
+
+static void setup_dedup(void)
+{
+  unsigned seed = 0xdedu;
+  uint8_t base[64 * 3];
+  for (int i = 0; i < 64 * 3; ++i)
+    base[i] = (uint8_t)bench_rand(&seed);
+  for (int i = 0; i < N_DEDUP; ++i)
+  {
+    const uint8_t *b = base + (bench_rand(&seed) & 63) * 3;
+    for (int k = 0; k < 3; ++k)
+    {
+      int v = b[k] + (int)(bench_rand(&seed) % 17) - 8;
+      s_dedup[i * 3 + k] = (uint8_t)(v < 0 ? 0 : v > 255 ? 255 : v);
+    }
+  }
+  ensure_gamma_lut();
+}
+
+static double run_dedup_labels(size_t iters)
+{
+  double acc = 0.0;
+  for (size_t i = 0; i < iters; ++i)
+    acc += (double)dedup_run(s_dedup, N_DEDUP, 0.02, 1, s_labels, NULL);
+  return acc;
+}
+
+// OKLab 合成：两幅 256x256 的随机 RGBA 图层，一次操作 = 合成一整层（每次从同一背景重新开始）
+#define N_BLEND (256 * 256)
+static uint8_t s_blend_bg[N_BLEND * 4], s_blend_fg[N_BLEND * 4], s_blend_out[N_BLEND * 4];
+
+static void setup_blend(void)
+{
+  unsigned seed = 0xb1e0u;
+  for (int i = 0; i < N_BLEND * 4; ++i)
+  {
+    s_blend_bg[i] = (uint8_t)bench_rand(&seed);
+    s_blend_fg[i] = (uint8_t)bench_rand(&seed);
+  }
+  ensure_gamma_lut();
+  ensure_srgb8_lut();
+}
+
+static double run_blend_mode(size_t iters, int mode)
+{
+  double acc = 0.0;
+  for (size_t i = 0; i < iters; ++i)
+  {
+    memcpy(s_blend_out, s_blend_bg, sizeof s_blend_out);
+    blend_run(s_blend_out, s_blend_fg, N_BLEND, mode, 0.8);
+    acc += s_blend_out[i % sizeof s_blend_out];
+  }
+  return acc;
+}
+
+// CVD 模拟：一次操作 = 一整层 256x256 RGBA 就地做 deutan 模拟（每次从同一背景重新开始）
+static double run_cvd_deutan(size_t iters)
+{
+  double acc = 0.0;
+  for (size_t i = 0; i < iters; ++i)
+  {
+    memcpy(s_blend_out, s_blend_bg, sizeof s_blend_out);
+    cvd_run(s_blend_out, N_BLEND, CVD_DEUTAN, 1.0);
+    acc += s_blend_out[i % sizeof s_blend_out];
+  }
+  return acc;
+}
+
+static double run_blend_normal(size_t iters)
+{
+  return run_blend_mode(iters, BLEND_NORMAL);
+}
+
+static double run_blend_hue(size_t iters)
+{
+  return run_blend_mode(iters, BLEND_HUE);
+}
+
+// 任意空间转换：4096 个 Display-P3 颜色 -> OKLCH，一次转换（分块内核）对比逐段调用（经 XYZ 与 OKLab 的整幅中间数组）
+static double s_conv_in[N_INPUTS * 3], s_conv_out[N_INPUTS * 3], s_conv_tmp[N_INPUTS * 3];
+
+static void setup_convert(void)
+{
+  unsigned seed = 0xc0feu;
+  for (int i = 0; i < N_INPUTS * 3; ++i)
+    s_conv_in[i] = bench_unit(&seed);
+}
+
+static double run_convert_fused(size_t iters)
+{
+  double acc = 0.0;
+  for (size_t i = 0; i < iters; ++i)
+  {
+    convert_run(CS_DISPLAY_P3, CS_OKLCH, s_conv_in, N_INPUTS, s_conv_out);
+    acc += s_conv_out[(i * 3) % (N_INPUTS * 3)];
+  }
+  return acc;
+}
+
+static double run_convert_chained(size_t iters)
+{
+  double acc = 0.0;
+  for (size_t i = 0; i < iters; ++i)
+  {
+    convert_run(CS_DISPLAY_P3, CS_XYZ_D65, s_conv_in, N_INPUTS, s_conv_tmp);
+    convert_run(CS_XYZ_D65, CS_OKLAB, s_conv_tmp, N_INPUTS, s_conv_tmp);
+    convert_run(CS_OKLAB, CS_OKLCH, s_conv_tmp, N_INPUTS, s_conv_out);
+    acc += s_conv_out[(i * 3) % (N_INPUTS * 3)];
+  }
+  return acc;
+}
+
+// 极坐标换算：4096 个 OKLab -> OKLCH（按 CPU 分派的融合路径，只剩 sqrt + polar_atan2_deg），对比逐个调 libm atan2
+static double s_polar_in[N_INPUTS * 3], s_polar_out[N_INPUTS * 3];
+
+static void setup_polar(void)
+{
+  unsigned seed = 0x9017u;
+  for (int i = 0; i < N_INPUTS; ++i)
+  {
+    s_polar_in[i * 3 + 0] = bench_unit(&seed);
+    s_polar_in[i * 3 + 1] = 0.8 * bench_unit(&seed) - 0.4;
+    s_polar_in[i * 3 + 2] = 0.8 * bench_unit(&seed) - 0.4;
+  }
+}
+
+static double run_polar_batch(size_t iters)
+{
+  double acc = 0.0;
+  for (size_t i = 0; i < iters; ++i)
+  {
+    convert_run(CS_OKLAB, CS_OKLCH, s_polar_in, N_INPUTS, s_polar_out);
+    acc += s_polar_out[(i * 3 + 2) % (N_INPUTS * 3)];
+  }
+  return acc;
+}
+
+static double run_polar_libm(size_t iters)
+{
+  double acc = 0.0;
+  for (size_t i = 0; i < iters; ++i)
+  {
+    for (int k = 0; k < N_INPUTS; ++k)
+    {
+      double a = s_polar_in[k * 3 + 1], b = s_polar_in[k * 3 + 2];
+      double h = atan2(b, a) * (180.0 / M_PI);
+      s_polar_out[k * 3 + 0] = s_polar_in[k * 3 + 0];
+      s_polar_out[k * 3 + 1] = sqrt(a * a + b * b);
+      s_polar_out[k * 3 + 2] = h < 0.0 ? h + 360.0 : h;
+    }
+    acc += s_polar_out[(i * 3 + 2) % (N_INPUTS * 3)];
+  }
+  return acc;
+}
+
+const BenchCase bench_rgb2oklch_cases[] = {
+    {"rgb_to_oklch", setup_inputs, run_rgb_to_oklch},
+    {"rgb8_to_oklch_lut", setup_inputs, run_rgb8_lut},
+    {"dedup_labels_16k", setup_dedup, run_dedup_labels},
+    {"blend_normal_64k", setup_blend, run_blend_normal},
+    {"blend_hue_64k", setup_blend, run_blend_hue},
+    {"cvd_deutan_64k", setup_blend, run_cvd_deutan, N_BLEND * 4},
+    {"convert_p3_to_oklch", setup_convert, run_convert_fused},
+    {"convert_p3_to_oklch_chained", setup_convert, run_convert_chained},
+    {"oklab_to_oklch_4k", setup_polar, run_polar_batch, N_INPUTS * 3 * 8},
+    {"oklab_to_oklch_4k_libm", setup_polar, run_polar_libm, N_INPUTS * 3 * 8},
+    {NULL, NULL, NULL},
+};
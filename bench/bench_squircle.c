@@ -0,0 +1,42 @@
+// squircle_svg.c 路径生成基准垫片（复用同一 StrBuf，只计格式化与拼接）
+#define OKCOLOR_EMBED 1
+#include "../squircle_svg.c"
+#include "bench.h"
+
+static StrBuf s_sb = {NULL, 0, 0, 0};
+
+static void setup_sb(void)
+{
+  if (!s_sb.data)
+    sb_init(&s_sb, 4096);
+}
+
+static double run_squircle(size_t iters)
+{
+  double acc = 0.0;
+  for (size_t i = 0; i < iters; ++i)
+  {
+    s_sb.len = 0;
+    append_path_squircle(&s_sb, 200.0 + (double)(i & 255), 120.0 + (double)(i & 63), 16.0);
+    acc += (double)s_sb.len;
+  }
+  return acc;
+}
+
+static double run_capsule(size_t iters)
+{
+  double acc = 0.0;
+  for (size_t i = 0; i < iters; ++i)
+  {
+    s_sb.len = 0;
+    append_path_capsule(&s_sb, 300.0 + (double)(i & 255), 80.0 + (double)(i & 63), 40.0);
+    acc += (double)s_sb.len;
+  }
+  return acc;
+}
+
+const BenchCase bench_squircle_cases[] = {
+    {"build_path_squircle", setup_sb, run_squircle},
+    {"build_path_capsule", setup_sb, run_capsule},
+    {NULL, NULL, NULL},
+};
@@ -0,0 +1,363 @@
+// okcolor_bench —— 内核统一基准驱动
+// 覆盖 oklch2rgb / rgb2oklch / extract-colors 各阶段 / squircle 路径生成 / CSS 颜色编解码，报告 ns/op
+// （按字节计量的用例另报 MB/s），
+// 并在 Linux 上通过 perf_event_open 读取 cycles、instructions、branch-misses、cache-misses（每次操作均值）。
+// 计数器不可用时（非 Linux、容器、perf_event_paranoid 限制）对应字段输出 null，计时不受影响。
+//
+// 用法：
+//   okcolor_bench [--filter SUBSTR] [--min-time MS] [--repeat N]
+//                 [--json OUT.json] [--baseline BASE.json] [--threshold FRAC]
+//   --baseline 与保存的 JSON 对比 ns/op，任一用例变慢超过 threshold（默认 0.05）则返回 2。
+//
+// 构建：make bench（见 Makefile）
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "bench.h"
+
+// ---- 硬件计数器 ----
+enum
+{
+  PC_CYCLES,
+  PC_INSTRUCTIONS,
+  PC_BRANCH_MISSES,
+  PC_CACHE_MISSES,
+  PC_COUNT
+};
+
+static const char *const k_counter_names[PC_COUNT] = {"cycles", "instructions", "branch_misses", "cache_misses"};
+
+typedef struct
+{
+  int fd[PC_COUNT]; // -1 表示不可用
+} PerfCounters;
+
+static void perf_open(PerfCounters *pc)
+{
+  for (int i = 0; i < PC_COUNT; ++i)
+    pc->fd[i] = -1;
+#ifdef __linux__
+  static const uint64_t configs[PC_COUNT] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                             PERF_COUNT_HW_BRANCH_MISSES, PERF_COUNT_HW_CACHE_MISSES};
+  for (int i = 0; i < PC_COUNT; ++i)
+  {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof attr);
+    attr.size = sizeof attr;
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = configs[i];
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    // 多线程用例（切片、去重、索引查询）的工作线程在计数器打开之后创建：继承计数，线程退出时并入本计数器
+    attr.inherit = 1;
+    // 各计数器独立打开：部分 PMU 事件不可用时其余仍可工作
+    pc->fd[i] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+  }
+#endif
+}
+
+static void perf_close(PerfCounters *pc)
+{
+#ifdef __linux__
+  for (int i = 0; i < PC_COUNT; ++i)
+    if (pc->fd[i] >= 0)
+      close(pc->fd[i]);
+#endif
+  (void)pc;
+}
+
+static int perf_any(const PerfCounters *pc)
+{
+  for (int i = 0; i < PC_COUNT; ++i)
+    if (pc->fd[i] >= 0)
+      return 1;
+  return 0;
+}
+
+static void perf_start(PerfCounters *pc)
+{
+#ifdef __linux__
+  for (int i = 0; i < PC_COUNT; ++i)
+    if (pc->fd[i] >= 0)
+    {
+      ioctl(pc->fd[i], PERF_EVENT_IOC_RESET, 0);
+      ioctl(pc->fd[i], PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+  (void)pc;
+}
+
+// 读取计数；不可用的写 -1
+static void perf_stop(PerfCounters *pc, int64_t out[PC_COUNT])
+{
+  for (int i = 0; i < PC_COUNT; ++i)
+  {
+    out[i] = -1;
+#ifdef __linux__
+    if (pc->fd[i] < 0)
+      continue;
+    ioctl(pc->fd[i], PERF_EVENT_IOC_DISABLE, 0);
+    uint64_t v = 0;
+    if (read(pc->fd[i], &v, sizeof v) == (ssize_t)sizeof v)
+      out[i] = (int64_t)v;
+#endif
+  }
+}
+
+// ---- 计时 ----
+static double now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+typedef struct
+{
+  const char *name;
+  size_t ops;                // 每轮操作数
+  double ns_per_op;          // 各轮中位数
+  double mb_per_s;           // 吞吐（BenchCase.bytes 为 0 时 < 0）
+  double counters[PC_COUNT]; // 每次操作均值（取 ns/op 中位那一轮）；< 0 表示不可用
+} BenchResult;
+
+static volatile double g_sink = 0.0;
+
+static int cmp_double(const void *a, const void *b)
+{
+  double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+// 先倍增 iters 直到单轮耗时达到 min_ns，再重复 repeat 轮取中位数
+static void run_case(const BenchCase *bc, PerfCounters *pc, double min_ns, int repeat, BenchResult *res)
+{
+  if (bc->setup)
+    bc->setup();
+  size_t iters = 1;
+  for (;;)
+  {
+    double t0 = now_ns();
+    g_sink += bc->run(iters);
+    double dt = now_ns() - t0;
+    if (dt >= min_ns || iters >= ((size_t)1 << 40))
+      break;
+    iters *= dt > 0 && dt * 8 < min_ns ? 8 : 2;
+  }
+
+  double ns[64];
+  int64_t cnt[64][PC_COUNT];
+  if (repeat > 64)
+    repeat = 64;
+  for (int r = 0; r < repeat; ++r)
+  {
+    perf_start(pc);
+    double t0 = now_ns();
+    g_sink += bc->run(iters);
+    ns[r] = (now_ns() - t0) / (double)iters;
+    perf_stop(pc, cnt[r]);
+  }
+  double sorted[64];
+  memcpy(sorted, ns, sizeof(double) * (size_t)repeat);
+  qsort(sorted, (size_t)repeat, sizeof(double), cmp_double);
+  double med = sorted[repeat / 2];
+  int mi = 0;
+  for (int r = 0; r < repeat; ++r)
+    if (ns[r] == med)
+      mi = r;
+
+  res->name = bc->name;
+  res->ops = iters;
+  res->ns_per_op = med;
+  res->mb_per_s = bc->bytes ? (double)bc->bytes / med * 1e3 : -1.0;
+  for (int i = 0; i < PC_COUNT; ++i)
+    res->counters[i] = cnt[mi][i] >= 0 ? (double)cnt[mi][i] / (double)iters : -1.0;
+}
+
+// ---- JSON ----
+static void write_json(FILE *f, const BenchResult *rs, int n, int perf_ok)
+{
+  fprintf(f, "{\n  \"version\": 1,\n  \"perf_counters\": %s,\n  \"results\": [\n", perf_ok ? "true" : "false");
+  for (int i = 0; i < n; ++i)
+  {
+    const BenchResult *r = &rs[i];
+    // 每个结果单独一行，便于 --baseline 逐行解析与 diff
+    fprintf(f, "    {\"name\": \"%s\", \"ops\": %zu, \"ns_per_op\": %.4f", r->name, r->ops, r->ns_per_op);
+    if (r->mb_per_s >= 0)
+      fprintf(f, ", \"mb_per_s\": %.2f", r->mb_per_s);
+    for (int k = 0; k < PC_COUNT; ++k)
+    {
+      if (r->counters[k] >= 0)
+        fprintf(f, ", \"%s_per_op\": %.3f", k_counter_names[k], r->counters[k]);
+      else
+        fprintf(f, ", \"%s_per_op\": null", k_counter_names[k]);
+    }
+    fprintf(f, "}%s\n", i + 1 < n ? "," : "");
+  }
+  fprintf(f, "  ]\n}\n");
+}
+
+// 从本工具写出的 JSON 中查找 name 对应的 ns_per_op；找不到返回 -1
+static double baseline_lookup(const char *path, const char *name)
+{
+  FILE *f = fopen(path, "r");
+  if (!f)
+    return -1.0;
+  char line[1024], key[256];
+  snprintf(key, sizeof key, "{\"name\": \"%s\",", name);
+  double v = -1.0;
+  while (fgets(line, sizeof line, f))
+  {
+    char *p = strstr(line, key);
+    if (!p)
+      continue;
+    char *q = strstr(p, "\"ns_per_op\": ");
+    if (q)
+      v = strtod(q + strlen("\"ns_per_op\": "), NULL);
+    break;
+  }
+  fclose(f);
+  return v;
+}
+
+static void print_usage(const char *prog)
+{
+  fprintf(stderr,
+          "Usage: %s [--filter SUBSTR] [--min-time MS] [--repeat N]\n"
+          "          [--json OUT.json] [--baseline BASE.json] [--threshold FRAC]\n",
+          prog);
+}
+
+int main(int argc, char **argv)
+{
+  const char *filter = NULL, *json_path = NULL, *baseline = NULL;
+  double min_ms = 100.0, threshold = 0.05;
+  int repeat = 5;
+  for (int i = 1; i < argc; ++i)
+  {
+    const char *a = argv[i];
+    if (i + 1 >= argc)
+    {
+      print_usage(argv[0]);
+      return 1;
+    }
+    const char *v = argv[++i];
+    if (strcmp(a, "--filter") == 0)
+      filter = v;
+    else if (strcmp(a, "--min-time") == 0)
+      min_ms = atof(v);
+    else if (strcmp(a, "--repeat") == 0)
+      repeat = atoi(v);
+    else if (strcmp(a, "--json") == 0)
+      json_path = v;
+    else if (strcmp(a, "--baseline") == 0)
+      baseline = v;
+    else if (strcmp(a, "--threshold") == 0)
+      threshold = atof(v);
+    else
+    {
+      print_usage(argv[0]);
+      return 1;
+    }
+  }
+  if (repeat < 1)
+    repeat = 1;
+  if (min_ms <= 0)
+    min_ms = 1.0;
+
+  const BenchCase *const tables[] = {bench_oklch2rgb_cases, bench_rgb2oklch_cases, bench_extract_cases,
+                                     bench_squircle_cases,    bench_css_cases,       bench_palette_index_cases};
+  // 先数出要运行的用例，结果数组按需分配
+  size_t ncases = 0;
+  for (size_t t = 0; t < sizeof tables / sizeof tables[0]; ++t)
+    for (const BenchCase *bc = tables[t]; bc->name; ++bc)
+      if (!filter || strstr(bc->name, filter))
+        ncases++;
+  BenchResult *results = (BenchResult *)malloc((ncases ? ncases : 1) * sizeof(BenchResult));
+  if (!results)
+  {
+    fprintf(stderr, "Out of memory.\n");
+    return 1;
+  }
+  int nres = 0;
+
+  PerfCounters pc;
+  perf_open(&pc);
+  int perf_ok = perf_any(&pc);
+  if (!perf_ok)
+    fprintf(stderr, "[bench] hardware counters unavailable; reporting time only\n");
+
+  printf("%-28s %12s %10s %10s %10s %10s %9s\n", "case", "ns/op", "cycles", "instr", "br-miss", "cache-miss",
+         "MB/s");
+  for (size_t t = 0; t < sizeof tables / sizeof tables[0]; ++t)
+  {
+    for (const BenchCase *bc = tables[t]; bc->name; ++bc)
+    {
+      if (filter && !strstr(bc->name, filter))
+        continue;
+      BenchResult *r = &results[nres++];
+      run_case(bc, &pc, min_ms * 1e6 / repeat, repeat, r);
+      printf("%-28s %12.2f", r->name, r->ns_per_op);
+      for (int k = 0; k < PC_COUNT; ++k)
+      {
+        if (r->counters[k] >= 0)
+          printf(" %10.1f", r->counters[k]);
+        else
+          printf(" %10s", "-");
+      }
+      if (r->mb_per_s >= 0)
+        printf(" %9.1f\n", r->mb_per_s);
+      else
+        printf(" %9s\n", "-");
+    }
+  }
+  perf_close(&pc);
+
+  if (json_path)
+  {
+    FILE *f = fopen(json_path, "w");
+    if (!f)
+    {
+      fprintf(stderr, "Cannot write %s\n", json_path);
+      free(results);
+      return 1;
+    }
+    write_json(f, results, nres, perf_ok);
+    fclose(f);
+  }
+
+  int regressed = 0;
+  if (baseline)
+  {
+    printf("\n%-28s %12s %12s %8s\n", "case", "base ns/op", "ns/op", "delta");
+    for (int i = 0; i < nres; ++i)
+    {
+      double b = baseline_lookup(baseline, results[i].name);
+      if (b <= 0)
+      {
+        printf("%-28s %12s %12.2f %8s\n", results[i].name, "-", results[i].ns_per_op, "new");
+        continue;
+      }
+      double d = results[i].ns_per_op / b - 1.0;
+      int bad = d > threshold;
+      regressed |= bad;
+      printf("%-28s %12.2f %12.2f %+7.1f%%%s\n", results[i].name, b, results[i].ns_per_op, d * 100.0,
+             bad ? "  REGRESSION" : "");
+    }
+  }
+  free(results);
+  return regressed ? 2 : 0;
+}
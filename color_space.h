@@ -0,0 +1,271 @@
+// color_space.h —— 任意两色彩空间之间的融合转换（仅头文件，由 rgb2oklch.c 包含）
+// 空间按「层级」组成一条链：编码 RGB（sRGB / Display-P3，共用 sRGB 传递函数）
+//   <-> 线性空间（线性 sRGB、线性 P3、XYZ D65、LMS，两两只差一个 3×3 矩阵）
+//   <-> OKLab（LMS 取立方根后再乘矩阵）<-> OKLCH（极坐标）。
+// 转换计划（CsPlan）在创建时把源、目标之间的所有线性矩阵预先乘成一个；
+// 每对（源层级, 目标层级）由 CS_CONVERT_CASE 展开一份只含该路径必需阶段的内核（如 OKLab <-> OKLCH
+// 不经过线性空间）。内核每 CS_CHUNK 个颜色一块，各阶段在栈上的 SoA 缓冲里各跑一趟：
+// 调用 libm 的阶段（pow、cbrt）单独成趟，其余阶段（矩阵、立方、极坐标）无分支，可自动向量化。
+// 编码 RGB 取 0..1（同 CSS color()），传递函数按符号扩展到 [0,1] 之外；不做色域映射或裁剪。
+
+#ifndef OKCOLOR_COLOR_SPACE_H
+#define OKCOLOR_COLOR_SPACE_H
+
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+
+#ifndef INLINE
+#define INLINE inline __attribute__((always_inline))
+#endif
+#include "polar.h"
+
+enum
+{
+  CS_SRGB = 0,
+  CS_SRGB_LINEAR = 1,
+  CS_DISPLAY_P3 = 2,
+  CS_DISPLAY_P3_LINEAR = 3,
+  CS_XYZ_D65 = 4,
+  CS_LMS = 5, // OKLab 的线性 LMS（立方根之前）
+  CS_OKLAB = 6,
+  CS_OKLCH = 7, // [L, C, h]，h 为角度
+  CS_SPACE_COUNT = 8,
+};
+
+// 层级
+enum
+{
+  CS_LEVEL_ENCODED = 0,
+  CS_LEVEL_LINEAR = 1,
+  CS_LEVEL_OKLAB = 2,
+  CS_LEVEL_OKLCH = 3,
+};
+
+typedef struct
+{
+  const char *name; // CSS color() 的名字；lms 为本仓库自定义
+  int level;
+  double to_hub[9];   // 本空间所在线性空间 -> 线性 sRGB
+  double from_hub[9]; // 线性 sRGB -> 本空间所在线性空间
+} CsSpace;
+
+#define CS_IDENTITY {1, 0, 0, 0, 1, 0, 0, 0, 1}
+// 线性 P3 <-> 线性 sRGB 由 CSS Color 4 的两个到 XYZ 的矩阵相乘得到（有理数精确计算后取 double）
+#define CS_P3_TO_SRGB                                                                                           \
+  {1.22494017628056, -0.2249401762805601, 0, -0.04205695470968811, 1.0420569547096883, 0,                      \
+   -0.019637554590334404, -0.07863604555063183, 1.0982736001409663}
+#define CS_SRGB_TO_P3                                                                                           \
+  {0.8224619687143622, 0.1775380312856378, 0, 0.033194198850961566, 0.9668058011490381, 0,                     \
+   0.017082630721120002, 0.0723974406639634, 0.9105199286149165}
+// 与 oklch2rgb.c / rgb2oklch.c 相同的 OKLab 矩阵
+#define CS_LMS_TO_SRGB                                                                                          \
+  {4.0767416621, -3.3077115913, 0.2309699292, -1.2684380046, 2.6097574011, -0.3413193965, -0.0041960863,      \
+   -0.7034186147, 1.7076147010}
+#define CS_SRGB_TO_LMS                                                                                          \
+  {0.4122214708, 0.5363325363, 0.0514459929, 0.2119034982, 0.6806995451, 0.1073969566, 0.0883024619,           \
+   0.2817188376, 0.6299787005}
+
+static const CsSpace k_cs_spaces[CS_SPACE_COUNT] = {
+    {"srgb", CS_LEVEL_ENCODED, CS_IDENTITY, CS_IDENTITY},
+    {"srgb-linear", CS_LEVEL_LINEAR, CS_IDENTITY, CS_IDENTITY},
+    {"display-p3", CS_LEVEL_ENCODED, CS_P3_TO_SRGB, CS_SRGB_TO_P3},
+    {"display-p3-linear", CS_LEVEL_LINEAR, CS_P3_TO_SRGB, CS_SRGB_TO_P3},
+    {"xyz-d65",
+     CS_LEVEL_LINEAR,
+     {3.2409699419045226, -1.537383177570094, -0.4986107602930034, -0.9692436362808796, 1.8759675015077204,
+      0.0415550574071756, 0.05563007969699364, -0.20397695888897652, 1.0569715142428784},
+     {0.41239079926595934, 0.357584339383878, 0.1804807884018343, 0.21263900587151027, 0.715168678767756,
+      0.07219231536073371, 0.01933081871559182, 0.11919477979462598, 0.9505321522496607}},
+    {"lms", CS_LEVEL_LINEAR, CS_LMS_TO_SRGB, CS_SRGB_TO_LMS},
+    {"oklab", CS_LEVEL_OKLAB, CS_LMS_TO_SRGB, CS_SRGB_TO_LMS},
+    {"oklch", CS_LEVEL_OKLCH, CS_LMS_TO_SRGB, CS_SRGB_TO_LMS},
+};
+
+#undef CS_IDENTITY
+#undef CS_P3_TO_SRGB
+#undef CS_SRGB_TO_P3
+#undef CS_LMS_TO_SRGB
+#undef CS_SRGB_TO_LMS
+
+typedef struct
+{
+  int src_level, dst_level;
+  int same; // 源与目标为同一空间：直接复制
+  double m[9]; // 源线性空间 -> 目标线性空间（已预乘）
+} CsPlan;
+
+// 名字 -> 空间编号（大小写敏感，同 CSS color() 的小写写法）；未知返回 -1
+static inline int cs_space_from_name(const char *name)
+{
+  for (int k = 0; k < CS_SPACE_COUNT; ++k)
+    if (strcmp(name, k_cs_spaces[k].name) == 0)
+      return k;
+  return -1;
+}
+
+// 成功返回 0，空间编号无效返回 -1
+static inline int cs_plan_init(CsPlan *plan, int src, int dst)
+{
+  if (src < 0 || src >= CS_SPACE_COUNT || dst < 0 || dst >= CS_SPACE_COUNT)
+    return -1;
+  const CsSpace *s = &k_cs_spaces[src], *d = &k_cs_spaces[dst];
+  plan->src_level = s->level;
+  plan->dst_level = d->level;
+  plan->same = src == dst;
+  for (int i = 0; i < 3; ++i)
+    for (int j = 0; j < 3; ++j)
+      plan->m[i * 3 + j] = d->from_hub[i * 3 + 0] * s->to_hub[0 * 3 + j] +
+                           d->from_hub[i * 3 + 1] * s->to_hub[1 * 3 + j] +
+                           d->from_hub[i * 3 + 2] * s->to_hub[2 * 3 + j];
+  return 0;
+}
+
+// sRGB 传递函数（Display-P3 相同），按符号扩展
+static INLINE double cs_decode(double u)
+{
+  double a = fabs(u);
+  double v = a <= 0.04045 ? a / 12.92 : pow((a + 0.055) / 1.055, 2.4);
+  return u < 0.0 ? -v : v;
+}
+
+static INLINE double cs_encode(double u)
+{
+  double a = fabs(u);
+  double v = a <= 0.0031308 ? 12.92 * a : 1.055 * pow(a, 1.0 / 2.4) - 0.055;
+  return u < 0.0 ? -v : v;
+}
+
+#define CS_CHUNK 256
+
+// 一条转换路径；sl / dl 为常量实参时未用到的阶段整体消去。整块先载入 SoA，故 in 与 out 可以相同
+static INLINE void cs_convert_body(const CsPlan *plan, const double *in, size_t n, double *out, int sl, int dl)
+{
+  const double *m = plan->m;
+  const int via_linear = !(sl >= CS_LEVEL_OKLAB && dl >= CS_LEVEL_OKLAB);
+  double x[CS_CHUNK], y[CS_CHUNK], z[CS_CHUNK];
+  for (size_t i0 = 0; i0 < n; i0 += CS_CHUNK)
+  {
+    size_t cnt = n - i0 < CS_CHUNK ? n - i0 : CS_CHUNK;
+    const double *p = in + i0 * 3;
+    double *o = out + i0 * 3;
+    if (sl == CS_LEVEL_OKLCH)
+      for (size_t k = 0; k < cnt; ++k)
+      {
+        double sh, ch;
+        polar_sincos_deg(p[k * 3 + 2], &sh, &ch);
+        x[k] = p[k * 3 + 0];
+        y[k] = p[k * 3 + 1] * ch;
+        z[k] = p[k * 3 + 1] * sh;
+      }
+    else
+      for (size_t k = 0; k < cnt; ++k)
+      {
+        x[k] = p[k * 3 + 0];
+        y[k] = p[k * 3 + 1];
+        z[k] = p[k * 3 + 2];
+      }
+    if (via_linear)
+    {
+      if (sl >= CS_LEVEL_OKLAB)
+        for (size_t k = 0; k < cnt; ++k)
+        {
+          double l = x[k] + 0.3963377774 * y[k] + 0.2158037573 * z[k];
+          double mm = x[k] - 0.1055613458 * y[k] - 0.0638541728 * z[k];
+          double s = x[k] - 0.0894841775 * y[k] - 1.2914855480 * z[k];
+          x[k] = l * l * l;
+          y[k] = mm * mm * mm;
+          z[k] = s * s * s;
+        }
+      else if (sl == CS_LEVEL_ENCODED)
+        for (size_t k = 0; k < cnt; ++k)
+        {
+          x[k] = cs_decode(x[k]);
+          y[k] = cs_decode(y[k]);
+          z[k] = cs_decode(z[k]);
+        }
+      for (size_t k = 0; k < cnt; ++k)
+      {
+        double r = m[0] * x[k] + m[1] * y[k] + m[2] * z[k];
+        double g = m[3] * x[k] + m[4] * y[k] + m[5] * z[k];
+        double b = m[6] * x[k] + m[7] * y[k] + m[8] * z[k];
+        x[k] = r;
+        y[k] = g;
+        z[k] = b;
+      }
+      if (dl >= CS_LEVEL_OKLAB)
+      {
+        for (size_t k = 0; k < cnt; ++k)
+        {
+          x[k] = cbrt(x[k]);
+          y[k] = cbrt(y[k]);
+          z[k] = cbrt(z[k]);
+        }
+        for (size_t k = 0; k < cnt; ++k)
+        {
+          double l = x[k], mm = y[k], s = z[k];
+          x[k] = 0.2104542553 * l + 0.7936177850 * mm - 0.0040720468 * s;
+          y[k] = 1.9779984951 * l - 2.4285922050 * mm + 0.4505937099 * s;
+          z[k] = 0.0259040371 * l + 0.7827717662 * mm - 0.8086757660 * s;
+        }
+      }
+      else if (dl == CS_LEVEL_ENCODED)
+        for (size_t k = 0; k < cnt; ++k)
+        {
+          x[k] = cs_encode(x[k]);
+          y[k] = cs_encode(y[k]);
+          z[k] = cs_encode(z[k]);
+        }
+    }
+    if (dl == CS_LEVEL_OKLCH)
+      for (size_t k = 0; k < cnt; ++k)
+      {
+        // 与 rgb2oklch 一致：近乎无彩时 C、h 置 0
+        double C = sqrt(y[k] * y[k] + z[k] * z[k]);
+        double h = polar_atan2_deg(z[k], y[k]);
+        o[k * 3 + 0] = x[k];
+        o[k * 3 + 1] = C > 1e-12 ? C : 0.0;
+        o[k * 3 + 2] = C > 1e-12 ? h : 0.0;
+      }
+    else
+      for (size_t k = 0; k < cnt; ++k)
+      {
+        o[k * 3 + 0] = x[k];
+        o[k * 3 + 1] = y[k];
+        o[k * 3 + 2] = z[k];
+      }
+  }
+}
+
+// 按计划的（源层级, 目标层级）选择展开好的路径；in 与 out 可以相同
+static INLINE void cs_convert(const CsPlan *plan, const double *in, size_t n, double *out)
+{
+  if (plan->same)
+  {
+    if (out != in)
+      memmove(out, in, n * 3 * sizeof(double));
+    return;
+  }
+  switch (plan->src_level * 4 + plan->dst_level)
+  {
+#define CS_CONVERT_CASE(s, d)                                                                                   \
+  case (s) * 4 + (d):                                                                                           \
+    cs_convert_body(plan, in, n, out, s, d);                                                                    \
+    return;
+#define CS_CONVERT_ROW(s)                                                                                       \
+  CS_CONVERT_CASE(s, CS_LEVEL_ENCODED)                                                                          \
+  CS_CONVERT_CASE(s, CS_LEVEL_LINEAR)                                                                           \
+  CS_CONVERT_CASE(s, CS_LEVEL_OKLAB)                                                                            \
+  CS_CONVERT_CASE(s, CS_LEVEL_OKLCH)
+    CS_CONVERT_ROW(CS_LEVEL_ENCODED)
+    CS_CONVERT_ROW(CS_LEVEL_LINEAR)
+    CS_CONVERT_ROW(CS_LEVEL_OKLAB)
+    CS_CONVERT_ROW(CS_LEVEL_OKLCH)
+#undef CS_CONVERT_ROW
+#undef CS_CONVERT_CASE
+  default:
+    return;
+  }
+}
+
+#endif // OKCOLOR_COLOR_SPACE_H
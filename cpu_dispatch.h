@@ -0,0 +1,137 @@
+// cpu_dispatch.h —— 原生批量内核的运行时 CPU 分派与线程池（仅头文件，oklch2rgb.c / rgb2oklch.c / palette_index.c 共用）
+// 热点内核按 baseline / AVX2+FMA / AVX-512 各编译一份（调用链经 INLINE 完整展开进各变体），
+// 各文件的构造函数按 detect_cpu_level() 在进程启动时选定一次，同一产物可在新旧机器上运行。
+// 环境变量 OKCOLOR_CPU=baseline|avx2|avx512 可强制降级（不会升级到 CPU 不支持的路径）。
+// 多线程驱动（行带渲染、去重、索引扫描）都经 pool_run 启动：各线程从调用方的原子计数器领取工作块。
+// 仅供原生构建包含（Wasm 只有一条路径，且单线程）。包含前需打开 POSIX（_POSIX_C_SOURCE，供 sysconf）。
+
+#ifndef OKCOLOR_CPU_DISPATCH_H
+#define OKCOLOR_CPU_DISPATCH_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define HAVE_X86_DISPATCH 1
+#endif
+
+enum
+{
+  CPU_LEVEL_BASELINE = 0,
+  CPU_LEVEL_AVX2 = 1,   // AVX2 + FMA
+  CPU_LEVEL_AVX512 = 2, // AVX-512 F/VL/DQ/BW
+};
+
+// 检测可用的最高档位，再按 OKCOLOR_CPU 降级
+static inline int detect_cpu_level(void)
+{
+#ifdef HAVE_X86_DISPATCH
+  __builtin_cpu_init();
+  int level = CPU_LEVEL_BASELINE;
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    level = CPU_LEVEL_AVX2;
+  if (level == CPU_LEVEL_AVX2 && __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl") &&
+      __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("avx512bw"))
+    level = CPU_LEVEL_AVX512;
+  const char *force = getenv("OKCOLOR_CPU");
+  if (force)
+  {
+    int want = level;
+    if (strcmp(force, "baseline") == 0)
+      want = CPU_LEVEL_BASELINE;
+    else if (strcmp(force, "avx2") == 0)
+      want = CPU_LEVEL_AVX2;
+    else if (strcmp(force, "avx512") == 0)
+      want = CPU_LEVEL_AVX512;
+    if (want < level)
+      level = want;
+  }
+  return level;
+#else
+  return CPU_LEVEL_BASELINE;
+#endif
+}
+
+// --cpu-info：打印所选内核路径与检测到的 CPU 特性
+static inline void print_cpu_info(const char *path)
+{
+  printf("kernel: %s\n", path);
+#ifdef HAVE_X86_DISPATCH
+#define PRINT_FEATURE(f)         \
+  if (__builtin_cpu_supports(f)) \
+  printf(" " f)
+  printf("features:");
+  PRINT_FEATURE("sse4.2");
+  PRINT_FEATURE("avx");
+  PRINT_FEATURE("avx2");
+  PRINT_FEATURE("fma");
+  PRINT_FEATURE("avx512f");
+  PRINT_FEATURE("avx512vl");
+  PRINT_FEATURE("avx512dq");
+  PRINT_FEATURE("avx512bw");
+#undef PRINT_FEATURE
+  printf("\n");
+#else
+  printf("features: (no ISA-specific kernels for this target)\n");
+#endif
+  const char *force = getenv("OKCOLOR_CPU");
+  if (force)
+    printf("OKCOLOR_CPU: %s\n", force);
+}
+
+// ---- 线程池 ----
+#define POOL_MAX_THREADS 64
+
+// 线程数：threads <= 0 表示按在线 CPU 数；再截到 POOL_MAX_THREADS 与 max_useful（如工作块数）以内，至少 1
+static inline int pool_thread_count(int threads, size_t max_useful)
+{
+  if (threads <= 0)
+  {
+    long c = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = c > 0 ? (int)c : 1;
+  }
+  if (threads > POOL_MAX_THREADS)
+    threads = POOL_MAX_THREADS;
+  if ((size_t)threads > max_useful)
+    threads = max_useful ? (int)max_useful : 1;
+  return threads;
+}
+
+typedef struct
+{
+  void (*fn)(void *arg);
+  void *arg;
+} PoolTask;
+
+static inline void *pool_thread_main(void *p)
+{
+  PoolTask *task = (PoolTask *)p;
+  task->fn(task->arg);
+  return NULL;
+}
+
+// 以 nthreads 个线程执行 fn：第 t 个线程的参数为 (char *)args + t * stride（stride 为 0 时共用同一参数），
+// t = 0 在调用线程上执行，返回时全部线程已结束。线程创建失败时该份参数不会被执行，
+// 因此 fn 须从共享的原子计数器领取工作，剩余部分由其它线程领走
+static inline void pool_run(int nthreads, void (*fn)(void *arg), void *args, size_t stride)
+{
+  pthread_t tid[POOL_MAX_THREADS];
+  PoolTask task[POOL_MAX_THREADS];
+  int started[POOL_MAX_THREADS] = {0};
+  if (nthreads > POOL_MAX_THREADS)
+    nthreads = POOL_MAX_THREADS;
+  for (int t = 1; t < nthreads; ++t)
+  {
+    task[t] = (PoolTask){fn, (char *)args + (size_t)t * stride};
+    started[t] = pthread_create(&tid[t], NULL, pool_thread_main, &task[t]) == 0;
+  }
+  fn(args);
+  for (int t = 1; t < nthreads; ++t)
+    if (started[t])
+      pthread_join(tid[t], NULL);
+}
+
+#endif // OKCOLOR_CPU_DISPATCH_H
@@ -0,0 +1,494 @@
+// css_color.h —— CSS 颜色字符串的解析与序列化（仅头文件，由 oklch2rgb.c / rgb2oklch.c 的批量模式直接包含）
+// 支持的输入：
+//   #rgb #rgba #rrggbb #rrggbbaa
+//   rgb() / rgba()：逗号或空格分隔，分量为 0..255 数值或百分比，可带 "/ alpha"（或逗号形式的第 4 个分量）
+//   oklch()：L 为数值或百分比（100% = 1），C 为数值或百分比（100% = 0.4），
+//            h 为数值或带 deg/rad/grad/turn 单位，任一分量可为 none（按 0 处理）
+// 函数名大小写不敏感；不支持命名颜色（red、transparent 等）。
+// 全程不分配内存，只读 [p, end) 区间：十六进制以 SWAR 一次校验并解码 8 位，
+// 数值为手写解析（Clinger 快速路径，结果与 strtod 逐位一致；超出快速路径范围时退回 strtod）。
+
+#ifndef OKCOLOR_CSS_COLOR_H
+#define OKCOLOR_CSS_COLOR_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum
+{
+  CSS_COLOR_RGB = 1,   // v = [R, G, B]，0..255（未夹取）
+  CSS_COLOR_OKLCH = 2, // v = [L, C, h]，L ∈ 0..1、h 为角度（未归一化）
+};
+
+typedef struct
+{
+  int kind;
+  double v[3];
+  double alpha; // 0..1，缺省为 1
+} CssColor;
+
+static inline int css_is_space(char c)
+{
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+}
+
+static inline const char *css_skip_space(const char *p, const char *end)
+{
+  while (p < end && css_is_space(*p))
+    p++;
+  return p;
+}
+
+// ---- 数值 ----
+static const double k_css_pow10[23] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                       1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+// 解析 [+-]digits[.digits][(e|E)[+-]digits]；成功时写 *out、推进 *pp 并返回 1
+static inline int css_parse_number(const char **pp, const char *end, double *out)
+{
+  const char *p = *pp;
+  const char *start = p;
+  int neg = 0;
+  if (p < end && (*p == '+' || *p == '-'))
+  {
+    neg = *p == '-';
+    p++;
+  }
+  uint64_t mant = 0;
+  int nd = 0;        // 已累计的有效数字位数（不含前导 0）
+  int exp10 = 0;     // mant 需乘的 10 的幂
+  int truncated = 0; // 超过 19 位有效数字被截断
+  int any = 0;
+  while (p < end && (unsigned)(*p - '0') < 10)
+  {
+    unsigned d = (unsigned)(*p - '0');
+    if (nd < 19)
+    {
+      mant = mant * 10 + d;
+      nd += mant != 0;
+    }
+    else
+    {
+      exp10++;
+      truncated |= d != 0;
+    }
+    any = 1;
+    p++;
+  }
+  if (p < end && *p == '.')
+  {
+    p++;
+    while (p < end && (unsigned)(*p - '0') < 10)
+    {
+      unsigned d = (unsigned)(*p - '0');
+      if (nd < 19)
+      {
+        mant = mant * 10 + d;
+        nd += mant != 0;
+        exp10--;
+      }
+      else
+        truncated |= d != 0;
+      any = 1;
+      p++;
+    }
+  }
+  if (!any)
+    return 0;
+  if (p < end && (*p == 'e' || *p == 'E'))
+  {
+    // 仅当后面确实跟着指数数字时才吞掉 'e'
+    const char *q = p + 1;
+    int eneg = 0;
+    if (q < end && (*q == '+' || *q == '-'))
+    {
+      eneg = *q == '-';
+      q++;
+    }
+    if (q < end && (unsigned)(*q - '0') < 10)
+    {
+      int e = 0;
+      while (q < end && (unsigned)(*q - '0') < 10)
+      {
+        if (e < 100000)
+          e = e * 10 + (*q - '0');
+        q++;
+      }
+      exp10 += eneg ? -e : e;
+      p = q;
+    }
+  }
+  double v;
+  if (!truncated && mant <= ((uint64_t)1 << 53) && exp10 >= -22 && exp10 <= 22)
+  {
+    // mant 与 10^|exp10| 都可精确表示为 double，一次乘/除即为正确舍入的结果
+    v = exp10 < 0 ? (double)mant / k_css_pow10[-exp10] : (double)mant * k_css_pow10[exp10];
+  }
+  else
+  {
+    char buf[128];
+    size_t len = (size_t)(p - start);
+    if (len >= sizeof buf)
+      return 0;
+    memcpy(buf, start, len);
+    buf[len] = '\0';
+    v = strtod(buf, NULL);
+    neg = 0; // 符号已包含在 buf 中
+  }
+  *out = neg ? -v : v;
+  *pp = p;
+  return 1;
+}
+
+// ---- 十六进制（SWAR）----
+#define CSS_ONES 0x0101010101010101ull
+#define CSS_HIGHS 0x8080808080808080ull
+// 逐字节判断 m < b < n（要求 b 的最高位为 0 时才可能为真），结果在每字节最高位
+#define CSS_BETWEEN(x, m, n)                                                                                    \
+  (((CSS_ONES * (127 + (n)) - ((x) & CSS_ONES * 127)) & ~(x) & (((x) & CSS_ONES * 127) + CSS_ONES * (127 - (m)))) & \
+   CSS_HIGHS)
+
+static inline uint64_t css_load8(const char *p, const char *end)
+{
+  unsigned char b[8] = {0};
+  size_t n = (size_t)(end - p) < 8 ? (size_t)(end - p) : 8;
+  memcpy(b, p, n);
+  // 按小端字节序组装，首字符位于最低字节
+  uint64_t x = 0;
+  for (int i = 7; i >= 0; --i)
+    x = (x << 8) | b[i];
+  return x;
+}
+
+// 解析 '#' 之后的 3/4/6/8 位十六进制；返回结束位置，失败返回 NULL
+static inline const char *css_parse_hex(const char *p, const char *end, CssColor *out)
+{
+  uint64_t x = css_load8(p, end);
+  uint64_t lower = x | (CSS_ONES * 0x20);
+  uint64_t valid = CSS_BETWEEN(x, 0x2F, 0x3A) | CSS_BETWEEN(lower, 0x60, 0x67);
+  uint64_t invalid = ~valid & CSS_HIGHS;
+  int run = invalid ? __builtin_ctzll(invalid) >> 3 : 8;
+  // 超过 8 位十六进制不是合法颜色
+  if (run == 8 && p + 8 < end && ((unsigned)(p[8] - '0') < 10 || (unsigned)((p[8] | 0x20) - 'a') < 6))
+    return NULL;
+  // 每字节转为 0..15：数字取低 4 位，字母（第 6 位为 1）再加 9
+  uint64_t nib = (x & (CSS_ONES * 0x0F)) + ((x >> 6) & CSS_ONES) * 9;
+  double a = 255.0;
+  if (run == 6 || run == 8)
+  {
+    // 相邻两个半字节合并为一个字节，结果位于偶数字节
+    uint64_t t = ((nib << 4) | (nib >> 8)) & 0x00FF00FF00FF00FFull;
+    out->v[0] = (double)(t & 0xFF);
+    out->v[1] = (double)((t >> 16) & 0xFF);
+    out->v[2] = (double)((t >> 32) & 0xFF);
+    if (run == 8)
+      a = (double)((t >> 48) & 0xFF);
+  }
+  else if (run == 3 || run == 4)
+  {
+    out->v[0] = (double)((nib & 0xFF) * 17);
+    out->v[1] = (double)(((nib >> 8) & 0xFF) * 17);
+    out->v[2] = (double)(((nib >> 16) & 0xFF) * 17);
+    if (run == 4)
+      a = (double)(((nib >> 24) & 0xFF) * 17);
+  }
+  else
+    return NULL;
+  out->kind = CSS_COLOR_RGB;
+  out->alpha = a / 255.0;
+  return p + run;
+}
+
+// ---- 函数式语法 ----
+static inline int css_match_word(const char *p, const char *end, const char *w)
+{
+  size_t n = strlen(w);
+  if ((size_t)(end - p) < n)
+    return 0;
+  for (size_t i = 0; i < n; ++i)
+    if ((p[i] | 0x20) != w[i])
+      return 0;
+  return 1;
+}
+
+// 解析一个分量：数值（可带 % 或角度单位）或 none。unit: 0=无，1=%，2=角度（已换算为度）
+static inline int css_parse_component(const char **pp, const char *end, double *out, int *unit)
+{
+  const char *p = *pp;
+  if (css_match_word(p, end, "none"))
+  {
+    *out = 0.0;
+    *unit = 0;
+    *pp = p + 4;
+    return 1;
+  }
+  if (!css_parse_number(&p, end, out))
+    return 0;
+  *unit = 0;
+  if (p < end && *p == '%')
+  {
+    *unit = 1;
+    p++;
+  }
+  else if (css_match_word(p, end, "deg"))
+  {
+    *unit = 2;
+    p += 3;
+  }
+  else if (css_match_word(p, end, "grad"))
+  {
+    *unit = 2;
+    *out *= 0.9;
+    p += 4;
+  }
+  else if (css_match_word(p, end, "rad"))
+  {
+    *unit = 2;
+    *out *= 180.0 / 3.14159265358979323846;
+    p += 3;
+  }
+  else if (css_match_word(p, end, "turn"))
+  {
+    *unit = 2;
+    *out *= 360.0;
+    p += 4;
+  }
+  *pp = p;
+  return 1;
+}
+
+// 解析 "(" 之后的 3 个分量与可选 alpha，直到 ")"；comma_ok 允许旧式逗号分隔
+static inline const char *css_parse_args(const char *p, const char *end, double v[3], int unit[3], double *alpha,
+                                         int comma_ok)
+{
+  int commas = -1; // -1 未定，0 空格分隔，1 逗号分隔
+  for (int i = 0; i < 3; ++i)
+  {
+    p = css_skip_space(p, end);
+    if (i > 0 && p < end && *p == ',')
+    {
+      if (!comma_ok || commas == 0)
+        return NULL;
+      commas = 1;
+      p = css_skip_space(p + 1, end);
+    }
+    else if (i > 0)
+    {
+      if (commas == 1)
+        return NULL;
+      commas = 0;
+    }
+    if (!css_parse_component(&p, end, &v[i], &unit[i]))
+      return NULL;
+  }
+  *alpha = 1.0;
+  p = css_skip_space(p, end);
+  if (p < end && (*p == '/' || (*p == ',' && commas == 1)))
+  {
+    if (*p == '/' && commas == 1)
+      return NULL;
+    p = css_skip_space(p + 1, end);
+    double a;
+    int u;
+    if (!css_parse_component(&p, end, &a, &u) || u == 2)
+      return NULL;
+    if (u == 1)
+      a *= 0.01;
+    *alpha = a < 0.0 ? 0.0 : a > 1.0 ? 1.0 : a;
+    p = css_skip_space(p, end);
+  }
+  if (p >= end || *p != ')')
+    return NULL;
+  return p + 1;
+}
+
+// 解析一个 CSS 颜色（允许前导空白）；返回结束位置，失败返回 NULL
+static inline const char *css_parse_color(const char *p, const char *end, CssColor *out)
+{
+  p = css_skip_space(p, end);
+  if (p >= end)
+    return NULL;
+  if (*p == '#')
+    return css_parse_hex(p + 1, end, out);
+  double v[3];
+  int unit[3];
+  if (css_match_word(p, end, "oklch("))
+  {
+    p = css_parse_args(p + 6, end, v, unit, &out->alpha, 0);
+    if (!p || unit[0] == 2 || unit[1] == 2 || unit[2] == 1)
+      return NULL;
+    out->kind = CSS_COLOR_OKLCH;
+    out->v[0] = unit[0] == 1 ? v[0] * 0.01 : v[0];
+    out->v[1] = unit[1] == 1 ? v[1] * 0.004 : v[1];
+    out->v[2] = v[2];
+    return p;
+  }
+  int skip = css_match_word(p, end, "rgba(") ? 5 : css_match_word(p, end, "rgb(") ? 4 : 0;
+  if (skip)
+  {
+    p = css_parse_args(p + skip, end, v, unit, &out->alpha, 1);
+    if (!p)
+      return NULL;
+    out->kind = CSS_COLOR_RGB;
+    for (int i = 0; i < 3; ++i)
+    {
+      if (unit[i] == 2)
+        return NULL;
+      out->v[i] = unit[i] == 1 ? v[i] * 2.55 : v[i];
+    }
+    return p;
+  }
+  return NULL;
+}
+
+// ---- 序列化 ----
+static const char k_css_hex_digits[] = "0123456789abcdef";
+
+// "#rrggbb"，alpha < 1 时为 "#rrggbbaa"；返回写入结束位置（不写 '\0'）
+static inline char *css_format_hex(char *dst, const uint8_t rgb[3], double alpha)
+{
+  *dst++ = '#';
+  for (int i = 0; i < 3; ++i)
+  {
+    *dst++ = k_css_hex_digits[rgb[i] >> 4];
+    *dst++ = k_css_hex_digits[rgb[i] & 15];
+  }
+  if (alpha < 1.0)
+  {
+    int a = (int)(alpha * 255.0 + 0.5);
+    *dst++ = k_css_hex_digits[a >> 4];
+    *dst++ = k_css_hex_digits[a & 15];
+  }
+  return dst;
+}
+
+// 0..255 十进制
+static inline char *css_format_u8(char *dst, unsigned v)
+{
+  if (v >= 100)
+  {
+    *dst++ = (char)('0' + v / 100);
+    v %= 100;
+    *dst++ = (char)('0' + v / 10);
+    *dst++ = (char)('0' + v % 10);
+  }
+  else if (v >= 10)
+  {
+    *dst++ = (char)('0' + v / 10);
+    *dst++ = (char)('0' + v % 10);
+  }
+  else
+    *dst++ = (char)('0' + v);
+  return dst;
+}
+
+// 与 printf("%.6f") 再去掉末尾 0 与小数点的结果逐字节一致（如 0.597263、1、-0）。
+// |x| < 1e4 且第 7 位小数不接近 .5 时走整数快速路径；其余情况退回 snprintf。
+static inline char *css_format_fixed6(char *dst, double x)
+{
+  double ax = x < 0.0 ? -x : x;
+  double y = ax * 1e6;
+  uint64_t m = (uint64_t)y;
+  double frac = y - (double)m;
+  if (!(ax < 1e4) || (frac > 0.5 - 1e-5 && frac < 0.5 + 1e-5))
+  {
+    char buf[64];
+    int n = snprintf(buf, sizeof buf, "%.6f", x);
+    while (n > 0 && buf[n - 1] == '0')
+      n--;
+    if (n > 0 && buf[n - 1] == '.')
+      n--;
+    memcpy(dst, buf, (size_t)n);
+    return dst + n;
+  }
+  if (frac > 0.5)
+    m++;
+  if (x < 0.0)
+    *dst++ = '-';
+  uint64_t ip = m / 1000000, fp = m % 1000000;
+  char tmp[20];
+  int k = 0;
+  do
+  {
+    tmp[k++] = (char)('0' + ip % 10);
+    ip /= 10;
+  } while (ip);
+  while (k)
+    *dst++ = tmp[--k];
+  if (fp)
+  {
+    *dst++ = '.';
+    char d[6];
+    for (int i = 5; i >= 0; --i)
+    {
+      d[i] = (char)('0' + fp % 10);
+      fp /= 10;
+    }
+    int n = 6;
+    while (d[n - 1] == '0')
+      n--;
+    memcpy(dst, d, (size_t)n);
+    dst += n;
+  }
+  return dst;
+}
+
+// "oklch(L C h)"，alpha < 1 时为 "oklch(L C h / a)"；数字格式同 css_format_fixed6
+static inline char *css_format_oklch(char *dst, double L, double C, double h, double alpha)
+{
+  memcpy(dst, "oklch(", 6);
+  dst += 6;
+  dst = css_format_fixed6(dst, L);
+  *dst++ = ' ';
+  dst = css_format_fixed6(dst, C);
+  *dst++ = ' ';
+  dst = css_format_fixed6(dst, h);
+  if (alpha < 1.0)
+  {
+    memcpy(dst, " / ", 3);
+    dst = css_format_fixed6(dst + 3, alpha);
+  }
+  *dst++ = ')';
+  return dst;
+}
+
+// ---- 批量模式驱动（oklch2rgb / rgb2oklch 的 --batch 共用）----
+// stdin 每行一个颜色：空行跳过，其余交给 parse 解析进第 slot 个槽位；攒满 chunk 个或读到 EOF 时
+// 调用 flush 整块转换并写出。解析失败时报告行号与期望格式 expect，返回 1；成功返回 0
+typedef int (*CssBatchParseFn)(void *ctx, const char *p, const char *end, size_t slot);
+typedef void (*CssBatchFlushFn)(void *ctx, size_t n);
+
+static inline int css_run_batch(size_t chunk, CssBatchParseFn parse, CssBatchFlushFn flush, void *ctx,
+                                const char *expect)
+{
+  char line[512];
+  size_t n = 0;
+  long lineno = 0;
+  int eof = 0;
+  while (!eof)
+  {
+    eof = fgets(line, sizeof line, stdin) == NULL;
+    if (!eof)
+    {
+      lineno++;
+      const char *end = line + strlen(line);
+      const char *p = css_skip_space(line, end);
+      if (p == end)
+        continue;
+      if (!parse(ctx, p, end, n))
+      {
+        fprintf(stderr, "Failed to parse line %ld. Expect: %s\n", lineno, expect);
+        return 1;
+      }
+      if (++n < chunk)
+        continue;
+    }
+    flush(ctx, n);
+    n = 0;
+  }
+  return 0;
+}
+
+#endif // OKCOLOR_CSS_COLOR_H
@@ -14,19 +14,28 @@
 //   extract-colors <image_path>
 //       [--pixels N] [--distance D]
 //       [--saturationDistance S] [--lightnessDistance L] [--hueDistance H]
-//       [--alphaThreshold A] [--maxColors K]
+//       [--alphaThreshold A] [--maxColors K] [--deadline US] [--frame N] [--all-k]
+//   <image_path> 以 .y4m 结尾时直接从该帧的 YUV 平面取色（不转 RGBA）
+//   调色板 PNG / GIF 等索引色图直接统计调色板下标（不转 RGBA）
+//   --all-k 一次输出 K = 1..maxColors 的全部调色板（层次聚类，各 K 相互嵌套）
 // 默认值与 extract-colors 的行为大体一致：
 //   pixels=64000，distance=0.22，saturationDistance=0.2，
 //   lightnessDistance=0.2，hueDistance=0.083333333（约 30°），
 //   alphaThreshold=250，maxColors=16
 //
 // 在 macOS 上构建：
-//   clang -O2 extract-colors.c -o extract-colors \
-//     -framework ImageIO -framework CoreGraphics -framework CoreFoundation
+//   clang -O2 extract-colors.c -o extract-colors -framework ImageIO -framework CoreGraphics -framework CoreFoundation
 //
 // 说明：独立实现，仅参考其设计与输出格式。
 
-#ifndef __EMSCRIPTEN__
+// 渐进取色的计时用到 clock_gettime；-std=c11 下 glibc 需显式打开
+#if !defined(__APPLE__) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+// 仅原生 CLI 需要 ImageIO 读图；Wasm 与嵌入（OKCOLOR_EMBED）构建直接接收 RGBA 像素
+#if !defined(__EMSCRIPTEN__) && !defined(OKCOLOR_EMBED)
+#define EC_WITH_IMAGEIO 1
 #include <CoreFoundation/CoreFoundation.h>
 #include <CoreGraphics/CoreGraphics.h>
 #include <ImageIO/ImageIO.h>
@@ -38,6 +47,8 @@
 #include <string.h>
 #include <math.h>
 #include <time.h>
+#include <stdatomic.h>
+#include <limits.h>
 
 // 微优化辅助宏：分支预测与内联提示
 #ifndef LIKELY
@@ -56,6 +67,10 @@
 #include <omp.h>
 #endif
 
+#ifdef OKCOLOR_EMBED
+#include "okcolor.h"
+#endif
+
 typedef struct
 {
   int pixels;         // 目标样本像素预算
@@ -72,6 +87,12 @@ typedef struct
   int width;
   int height;
   uint8_t *rgba; // RGBA8，行优先，步长 stride = width*4
+  // 索引色图（rgba 为 NULL）：indices 每像素 indexBits 位，palette 为 paletteSize 项 RGBA8
+  uint8_t *indices;
+  size_t indexStride;
+  int indexBits;
+  int paletteSize;
+  uint8_t palette[256 * 4];
 } Image;
 
 typedef struct
@@ -103,25 +124,79 @@ static INLINE double clampd(double x, double lo, double hi)
 }
 
 // 0..255 -> 0..1 的查表，减少标量乘法（在采样热点中收益明显，尤其是 Wasm）
+// 线程安全的一次性初始化：0=未初始化，1=填表中，2=已发布（CAS 成功者填表，其余自旋等待）
 static float g_u8_to_f32_01[256];
-static int g_u8_lut_inited = 0;
+static atomic_int g_u8_lut_state = 0;
 static INLINE void ensure_u8_lut(void)
 {
-  if (LIKELY(g_u8_lut_inited))
+  if (LIKELY(atomic_load_explicit(&g_u8_lut_state, memory_order_acquire) == 2))
     return;
+  int expected = 0;
+  if (!atomic_compare_exchange_strong_explicit(&g_u8_lut_state, &expected, 1, memory_order_acquire,
+                                               memory_order_acquire))
+  {
+    while (atomic_load_explicit(&g_u8_lut_state, memory_order_acquire) != 2)
+      ;
+    return;
+  }
   for (int i = 0; i < 256; ++i)
     g_u8_to_f32_01[i] = (float)i * (1.0f / 255.0f);
-  // 写屏障对 Wasm 单线程不是必须；此处仅作为语义标记
-  g_u8_lut_inited = 1;
+  atomic_store_explicit(&g_u8_lut_state, 2, memory_order_release);
 }
 
-static int load_image_rgba8(const char *path, Image *out)
+#ifdef EC_WITH_IMAGEIO
+// 索引色图（PNG 调色板 / GIF）保留原始下标与色表，取色时只统计下标；
+// 带 alpha / decode 数组、或色表的基础色彩空间不是 RGB 时返回 0，由调用方按 RGBA 绘制。
+// 色表按 sRGB 解释（调色板 PNG / GIF 通常未标注或标注为 sRGB）
+static int load_image_indices(CGImageRef img, Image *out)
+{
+  CGColorSpaceRef ics = CGImageGetColorSpace(img);
+  if (!ics || CGColorSpaceGetModel(ics) != kCGColorSpaceModelIndexed)
+    return 0;
+  CGColorSpaceRef base = CGColorSpaceGetBaseColorSpace(ics);
+  size_t n = CGColorSpaceGetColorTableCount(ics);
+  size_t bits = CGImageGetBitsPerPixel(img);
+  if (!base || CGColorSpaceGetModel(base) != kCGColorSpaceModelRGB || n == 0 || n > 256 ||
+      CGImageGetAlphaInfo(img) != kCGImageAlphaNone || CGImageGetDecode(img) != NULL ||
+      CGImageGetBitsPerComponent(img) != bits || (bits != 1 && bits != 2 && bits != 4 && bits != 8))
+    return 0;
+
+  size_t w = CGImageGetWidth(img), h = CGImageGetHeight(img);
+  size_t stride = CGImageGetBytesPerRow(img);
+  CFDataRef data = CGDataProviderCopyData(CGImageGetDataProvider(img));
+  if (!data)
+    return 0;
+  size_t need = stride * (h - 1) + (w * bits + 7) / 8;
+  uint8_t *idx = NULL;
+  if ((size_t)CFDataGetLength(data) >= need && (idx = (uint8_t *)malloc(need)) != NULL)
+    memcpy(idx, CFDataGetBytePtr(data), need);
+  CFRelease(data);
+  if (!idx)
+    return 0;
+
+  uint8_t table[256 * 3];
+  CGColorSpaceGetColorTable(ics, table);
+  for (size_t i = 0; i < n; ++i)
+  {
+    out->palette[i * 4 + 0] = table[i * 3 + 0];
+    out->palette[i * 4 + 1] = table[i * 3 + 1];
+    out->palette[i * 4 + 2] = table[i * 3 + 2];
+    out->palette[i * 4 + 3] = 255;
+  }
+  out->width = (int)w;
+  out->height = (int)h;
+  out->indices = idx;
+  out->indexStride = stride;
+  out->indexBits = (int)bits;
+  out->paletteSize = (int)n;
+  return 1;
+}
+#endif
+
+#ifdef EC_WITH_IMAGEIO
+// 读图：索引色图保留下标（见 load_image_indices），其余绘制为 RGBA8（仅原生 CLI）
+static int load_image(const char *path, Image *out)
 {
-#ifdef __EMSCRIPTEN__
-  (void)path;
-  (void)out;
-  return 0; // 在 WebAssembly 中不提供文件加载
-#else
   memset(out, 0, sizeof(*out));
   CFStringRef cfPath = CFStringCreateWithCString(NULL, path, kCFStringEncodingUTF8);
   if (!cfPath)
@@ -148,6 +223,11 @@ static int load_image_rgba8(const char *path, Image *out)
     CGImageRelease(img);
     return 0;
   }
+  if (load_image_indices(img, out))
+  {
+    CGImageRelease(img);
+    return 1;
+  }
 
   CGColorSpaceRef cs = CGColorSpaceCreateWithName(kCGColorSpaceSRGB);
   if (!cs)
@@ -185,17 +265,18 @@ static int load_image_rgba8(const char *path, Image *out)
     CGColorSpaceRelease(cs);
   CGImageRelease(img);
   return 1;
-#endif
 }
 
 static void free_image(Image *im)
 {
-  if (im && im->rgba)
-  {
-    free(im->rgba);
-    im->rgba = NULL;
-  }
+  if (!im)
+    return;
+  free(im->rgba);
+  free(im->indices);
+  im->rgba = NULL;
+  im->indices = NULL;
 }
+#endif
 
 // 将 RGB（0..1）转换为 H、S、L（0..1）。Hue ∈ [0,1)，S/L ∈ [0,1]。
 static INLINE void rgb_to_hsl(double r, double g, double b, double *h, double *s, double *l)
@@ -284,22 +365,14 @@ static INLINE float qlev_to_unit(unsigned q)
   return (float)q * (1.0f / (float)(EC_QLEVELS - 1));
 }
 
-// 构建量化直方图并导出「带权样本」
-// 输出：
-//   *outSamples: RGBf 数组（量化后映射回 0..1）
-//   *outWeights: 每个样本的权重（像素计数，float）
-//   返回样本数 n（非零桶数量）
-static int build_quantized_weighted_samples(const uint8_t *rgba, int w, int h, int step, int alphaThreshold,
-                                            RGBf **outSamples, float **outWeights)
+// 将 rows 行（行距 rowStride 字节）按列步长 step 采样并累加到量化直方图 counts。
+// 可分块多次调用：大图可按行带分批喂入，无需整图常驻内存。
+static void hist_accumulate_rows(unsigned *restrict counts, const uint8_t *rgba, int w, int rows,
+                                 size_t rowStride, int rowStep, int step, int alphaThreshold)
 {
-  // 计数数组（栈上可能过大，放到堆上）
-  unsigned *counts = (unsigned *)calloc((size_t)EC_QSIZE, sizeof(unsigned));
-  if (!counts)
-    return 0;
-
-  for (int y = 0; y < h; y += step)
+  for (int y = 0; y < rows; y += rowStep)
   {
-    const uint8_t *row = rgba + (size_t)y * (size_t)w * 4;
+    const uint8_t *row = rgba + (size_t)y * rowStride;
     for (int x = 0; x < w; x += step)
     {
       const uint8_t *p = row + (size_t)x * 4;
@@ -314,7 +387,15 @@ static int build_quantized_weighted_samples(const uint8_t *rgba, int w, int h, i
       counts[idx]++;
     }
   }
+}
 
+// 从量化直方图导出「带权样本」
+// 输出：
+//   *outSamples: RGBf 数组（量化后映射回 0..1）
+//   *outWeights: 每个样本的权重（像素计数，float）
+//   返回样本数 n（非零桶数量，空直方图为 0）；内存不足返回 -1
+static int hist_export_weighted_samples(const unsigned *counts, RGBf **outSamples, float **outWeights)
+{
   // 统计非零桶数
   int m = 0;
   for (int i = 0; i < EC_QSIZE; ++i)
@@ -323,7 +404,6 @@ static int build_quantized_weighted_samples(const uint8_t *rgba, int w, int h, i
 
   if (m == 0)
   {
-    free(counts);
     *outSamples = NULL;
     *outWeights = NULL;
     return 0;
@@ -337,8 +417,7 @@ static int build_quantized_weighted_samples(const uint8_t *rgba, int w, int h, i
       free(samples);
     if (weights)
       free(weights);
-    free(counts);
-    return 0;
+    return -1;
   }
 
   // 导出非零桶：解码量化级并映射到 0..1
@@ -358,72 +437,263 @@ static int build_quantized_weighted_samples(const uint8_t *rgba, int w, int h, i
     j++;
   }
 
-  free(counts);
   *outSamples = samples;
   *outWeights = weights;
   return m;
 }
 
-// KMeans++ 初始化：先随机一个中心，再按距离平方加权挑选其余中心
-static void kmeans_pp_init(const RGBf *restrict samples, int n, Cluster *restrict clusters, int K)
+// 构建量化直方图并导出「带权样本」（整图一次性版本）；返回值同上，内存不足返回 -1
+static int build_quantized_weighted_samples(const uint8_t *rgba, int w, int h, int step, int alphaThreshold,
+                                            RGBf **outSamples, float **outWeights)
 {
-  if (n <= 0 || K <= 0)
-    return;
-  int first = rand() % n;
-  clusters[0].color = samples[first];
-  clusters[0].weight = 0.0;
-  double *dist2 = (double *)malloc((size_t)n * sizeof(double));
-  if (!dist2)
+  // 计数数组（栈上可能过大，放到堆上）
+  unsigned *counts = (unsigned *)calloc((size_t)EC_QSIZE, sizeof(unsigned));
+  if (!counts)
+    return -1;
+  hist_accumulate_rows(counts, rgba, w, h, (size_t)w * 4, step, step, alphaThreshold);
+  int m = hist_export_weighted_samples(counts, outSamples, outWeights);
+  free(counts);
+  return m;
+}
+
+// ---- YUV 帧直接取色：只换算被采样到的像素，不生成整幅 RGBA ----
+// 格式：I420 / I422 / I444 为三个平面，NV12 为 Y 平面 + UV 交错平面，GRAY 只有 Y（色度按 128）。
+// 色度取 (x >> cshift_x, y >> cshift_y) 处的最近样本；YUV 没有 alpha，所有采样像素都计入。
+enum
+{
+  YUV_I420 = 0,
+  YUV_NV12 = 1,
+  YUV_I422 = 2,
+  YUV_I444 = 3,
+  YUV_GRAY = 4,
+  YUV_FORMAT_COUNT
+};
+#define YUV_BT709 1      // 否则 BT.601
+#define YUV_FULL_RANGE 2 // 否则 limited（Y 16..235，UV 16..240）
+
+typedef struct
+{
+  const uint8_t *y, *u, *v; // NV12 时 u 指向 UV 交错平面、v = u + 1；GRAY 时 u = v = NULL
+  size_t ystride, cstride;
+  int cstep;              // 同一色度平面相邻样本的字节间距（平面 1，NV12 为 2）
+  int cshift_x, cshift_y; // 色度二次采样（4:2:0 为 1, 1）
+  int width, height;
+} YuvFrame;
+
+// YUV -> 8 位 RGB 的定点（16.16）查表：R = Y' + rv[V]，G = Y' + gu[U] + gv[V]，B = Y' + bu[U]，
+// y 表已含 0.5 的舍入偏置；每次调用在栈上建表（5 KB，约 1 µs），无全局状态
+typedef struct
+{
+  int32_t y[256], rv[256], gu[256], gv[256], bu[256];
+} YuvTables;
+
+static void yuv_tables_init(YuvTables *t, int flags)
+{
+  double kr = (flags & YUV_BT709) ? 0.2126 : 0.299;
+  double kb = (flags & YUV_BT709) ? 0.0722 : 0.114;
+  double kg = 1.0 - kr - kb;
+  int full = (flags & YUV_FULL_RANGE) != 0;
+  for (int i = 0; i < 256; ++i)
   {
-    for (int k = 1; k < K; ++k)
+    double yv = full ? (double)i : ((double)i - 16.0) * (255.0 / 219.0);
+    double c = full ? (double)i - 128.0 : ((double)i - 128.0) * (255.0 / 224.0);
+    t->y[i] = (int32_t)lround(yv * 65536.0) + 32768;
+    t->rv[i] = (int32_t)lround(2.0 * (1.0 - kr) * c * 65536.0);
+    t->gu[i] = (int32_t)lround(-2.0 * kb * (1.0 - kb) / kg * c * 65536.0);
+    t->gv[i] = (int32_t)lround(-2.0 * kr * (1.0 - kr) / kg * c * 65536.0);
+    t->bu[i] = (int32_t)lround(2.0 * (1.0 - kb) * c * 65536.0);
+  }
+}
+
+static INLINE unsigned yuv_fixed_to_u8(int32_t v)
+{
+  v = v < 0 ? 0 : v > (255 << 16) ? (255 << 16) : v;
+  return (unsigned)v >> 16;
+}
+
+// 按 YUV 格式填写平面布局（y/u/v 指针与步长由调用方填写）；格式无效返回 0
+static int yuv_frame_layout(YuvFrame *f, int format)
+{
+  switch (format)
+  {
+  case YUV_I420:
+  case YUV_NV12:
+    f->cshift_x = f->cshift_y = 1;
+    break;
+  case YUV_I422:
+    f->cshift_x = 1;
+    f->cshift_y = 0;
+    break;
+  case YUV_I444:
+  case YUV_GRAY:
+    f->cshift_x = f->cshift_y = 0;
+    break;
+  default:
+    return 0;
+  }
+  f->cstep = format == YUV_NV12 ? 2 : 1;
+  if (format == YUV_NV12)
+    f->v = f->u + 1;
+  if (format == YUV_GRAY)
+    f->u = f->v = NULL;
+  return 1;
+}
+
+// 同 hist_accumulate_rows：对 [y0, y0 + rows) 行按 rowStep / step 采样，逐点换算为 8 位 RGB 后累加。
+// 结果与先按同一公式转成 RGBA 再取色完全一致，但只读取被采样的 Y 与对应色度字节
+static void hist_accumulate_yuv(unsigned *restrict counts, const YuvFrame *f, const YuvTables *t, int y0, int rows,
+                                int rowStep, int step)
+{
+  for (int y = y0; y < y0 + rows; y += rowStep)
+  {
+    const uint8_t *yr = f->y + (size_t)y * f->ystride;
+    const uint8_t *ur = f->u ? f->u + (size_t)(y >> f->cshift_y) * f->cstride : NULL;
+    const uint8_t *vr = f->u ? f->v + (size_t)(y >> f->cshift_y) * f->cstride : NULL;
+    for (int x = 0; x < f->width; x += step)
     {
-      clusters[k].color = samples[rand() % n];
-      clusters[k].weight = 0.0;
+      int32_t yy = t->y[yr[x]];
+      unsigned r, g, b;
+      if (ur)
+      {
+        size_t c = (size_t)(x >> f->cshift_x) * f->cstep;
+        unsigned u = ur[c], v = vr[c];
+        r = yuv_fixed_to_u8(yy + t->rv[v]);
+        g = yuv_fixed_to_u8(yy + t->gu[u] + t->gv[v]);
+        b = yuv_fixed_to_u8(yy + t->bu[u]);
+      }
+      else
+        r = g = b = yuv_fixed_to_u8(yy);
+      unsigned idx = (q8_to_qlev(r) << (EC_QBITS * 2)) | (q8_to_qlev(g) << EC_QBITS) | q8_to_qlev(b);
+      counts[idx]++;
     }
-    return;
   }
-  for (int i = 0; i < n; ++i)
-    dist2[i] = rgb_dist2_raw(samples[i], clusters[0].color);
-  for (int k = 1; k < K; ++k)
+}
+
+// ---- 索引色图（PNG 调色板 / GIF）直接取色 ----
+// 每个像素都是 ≤256 色调色板中的一项：采样时只统计下标（256 个计数），
+// 再把用到的调色板项放进与 RGBA 路径相同的量化桶，省去整图展开与 32768 桶的扫描。
+#define EC_MAX_PALETTE 256
+
+static INLINE int indexed_bits_valid(int bits)
+{
+  return bits == 1 || bits == 2 || bits == 4 || bits == 8;
+}
+
+// 同 hist_accumulate_rows 的采样网格；bits < 8 时一字节内高位在前（同 PNG）
+static void hist_accumulate_indexed(unsigned *restrict counts, const uint8_t *indices, int w, int rows,
+                                    size_t rowStride, int bits, int rowStep, int step)
+{
+  unsigned mask = (1u << bits) - 1;
+  for (int y = 0; y < rows; y += rowStep)
   {
-    double sum = 0.0;
-    for (int i = 0; i < n; ++i)
-      sum += dist2[i];
-    if (sum <= 0)
+    const uint8_t *row = indices + (size_t)y * rowStride;
+    if (bits == 8)
     {
-      clusters[k].color = samples[rand() % n];
-      clusters[k].weight = 0.0;
+      for (int x = 0; x < w; x += step)
+        counts[row[x]]++;
       continue;
     }
-    double r = ((double)rand() / (double)RAND_MAX) * sum, acc = 0.0;
-    int idx = 0;
-    for (int i = 0; i < n; ++i)
-    {
-      acc += dist2[i];
-      if (acc >= r)
-      {
-        idx = i;
-        break;
-      }
-    }
-    clusters[k].color = samples[idx];
-    clusters[k].weight = 0.0;
-    for (int i = 0; i < n; ++i)
+    for (int x = 0; x < w; x += step)
     {
-      double d = rgb_dist2_raw(samples[i], clusters[k].color);
-      if (d < dist2[i])
-        dist2[i] = d;
+      size_t bit = (size_t)x * (size_t)bits;
+      counts[(row[bit >> 3] >> (8 - bits - (int)(bit & 7))) & mask]++;
     }
   }
-  free(dist2);
 }
 
+// 由下标计数导出带权样本：落入同一量化桶的调色板项合并，样本按桶号升序排列，
+// 与 hist_export_weighted_samples 对展开后的直方图给出的样本完全相同；内存不足返回 -1
+static int indexed_export_weighted_samples(const unsigned *counts, const uint8_t *palette, int paletteSize,
+                                           int alphaThreshold, RGBf **outSamples, float **outWeights)
+{
+  uint32_t keys[EC_MAX_PALETTE]; // (桶号 << 8) | 下标
+  int n = 0;
+  for (int i = 0; i < paletteSize; ++i)
+  {
+    const uint8_t *p = palette + (size_t)i * 4;
+    if (!counts[i] || p[3] <= (unsigned)alphaThreshold)
+      continue;
+    uint32_t q = (q8_to_qlev(p[0]) << (EC_QBITS * 2)) | (q8_to_qlev(p[1]) << EC_QBITS) | q8_to_qlev(p[2]);
+    uint32_t key = (q << 8) | (uint32_t)i;
+    int j = n++;
+    for (; j > 0 && keys[j - 1] > key; --j) // 插入排序：项数很少
+      keys[j] = keys[j - 1];
+    keys[j] = key;
+  }
+  *outSamples = NULL;
+  *outWeights = NULL;
+  if (n == 0)
+    return 0;
+
+  RGBf *samples = (RGBf *)malloc((size_t)n * sizeof(RGBf));
+  float *weights = (float *)malloc((size_t)n * sizeof(float));
+  if (!samples || !weights)
+  {
+    free(samples);
+    free(weights);
+    return -1;
+  }
+  int m = 0;
+  for (int j = 0; j < n;)
+  {
+    uint32_t q = keys[j] >> 8;
+    unsigned c = 0;
+    for (; j < n && (keys[j] >> 8) == q; ++j)
+      c += counts[keys[j] & 0xFF];
+    samples[m].r = qlev_to_unit((q >> (EC_QBITS * 2)) & (EC_QLEVELS - 1));
+    samples[m].g = qlev_to_unit((q >> EC_QBITS) & (EC_QLEVELS - 1));
+    samples[m].b = qlev_to_unit(q & (EC_QLEVELS - 1));
+    weights[m] = (float)c;
+    m++;
+  }
+  *outSamples = samples;
+  *outWeights = weights;
+  return m;
+}
+
+// 每次调用独立的 PRNG 状态（xorshift32），不依赖全局 rand()/srand()，可重入
+typedef struct
+{
+  uint32_t s;
+} EcRng;
+
+static INLINE void ec_rng_seed(EcRng *rng, uint32_t seed)
+{
+  rng->s = seed * 2654435761u + 0x9E3779B9u;
+  if (!rng->s)
+    rng->s = 1;
+}
+
+static INLINE uint32_t ec_rng_next(EcRng *rng)
+{
+  uint32_t x = rng->s;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  rng->s = x;
+  return x;
+}
+
+// [0, n)
+static INLINE int ec_rng_below(EcRng *rng, int n)
+{
+  return (int)(ec_rng_next(rng) % (uint32_t)n);
+}
+
+// [0, 1]
+static INLINE double ec_rng_unit(EcRng *rng)
+{
+  return (double)ec_rng_next(rng) * (1.0 / 4294967295.0);
+}
+
+// KMeans++ 初始化：先随机一个中心，再按（样本权重 × 距离平方）加权挑选其余中心；
+// 内存不足时退化为随机挑选
 static void kmeans_pp_init_weighted(const RGBf *restrict samples, const float *restrict wts, int n,
-                                    Cluster *restrict clusters, int K)
+                                    Cluster *restrict clusters, int K, EcRng *rng)
 {
   if (n <= 0 || K <= 0)
     return;
-  int first = rand() % n;
+  int first = ec_rng_below(rng, n);
   clusters[0].color = samples[first];
   clusters[0].weight = 0.0;
   double *dist2 = (double *)malloc((size_t)n * sizeof(double));
@@ -431,7 +701,7 @@ static void kmeans_pp_init_weighted(const RGBf *restrict samples, const float *r
   {
     for (int k = 1; k < K; ++k)
     {
-      clusters[k].color = samples[rand() % n];
+      clusters[k].color = samples[ec_rng_below(rng, n)];
       clusters[k].weight = 0.0;
     }
     return;
@@ -445,11 +715,11 @@ static void kmeans_pp_init_weighted(const RGBf *restrict samples, const float *r
       sum += (double)wts[i] * dist2[i];
     if (sum <= 0)
     {
-      clusters[k].color = samples[rand() % n];
+      clusters[k].color = samples[ec_rng_below(rng, n)];
       clusters[k].weight = 0.0;
       continue;
     }
-    double r = ((double)rand() / (double)RAND_MAX) * sum, acc = 0.0;
+    double r = ec_rng_unit(rng) * sum, acc = 0.0;
     int idx = 0;
     for (int i = 0; i < n; ++i)
     {
@@ -472,14 +742,15 @@ static void kmeans_pp_init_weighted(const RGBf *restrict samples, const float *r
   free(dist2);
 }
 
-static void kmeans_run_weighted(const RGBf *restrict samples, const float *restrict wts,
-                                int n, Cluster *restrict clusters, int K, int iters)
+// 带权 Lloyd 迭代；内存不足返回 0（簇未更新，权重不可用）
+static int kmeans_run_weighted(const RGBf *restrict samples, const float *restrict wts,
+                               int n, Cluster *restrict clusters, int K, int iters)
 {
   if (n <= 0 || K <= 0)
-    return;
+    return 1;
   int *assign = (int *)malloc((size_t)n * sizeof(int));
   if (!assign)
-    return;
+    return 0;
   for (int i = 0; i < n; ++i)
     assign[i] = -1;
   float *sr = (float *)calloc((size_t)K, sizeof(float));
@@ -498,7 +769,7 @@ static void kmeans_run_weighted(const RGBf *restrict samples, const float *restr
     if (sb)
       free(sb);
     free(assign);
-    return;
+    return 0;
   }
   if (!cr || !cg || !cb || !bestd2)
   {
@@ -514,7 +785,7 @@ static void kmeans_run_weighted(const RGBf *restrict samples, const float *restr
     free(sg);
     free(sb);
     free(assign);
-    return;
+    return 0;
   }
   for (int k = 0; k < K; ++k)
   {
@@ -658,6 +929,7 @@ static void kmeans_run_weighted(const RGBf *restrict samples, const float *restr
   free(cb);
   free(bestd2);
   free(assign);
+  return 1;
 }
 
 static int cmp_cluster_weight_desc(const void *a, const void *b)
@@ -671,13 +943,22 @@ static int cmp_cluster_weight_desc(const void *a, const void *b)
   return 0;
 }
 
-static void merge_colors(const Cluster *clusters, int K, double totalWeight, const Options *opt,
-                         ColorAgg **outArr, int *outN)
+static int merge_colors(const Cluster *clusters, int K, double totalWeight, const Options *opt,
+                        ColorAgg **outArr, int *outN)
 {
-  Cluster *sorted = (Cluster *)malloc((size_t)K * sizeof(Cluster));
+  Cluster *sorted = (Cluster *)malloc((size_t)(K > 0 ? K : 1) * sizeof(Cluster));
+  ColorAgg *acc = (ColorAgg *)malloc((size_t)(K > 0 ? K : 1) * sizeof(ColorAgg));
+  if (!sorted || !acc)
+  {
+    // 内存不足：*outArr 为 NULL，返回 0
+    free(sorted);
+    free(acc);
+    *outArr = NULL;
+    *outN = 0;
+    return 0;
+  }
   memcpy(sorted, clusters, (size_t)K * sizeof(Cluster));
   qsort(sorted, (size_t)K, sizeof(Cluster), cmp_cluster_weight_desc);
-  ColorAgg *acc = (ColorAgg *)malloc((size_t)K * sizeof(ColorAgg));
   int m = 0;
   const double rgb_thresh2 = opt->distance * opt->distance * 3.0;
   for (int i = 0; i < K; ++i)
@@ -722,8 +1003,10 @@ static void merge_colors(const Cluster *clusters, int K, double totalWeight, con
     acc[i].weight = (totalWeight > 0.0) ? (acc[i].weight / totalWeight) : 0.0;
   *outArr = acc;
   *outN = m;
+  return 1;
 }
 
+#ifdef EC_WITH_IMAGEIO
 static void print_hex_from_rgb(uint8_t r, uint8_t g, uint8_t b)
 {
   static const char *hex = "0123456789abcdef";
@@ -737,108 +1020,977 @@ static void print_hex_from_rgb(uint8_t r, uint8_t g, uint8_t b)
   buf[6] = '\0';
   printf("\"#%s\"", buf);
 }
+#endif
 
-// 从原始 RGBA 像素缓冲与尺寸进行取色（核心逻辑）
-static int extract_colors_core(const uint8_t *rgba, int w, int h, const Options *opt,
-                               ColorAgg **outAgg, int *outM)
+// 子采样步长：使采样点数量约等于 pixels
+static int compute_sample_step(int w, int h, int pixels)
 {
-  const uint8_t *px = rgba;
-  if (w <= 0 || h <= 0 || !px || !outAgg || !outM)
-    return 0;
-
-  // 确保 LUT 初始化
-  ensure_u8_lut();
-
-  // 子采样步长：使采样点数量约等于 opt->pixels
   long long total = (long long)w * (long long)h;
   int step = 1;
-  if (total > opt->pixels && opt->pixels > 0)
+  if (total > pixels && pixels > 0)
   {
-    double ratio = sqrt((double)total / (double)opt->pixels);
+    double ratio = sqrt((double)total / (double)pixels);
     step = (int)ceil(ratio);
     if (step < 1)
       step = 1;
   }
+  return step;
+}
 
-  // 使用量化直方图构建「带权样本」
-  RGBf *samples = NULL;
-  float *weights = NULL;
-  int n = build_quantized_weighted_samples(px, w, h, step, opt->alphaThreshold, &samples, &weights);
+// 实际聚类数：maxColors 截断到样本数，至少 1
+static INLINE int cluster_count(int n, int maxColors)
+{
+  int K = maxColors;
+  if (K > n)
+    K = n;
+  return K > 0 ? K : 1;
+}
+
+// 聚类阶段：K-Means++ 初始化 + 12 次迭代，返回各簇总权重；内存不足返回 -1
+static double kmeans_cluster(const RGBf *samples, const float *weights, int n, Cluster *clusters, int K)
+{
+  EcRng rng;
+  ec_rng_seed(&rng, (uint32_t)time(NULL));
+  kmeans_pp_init_weighted(samples, weights, n, clusters, K, &rng);
+  if (!kmeans_run_weighted(samples, weights, n, clusters, K, 12))
+    return -1.0;
+  double totalW = 0.0;
+  for (int k = 0; k < K; ++k)
+    totalW += clusters[k].weight;
+  return totalW;
+}
+
+// 由带权样本聚类并合并（接管 samples/weights 的所有权）；n < 0 表示导出样本时内存不足，返回 0
+static int cluster_weighted_samples(RGBf *samples, float *weights, int n, const Options *opt,
+                                    ColorAgg **outAgg, int *outM)
+{
   if (n <= 0)
   {
     *outAgg = NULL;
     *outM = 0;
-    return 1;
+    return n == 0;
   }
 
-  int K = opt->maxColors;
-  if (K > n)
-    K = n;
-  if (K <= 0)
-    K = 1;
+  int K = cluster_count(n, opt->maxColors);
   Cluster *clusters = (Cluster *)malloc((size_t)K * sizeof(Cluster));
   if (!clusters)
   {
     free(samples);
+    free(weights);
     return 0;
   }
 
-  srand((unsigned int)time(NULL));
-  kmeans_pp_init_weighted(samples, weights, n, clusters, K);
-  kmeans_run_weighted(samples, weights, n, clusters, K, 12);
-
-  double totalW = 0.0;
-  for (int k = 0; k < K; ++k)
-    totalW += clusters[k].weight;
+  double totalW = kmeans_cluster(samples, weights, n, clusters, K);
   ColorAgg *agg = NULL;
   int m = 0;
-  merge_colors(clusters, K, totalW, opt, &agg, &m);
+  int ok = totalW >= 0.0 && merge_colors(clusters, K, totalW, opt, &agg, &m);
 
   free(samples);
   free(weights);
   free(clusters);
   *outAgg = agg;
   *outM = m;
-  return 1;
+  return ok;
 }
 
-#ifndef __EMSCRIPTEN__
-// 从 Image 取色并输出 JSON（原生 CLI 用）
-static int extract_colors_from_image(const Image *im, const Options *opt)
+// 从原始 RGBA 像素缓冲与尺寸进行取色（核心逻辑）
+static int extract_colors_core(const uint8_t *rgba, int w, int h, const Options *opt,
+                               ColorAgg **outAgg, int *outM)
 {
-  ColorAgg *agg = NULL;
-  int m = 0;
-  if (!extract_colors_core(im->rgba, im->width, im->height, opt, &agg, &m))
+  const uint8_t *px = rgba;
+  if (w <= 0 || h <= 0 || !px || !outAgg || !outM)
     return 0;
-  // 输出 JSON 数组
-  printf("[\n");
-  for (int i = 0; i < m; ++i)
-  {
-    RGBf c = agg[i].color;
-    // 直接使用缓存的 HSL，避免重复计算
-    double h_ = agg[i].h, s_ = agg[i].s, l_ = agg[i].l;
-    int R = (int)lround(clampd((double)c.r, 0.0, 1.0) * 255.0);
-    int G = (int)lround(clampd((double)c.g, 0.0, 1.0) * 255.0);
-    int B = (int)lround(clampd((double)c.b, 0.0, 1.0) * 255.0);
-    double intensity = ((double)c.r + (double)c.g + (double)c.b) / 3.0; // 0..1
 
-    printf("  { ");
-    printf("\"hex\": ");
-    print_hex_from_rgb((uint8_t)R, (uint8_t)G, (uint8_t)B);
-    printf(", ");
-    printf("\"red\": %d, \"green\": %d, \"blue\": %d, ", R, G, B);
-    printf("\"hue\": %.10g, ", h_);
-    printf("\"intensity\": %.10g, ", intensity);
-    printf("\"lightness\": %.10g, ", l_);
-    printf("\"saturation\": %.10g, ", s_);
-    printf("\"area\": %.10g ", agg[i].weight);
-    printf("}%s\n", (i + 1 < m) ? "," : "");
-  }
-  printf("]\n");
-  free(agg);
-  return 1;
+  // 确保 LUT 初始化
+  ensure_u8_lut();
+
+  int step = compute_sample_step(w, h, opt->pixels);
+
+  // 使用量化直方图构建「带权样本」
+  RGBf *samples = NULL;
+  float *weights = NULL;
+  int n = build_quantized_weighted_samples(px, w, h, step, opt->alphaThreshold, &samples, &weights);
+  return cluster_weighted_samples(samples, weights, n, opt, outAgg, outM);
 }
-#endif
+
+// 从 YUV 帧取色（流程同 extract_colors_core，直方图由 hist_accumulate_yuv 直接从平面累加）
+static int extract_colors_yuv_core(const YuvFrame *f, int flags, const Options *opt, ColorAgg **outAgg, int *outM)
+{
+  if (f->width <= 0 || f->height <= 0 || !f->y || !outAgg || !outM)
+    return 0;
+  ensure_u8_lut();
+  YuvTables t;
+  yuv_tables_init(&t, flags);
+  unsigned *counts = (unsigned *)calloc((size_t)EC_QSIZE, sizeof(unsigned));
+  if (!counts)
+    return 0;
+  int step = compute_sample_step(f->width, f->height, opt->pixels);
+  hist_accumulate_yuv(counts, f, &t, 0, f->height, step, step);
+  RGBf *samples = NULL;
+  float *weights = NULL;
+  int n = hist_export_weighted_samples(counts, &samples, &weights);
+  free(counts);
+  return cluster_weighted_samples(samples, weights, n, opt, outAgg, outM);
+}
+
+// 从索引色图取色：palette 为 paletteSize 项 RGBA8，越界下标不计入
+static int extract_colors_indexed_core(const uint8_t *indices, int w, int h, size_t stride, int bits,
+                                       const uint8_t *palette, int paletteSize, const Options *opt,
+                                       ColorAgg **outAgg, int *outM)
+{
+  if (w <= 0 || h <= 0 || !indices || !palette || paletteSize <= 0 || paletteSize > EC_MAX_PALETTE ||
+      !indexed_bits_valid(bits) || stride < ((size_t)w * (size_t)bits + 7) / 8 || !outAgg || !outM)
+    return 0;
+  ensure_u8_lut();
+  unsigned counts[EC_MAX_PALETTE] = {0};
+  int step = compute_sample_step(w, h, opt->pixels);
+  hist_accumulate_indexed(counts, indices, w, h, stride, bits, step, step);
+  RGBf *samples = NULL;
+  float *weights = NULL;
+  int n = indexed_export_weighted_samples(counts, palette, paletteSize, opt->alphaThreshold, &samples, &weights);
+  return cluster_weighted_samples(samples, weights, n, opt, outAgg, outM);
+}
+
+// ---- YUV4MPEG2（.y4m）----
+// 流头 "YUV4MPEG2 W<w> H<h> ... [C<色度>] [XCOLORRANGE=FULL|LIMITED]\n"，随后每帧 "FRAME[ 参数]\n" + 平面数据。
+// 支持 8 位的 C420jpeg / C420paldv / C420mpeg2 / C420（缺省）、C422、C444、Cmono；缺省为 limited range。
+// 流头不带矩阵：高度 >= 720 按 BT.709，否则 BT.601（同常见播放器的猜测）
+static int y4m_parse_int(const uint8_t *p, const uint8_t *end)
+{
+  long v = 0;
+  for (; p < end && *p >= '0' && *p <= '9'; ++p)
+    if ((v = v * 10 + (*p - '0')) > (1 << 20))
+      return 0;
+  return (int)v;
+}
+
+// 在内存中的 .y4m 流里定位第 frame 帧（从 0 起），填写 *f 与 *flags；失败返回 0
+static int y4m_read_frame(const uint8_t *data, size_t len, int frame, YuvFrame *f, int *flags)
+{
+  static const char magic[] = "YUV4MPEG2 ";
+  if (len < sizeof magic - 1 || memcmp(data, magic, sizeof magic - 1) != 0 || frame < 0)
+    return 0;
+  const uint8_t *end = data + len;
+  const uint8_t *nl = (const uint8_t *)memchr(data, '\n', len);
+  if (!nl)
+    return 0;
+  int w = 0, h = 0, format = YUV_I420, full = 0;
+  for (const uint8_t *p = data + sizeof magic - 1; p < nl;)
+  {
+    const uint8_t *tok = p;
+    while (p < nl && *p != ' ')
+      p++;
+    size_t n = (size_t)(p - tok);
+    if (n > 1 && tok[0] == 'W')
+      w = y4m_parse_int(tok + 1, p);
+    else if (n > 1 && tok[0] == 'H')
+      h = y4m_parse_int(tok + 1, p);
+    else if (n > 1 && tok[0] == 'C')
+    {
+      if (n >= 4 && memcmp(tok, "C420", 4) == 0 && (n == 4 || tok[4] == 'j' || tok[4] == 'p' || tok[4] == 'm'))
+        format = YUV_I420;
+      else if (n == 4 && memcmp(tok, "C422", 4) == 0)
+        format = YUV_I422;
+      else if (n == 4 && memcmp(tok, "C444", 4) == 0)
+        format = YUV_I444;
+      else if (n == 5 && memcmp(tok, "Cmono", 5) == 0)
+        format = YUV_GRAY;
+      else
+        return 0; // 高位深、带 alpha 等不支持
+    }
+    else if (n == 16 && memcmp(tok, "XCOLORRANGE=FULL", 16) == 0)
+      full = 1;
+    while (p < nl && *p == ' ')
+      p++;
+  }
+  if (w <= 0 || h <= 0 || (uint64_t)w * (uint64_t)h > (uint64_t)len)
+    return 0;
+
+  memset(f, 0, sizeof *f);
+  f->width = w;
+  f->height = h;
+  f->u = f->v = data; // 占位，yuv_frame_layout 只需要格式
+  yuv_frame_layout(f, format);
+  size_t cw = ((size_t)w + (1u << f->cshift_x) - 1) >> f->cshift_x;
+  size_t ch = ((size_t)h + (1u << f->cshift_y) - 1) >> f->cshift_y;
+  size_t ysize = (size_t)w * h, csize = format == YUV_GRAY ? 0 : cw * ch;
+  const uint8_t *p = nl + 1;
+  for (int k = 0;; ++k)
+  {
+    if ((size_t)(end - p) < 5 || memcmp(p, "FRAME", 5) != 0)
+      return 0;
+    const uint8_t *fnl = (const uint8_t *)memchr(p, '\n', (size_t)(end - p));
+    if (!fnl || (size_t)(end - fnl - 1) < ysize + 2 * csize)
+      return 0;
+    p = fnl + 1;
+    if (k == frame)
+      break;
+    p += ysize + 2 * csize;
+  }
+  f->y = p;
+  f->ystride = (size_t)w;
+  if (format != YUV_GRAY)
+  {
+    f->u = p + ysize;
+    f->v = f->u + csize;
+    f->cstride = cw;
+  }
+  *flags = (full ? YUV_FULL_RANGE : 0) | (h >= 720 ? YUV_BT709 : 0);
+  return 1;
+}
+
+// ---- 渐进取色（交互预览）：先用很稀的采样网格快速给出结果，再逐级加密 ----
+// 共 PROG_STAGES 级，第 s 级的采样步长为最终步长（同 extract_colors_core）的 2^(PROG_STAGES-1-s) 倍，
+// 每级只累加新增的网格点，因此末级的直方图与整图流程完全相同。每级都重新聚类并合并：
+// 中间级以上一级的中心热启动、迭代 PROG_ITERS 次；末级迭代次数同整图流程。
+// 调用方给出时间预算（微秒），预计下一级会超时就停下，随时可取目前最好的结果。
+#define PROG_STAGES 4
+#define PROG_ITERS 4
+// 下一级耗时的预估倍数：加密一级样本约为 4 倍，但非零桶（k-means 的规模）增长更慢，
+// 实测中间级约 2 倍、末级（迭代更多）约 3.5 倍；取 4 偏保守，宁可早停也不超预算
+#define PROG_GROWTH 4.0
+
+typedef struct
+{
+  const uint8_t *rgba;
+  int w, h;
+  size_t stride;
+  Options opt;
+  unsigned *counts; // EC_QSIZE 个桶，调用方所有
+  int final_step;
+  int step;         // 已累加的采样步长（0 表示尚未开始）
+  int stage;        // 已完成的级数
+  Cluster *centers; // 上一级的 k-means 中心（热启动）
+  int K;
+  ColorAgg *best; // 最近完成一级的合并结果
+  int best_m;
+  double last_us; // 最近一级的耗时
+  EcRng rng;
+} ProgressiveExtract;
+
+static double ec_now_us(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1e6 + (double)ts.tv_nsec * 1e-3;
+}
+
+// 把采样网格从 coarse 加密到 fine = coarse / 2：只累加新增的网格点
+static void hist_refine_rows(unsigned *restrict counts, const uint8_t *rgba, int w, int h, size_t stride,
+                             int coarse, int fine, int alphaThreshold)
+{
+  for (int y = 0; y < h; y += fine)
+  {
+    const uint8_t *row = rgba + (size_t)y * stride;
+    if (y % coarse)
+      hist_accumulate_rows(counts, row, w, 1, stride, 1, fine, alphaThreshold);
+    else if (fine < w)
+      hist_accumulate_rows(counts, row + (size_t)fine * 4, w - fine, 1, stride, 1, coarse, alphaThreshold);
+  }
+}
+
+static void progressive_release(ProgressiveExtract *pe)
+{
+  free(pe->centers);
+  free(pe->best);
+  pe->centers = NULL;
+  pe->best = NULL;
+  pe->K = pe->best_m = 0;
+}
+
+// counts 由调用方提供（EC_QSIZE 个桶），rgba 在整个会话期间须保持有效
+static int progressive_begin(ProgressiveExtract *pe, unsigned *counts, const uint8_t *rgba, int w, int h,
+                             size_t stride, const Options *opt)
+{
+  progressive_release(pe);
+  if (w <= 0 || h <= 0 || !rgba || !counts)
+    return 0;
+  ensure_u8_lut();
+  memset(counts, 0, (size_t)EC_QSIZE * sizeof(unsigned));
+  pe->rgba = rgba;
+  pe->w = w;
+  pe->h = h;
+  pe->stride = stride;
+  pe->opt = *opt;
+  pe->counts = counts;
+  pe->final_step = compute_sample_step(w, h, opt->pixels);
+  pe->step = 0;
+  pe->stage = 0;
+  pe->last_us = 0.0;
+  ec_rng_seed(&pe->rng, (uint32_t)time(NULL));
+  return 1;
+}
+
+// 完成下一级；失败（内存不足）返回 0，目前的结果保持不变。
+// 直方图已加密到本级（step 相同）说明上次在聚类或合并时失败，重试时不再累加。
+static int progressive_stage(ProgressiveExtract *pe)
+{
+  if (pe->stage >= PROG_STAGES)
+    return 1;
+  double t0 = ec_now_us();
+  int step = pe->final_step << (PROG_STAGES - 1 - pe->stage);
+  if (pe->step != step)
+  {
+    if (pe->step)
+      hist_refine_rows(pe->counts, pe->rgba, pe->w, pe->h, pe->stride, pe->step, step, pe->opt.alphaThreshold);
+    else
+      hist_accumulate_rows(pe->counts, pe->rgba, pe->w, pe->h, pe->stride, step, step, pe->opt.alphaThreshold);
+    pe->step = step;
+  }
+  int last = pe->stage + 1 == PROG_STAGES;
+
+  RGBf *samples = NULL;
+  float *weights = NULL;
+  int n = hist_export_weighted_samples(pe->counts, &samples, &weights);
+  int ok = n >= 0;
+  if (n > 0)
+  {
+    int K = pe->opt.maxColors;
+    if (K > n)
+      K = n;
+    if (K <= 0)
+      K = 1;
+    // 非零桶随加密只增不减；K 变大（粗网格的桶数少于 maxColors）时重新 k-means++ 初始化
+    if (K != pe->K)
+    {
+      Cluster *c = (Cluster *)realloc(pe->centers, (size_t)K * sizeof(Cluster));
+      if (c)
+      {
+        pe->centers = c;
+        pe->K = K;
+        kmeans_pp_init_weighted(samples, weights, n, c, K, &pe->rng);
+      }
+      else
+        ok = 0;
+    }
+    if (ok)
+      ok = kmeans_run_weighted(samples, weights, n, pe->centers, K, last ? 12 : PROG_ITERS);
+    if (ok)
+    {
+      double totalW = 0.0;
+      for (int k = 0; k < K; ++k)
+        totalW += pe->centers[k].weight;
+      ColorAgg *agg = NULL;
+      int m = 0;
+      ok = merge_colors(pe->centers, K, totalW, &pe->opt, &agg, &m);
+      if (ok)
+      {
+        free(pe->best);
+        pe->best = agg;
+        pe->best_m = m;
+      }
+    }
+  }
+  free(samples);
+  free(weights);
+  pe->last_us = ec_now_us() - t0;
+  if (ok)
+    pe->stage++;
+  return ok;
+}
+
+// 在 budget_us 微秒内推进若干级：会话的第一级总会执行（保证有结果），
+// 之后按上一级耗时 × PROG_GROWTH 预估下一级，预计超出预算则停下。失败返回 0
+static int progressive_run(ProgressiveExtract *pe, double budget_us)
+{
+  double t0 = ec_now_us();
+  while (pe->stage < PROG_STAGES)
+  {
+    if (pe->stage > 0 && ec_now_us() - t0 + pe->last_us * PROG_GROWTH > budget_us)
+      break;
+    if (!progressive_stage(pe))
+      return 0;
+  }
+  return 1;
+}
+
+// ---- 取色会话：保留各阶段的结果，参数变化时只重算受影响的阶段 ----
+// pixels / alphaThreshold -> 采样与直方图（及其后各阶段）；maxColors -> 聚类与合并；
+// distance / satDist / lightDist / hueDist 只影响合并（微秒级），拖动合并阈值滑块时无需重新聚类。
+// 供 Wasm 与嵌入构建的交互式调色板编辑使用；CLI 一次性运行，不需要会话。
+#ifndef EC_WITH_IMAGEIO
+#define SESSION_SAMPLES 1
+#define SESSION_CLUSTERS 2
+#define SESSION_MERGE 4
+
+typedef struct
+{
+  const uint8_t *rgba; // 调用方所有，会话期间须保持有效
+  int w, h;
+  Options opt;     // 上次 session_run 的参数
+  int valid;       // 仍有效的阶段（SESSION_* 位）
+  int recomputed;  // 上次 session_run 重算了哪些阶段
+  RGBf *samples;   // 采样阶段：带权样本
+  float *weights;
+  int n;
+  Cluster *clusters; // 聚类阶段
+  int K;
+  double totalW;
+  ColorAgg *agg; // 合并阶段：最终结果
+  int m;
+} ExtractSession;
+
+static void session_release(ExtractSession *s)
+{
+  free(s->samples);
+  free(s->weights);
+  free(s->clusters);
+  free(s->agg);
+  memset(s, 0, sizeof(*s));
+}
+
+// 换图：所有阶段失效；rgba 为行距 w*4 的 RGBA8
+static int session_begin(ExtractSession *s, const uint8_t *rgba, int w, int h)
+{
+  if (!rgba || w <= 0 || h <= 0)
+    return 0;
+  s->rgba = rgba;
+  s->w = w;
+  s->h = h;
+  s->valid = 0;
+  return 1;
+}
+
+static int session_run(ExtractSession *s, const Options *opt)
+{
+  if (!s->rgba)
+    return 0;
+  int valid = s->valid;
+  if (opt->pixels != s->opt.pixels || opt->alphaThreshold != s->opt.alphaThreshold)
+    valid = 0;
+  if (opt->maxColors != s->opt.maxColors)
+    valid &= SESSION_SAMPLES;
+  if (opt->distance != s->opt.distance || opt->satDist != s->opt.satDist || opt->lightDist != s->opt.lightDist ||
+      opt->hueDist != s->opt.hueDist)
+    valid &= ~SESSION_MERGE;
+  s->opt = *opt;
+  s->valid = valid;
+  s->recomputed = 0;
+
+  if (!(valid & SESSION_SAMPLES))
+  {
+    free(s->samples);
+    free(s->weights);
+    s->samples = NULL;
+    s->weights = NULL;
+    ensure_u8_lut();
+    int step = compute_sample_step(s->w, s->h, opt->pixels);
+    s->n = build_quantized_weighted_samples(s->rgba, s->w, s->h, step, opt->alphaThreshold, &s->samples,
+                                            &s->weights);
+    if (s->n < 0) // 内存不足（不同于空图的 0）：整个会话失效，下次重新采样
+    {
+      s->n = 0;
+      s->valid = 0;
+      return 0;
+    }
+    s->recomputed |= SESSION_SAMPLES;
+    valid = 0;
+  }
+  if (!(valid & SESSION_CLUSTERS))
+  {
+    free(s->clusters);
+    s->clusters = NULL;
+    s->K = 0;
+    s->totalW = 0.0;
+    if (s->n > 0)
+    {
+      int K = cluster_count(s->n, opt->maxColors);
+      s->clusters = (Cluster *)malloc((size_t)K * sizeof(Cluster));
+      if (!s->clusters)
+      {
+        s->valid = 0;
+        return 0;
+      }
+      s->K = K;
+      s->totalW = kmeans_cluster(s->samples, s->weights, s->n, s->clusters, K);
+      if (s->totalW < 0.0)
+      {
+        s->valid = SESSION_SAMPLES;
+        return 0;
+      }
+    }
+    s->recomputed |= SESSION_CLUSTERS;
+    valid = SESSION_SAMPLES;
+  }
+  if (!(valid & SESSION_MERGE))
+  {
+    free(s->agg);
+    s->agg = NULL;
+    s->m = 0;
+    s->recomputed |= SESSION_MERGE;
+    if (s->K > 0 && !merge_colors(s->clusters, s->K, s->totalW, opt, &s->agg, &s->m))
+    {
+      // 合并失败（内存不足）：样本与聚类仍有效，下次只重做合并
+      s->valid = SESSION_SAMPLES | SESSION_CLUSTERS;
+      return 0;
+    }
+  }
+  s->valid = SESSION_SAMPLES | SESSION_CLUSTERS | SESSION_MERGE;
+  return 1;
+}
+#endif
+
+// ---- 全部 K 的调色板：对带权样本做一次自顶向下的二分层次聚类 ----
+// 每步拆开加权平方误差（SSE）最大的叶子：沿其主轴按投影符号分成两半作初值，再做 2-means。
+// 第 s 次拆分后恰有 s + 1 个叶子，即 K = s + 1 的聚类；各 K 的结果相互嵌套（K + 1 只比 K 多拆一簇），
+// 建好之后任意 K 只需挑出当时的叶子并合并（微秒级），不再重跑 k-means。
+#define HIER_MAX_K 64
+#define HIER_ITERS 8
+
+typedef struct
+{
+  RGBf color;    // 加权均值
+  double weight; // 权重之和
+  double sse;    // 加权平方误差；0 表示不可再拆
+  int lo, hi;    // 建树期间：在 order 中的样本区间
+  int born;      // 第 born 次拆分产生（根为 0）
+  int split;     // 第 split 次拆分时被拆开（仍为叶子时为 INT_MAX）
+} HierNode;
+
+typedef struct
+{
+  HierNode nodes[2 * HIER_MAX_K - 1];
+  int nnodes;
+  int levels; // 可取的最大 K（0 表示未建树）
+} ColorHierarchy;
+
+// 统计 order[lo, hi) 的加权均值、权重与 SSE
+static void hier_node_stats(HierNode *nd, const RGBf *samples, const float *weights, const int *order)
+{
+  double w = 0.0, r = 0.0, g = 0.0, b = 0.0;
+  for (int i = nd->lo; i < nd->hi; ++i)
+  {
+    const RGBf *x = &samples[order[i]];
+    double wi = weights[order[i]];
+    w += wi;
+    r += wi * x->r;
+    g += wi * x->g;
+    b += wi * x->b;
+  }
+  double inv = w > 0.0 ? 1.0 / w : 0.0;
+  r *= inv;
+  g *= inv;
+  b *= inv;
+  double sse = 0.0;
+  for (int i = nd->lo; i < nd->hi; ++i)
+  {
+    const RGBf *x = &samples[order[i]];
+    double dr = x->r - r, dg = x->g - g, db = x->b - b;
+    sse += weights[order[i]] * (dr * dr + dg * dg + db * db);
+  }
+  nd->color.r = (float)r;
+  nd->color.g = (float)g;
+  nd->color.b = (float)b;
+  nd->weight = w;
+  nd->sse = nd->hi - nd->lo > 1 ? sse : 0.0;
+}
+
+// 将 nd 的样本区间分成两段（side[i] 为 0 的在前），返回分界；side 以 order 的位置为下标
+static int hier_partition(const HierNode *nd, int *order, unsigned char *side)
+{
+  int i = nd->lo, j = nd->hi - 1;
+  while (i <= j)
+  {
+    if (!side[i])
+    {
+      i++;
+      continue;
+    }
+    int t = order[i];
+    order[i] = order[j];
+    order[j] = t;
+    unsigned char s = side[i];
+    side[i] = side[j];
+    side[j] = s;
+    j--;
+  }
+  return i;
+}
+
+// 2-means 拆分 nd：主轴投影初分，再迭代至多 HIER_ITERS 次；任一侧为空时返回 0
+static int hier_split(const HierNode *nd, const RGBf *samples, const float *weights, int *order,
+                      unsigned char *side, int *mid)
+{
+  // 加权协方差与幂迭代求主轴
+  double m[3] = {nd->color.r, nd->color.g, nd->color.b};
+  double cov[3][3] = {{0}};
+  for (int i = nd->lo; i < nd->hi; ++i)
+  {
+    const RGBf *x = &samples[order[i]];
+    double wi = weights[order[i]];
+    double d[3] = {x->r - m[0], x->g - m[1], x->b - m[2]};
+    for (int a = 0; a < 3; ++a)
+      for (int c = a; c < 3; ++c)
+        cov[a][c] += wi * d[a] * d[c];
+  }
+  cov[1][0] = cov[0][1];
+  cov[2][0] = cov[0][2];
+  cov[2][1] = cov[1][2];
+  int a0 = cov[1][1] > cov[0][0] ? 1 : 0;
+  if (cov[2][2] > cov[a0][a0])
+    a0 = 2;
+  double v[3] = {0.0, 0.0, 0.0};
+  v[a0] = 1.0;
+  for (int it = 0; it < 8; ++it)
+  {
+    double u[3];
+    for (int a = 0; a < 3; ++a)
+      u[a] = cov[a][0] * v[0] + cov[a][1] * v[1] + cov[a][2] * v[2];
+    double len = sqrt(u[0] * u[0] + u[1] * u[1] + u[2] * u[2]);
+    if (len <= 0.0)
+      break;
+    for (int a = 0; a < 3; ++a)
+      v[a] = u[a] / len;
+  }
+
+  int n0 = 0, n1 = 0;
+  for (int i = nd->lo; i < nd->hi; ++i)
+  {
+    const RGBf *x = &samples[order[i]];
+    double t = (x->r - m[0]) * v[0] + (x->g - m[1]) * v[1] + (x->b - m[2]) * v[2];
+    side[i] = t > 0.0;
+    n1 += side[i];
+  }
+  n0 = nd->hi - nd->lo - n1;
+  if (n0 == 0 || n1 == 0)
+    return 0;
+
+  for (int it = 0; it < HIER_ITERS; ++it)
+  {
+    double c[2][4] = {{0}};
+    for (int i = nd->lo; i < nd->hi; ++i)
+    {
+      const RGBf *x = &samples[order[i]];
+      double wi = weights[order[i]];
+      double *cc = c[side[i]];
+      cc[0] += wi * x->r;
+      cc[1] += wi * x->g;
+      cc[2] += wi * x->b;
+      cc[3] += wi;
+    }
+    RGBf cen[2];
+    for (int k = 0; k < 2; ++k)
+    {
+      double inv = c[k][3] > 0.0 ? 1.0 / c[k][3] : 0.0;
+      cen[k].r = (float)(c[k][0] * inv);
+      cen[k].g = (float)(c[k][1] * inv);
+      cen[k].b = (float)(c[k][2] * inv);
+    }
+    int changed = 0;
+    n1 = 0;
+    for (int i = nd->lo; i < nd->hi; ++i)
+    {
+      const RGBf x = samples[order[i]];
+      unsigned char s = rgb_dist2f_raw(x, cen[1]) < rgb_dist2f_raw(x, cen[0]);
+      changed |= s != side[i];
+      side[i] = s;
+      n1 += s;
+    }
+    if (n1 == 0 || n1 == nd->hi - nd->lo)
+      return 0;
+    if (!changed)
+      break;
+  }
+  *mid = hier_partition(nd, order, side);
+  return 1;
+}
+
+// 由带权样本建树（接管 samples/weights 的所有权），maxK 截断到 [1, HIER_MAX_K]；失败返回 0
+static int hierarchy_build(ColorHierarchy *hc, RGBf *samples, float *weights, int n, int maxK)
+{
+  hc->nnodes = 0;
+  hc->levels = 0;
+  int *order = n > 0 ? (int *)malloc((size_t)n * sizeof(int)) : NULL;
+  unsigned char *side = n > 0 ? (unsigned char *)malloc((size_t)n) : NULL;
+  if (n <= 0 || !order || !side)
+  {
+    free(order);
+    free(side);
+    free(samples);
+    free(weights);
+    return n == 0; // 空图（全部透明）：建树成功但没有可取的 K
+  }
+  if (maxK > HIER_MAX_K)
+    maxK = HIER_MAX_K;
+  if (maxK < 1)
+    maxK = 1;
+  for (int i = 0; i < n; ++i)
+    order[i] = i;
+
+  HierNode *root = &hc->nodes[0];
+  root->lo = 0;
+  root->hi = n;
+  root->born = 0;
+  root->split = INT_MAX;
+  hier_node_stats(root, samples, weights, order);
+  hc->nnodes = 1;
+  int levels = 1;
+  while (levels < maxK)
+  {
+    // 选 SSE 最大的叶子；拆不开的置 sse = 0 后换下一个
+    int best = -1;
+    for (int i = 0; i < hc->nnodes; ++i)
+      if (hc->nodes[i].split == INT_MAX && hc->nodes[i].sse > 0.0 &&
+          (best < 0 || hc->nodes[i].sse > hc->nodes[best].sse))
+        best = i;
+    if (best < 0)
+      break;
+    HierNode *nd = &hc->nodes[best];
+    int mid;
+    if (!hier_split(nd, samples, weights, order, side, &mid))
+    {
+      nd->sse = 0.0;
+      continue;
+    }
+    HierNode *c0 = &hc->nodes[hc->nnodes], *c1 = &hc->nodes[hc->nnodes + 1];
+    c0->lo = nd->lo;
+    c0->hi = mid;
+    c1->lo = mid;
+    c1->hi = nd->hi;
+    c0->born = c1->born = levels;
+    c0->split = c1->split = INT_MAX;
+    hier_node_stats(c0, samples, weights, order);
+    hier_node_stats(c1, samples, weights, order);
+    nd->split = levels;
+    hc->nnodes += 2;
+    levels++;
+  }
+  hc->levels = levels;
+  free(order);
+  free(side);
+  free(samples);
+  free(weights);
+  return 1;
+}
+
+// K（1..levels）时的叶子按 merge_colors 合并；K 超出范围时取最近的有效值
+static int hierarchy_palette(const ColorHierarchy *hc, int K, const Options *opt, ColorAgg **outAgg, int *outM)
+{
+  *outAgg = NULL;
+  *outM = 0;
+  if (hc->levels <= 0)
+    return 1;
+  if (K > hc->levels)
+    K = hc->levels;
+  if (K < 1)
+    K = 1;
+  Cluster clusters[HIER_MAX_K];
+  int k = 0;
+  double totalW = 0.0;
+  for (int i = 0; i < hc->nnodes; ++i)
+  {
+    const HierNode *nd = &hc->nodes[i];
+    if (nd->born <= K - 1 && nd->split > K - 1)
+    {
+      clusters[k].color = nd->color;
+      clusters[k].weight = nd->weight;
+      totalW += nd->weight;
+      k++;
+    }
+  }
+  return merge_colors(clusters, k, totalW, opt, outAgg, outM);
+}
+
+#ifndef EC_WITH_IMAGEIO
+// 按 opt 的 pixels / alphaThreshold 采样整图 RGBA 并建树（CLI 另在 extract_colors_all_k 中兼顾索引色图）
+static int hierarchy_build_rgba(ColorHierarchy *hc, const uint8_t *rgba, int w, int h, const Options *opt, int maxK)
+{
+  if (!rgba || w <= 0 || h <= 0)
+    return 0;
+  ensure_u8_lut();
+  int step = compute_sample_step(w, h, opt->pixels);
+  RGBf *samples = NULL;
+  float *weights = NULL;
+  int n = build_quantized_weighted_samples(rgba, w, h, step, opt->alphaThreshold, &samples, &weights);
+  return hierarchy_build(hc, samples, weights, n, maxK);
+}
+
+// 输出排序：按 (intensity + 0.1) * (0.9 - area) 降序（与 JS 版 extractColors 一致）。
+// 稳定插入排序，order 写入排序后的下标（颜色数很少，比 qsort 回调更省）
+static INLINE double color_sort_power(const ColorAgg *a)
+{
+  double intensity = ((double)a->color.r + (double)a->color.g + (double)a->color.b) / 3.0;
+  return (intensity + 0.1) * (0.9 - a->weight);
+}
+
+static void order_colors_by_power(const ColorAgg *agg, int m, int *order)
+{
+  for (int i = 0; i < m; ++i)
+  {
+    double p = color_sort_power(&agg[i]);
+    int j = i;
+    while (j > 0 && color_sort_power(&agg[order[j - 1]]) < p)
+    {
+      order[j] = order[j - 1];
+      j--;
+    }
+    order[j] = i;
+  }
+}
+
+// 写入 "#rrggbb\0"（8 字节）
+static void format_hex_rgb(char *dst, int R, int G, int B)
+{
+  static const char *hexd = "0123456789abcdef";
+  dst[0] = '#';
+  dst[1] = hexd[(R >> 4) & 0xF];
+  dst[2] = hexd[R & 0xF];
+  dst[3] = hexd[(G >> 4) & 0xF];
+  dst[4] = hexd[G & 0xF];
+  dst[5] = hexd[(B >> 4) & 0xF];
+  dst[6] = hexd[B & 0xF];
+  dst[7] = '\0';
+}
+#endif
+
+#ifdef EC_WITH_IMAGEIO
+// 从 Image 取色并输出 JSON（原生 CLI 用）
+// 输出 JSON 数组
+// end 接在结尾的 "]" 之后（单个调色板为 "\n"，--all-k 的外层数组里用 ",\n"）
+static void print_colors_json(const ColorAgg *agg, int m, const char *end)
+{
+  printf("[\n");
+  for (int i = 0; i < m; ++i)
+  {
+    RGBf c = agg[i].color;
+    // 直接使用缓存的 HSL，避免重复计算
+    double h_ = agg[i].h, s_ = agg[i].s, l_ = agg[i].l;
+    int R = (int)lround(clampd((double)c.r, 0.0, 1.0) * 255.0);
+    int G = (int)lround(clampd((double)c.g, 0.0, 1.0) * 255.0);
+    int B = (int)lround(clampd((double)c.b, 0.0, 1.0) * 255.0);
+    double intensity = ((double)c.r + (double)c.g + (double)c.b) / 3.0; // 0..1
+
+    printf("  { ");
+    printf("\"hex\": ");
+    print_hex_from_rgb((uint8_t)R, (uint8_t)G, (uint8_t)B);
+    printf(", ");
+    printf("\"red\": %d, \"green\": %d, \"blue\": %d, ", R, G, B);
+    printf("\"hue\": %.10g, ", h_);
+    printf("\"intensity\": %.10g, ", intensity);
+    printf("\"lightness\": %.10g, ", l_);
+    printf("\"saturation\": %.10g, ", s_);
+    printf("\"area\": %.10g ", agg[i].weight);
+    printf("}%s\n", (i + 1 < m) ? "," : "");
+  }
+  printf("]%s", end);
+}
+
+static int extract_colors_from_image(const Image *im, const Options *opt)
+{
+  ColorAgg *agg = NULL;
+  int m = 0;
+  int ok = im->indices ? extract_colors_indexed_core(im->indices, im->width, im->height, im->indexStride,
+                                                     im->indexBits, im->palette, im->paletteSize, opt, &agg, &m)
+                       : extract_colors_core(im->rgba, im->width, im->height, opt, &agg, &m);
+  if (!ok)
+    return 0;
+  print_colors_json(agg, m, "\n");
+  free(agg);
+  return 1;
+}
+
+// .y4m：整个文件读入内存，直接从第 frame 帧的 YUV 平面取色
+static int extract_colors_from_y4m(const char *path, int frame, const Options *opt)
+{
+  FILE *fp = fopen(path, "rb");
+  if (!fp)
+  {
+    fprintf(stderr, "Failed to open: %s\n", path);
+    return 1;
+  }
+  uint8_t *data = NULL;
+  size_t len = 0, cap = 0, got;
+  do
+  {
+    if (len == cap)
+    {
+      cap = cap ? cap * 2 : (size_t)1 << 20;
+      uint8_t *nd = (uint8_t *)realloc(data, cap);
+      if (!nd)
+        break;
+      data = nd;
+    }
+    got = fread(data + len, 1, cap - len, fp);
+    len += got;
+  } while (got > 0);
+  fclose(fp);
+  YuvFrame f;
+  int flags = 0, rc = 2;
+  if (!data || !y4m_read_frame(data, len, frame, &f, &flags))
+    fprintf(stderr, "Not a supported 8-bit y4m stream, or frame %d missing: %s\n", frame, path);
+  else
+  {
+    ColorAgg *agg = NULL;
+    int m = 0;
+    if (extract_colors_yuv_core(&f, flags, opt, &agg, &m))
+    {
+      print_colors_json(agg, m, "\n");
+      free(agg);
+      rc = 0;
+    }
+  }
+  free(data);
+  return rc;
+}
+
+// --deadline：在 deadline_us 微秒内尽量细化，输出届时最好的结果；stderr 报告完成的级数与耗时
+static int extract_colors_progressive(const Image *im, const Options *opt, double deadline_us)
+{
+  unsigned *counts = (unsigned *)malloc((size_t)EC_QSIZE * sizeof(unsigned));
+  ProgressiveExtract pe = {0};
+  double t0 = ec_now_us();
+  int ok = counts && progressive_begin(&pe, counts, im->rgba, im->width, im->height, (size_t)im->width * 4, opt) &&
+           progressive_run(&pe, deadline_us);
+  if (ok)
+  {
+    print_colors_json(pe.best, pe.best_m, "\n");
+    fprintf(stderr, "extract-colors: stage %d/%d (step %d) in %.0f us\n", pe.stage, PROG_STAGES, pe.step,
+            ec_now_us() - t0);
+  }
+  progressive_release(&pe);
+  free(counts);
+  return ok;
+}
+
+// --all-k：建一次层次树，输出 K = 1..maxColors（至多 HIER_MAX_K）的调色板，第 i 项为 K = i + 1
+static int extract_colors_all_k(const Image *im, const Options *opt)
+{
+  ensure_u8_lut();
+  int step = compute_sample_step(im->width, im->height, opt->pixels);
+  RGBf *samples = NULL;
+  float *weights = NULL;
+  int n;
+  if (im->indices)
+  {
+    unsigned counts[EC_MAX_PALETTE] = {0};
+    hist_accumulate_indexed(counts, im->indices, im->width, im->height, im->indexStride, im->indexBits, step, step);
+    n = indexed_export_weighted_samples(counts, im->palette, im->paletteSize, opt->alphaThreshold, &samples,
+                                        &weights);
+  }
+  else
+    n = build_quantized_weighted_samples(im->rgba, im->width, im->height, step, opt->alphaThreshold, &samples,
+                                         &weights);
+  ColorHierarchy hc;
+  if (!hierarchy_build(&hc, samples, weights, n, opt->maxColors))
+    return 0;
+  // 先求出全部调色板，全部成功才输出：中途失败时 stdout 不留半截 JSON
+  ColorAgg *aggs[HIER_MAX_K] = {NULL};
+  int ms[HIER_MAX_K] = {0};
+  int ok = 1;
+  for (int K = 1; ok && K <= hc.levels; ++K)
+    ok = hierarchy_palette(&hc, K, opt, &aggs[K - 1], &ms[K - 1]);
+  if (ok)
+  {
+    printf("[\n");
+    for (int K = 1; K <= hc.levels; ++K)
+      print_colors_json(aggs[K - 1], ms[K - 1], K < hc.levels ? ",\n" : "\n");
+    printf("]\n");
+  }
+  for (int K = 1; K <= hc.levels; ++K)
+    free(aggs[K - 1]);
+  return ok;
+}
+#endif
 
 #ifdef __EMSCRIPTEN__
 // Emscripten 运行时：确保导出符号不会被裁剪
@@ -847,98 +1999,794 @@ static int extract_colors_from_image(const Image *im, const Options *opt)
 static uint8_t *g_pixels_buf = NULL;
 static size_t g_pixels_cap = 0;
 
-// 返回一段至少 size 字节的 RGBA 写入缓冲指针（线性内存地址）
-EMSCRIPTEN_KEEPALIVE __attribute__((export_name("get_pixels_buffer")))
+// ---- 内存计数：[当前线性内存字节, 峰值线性内存字节, 像素缓冲容量, 像素缓冲峰值容量] ----
+// 以 double 存放，避免 4 GB 时 uint32 溢出
+static double g_mem_stats[4];
+
+static void note_memory_usage(void)
+{
+#if defined(__wasm__)
+  double cur = (double)__builtin_wasm_memory_size(0) * 65536.0;
+#else
+  double cur = 0.0;
+#endif
+  g_mem_stats[0] = cur;
+  if (cur > g_mem_stats[1])
+    g_mem_stats[1] = cur;
+  g_mem_stats[2] = (double)g_pixels_cap;
+  if (g_mem_stats[2] > g_mem_stats[3])
+    g_mem_stats[3] = g_mem_stats[2];
+}
+
+// 返回一段至少 size 字节的 RGBA 写入缓冲指针（线性内存地址）
+// 增长策略：按 1.5 倍几何增长并按 64 KB 对齐，避免逐次精确 realloc 造成的反复搬移与碎片
+#define EC_PIXBUF_ALIGN ((uint64_t)65536)
+EMSCRIPTEN_KEEPALIVE __attribute__((export_name("get_pixels_buffer")))
+uint32_t
+get_pixels_buffer(uint32_t size)
+{
+  if (size > g_pixels_cap)
+  {
+    uint64_t ncap = (uint64_t)g_pixels_cap + (g_pixels_cap >> 1);
+    if (ncap < size)
+      ncap = size;
+    ncap = (ncap + EC_PIXBUF_ALIGN - 1) & ~(uint64_t)(EC_PIXBUF_ALIGN - 1);
+    if (ncap > UINT32_MAX)
+      ncap = size;
+    // 旧内容无需保留：先释放再分配，避免 realloc 期间新旧两份同时存在
+    free(g_pixels_buf);
+    g_pixels_buf = (uint8_t *)malloc((size_t)ncap);
+    g_pixels_cap = g_pixels_buf ? (size_t)ncap : 0;
+    note_memory_usage();
+    if (!g_pixels_buf)
+      return 0;
+  }
+  return (uint32_t)(uintptr_t)g_pixels_buf;
+}
+
+// 释放/收缩像素缓冲：keep 为保留的最大容量（0 表示完全释放）。
+// Wasm 线性内存本身不能缩小，但释放后的空间可被后续分配复用，适合长驻页面在大图之后调用。
+EMSCRIPTEN_KEEPALIVE __attribute__((export_name("release_pixels_buffer")))
+void release_pixels_buffer(uint32_t keep)
+{
+  if (g_pixels_cap <= keep)
+    return;
+  free(g_pixels_buf);
+  g_pixels_buf = NULL;
+  g_pixels_cap = 0;
+  if (keep > 0)
+  {
+    g_pixels_buf = (uint8_t *)malloc(keep);
+    g_pixels_cap = g_pixels_buf ? keep : 0;
+  }
+  note_memory_usage();
+}
+
+// 返回内存计数的地址（4 个 double，见 g_mem_stats 注释）
+EMSCRIPTEN_KEEPALIVE __attribute__((export_name("wasm_memory_stats_js")))
+uint32_t
+wasm_memory_stats_js(void)
+{
+  note_memory_usage();
+  return (uint32_t)(uintptr_t)g_mem_stats;
+}
+
+// 结果缓冲布局（固定偏移，JS 端按偏移直接解码，无需再排序/拼接字符串）：
+// nums[0] = 颜色数量 M（double）
+// 紧随其后每个颜色 8 个 double：
+//   [R(0..255 整数), G(0..255 整数), B(0..255 整数), hue(0..1), intensity(0..1), lightness(0..1), saturation(0..1), area(0..1)]
+// hex[i] = "#rrggbb\0"（8 字节，紧跟在 nums 之后）
+// 颜色已按 (intensity + 0.1) * (0.9 - area) 降序排列（与 JS 版 extractColors 的排序一致）
+// 固定最大颜色数上限（避免 JS 端管理内存）：
+#define EXTRACT_MAX_OUT_COLORS 64
+typedef struct
+{
+  double nums[1 + EXTRACT_MAX_OUT_COLORS * 8];
+  char hex[EXTRACT_MAX_OUT_COLORS][8];
+} ExtractOut;
+static ExtractOut g_out_buf;
+
+static void pack_results_to_out(ExtractOut *out, const ColorAgg *agg, int m)
+{
+  if (m > EXTRACT_MAX_OUT_COLORS)
+    m = EXTRACT_MAX_OUT_COLORS;
+  int order[EXTRACT_MAX_OUT_COLORS];
+  order_colors_by_power(agg, m, order);
+  out->nums[0] = (double)m;
+  for (int i = 0; i < m; ++i)
+  {
+    const ColorAgg *a = &agg[order[i]];
+    RGBf c = a->color;
+    // 直接使用缓存的 HSL，避免重复计算
+    double h_ = a->h, s_ = a->s, l_ = a->l;
+    int R = (int)lround(clampd((double)c.r, 0.0, 1.0) * 255.0);
+    int G = (int)lround(clampd((double)c.g, 0.0, 1.0) * 255.0);
+    int B = (int)lround(clampd((double)c.b, 0.0, 1.0) * 255.0);
+    double intensity = ((double)c.r + (double)c.g + (double)c.b) / 3.0;
+    size_t base = 1 + (size_t)i * 8;
+    out->nums[base + 0] = (double)R;
+    out->nums[base + 1] = (double)G;
+    out->nums[base + 2] = (double)B;
+    out->nums[base + 3] = h_;
+    out->nums[base + 4] = intensity;
+    out->nums[base + 5] = l_;
+    out->nums[base + 6] = s_;
+    out->nums[base + 7] = a->weight; // area
+    format_hex_rgb(out->hex[i], R, G, B);
+  }
+}
+
+// JS 传入的取色参数（pixels <= 0 取默认，maxColors 超出结果区上限时取 16）
+static void wasm_options(Options *opt, int pixels, double distance, double satDist, double lightDist,
+                         double hueDist, int alphaThreshold, int maxColors)
+{
+  opt->pixels = pixels > 0 ? pixels : 64000;
+  opt->distance = distance;
+  opt->satDist = satDist;
+  opt->lightDist = lightDist;
+  opt->hueDist = hueDist;
+  opt->alphaThreshold = alphaThreshold;
+  opt->maxColors = (maxColors > 0 && maxColors <= EXTRACT_MAX_OUT_COLORS) ? maxColors : 16;
+}
+
+// 调用方缓冲版本：结果按上述布局写入调用方提供的 out_ptr（extract_out_size_js() 字节，8 字节对齐），
+// 像素与结果缓冲均由调用方管理（extract_alloc_js / extract_free_js），不经过 g_out_buf / g_pixels_buf，
+// 结果不会被后续调用覆盖。模块仍有全局状态（g_mem_stats、分块/渐进/会话取色），且未以共享内存构建：
+// 同一实例的调用须串行，多 Worker 并行时每个 Worker 各自实例化模块。
+// 成功返回 out_ptr，失败返回 0。
+EMSCRIPTEN_KEEPALIVE __attribute__((export_name("extract_colors_into_js")))
+uint32_t
+extract_colors_into_js(uint32_t rgba_ptr, int width, int height,
+                       int pixels, double distance, double satDist,
+                       double lightDist, double hueDist,
+                       int alphaThreshold, int maxColors, uint32_t out_ptr)
+{
+  if (!out_ptr)
+    return 0;
+  Options opt;
+  wasm_options(&opt, pixels, distance, satDist, lightDist, hueDist, alphaThreshold, maxColors);
+
+  ColorAgg *agg = NULL;
+  int m = 0;
+  const uint8_t *rgba = (const uint8_t *)(uintptr_t)rgba_ptr;
+  if (!extract_colors_core(rgba, width, height, &opt, &agg, &m))
+    return 0;
+  pack_results_to_out((ExtractOut *)(uintptr_t)out_ptr, agg, m);
+  free(agg);
+  return out_ptr;
+}
+
+// 从 RGBA 指针取色，返回结果缓冲的线性内存地址
+EMSCRIPTEN_KEEPALIVE __attribute__((export_name("extract_colors_from_rgba_js")))
+uint32_t
+extract_colors_from_rgba_js(uint32_t rgba_ptr, int width, int height,
+                            int pixels, double distance, double satDist,
+                            double lightDist, double hueDist,
+                            int alphaThreshold, int maxColors)
+{
+  uint32_t r = extract_colors_into_js(rgba_ptr, width, height, pixels, distance, satDist, lightDist, hueDist,
+                                      alphaThreshold, maxColors, (uint32_t)(uintptr_t)&g_out_buf);
+  note_memory_usage();
+  return r;
+}
+
+// YUV 帧直接取色（视频缩略图免转 RGBA）：format 0=I420 1=NV12 2=I422 3=I444 4=GRAY，
+// flags 位 0 = BT.709（否则 BT.601）、位 1 = full range（否则 limited）；NV12 的 u_ptr 为 UV 交错平面、v_ptr 忽略。
+// 只读取被采样的像素，结果布局与缓冲约定同 extract_colors_into_js
+EMSCRIPTEN_KEEPALIVE __attribute__((export_name("extract_colors_yuv_into_js")))
+uint32_t
+extract_colors_yuv_into_js(uint32_t y_ptr, uint32_t u_ptr, uint32_t v_ptr, int width, int height,
+                           int y_stride, int c_stride, int format, int flags,
+                           int pixels, double distance, double satDist,
+                           double lightDist, double hueDist, int maxColors, uint32_t out_ptr)
+{
+  YuvFrame f = {(const uint8_t *)(uintptr_t)y_ptr, (const uint8_t *)(uintptr_t)u_ptr,
+                (const uint8_t *)(uintptr_t)v_ptr, (size_t)y_stride, (size_t)c_stride, 1, 0, 0, width, height};
+  if (!out_ptr || !yuv_frame_layout(&f, format) || (format != YUV_GRAY && !f.u))
+    return 0;
+  Options opt;
+  wasm_options(&opt, pixels, distance, satDist, lightDist, hueDist, 0, maxColors);
+  ColorAgg *agg = NULL;
+  int m = 0;
+  if (!extract_colors_yuv_core(&f, flags, &opt, &agg, &m))
+    return 0;
+  pack_results_to_out((ExtractOut *)(uintptr_t)out_ptr, agg, m);
+  free(agg);
+  return out_ptr;
+}
+
+// 索引色图（PNG 调色板 / GIF，如 JS 侧 GIF 解码器给出的下标 + 色表）直接取色：
+// idx_ptr 每像素 bits 位（1/2/4/8，高位在前），palette_ptr 为 palette_size 项 RGBA8。
+// 只统计被采样的下标，结果布局与缓冲约定同 extract_colors_into_js
+EMSCRIPTEN_KEEPALIVE __attribute__((export_name("extract_colors_indexed_into_js")))
 uint32_t
-get_pixels_buffer(uint32_t size)
+extract_colors_indexed_into_js(uint32_t idx_ptr, int width, int height, int stride, int bits,
+                               uint32_t palette_ptr, int palette_size,
+                               int pixels, double distance, double satDist,
+                               double lightDist, double hueDist,
+                               int alphaThreshold, int maxColors, uint32_t out_ptr)
 {
-  if (size > g_pixels_cap)
-  {
-    // 重新分配
-    uint8_t *nbuf = (uint8_t *)realloc(g_pixels_buf, size);
-    if (!nbuf)
-      return 0;
-    g_pixels_buf = nbuf;
-    g_pixels_cap = size;
-  }
-  return (uint32_t)(uintptr_t)g_pixels_buf;
+  if (!out_ptr || stride <= 0)
+    return 0;
+  Options opt;
+  wasm_options(&opt, pixels, distance, satDist, lightDist, hueDist, alphaThreshold, maxColors);
+  ColorAgg *agg = NULL;
+  int m = 0;
+  if (!extract_colors_indexed_core((const uint8_t *)(uintptr_t)idx_ptr, width, height, (size_t)stride, bits,
+                                   (const uint8_t *)(uintptr_t)palette_ptr, palette_size, &opt, &agg, &m))
+    return 0;
+  pack_results_to_out((ExtractOut *)(uintptr_t)out_ptr, agg, m);
+  free(agg);
+  return out_ptr;
 }
 
-// 结果按 double 打包：
-// out[0] = 颜色数量 M（double）
-// 紧随其后每个颜色 8 个 double：
-//   [R(0..255), G(0..255), B(0..255), hue(0..1), intensity(0..1), lightness(0..1), saturation(0..1), area(0..1)]
-// 固定最大颜色数上限（避免 JS 端管理内存）：
-#define EXTRACT_MAX_OUT_COLORS 64
-static double g_out_buf[1 + EXTRACT_MAX_OUT_COLORS * 8];
+// .y4m 流（整段位于线性内存）中第 frame 帧取色；色度格式、range 与矩阵按流头推断（见 y4m_read_frame）
+EMSCRIPTEN_KEEPALIVE __attribute__((export_name("extract_colors_y4m_into_js")))
+uint32_t
+extract_colors_y4m_into_js(uint32_t data_ptr, uint32_t len, int frame,
+                           int pixels, double distance, double satDist,
+                           double lightDist, double hueDist, int maxColors, uint32_t out_ptr)
+{
+  YuvFrame f;
+  int flags = 0;
+  if (!out_ptr || !y4m_read_frame((const uint8_t *)(uintptr_t)data_ptr, len, frame, &f, &flags))
+    return 0;
+  Options opt;
+  wasm_options(&opt, pixels, distance, satDist, lightDist, hueDist, 0, maxColors);
+  ColorAgg *agg = NULL;
+  int m = 0;
+  if (!extract_colors_yuv_core(&f, flags, &opt, &agg, &m))
+    return 0;
+  pack_results_to_out((ExtractOut *)(uintptr_t)out_ptr, agg, m);
+  free(agg);
+  return out_ptr;
+}
+
+EMSCRIPTEN_KEEPALIVE __attribute__((export_name("extract_out_size_js")))
+uint32_t
+extract_out_size_js(void)
+{
+  return (uint32_t)sizeof(ExtractOut);
+}
 
-static void pack_results_to_out(const ColorAgg *agg, int m)
+// 供调用方分配自己的像素/结果缓冲；malloc 保证 8 字节对齐
+EMSCRIPTEN_KEEPALIVE __attribute__((export_name("extract_alloc_js")))
+uint32_t
+extract_alloc_js(uint32_t size)
 {
-  if (m > EXTRACT_MAX_OUT_COLORS)
-    m = EXTRACT_MAX_OUT_COLORS;
-  g_out_buf[0] = (double)m;
-  for (int i = 0; i < m; ++i)
+  void *p = malloc(size ? size : 1);
+  note_memory_usage();
+  return (uint32_t)(uintptr_t)p;
+}
+
+EMSCRIPTEN_KEEPALIVE __attribute__((export_name("extract_free_js")))
+void extract_free_js(uint32_t ptr)
+{
+  free((void *)(uintptr_t)ptr);
+}
+
+// ---- 分块喂入（大图）：整图无需拷入 Wasm 内存 ----
+// 1) extract_stream_begin_js(w, h, pixels, alphaThreshold) 返回行步长 step（失败返回 0）
+// 2) JS 仅拷贝 y % step == 0 的行，按行带写入 get_pixels_buffer(rows * w * 4)，
+//    再调用 extract_stream_feed_js(ptr, rows)；可重复多次
+// 3) extract_stream_finish_js(...) 聚类并返回与 extract_colors_from_rgba_js 相同布局的结果地址
+static unsigned *g_stream_counts = NULL;
+static int g_stream_w = 0;
+static int g_stream_step = 1;
+static int g_stream_alpha = 250;
+static ProgressiveExtract g_prog; // 渐进取色会话（见下），与分块喂入共用 g_stream_counts
+
+EMSCRIPTEN_KEEPALIVE __attribute__((export_name("extract_stream_begin_js")))
+int extract_stream_begin_js(int width, int height, int pixels, int alphaThreshold)
+{
+  if (width <= 0 || height <= 0)
+    return 0;
+  if (!g_stream_counts)
   {
-    RGBf c = agg[i].color;
-    // 直接使用缓存的 HSL，避免重复计算
-    double h_ = agg[i].h, s_ = agg[i].s, l_ = agg[i].l;
-    double R = clampd((double)c.r, 0.0, 1.0) * 255.0;
-    double G = clampd((double)c.g, 0.0, 1.0) * 255.0;
-    double B = clampd((double)c.b, 0.0, 1.0) * 255.0;
-    double intensity = ((double)c.r + (double)c.g + (double)c.b) / 3.0;
-    size_t base = 1 + (size_t)i * 8;
-    g_out_buf[base + 0] = R;
-    g_out_buf[base + 1] = G;
-    g_out_buf[base + 2] = B;
-    g_out_buf[base + 3] = h_;
-    g_out_buf[base + 4] = intensity;
-    g_out_buf[base + 5] = l_;
-    g_out_buf[base + 6] = s_;
-    g_out_buf[base + 7] = agg[i].weight; // area
+    g_stream_counts = (unsigned *)malloc((size_t)EC_QSIZE * sizeof(unsigned));
+    if (!g_stream_counts)
+      return 0;
   }
+  memset(g_stream_counts, 0, (size_t)EC_QSIZE * sizeof(unsigned));
+  // 直方图改作分块喂入：结束进行中的渐进会话并释放其结果缓冲（同 extract_progressive_end_js）
+  progressive_release(&g_prog);
+  g_prog.counts = NULL;
+  g_prog.stage = 0;
+  ensure_u8_lut();
+  g_stream_w = width;
+  g_stream_step = compute_sample_step(width, height, pixels > 0 ? pixels : 64000);
+  g_stream_alpha = alphaThreshold;
+  note_memory_usage();
+  return g_stream_step;
 }
 
-// 从 RGBA 指针取色，返回结果缓冲的线性内存地址
-EMSCRIPTEN_KEEPALIVE __attribute__((export_name("extract_colors_from_rgba_js")))
+// rgba_ptr 指向 rows 行已按 step 纵向抽取的行（紧密排列，每行 width*4 字节）
+EMSCRIPTEN_KEEPALIVE __attribute__((export_name("extract_stream_feed_js")))
+int extract_stream_feed_js(uint32_t rgba_ptr, int rows)
+{
+  if (!g_stream_counts || rows <= 0)
+    return 0;
+  const uint8_t *rgba = (const uint8_t *)(uintptr_t)rgba_ptr;
+  hist_accumulate_rows(g_stream_counts, rgba, g_stream_w, rows, (size_t)g_stream_w * 4, 1,
+                       g_stream_step, g_stream_alpha);
+  return 1;
+}
+
+EMSCRIPTEN_KEEPALIVE __attribute__((export_name("extract_stream_finish_js")))
 uint32_t
-extract_colors_from_rgba_js(uint32_t rgba_ptr, int width, int height,
-                            int pixels, double distance, double satDist,
-                            double lightDist, double hueDist,
-                            int alphaThreshold, int maxColors)
+extract_stream_finish_js(double distance, double satDist, double lightDist, double hueDist, int maxColors)
 {
+  if (!g_stream_counts)
+    return 0;
   Options opt;
-  opt.pixels = pixels > 0 ? pixels : 64000;
+  opt.pixels = 0;
   opt.distance = distance;
   opt.satDist = satDist;
   opt.lightDist = lightDist;
   opt.hueDist = hueDist;
-  opt.alphaThreshold = alphaThreshold;
+  opt.alphaThreshold = g_stream_alpha;
   opt.maxColors = (maxColors > 0 && maxColors <= EXTRACT_MAX_OUT_COLORS) ? maxColors : 16;
 
+  RGBf *samples = NULL;
+  float *weights = NULL;
+  int n = hist_export_weighted_samples(g_stream_counts, &samples, &weights);
   ColorAgg *agg = NULL;
   int m = 0;
-  const uint8_t *rgba = (const uint8_t *)(uintptr_t)rgba_ptr;
-  if (!extract_colors_core(rgba, width, height, &opt, &agg, &m))
+  if (!cluster_weighted_samples(samples, weights, n, &opt, &agg, &m))
+    return 0;
+  pack_results_to_out(&g_out_buf, agg, m);
+  free(agg);
+  note_memory_usage();
+  return (uint32_t)(uintptr_t)&g_out_buf;
+}
+
+// ---- 渐进取色（交互预览，轮询式）----
+// 1) extract_progressive_begin_js(rgbaPtr, w, h, ...) 开始会话（参数同 extract_colors_from_rgba_js；
+//    像素须在会话期间保持不动，与分块喂入共用直方图缓冲，二者不可交错）
+// 2) 每帧调用 extract_progressive_run_js(budgetUs)：在预算内推进若干级，返回目前最好结果的地址（布局同上）
+// 3) extract_progressive_state_js() 指向 4 个 double：[已完成级数, 总级数, 当前采样步长, 最近一级耗时 µs]，
+//    前两者相等即已收敛，可停止轮询；extract_progressive_end_js() 释放会话
+static double g_prog_state[4];
+
+EMSCRIPTEN_KEEPALIVE __attribute__((export_name("extract_progressive_begin_js")))
+int extract_progressive_begin_js(uint32_t rgba_ptr, int width, int height,
+                                 int pixels, double distance, double satDist,
+                                 double lightDist, double hueDist,
+                                 int alphaThreshold, int maxColors)
+{
+  if (!g_stream_counts)
+  {
+    g_stream_counts = (unsigned *)malloc((size_t)EC_QSIZE * sizeof(unsigned));
+    if (!g_stream_counts)
+      return 0;
+  }
+  Options opt;
+  wasm_options(&opt, pixels, distance, satDist, lightDist, hueDist, alphaThreshold, maxColors);
+  int ok = progressive_begin(&g_prog, g_stream_counts, (const uint8_t *)(uintptr_t)rgba_ptr, width, height,
+                             (size_t)width * 4, &opt);
+  note_memory_usage();
+  return ok;
+}
+
+EMSCRIPTEN_KEEPALIVE __attribute__((export_name("extract_progressive_run_js")))
+uint32_t
+extract_progressive_run_js(double budget_us)
+{
+  if (!g_prog.counts || !progressive_run(&g_prog, budget_us))
+    return 0;
+  pack_results_to_out(&g_out_buf, g_prog.best, g_prog.best_m);
+  note_memory_usage();
+  return (uint32_t)(uintptr_t)&g_out_buf;
+}
+
+EMSCRIPTEN_KEEPALIVE __attribute__((export_name("extract_progressive_state_js")))
+uint32_t
+extract_progressive_state_js(void)
+{
+  g_prog_state[0] = (double)g_prog.stage;
+  g_prog_state[1] = (double)PROG_STAGES;
+  g_prog_state[2] = (double)g_prog.step;
+  g_prog_state[3] = g_prog.last_us;
+  return (uint32_t)(uintptr_t)g_prog_state;
+}
+
+EMSCRIPTEN_KEEPALIVE __attribute__((export_name("extract_progressive_end_js")))
+void extract_progressive_end_js(void)
+{
+  progressive_release(&g_prog);
+  g_prog.counts = NULL;
+  g_prog.stage = 0;
+}
+
+// ---- 取色会话（调色板编辑器的滑块）----
+// 1) extract_session_begin_js(rgbaPtr, w, h)：像素须在会话期间保持不动（get_pixels_buffer 再次调用后需重新 begin）
+// 2) extract_session_run_js(...)：参数同 extract_colors_from_rgba_js，只重算受影响的阶段，返回结果地址（布局同上），
+//    失败（未 begin 或内存不足）返回 0；
+//    只改 distance / saturation / lightness / hue 阈值时只重新合并，结果与上次共用同一组聚类
+// 3) extract_session_recomputed_js() 返回上次 run 重算的阶段：位 0 采样，位 1 聚类，位 2 合并
+// 4) extract_session_end_js() 释放会话
+static ExtractSession g_session;
+
+EMSCRIPTEN_KEEPALIVE __attribute__((export_name("extract_session_begin_js")))
+int extract_session_begin_js(uint32_t rgba_ptr, int width, int height)
+{
+  return session_begin(&g_session, (const uint8_t *)(uintptr_t)rgba_ptr, width, height);
+}
+
+EMSCRIPTEN_KEEPALIVE __attribute__((export_name("extract_session_run_js")))
+uint32_t
+extract_session_run_js(int pixels, double distance, double satDist, double lightDist, double hueDist,
+                       int alphaThreshold, int maxColors)
+{
+  Options opt;
+  wasm_options(&opt, pixels, distance, satDist, lightDist, hueDist, alphaThreshold, maxColors);
+  if (!session_run(&g_session, &opt))
+    return 0;
+  pack_results_to_out(&g_out_buf, g_session.agg, g_session.m);
+  note_memory_usage();
+  return (uint32_t)(uintptr_t)&g_out_buf;
+}
+
+EMSCRIPTEN_KEEPALIVE __attribute__((export_name("extract_session_recomputed_js")))
+int extract_session_recomputed_js(void)
+{
+  return g_session.recomputed;
+}
+
+EMSCRIPTEN_KEEPALIVE __attribute__((export_name("extract_session_end_js")))
+void extract_session_end_js(void)
+{
+  session_release(&g_session);
+}
+
+// ---- 全部 K 的调色板（「颜色数」滑块）----
+// extract_hierarchy_build_js(rgbaPtr, w, h, pixels, alphaThreshold, maxK) 建一次层次树（像素随后可释放），
+// 返回可取的最大 K（空图为 0，失败为 -1）；之后每个滑块位置调用
+// extract_hierarchy_palette_js(K, distance, satDist, lightDist, hueDist)，返回结果地址（布局同上），微秒级
+static ColorHierarchy g_hier;
+
+EMSCRIPTEN_KEEPALIVE __attribute__((export_name("extract_hierarchy_build_js")))
+int extract_hierarchy_build_js(uint32_t rgba_ptr, int width, int height, int pixels, int alphaThreshold, int maxK)
+{
+  Options opt;
+  wasm_options(&opt, pixels, 0.0, 0.0, 0.0, 0.0, alphaThreshold, 0);
+  if (maxK <= 0 || maxK > EXTRACT_MAX_OUT_COLORS)
+    maxK = EXTRACT_MAX_OUT_COLORS;
+  int ok = hierarchy_build_rgba(&g_hier, (const uint8_t *)(uintptr_t)rgba_ptr, width, height, &opt, maxK);
+  note_memory_usage();
+  return ok ? g_hier.levels : -1;
+}
+
+EMSCRIPTEN_KEEPALIVE __attribute__((export_name("extract_hierarchy_palette_js")))
+uint32_t
+extract_hierarchy_palette_js(int K, double distance, double satDist, double lightDist, double hueDist)
+{
+  Options opt;
+  wasm_options(&opt, 0, distance, satDist, lightDist, hueDist, 0, 0);
+  ColorAgg *agg = NULL;
+  int m = 0;
+  if (!hierarchy_palette(&g_hier, K, &opt, &agg, &m))
     return 0;
-  pack_results_to_out(agg, m);
+  pack_results_to_out(&g_out_buf, agg, m);
   free(agg);
-  return (uint32_t)(uintptr_t)g_out_buf;
+  return (uint32_t)(uintptr_t)&g_out_buf;
 }
 #endif // __EMSCRIPTEN__
 
+#ifdef OKCOLOR_EMBED
+// ---- 原生嵌入接口（见 okcolor.h）----
+_Static_assert(PROG_STAGES == OKC_PROGRESSIVE_STAGES, "okcolor.h stage count out of sync");
+
+void okc_extract_init(void)
+{
+  ensure_u8_lut();
+}
+
+void okc_extract_options_default(okc_extract_options *opt)
+{
+  opt->pixels = 64000;
+  opt->distance = 0.22;
+  opt->saturationDistance = 0.2;
+  opt->lightnessDistance = 0.2;
+  opt->hueDistance = 0.083333333;
+  opt->alphaThreshold = 250;
+  opt->maxColors = 16;
+}
+
+static void options_from_okc(const okc_extract_options *o, Options *opt)
+{
+  opt->pixels = o->pixels > 0 ? o->pixels : 64000;
+  opt->distance = o->distance;
+  opt->satDist = o->saturationDistance;
+  opt->lightDist = o->lightnessDistance;
+  opt->hueDist = o->hueDistance;
+  opt->alphaThreshold = o->alphaThreshold;
+  opt->maxColors = o->maxColors > 0 ? o->maxColors : 16;
+}
+
+// 排序并写出结果（接管 agg 的所有权）；返回颜色数，失败返回 -1
+static int emit_okc_colors(ColorAgg *agg, int m, okc_color *out, int cap)
+{
+  int *order = (int *)malloc((size_t)(m > 0 ? m : 1) * sizeof(int));
+  if (!order)
+  {
+    free(agg);
+    return -1;
+  }
+  order_colors_by_power(agg, m, order);
+  if (m > cap)
+    m = cap;
+  for (int i = 0; i < m; ++i)
+  {
+    const ColorAgg *a = &agg[order[i]];
+    RGBf c = a->color;
+    okc_color *d = &out[i];
+    d->red = (int)lround(clampd((double)c.r, 0.0, 1.0) * 255.0);
+    d->green = (int)lround(clampd((double)c.g, 0.0, 1.0) * 255.0);
+    d->blue = (int)lround(clampd((double)c.b, 0.0, 1.0) * 255.0);
+    format_hex_rgb(d->hex, d->red, d->green, d->blue);
+    d->hue = a->h;
+    d->intensity = ((double)c.r + (double)c.g + (double)c.b) / 3.0;
+    d->lightness = a->l;
+    d->saturation = a->s;
+    d->area = a->weight;
+  }
+  free(order);
+  free(agg);
+  return m;
+}
+
+int okc_extract_colors(const uint8_t *rgba, int width, int height, const okc_extract_options *o,
+                       okc_color *out, int cap)
+{
+  Options opt;
+  options_from_okc(o, &opt);
+  ColorAgg *agg = NULL;
+  int m = 0;
+  if (!extract_colors_core(rgba, width, height, &opt, &agg, &m))
+    return -1;
+  return emit_okc_colors(agg, m, out, cap);
+}
+
+// 两侧是不同的枚举类型，先转 int 再比较（否则 -Wenum-compare）
+_Static_assert((int)OKC_YUV_I420 == (int)YUV_I420 && (int)OKC_YUV_NV12 == (int)YUV_NV12 &&
+                   (int)OKC_YUV_I422 == (int)YUV_I422 && (int)OKC_YUV_I444 == (int)YUV_I444 &&
+                   (int)OKC_YUV_GRAY == (int)YUV_GRAY && (int)OKC_YUV_BT709 == (int)YUV_BT709 &&
+                   (int)OKC_YUV_FULL_RANGE == (int)YUV_FULL_RANGE,
+               "okcolor.h YUV constants out of sync");
+
+int okc_extract_colors_yuv(const okc_yuv_frame *frame, const okc_extract_options *o, okc_color *out, int cap)
+{
+  YuvFrame f = {frame->y, frame->u, frame->v, frame->yStride, frame->cStride, 1, 0, 0, frame->width, frame->height};
+  if (!yuv_frame_layout(&f, (int)frame->format) || (frame->format != OKC_YUV_GRAY && !f.u))
+    return -1;
+  Options opt;
+  options_from_okc(o, &opt);
+  ColorAgg *agg = NULL;
+  int m = 0;
+  if (!extract_colors_yuv_core(&f, frame->flags, &opt, &agg, &m))
+    return -1;
+  return emit_okc_colors(agg, m, out, cap);
+}
+
+int okc_extract_colors_y4m(const uint8_t *data, size_t len, int frame, const okc_extract_options *o, okc_color *out,
+                           int cap)
+{
+  YuvFrame f;
+  int flags = 0;
+  if (!data || !y4m_read_frame(data, len, frame, &f, &flags))
+    return -1;
+  Options opt;
+  options_from_okc(o, &opt);
+  ColorAgg *agg = NULL;
+  int m = 0;
+  if (!extract_colors_yuv_core(&f, flags, &opt, &agg, &m))
+    return -1;
+  return emit_okc_colors(agg, m, out, cap);
+}
+
+int okc_extract_colors_indexed(const okc_indexed_image *image, const okc_extract_options *o, okc_color *out,
+                               int cap)
+{
+  if (!image)
+    return -1;
+  Options opt;
+  options_from_okc(o, &opt);
+  ColorAgg *agg = NULL;
+  int m = 0;
+  if (!extract_colors_indexed_core(image->indices, image->width, image->height, image->stride, image->bitsPerIndex,
+                                   image->palette, image->paletteSize, &opt, &agg, &m))
+    return -1;
+  return emit_okc_colors(agg, m, out, cap);
+}
+
+// 取色上下文：持有参数与可复用的直方图，支持整图与按行带分批喂入
+struct okc_extractor
+{
+  Options opt;
+  unsigned *counts; // EC_QSIZE 个桶
+  int w;            // 分批喂入：图像宽度
+  int step;         // 分批喂入：行/列采样步长
+  long long y;      // 分批喂入：下一行的行号
+  ProgressiveExtract prog; // 渐进取色会话（与分批喂入共用 counts）
+  ExtractSession session;  // 取色会话（各阶段结果独立保存，不占用 counts）
+  ColorHierarchy hier;     // 全部 K 的层次树
+};
+
+okc_extractor *okc_extractor_create(const okc_extract_options *opt)
+{
+  okc_extractor *ex = (okc_extractor *)calloc(1, sizeof(okc_extractor));
+  if (!ex)
+    return NULL;
+  ex->counts = (unsigned *)malloc((size_t)EC_QSIZE * sizeof(unsigned));
+  if (!ex->counts)
+  {
+    free(ex);
+    return NULL;
+  }
+  okc_extract_options def;
+  okc_extract_options_default(&def);
+  options_from_okc(opt ? opt : &def, &ex->opt);
+  ex->step = 1;
+  ensure_u8_lut();
+  return ex;
+}
+
+void okc_extractor_destroy(okc_extractor *ex)
+{
+  if (!ex)
+    return;
+  progressive_release(&ex->prog);
+  session_release(&ex->session);
+  free(ex->counts);
+  free(ex);
+}
+
+void okc_extractor_set_options(okc_extractor *ex, const okc_extract_options *opt)
+{
+  options_from_okc(opt, &ex->opt);
+}
+
+int okc_extractor_run(okc_extractor *ex, const uint8_t *rgba, int width, int height, okc_color *out, int cap)
+{
+  if (okc_extractor_begin(ex, width, height) <= 0)
+    return -1;
+  okc_extractor_feed(ex, rgba, height, (size_t)width * 4);
+  return okc_extractor_finish(ex, out, cap);
+}
+
+int okc_extractor_begin(okc_extractor *ex, int width, int height)
+{
+  if (!ex || width <= 0 || height <= 0)
+    return 0;
+  memset(ex->counts, 0, (size_t)EC_QSIZE * sizeof(unsigned));
+  ex->prog.counts = NULL; // 直方图改作分批喂入，结束进行中的渐进会话
+  ex->w = width;
+  ex->step = compute_sample_step(width, height, ex->opt.pixels);
+  ex->y = 0;
+  return ex->step;
+}
+
+void okc_extractor_feed(okc_extractor *ex, const uint8_t *rgba, int rows, size_t rowStride)
+{
+  if (!ex || !rgba || rows <= 0)
+    return;
+  // 对齐到全图的采样相位：只累加 y % step == 0 的行
+  int skip = (int)((ex->step - ex->y % ex->step) % ex->step);
+  if (skip < rows)
+    hist_accumulate_rows(ex->counts, rgba + (size_t)skip * rowStride, ex->w, rows - skip, rowStride,
+                         ex->step, ex->step, ex->opt.alphaThreshold);
+  ex->y += rows;
+}
+
+int okc_extractor_finish(okc_extractor *ex, okc_color *out, int cap)
+{
+  if (!ex)
+    return -1;
+  RGBf *samples = NULL;
+  float *weights = NULL;
+  int n = hist_export_weighted_samples(ex->counts, &samples, &weights);
+  ColorAgg *agg = NULL;
+  int m = 0;
+  if (!cluster_weighted_samples(samples, weights, n, &ex->opt, &agg, &m))
+    return -1;
+  return emit_okc_colors(agg, m, out, cap);
+}
+
+int okc_extractor_progressive_begin(okc_extractor *ex, const uint8_t *rgba, int width, int height, size_t rowStride)
+{
+  if (!ex)
+    return -1;
+  return progressive_begin(&ex->prog, ex->counts, rgba, width, height, rowStride, &ex->opt) ? 0 : -1;
+}
+
+int okc_extractor_progressive_run(okc_extractor *ex, double budget_us, okc_color *out, int cap)
+{
+  if (!ex || !ex->prog.counts || !progressive_run(&ex->prog, budget_us))
+    return -1;
+  // emit_okc_colors 接管缓冲：交出一份拷贝，会话保留自己的结果
+  int m = ex->prog.best_m;
+  ColorAgg *agg = (ColorAgg *)malloc((size_t)(m > 0 ? m : 1) * sizeof(ColorAgg));
+  if (!agg)
+    return -1;
+  if (m)
+    memcpy(agg, ex->prog.best, (size_t)m * sizeof(ColorAgg));
+  return emit_okc_colors(agg, m, out, cap);
+}
+
+int okc_extractor_progressive_stage(const okc_extractor *ex)
+{
+  return ex ? ex->prog.stage : 0;
+}
+
+_Static_assert(OKC_SESSION_SAMPLES == SESSION_SAMPLES && OKC_SESSION_CLUSTERS == SESSION_CLUSTERS &&
+                   OKC_SESSION_MERGE == SESSION_MERGE,
+               "okcolor.h session constants out of sync");
+
+int okc_extractor_session_begin(okc_extractor *ex, const uint8_t *rgba, int width, int height)
+{
+  return ex && session_begin(&ex->session, rgba, width, height) ? 0 : -1;
+}
+
+int okc_extractor_session_run(okc_extractor *ex, okc_color *out, int cap)
+{
+  if (!ex || !session_run(&ex->session, &ex->opt))
+    return -1;
+  // 同渐进取色：交出结果的拷贝，会话保留自己的一份供下次只重新合并时复用
+  int m = ex->session.m;
+  ColorAgg *agg = (ColorAgg *)malloc((size_t)(m > 0 ? m : 1) * sizeof(ColorAgg));
+  if (!agg)
+    return -1;
+  if (m)
+    memcpy(agg, ex->session.agg, (size_t)m * sizeof(ColorAgg));
+  return emit_okc_colors(agg, m, out, cap);
+}
+
+int okc_extractor_session_recomputed(const okc_extractor *ex)
+{
+  return ex ? ex->session.recomputed : 0;
+}
+
+_Static_assert(OKC_HIERARCHY_MAX_K == HIER_MAX_K, "okcolor.h hierarchy constant out of sync");
+
+int okc_extractor_hierarchy_build(okc_extractor *ex, const uint8_t *rgba, int width, int height, int maxK)
+{
+  if (!ex || !hierarchy_build_rgba(&ex->hier, rgba, width, height, &ex->opt, maxK > 0 ? maxK : HIER_MAX_K))
+    return -1;
+  return ex->hier.levels;
+}
+
+int okc_extractor_hierarchy_palette(const okc_extractor *ex, int k, okc_color *out, int cap)
+{
+  if (!ex || ex->hier.levels <= 0 || k < 1 || k > ex->hier.levels)
+    return -1;
+  ColorAgg *agg = NULL;
+  int m = 0;
+  if (!hierarchy_palette(&ex->hier, k, &ex->opt, &agg, &m))
+    return -1;
+  return emit_okc_colors(agg, m, out, cap);
+}
+#endif
+
+#ifdef EC_WITH_IMAGEIO
 static void print_usage(const char *prog)
 {
   fprintf(stderr,
           "Usage:\n"
           "  %s <image_path> [--pixels N] [--distance D] [--saturationDistance S]\n"
           "                 [--lightnessDistance L] [--hueDistance H] [--alphaThreshold A]\n"
-          "                 [--maxColors K]\n\n"
+          "                 [--maxColors K] [--deadline US] [--frame N] [--all-k]\n\n"
           "Defaults: pixels=64000, distance=0.22, saturationDistance=0.2, lightnessDistance=0.2,\n"
-          "          hueDistance=0.083333333 (~30deg), alphaThreshold=250, maxColors=16\n",
+          "          hueDistance=0.083333333 (~30deg), alphaThreshold=250, maxColors=16\n"
+          "--deadline: progressive mode; refine from a coarse sample grid and print the best\n"
+          "            palette reached within US microseconds (the coarsest stage always runs)\n"
+          "*.y4m input: frame N (--frame N, default 0) is read straight from the YUV planes\n"
+          "Indexed PNG/GIF input: palette indices are counted directly (no RGBA expansion)\n"
+          "--all-k: print an array of palettes for K = 1..maxColors (max 64) from one nested\n"
+          "         divisive clustering of the histogram\n",
           prog);
 }
 
-#ifndef __EMSCRIPTEN__
 int main(int argc, char **argv)
 {
   if (argc < 2)
@@ -955,6 +2803,9 @@ int main(int argc, char **argv)
   opt.hueDist = 0.083333333; // ~30 degrees
   opt.alphaThreshold = 250;
   opt.maxColors = 16;
+  double deadline = 0.0; // > 0 时走渐进模式
+  int frame = 0;         // .y4m 输入的帧号
+  int allK = 0;          // --all-k
 
   // parse args
   for (int i = 1; i < argc; ++i)
@@ -997,6 +2848,21 @@ int main(int argc, char **argv)
         opt.maxColors = atoi(argv[++i]);
         continue;
       }
+      if (strcmp(a, "--deadline") == 0 && i + 1 < argc)
+      {
+        deadline = atof(argv[++i]);
+        continue;
+      }
+      if (strcmp(a, "--frame") == 0 && i + 1 < argc)
+      {
+        frame = atoi(argv[++i]);
+        continue;
+      }
+      if (strcmp(a, "--all-k") == 0)
+      {
+        allK = 1;
+        continue;
+      }
       fprintf(stderr, "Unknown or incomplete option: %s\n", a);
       print_usage(argv[0]);
       return 1;
@@ -1020,14 +2886,21 @@ int main(int argc, char **argv)
     return 1;
   }
 
+  size_t plen = strlen(imagePath);
+  if (plen > 4 && strcmp(imagePath + plen - 4, ".y4m") == 0)
+    return extract_colors_from_y4m(imagePath, frame, &opt);
+
   Image im;
-  if (!load_image_rgba8(imagePath, &im))
+  if (!load_image(imagePath, &im))
   {
     fprintf(stderr, "Failed to load image: %s\n", imagePath);
     return 1;
   }
 
-  int ok = extract_colors_from_image(&im, &opt);
+  // 索引色图本身几乎不花时间，--deadline 对它不起作用
+  int ok = allK ? extract_colors_all_k(&im, &opt)
+           : deadline > 0.0 && im.rgba ? extract_colors_progressive(&im, &opt, deadline)
+                                       : extract_colors_from_image(&im, &opt);
   free_image(&im);
   return ok ? 0 : 2;
 }
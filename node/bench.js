@@ -0,0 +1,100 @@
+#!/usr/bin/env node
+'use strict';
+/*
+Native addon vs Wasm builds on the same inputs.
+
+Usage: node bench.js [colors]   (build first: npx node-gyp rebuild)
+*/
+const fs = require('node:fs');
+const path = require('node:path');
+const ok = require('./index.js');
+
+const WASM_DIR = path.join(__dirname, '..', 'wasm');
+
+function loadWasm(name) {
+  const mod = new WebAssembly.Module(fs.readFileSync(path.join(WASM_DIR, name)));
+  const imports = {};
+  for (const imp of WebAssembly.Module.imports(mod)) {
+    if (imp.kind === 'function') (imports[imp.module] ??= {})[imp.name] = () => 0;
+  }
+  return new WebAssembly.Instance(mod, imports).exports;
+}
+
+async function time(label, fn, reps = 5) {
+  await fn(); // 热身
+  const ts = [];
+  for (let i = 0; i < reps; i++) {
+    const t0 = process.hrtime.bigint();
+    await fn();
+    ts.push(Number(process.hrtime.bigint() - t0) / 1e6);
+  }
+  ts.sort((a, b) => a - b);
+  const med = ts[ts.length >> 1];
+  console.log(`${label.padEnd(36)} ${med.toFixed(2).padStart(10)} ms`);
+  return med;
+}
+
+async function main() {
+  const n = Math.max(1, parseInt(process.argv[2] || '1000000', 10));
+  const rgb = new Uint8Array(n * 3);
+  for (let i = 0; i < rgb.length; i++) rgb[i] = (i * 2654435761) >>> 24;
+  const lch = ok.rgb2oklchBatch(rgb);
+  const outRgb = new Uint8Array(n * 3);
+  const outLch = new Float64Array(n * 3);
+
+  const wRo = loadWasm('rgb2oklch.wasm');
+  const wOk = loadWasm('oklch2rgb.wasm');
+  const wEx = loadWasm('extract-colors.wasm');
+  const wSq = loadWasm('squircle-svg.wasm');
+
+  console.log(`[bench] ${n} colors, UV_THREADPOOL_SIZE=${process.env.UV_THREADPOOL_SIZE || 4}`);
+  const a = await time('rgb2oklch   wasm (per call)', () => {
+    for (let i = 0; i < n; i++) {
+      const p = wRo.rgb2oklch_calc_js(rgb[i * 3], rgb[i * 3 + 1], rgb[i * 3 + 2]) >>> 0;
+      const f = new Float64Array(wRo.memory.buffer, p, 3);
+      outLch[i * 3] = f[0]; outLch[i * 3 + 1] = f[1]; outLch[i * 3 + 2] = f[2];
+    }
+  });
+  const b = await time('rgb2oklch   native batch', () => ok.rgb2oklchBatch(rgb, outLch));
+  const c = await time('rgb2oklch   native batch async', () => ok.rgb2oklchBatchAsync(rgb, outLch));
+  console.log(`  speedup: batch ${(a / b).toFixed(1)}x, async ${(a / c).toFixed(1)}x`);
+
+  const d = await time('oklch2rgb   wasm (per call)', () => {
+    for (let i = 0; i < n; i++) {
+      const p = wOk.oklch2rgb_calc_js(lch[i * 3], lch[i * 3 + 1], lch[i * 3 + 2]) >>> 0;
+      const v = new Int32Array(wOk.memory.buffer, p, 3);
+      outRgb[i * 3] = v[0]; outRgb[i * 3 + 1] = v[1]; outRgb[i * 3 + 2] = v[2];
+    }
+  });
+  const e = await time('oklch2rgb   native batch', () => ok.oklch2rgbBatch(lch, outRgb));
+  const f = await time('oklch2rgb   native batch async', () => ok.oklch2rgbBatchAsync(lch, outRgb));
+  console.log(`  speedup: batch ${(d / e).toFixed(1)}x, async ${(d / f).toFixed(1)}x`);
+
+  const w = 2048, h = 2048;
+  const img = new Uint8Array(w * h * 4);
+  for (let i = 0; i < img.length; i += 4) {
+    img[i] = (i >>> 4) & 255; img[i + 1] = (i >>> 12) & 255; img[i + 2] = (i >>> 7) & 255; img[i + 3] = 255;
+  }
+  const g = await time('extract     wasm 4 MP', () => {
+    const p = wEx.get_pixels_buffer(img.length) >>> 0;
+    new Uint8Array(wEx.memory.buffer, p, img.length).set(img);
+    wEx.extract_colors_from_rgba_js(p, w, h, 64000, 0.22, 0.2, 0.2, 1 / 12, 250, 64);
+  });
+  const hh = await time('extract     native 4 MP (async)', () => ok.extractColors({ data: img, width: w, height: h }));
+  console.log(`  speedup: ${(g / hh).toFixed(1)}x`);
+
+  const shapes = [];
+  for (let i = 0; i < 10000; i++) shapes.push([i & 1 ? 'capsule' : 'squircle', 200 + (i % 300), 120 + (i % 50), 16]);
+  const dec = new TextDecoder();
+  const k = await time('squircle    wasm 10k paths', () => {
+    for (const [s, sw, sh, sr] of shapes) {
+      const p = (s === 'squircle' ? wSq.squircle_path_js(sw, sh, sr) : wSq.capsule_path_js(sw, sh, sr)) >>> 0;
+      const u8 = new Uint8Array(wSq.memory.buffer, p);
+      dec.decode(u8.subarray(0, u8.indexOf(0)));
+    }
+  });
+  const l = await time('squircle    native 10k paths', () => ok.getPathsSync(shapes));
+  console.log(`  speedup: ${(k / l).toFixed(1)}x`);
+}
+
+main().catch((e) => { console.error(e); process.exit(1); });
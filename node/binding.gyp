@@ -0,0 +1,20 @@
+{
+  "targets": [
+    {
+      "target_name": "okcolor",
+      "sources": [
+        "okcolor_napi.c",
+        "../oklch2rgb.c",
+        "../rgb2oklch.c",
+        "../extract-colors.c",
+        "../squircle_svg.c"
+      ],
+      "include_dirs": [".."],
+      "defines": ["OKCOLOR_EMBED", "NAPI_VERSION=8"],
+      "cflags": ["-O3", "-ffast-math", "-std=c11"],
+      "xcode_settings": {
+        "OTHER_CFLAGS": ["-O3", "-ffast-math", "-std=c11"]
+      }
+    }
+  ]
+}
@@ -0,0 +1,161 @@
+'use strict';
+// okcolor 原生插件的 JS 封装（Node.js，CommonJS）
+// - API 与浏览器端模块对齐：
+//     color-convert.js : rgb2oklch / oklch2rgb_abs / oklch2rgb_rel
+//     extract-colors.js: extractColors（默认导出同名）
+//     squircle-svg.js  : getPath / getSquircle / getCapsule / getPathsSync
+// - 另提供零拷贝批量接口（直接读写传入的 TypedArray/Buffer）：
+//     oklch2rgbBatch(lch, out?) / oklch2rgbRelBatch(lhr, out?) / rgb2oklchBatch(rgb, out?)
+//     以及 *Async 版本：按线程池大小切分为多个任务并行执行，返回 Promise
+
+const path = require('node:path');
+
+const native = require(path.join(__dirname, 'build', 'Release', 'okcolor.node'));
+
+// 切片粒度：太小的任务得不偿失，低于该数量直接单任务
+const MIN_CHUNK = 16384;
+const POOL_SIZE = Math.max(1, parseInt(process.env.UV_THREADPOOL_SIZE || '4', 10));
+
+const SHAPE_CODES = { squircle: 0, capsule: 1 };
+
+// ---- color-convert.js 对齐 ----
+const _rgb1 = new Uint8Array(3);
+const _lch1 = new Float64Array(3);
+
+async function rgb2oklch(r, g, b) {
+  _rgb1[0] = clamp255(r); _rgb1[1] = clamp255(g); _rgb1[2] = clamp255(b);
+  native.rgb2oklchBatch(_rgb1, _lch1);
+  return { L: _lch1[0], C: _lch1[1], h: _lch1[2] };
+}
+
+async function oklch2rgb_abs(L, C, h) {
+  _lch1[0] = +L; _lch1[1] = +C; _lch1[2] = +h;
+  native.oklch2rgbBatch(_lch1, _rgb1);
+  return { R: _rgb1[0], G: _rgb1[1], B: _rgb1[2] };
+}
+
+async function oklch2rgb_rel(L, h, rel) {
+  _lch1[0] = +L; _lch1[1] = +h; _lch1[2] = Math.max(0, Math.min(1, Number(rel)));
+  native.oklch2rgbRelBatch(_lch1, _rgb1);
+  return { R: _rgb1[0], G: _rgb1[1], B: _rgb1[2] };
+}
+
+// ---- 批量接口 ----
+function oklch2rgbBatch(lch, out) {
+  return native.oklch2rgbBatch(lch, out || new Uint8Array(lch.length));
+}
+
+function oklch2rgbRelBatch(lhr, out) {
+  return native.oklch2rgbRelBatch(lhr, out || new Uint8Array(lhr.length));
+}
+
+function rgb2oklchBatch(rgb, out) {
+  return native.rgb2oklchBatch(rgb, out || new Float64Array(rgb.length));
+}
+
+// 将 [0, n) 按颜色切成最多 POOL_SIZE 段，subarray 为零拷贝视图
+async function parallel(fn, input, out) {
+  const n = Math.floor(input.length / 3);
+  const parts = Math.max(1, Math.min(POOL_SIZE, Math.floor(n / MIN_CHUNK)));
+  const per = Math.ceil(n / parts);
+  const jobs = [];
+  for (let s = 0; s < n; s += per) {
+    const e = Math.min(n, s + per);
+    jobs.push(fn(input.subarray(s * 3, e * 3), out.subarray(s * 3, e * 3)));
+  }
+  await Promise.all(jobs);
+  return out;
+}
+
+function oklch2rgbBatchAsync(lch, out) {
+  return parallel(native.oklch2rgbBatchAsync, lch, out || new Uint8Array(lch.length));
+}
+
+function oklch2rgbRelBatchAsync(lhr, out) {
+  return parallel(native.oklch2rgbRelBatchAsync, lhr, out || new Uint8Array(lhr.length));
+}
+
+function rgb2oklchBatchAsync(rgb, out) {
+  return parallel(native.rgb2oklchBatchAsync, rgb, out || new Float64Array(rgb.length));
+}
+
+// ---- extract-colors.js 对齐 ----
+// input: { data, width, height }（ImageData 形状；data 为 Uint8Array/Uint8ClampedArray/Buffer）
+async function extractColors(input, opts = {}) {
+  const { data, width, height } = input;
+  const u8 = data instanceof Uint8Array || data instanceof Uint8ClampedArray ? data : new Uint8Array(data);
+  const hasCustomValidator = typeof opts.colorValidator === 'function';
+  let pixels = u8;
+  if (hasCustomValidator) {
+    // 校验器需要逐像素回调 JS，只能在主线程处理；被拒像素 alpha 置 0
+    pixels = new Uint8Array(u8);
+    for (let i = 0; i < pixels.length; i += 4) {
+      if (!opts.colorValidator(pixels[i], pixels[i + 1], pixels[i + 2], pixels[i + 3])) pixels[i + 3] = 0;
+    }
+  }
+  return native.extractColors(pixels, width | 0, height | 0, {
+    pixels: Math.max(1, Math.floor(opts.pixels ?? 64000)),
+    distance: clamp01(opts.distance ?? 0.22),
+    saturationDistance: clamp01(opts.saturationDistance ?? 0.2),
+    lightnessDistance: clamp01(opts.lightnessDistance ?? 0.2),
+    hueDistance: clamp01(opts.hueDistance ?? 1 / 12),
+    alphaThreshold: hasCustomValidator ? 1 : 250,
+    maxColors: 64,
+  });
+}
+
+// ---- squircle-svg.js 对齐 ----
+function shapeCode(shape) {
+  const code = SHAPE_CODES[String(shape).toLowerCase()];
+  if (code === undefined) throw new Error('Unknown shape: ' + shape);
+  return code;
+}
+
+async function getSquircle(width, height, radius) {
+  return native.shapePath(0, +width, +height, +radius);
+}
+
+async function getCapsule(width, height, radius) {
+  return native.shapePath(1, +width, +height, +radius);
+}
+
+async function getPath(shape, width, height, radius) {
+  return native.shapePath(shapeCode(shape), +width, +height, +radius);
+}
+
+async function init() { }
+
+function getPathsSync(items) {
+  const specs = new Float64Array(items.length * 4);
+  for (let i = 0; i < items.length; i++) {
+    const it = items[i];
+    const isArr = Array.isArray(it);
+    specs[i * 4] = shapeCode(isArr ? it[0] : it.shape);
+    specs[i * 4 + 1] = +(isArr ? it[1] : it.width);
+    specs[i * 4 + 2] = +(isArr ? it[2] : it.height);
+    specs[i * 4 + 3] = +(isArr ? it[3] : it.radius);
+  }
+  return native.shapePaths(specs);
+}
+
+function clamp01(n) { return Math.min(1, Math.max(0, Number(n))); }
+function clamp255(n) { return Math.min(255, Math.max(0, Number(n) | 0)); }
+
+module.exports = {
+  rgb2oklch,
+  oklch2rgb_abs,
+  oklch2rgb_rel,
+  oklch2rgbBatch,
+  oklch2rgbRelBatch,
+  rgb2oklchBatch,
+  oklch2rgbBatchAsync,
+  oklch2rgbRelBatchAsync,
+  rgb2oklchBatchAsync,
+  extractColors,
+  default: extractColors,
+  init,
+  getPath,
+  getSquircle,
+  getCapsule,
+  getPathsSync,
+};
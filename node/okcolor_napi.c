@@ -0,0 +1,487 @@
+// okcolor N-API 插件：直接链接 oklch2rgb.c / rgb2oklch.c / extract-colors.c / squircle_svg.c
+// （以 -DOKCOLOR_EMBED 编译），在 Buffer/TypedArray 上零拷贝运行批量内核。
+// 长任务（批量转换、取色）通过 napi_async_work 在 libuv 线程池异步执行，返回 Promise。
+//
+// 导出（底层接口，JS 友好封装见 index.js）：
+//   oklch2rgbBatch(lch: Float64Array, out: Uint8Array)            -> out
+//   oklch2rgbRelBatch(lhr: Float64Array, out: Uint8Array)         -> out
+//   rgb2oklchBatch(rgb: Uint8Array, out: Float64Array)            -> out
+//   oklch2rgbBatchAsync / oklch2rgbRelBatchAsync / rgb2oklchBatchAsync(同上) -> Promise<out>
+//   extractColors(rgba: Uint8Array|Uint8ClampedArray, width, height, opts?) -> Promise<Color[]>
+//   shapePath(shapeCode, width, height, radius)                  -> string
+//   shapePaths(specs: Float64Array [shape, w, h, r] × n)         -> string[]
+
+#ifndef NAPI_VERSION
+#define NAPI_VERSION 8
+#endif
+#include <node_api.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "../okcolor.h"
+
+#define NAPI_CALL(env, call)                                      \
+  do                                                              \
+  {                                                               \
+    if ((call) != napi_ok)                                        \
+    {                                                             \
+      napi_throw_error((env), NULL, "N-API call failed: " #call); \
+      return NULL;                                                \
+    }                                                             \
+  } while (0)
+
+// 异步任务排队前的 N-API 调用：失败时记下调用并跳到 fail，由调用方删除已建的引用、释放 job
+#define JOB_CALL(call)                            \
+  do                                              \
+  {                                               \
+    if ((call) != napi_ok)                        \
+    {                                             \
+      failed = "N-API call failed: " #call;       \
+      goto fail;                                  \
+    }                                             \
+  } while (0)
+
+// 排队失败的收尾：promise 已创建则以错误拒绝并返回它（调用方拿到已结束的 promise），否则抛出异常
+static napi_value reject_unqueued(napi_env env, napi_deferred deferred, napi_value promise, const char *failed)
+{
+  napi_value msg, err;
+  if (deferred && napi_create_string_utf8(env, failed, NAPI_AUTO_LENGTH, &msg) == napi_ok &&
+      napi_create_error(env, NULL, msg, &err) == napi_ok && napi_reject_deferred(env, deferred, err) == napi_ok)
+    return promise;
+  napi_throw_error(env, NULL, failed);
+  return NULL;
+}
+
+// ---- TypedArray 取数辅助 ----
+typedef struct
+{
+  void *data;
+  size_t length; // 元素个数
+  napi_typedarray_type type;
+} ArrayView;
+
+static int get_typed_array(napi_env env, napi_value v, ArrayView *out)
+{
+  bool is_ta = false;
+  if (napi_is_typedarray(env, v, &is_ta) != napi_ok || !is_ta)
+  {
+    bool is_buf = false;
+    if (napi_is_buffer(env, v, &is_buf) != napi_ok || !is_buf)
+      return 0;
+    size_t len = 0;
+    if (napi_get_buffer_info(env, v, &out->data, &len) != napi_ok)
+      return 0;
+    out->length = len;
+    out->type = napi_uint8_array;
+    return 1;
+  }
+  napi_value ab;
+  size_t off = 0;
+  return napi_get_typedarray_info(env, v, &out->type, &out->length, &out->data, &ab, &off) == napi_ok;
+}
+
+static int is_u8_type(napi_typedarray_type t)
+{
+  return t == napi_uint8_array || t == napi_uint8_clamped_array;
+}
+
+// ---- 批量转换 ----
+typedef enum
+{
+  JOB_OKLCH2RGB = 0,
+  JOB_OKLCH2RGB_REL = 1,
+  JOB_RGB2OKLCH = 2
+} ConvertKind;
+
+// 校验参数并返回颜色个数；失败时已抛出异常并返回 (size_t)-1
+static size_t check_convert_args(napi_env env, ConvertKind kind, ArrayView *in, ArrayView *out)
+{
+  if (kind == JOB_RGB2OKLCH)
+  {
+    if (!is_u8_type(in->type) || out->type != napi_float64_array)
+    {
+      napi_throw_type_error(env, NULL, "expected (Uint8Array rgb, Float64Array out)");
+      return (size_t)-1;
+    }
+  }
+  else if (in->type != napi_float64_array || !is_u8_type(out->type))
+  {
+    napi_throw_type_error(env, NULL, "expected (Float64Array lch, Uint8Array out)");
+    return (size_t)-1;
+  }
+  size_t n = in->length / 3;
+  if (out->length < n * 3)
+  {
+    napi_throw_range_error(env, NULL, "output array too small");
+    return (size_t)-1;
+  }
+  return n;
+}
+
+static void run_convert(ConvertKind kind, const void *in, size_t n, void *out)
+{
+  switch (kind)
+  {
+  case JOB_OKLCH2RGB:
+    okc_oklch_to_rgb8_batch((const double *)in, n, (uint8_t *)out);
+    break;
+  case JOB_OKLCH2RGB_REL:
+    okc_oklch_rel_to_rgb8_batch((const double *)in, n, (uint8_t *)out);
+    break;
+  case JOB_RGB2OKLCH:
+    okc_rgb8_to_oklch_batch((const uint8_t *)in, n, (double *)out);
+    break;
+  }
+}
+
+static napi_value convert_sync(napi_env env, napi_callback_info info, ConvertKind kind)
+{
+  size_t argc = 2;
+  napi_value argv[2];
+  NAPI_CALL(env, napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
+  ArrayView in, out;
+  if (argc < 2 || !get_typed_array(env, argv[0], &in) || !get_typed_array(env, argv[1], &out))
+  {
+    napi_throw_type_error(env, NULL, "expected two typed arrays");
+    return NULL;
+  }
+  size_t n = check_convert_args(env, kind, &in, &out);
+  if (n == (size_t)-1)
+    return NULL;
+  run_convert(kind, in.data, n, out.data);
+  return argv[1];
+}
+
+static napi_value Oklch2rgbBatch(napi_env env, napi_callback_info info) { return convert_sync(env, info, JOB_OKLCH2RGB); }
+static napi_value Oklch2rgbRelBatch(napi_env env, napi_callback_info info) { return convert_sync(env, info, JOB_OKLCH2RGB_REL); }
+static napi_value Rgb2oklchBatch(napi_env env, napi_callback_info info) { return convert_sync(env, info, JOB_RGB2OKLCH); }
+
+// 异步版本：持有输入/输出数组的引用，保证线程池执行期间不被回收
+typedef struct
+{
+  napi_async_work work;
+  napi_deferred deferred;
+  napi_ref in_ref, out_ref;
+  ConvertKind kind;
+  const void *in;
+  void *out;
+  size_t n;
+} ConvertJob;
+
+static void convert_execute(napi_env env, void *data)
+{
+  (void)env;
+  ConvertJob *job = (ConvertJob *)data;
+  run_convert(job->kind, job->in, job->n, job->out);
+}
+
+static void convert_complete(napi_env env, napi_status status, void *data)
+{
+  ConvertJob *job = (ConvertJob *)data;
+  napi_value out;
+  napi_get_reference_value(env, job->out_ref, &out);
+  if (status == napi_ok)
+    napi_resolve_deferred(env, job->deferred, out);
+  else
+  {
+    napi_value msg, err;
+    napi_create_string_utf8(env, "conversion job cancelled", NAPI_AUTO_LENGTH, &msg);
+    napi_create_error(env, NULL, msg, &err);
+    napi_reject_deferred(env, job->deferred, err);
+  }
+  napi_delete_reference(env, job->in_ref);
+  napi_delete_reference(env, job->out_ref);
+  napi_delete_async_work(env, job->work);
+  free(job);
+}
+
+static napi_value convert_async(napi_env env, napi_callback_info info, ConvertKind kind)
+{
+  size_t argc = 2;
+  napi_value argv[2];
+  NAPI_CALL(env, napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
+  ArrayView in, out;
+  if (argc < 2 || !get_typed_array(env, argv[0], &in) || !get_typed_array(env, argv[1], &out))
+  {
+    napi_throw_type_error(env, NULL, "expected two typed arrays");
+    return NULL;
+  }
+  size_t n = check_convert_args(env, kind, &in, &out);
+  if (n == (size_t)-1)
+    return NULL;
+
+  ConvertJob *job = (ConvertJob *)calloc(1, sizeof(ConvertJob));
+  if (!job)
+  {
+    napi_throw_error(env, NULL, "out of memory");
+    return NULL;
+  }
+  job->kind = kind;
+  job->in = in.data;
+  job->out = out.data;
+  job->n = n;
+  napi_value promise = NULL, name;
+  const char *failed = NULL;
+  JOB_CALL(napi_create_promise(env, &job->deferred, &promise));
+  JOB_CALL(napi_create_reference(env, argv[0], 1, &job->in_ref));
+  JOB_CALL(napi_create_reference(env, argv[1], 1, &job->out_ref));
+  JOB_CALL(napi_create_string_utf8(env, "okcolor:convert", NAPI_AUTO_LENGTH, &name));
+  JOB_CALL(napi_create_async_work(env, NULL, name, convert_execute, convert_complete, job, &job->work));
+  JOB_CALL(napi_queue_async_work(env, job->work));
+  return promise;
+fail:
+  if (job->in_ref)
+    napi_delete_reference(env, job->in_ref);
+  if (job->out_ref)
+    napi_delete_reference(env, job->out_ref);
+  if (job->work)
+    napi_delete_async_work(env, job->work);
+  napi_deferred deferred = job->deferred;
+  free(job);
+  return reject_unqueued(env, deferred, promise, failed);
+}
+
+static napi_value Oklch2rgbBatchAsync(napi_env env, napi_callback_info info) { return convert_async(env, info, JOB_OKLCH2RGB); }
+static napi_value Oklch2rgbRelBatchAsync(napi_env env, napi_callback_info info) { return convert_async(env, info, JOB_OKLCH2RGB_REL); }
+static napi_value Rgb2oklchBatchAsync(napi_env env, napi_callback_info info) { return convert_async(env, info, JOB_RGB2OKLCH); }
+
+// ---- 取色（异步） ----
+#define EXTRACT_MAX_COLORS 64
+
+typedef struct
+{
+  napi_async_work work;
+  napi_deferred deferred;
+  napi_ref pixels_ref;
+  const uint8_t *rgba;
+  int width, height;
+  okc_extract_options opt;
+  okc_color colors[EXTRACT_MAX_COLORS];
+  int count;
+} ExtractJob;
+
+static void extract_execute(napi_env env, void *data)
+{
+  (void)env;
+  ExtractJob *job = (ExtractJob *)data;
+  job->count = okc_extract_colors(job->rgba, job->width, job->height, &job->opt, job->colors, EXTRACT_MAX_COLORS);
+}
+
+static void set_num(napi_env env, napi_value obj, const char *key, double v)
+{
+  napi_value nv;
+  napi_create_double(env, v, &nv);
+  napi_set_named_property(env, obj, key, nv);
+}
+
+static void extract_complete(napi_env env, napi_status status, void *data)
+{
+  ExtractJob *job = (ExtractJob *)data;
+  if (status != napi_ok || job->count < 0)
+  {
+    napi_value msg, err;
+    napi_create_string_utf8(env, "extractColors failed", NAPI_AUTO_LENGTH, &msg);
+    napi_create_error(env, NULL, msg, &err);
+    napi_reject_deferred(env, job->deferred, err);
+  }
+  else
+  {
+    napi_value arr;
+    napi_create_array_with_length(env, (size_t)job->count, &arr);
+    for (int i = 0; i < job->count; ++i)
+    {
+      const okc_color *c = &job->colors[i];
+      napi_value obj, hex;
+      napi_create_object(env, &obj);
+      // 字段顺序与 wasm/extract-colors.js 一致
+      napi_create_string_utf8(env, c->hex, 7, &hex);
+      napi_set_named_property(env, obj, "hex", hex);
+      set_num(env, obj, "red", c->red);
+      set_num(env, obj, "green", c->green);
+      set_num(env, obj, "blue", c->blue);
+      set_num(env, obj, "area", c->area);
+      set_num(env, obj, "hue", c->hue);
+      set_num(env, obj, "saturation", c->saturation);
+      set_num(env, obj, "lightness", c->lightness);
+      set_num(env, obj, "intensity", c->intensity);
+      napi_set_element(env, arr, (uint32_t)i, obj);
+    }
+    napi_resolve_deferred(env, job->deferred, arr);
+  }
+  napi_delete_reference(env, job->pixels_ref);
+  napi_delete_async_work(env, job->work);
+  free(job);
+}
+
+static int get_opt_double(napi_env env, napi_value obj, const char *key, double *out)
+{
+  bool has = false;
+  if (napi_has_named_property(env, obj, key, &has) != napi_ok || !has)
+    return 0;
+  napi_value v;
+  napi_valuetype t;
+  if (napi_get_named_property(env, obj, key, &v) != napi_ok || napi_typeof(env, v, &t) != napi_ok || t != napi_number)
+    return 0;
+  return napi_get_value_double(env, v, out) == napi_ok;
+}
+
+static napi_value ExtractColors(napi_env env, napi_callback_info info)
+{
+  size_t argc = 4;
+  napi_value argv[4];
+  NAPI_CALL(env, napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
+  ArrayView px;
+  int32_t w = 0, h = 0;
+  if (argc < 3 || !get_typed_array(env, argv[0], &px) || !is_u8_type(px.type) ||
+      napi_get_value_int32(env, argv[1], &w) != napi_ok || napi_get_value_int32(env, argv[2], &h) != napi_ok)
+  {
+    napi_throw_type_error(env, NULL, "expected (Uint8Array rgba, width, height, opts?)");
+    return NULL;
+  }
+  if (w <= 0 || h <= 0 || px.length < (size_t)w * (size_t)h * 4)
+  {
+    napi_throw_range_error(env, NULL, "pixel buffer smaller than width*height*4");
+    return NULL;
+  }
+
+  ExtractJob *job = (ExtractJob *)calloc(1, sizeof(ExtractJob));
+  if (!job)
+  {
+    napi_throw_error(env, NULL, "out of memory");
+    return NULL;
+  }
+  job->rgba = (const uint8_t *)px.data;
+  job->width = w;
+  job->height = h;
+  okc_extract_options_default(&job->opt);
+  napi_valuetype t = napi_undefined;
+  if (argc >= 4)
+    napi_typeof(env, argv[3], &t);
+  if (t == napi_object)
+  {
+    double v;
+    if (get_opt_double(env, argv[3], "pixels", &v))
+      job->opt.pixels = (int)v;
+    if (get_opt_double(env, argv[3], "distance", &v))
+      job->opt.distance = v;
+    if (get_opt_double(env, argv[3], "saturationDistance", &v))
+      job->opt.saturationDistance = v;
+    if (get_opt_double(env, argv[3], "lightnessDistance", &v))
+      job->opt.lightnessDistance = v;
+    if (get_opt_double(env, argv[3], "hueDistance", &v))
+      job->opt.hueDistance = v;
+    if (get_opt_double(env, argv[3], "alphaThreshold", &v))
+      job->opt.alphaThreshold = (int)v;
+    if (get_opt_double(env, argv[3], "maxColors", &v))
+      job->opt.maxColors = (int)v;
+  }
+  if (job->opt.maxColors <= 0 || job->opt.maxColors > EXTRACT_MAX_COLORS)
+    job->opt.maxColors = EXTRACT_MAX_COLORS;
+
+  napi_value promise = NULL, name;
+  const char *failed = NULL;
+  JOB_CALL(napi_create_promise(env, &job->deferred, &promise));
+  JOB_CALL(napi_create_reference(env, argv[0], 1, &job->pixels_ref));
+  JOB_CALL(napi_create_string_utf8(env, "okcolor:extract", NAPI_AUTO_LENGTH, &name));
+  JOB_CALL(napi_create_async_work(env, NULL, name, extract_execute, extract_complete, job, &job->work));
+  JOB_CALL(napi_queue_async_work(env, job->work));
+  return promise;
+fail:
+  if (job->pixels_ref)
+    napi_delete_reference(env, job->pixels_ref);
+  if (job->work)
+    napi_delete_async_work(env, job->work);
+  napi_deferred deferred = job->deferred;
+  free(job);
+  return reject_unqueued(env, deferred, promise, failed);
+}
+
+// ---- squircle / capsule 路径（同步） ----
+static napi_value make_path_string(napi_env env, int shape, double w, double h, double r)
+{
+  char stack[4096];
+  size_t n = okc_shape_path(shape, w, h, r, stack, sizeof(stack));
+  napi_value s;
+  if (n < sizeof(stack))
+  {
+    NAPI_CALL(env, napi_create_string_latin1(env, stack, n, &s));
+    return s;
+  }
+  char *heap = (char *)malloc(n + 1);
+  if (!heap)
+  {
+    napi_throw_error(env, NULL, "out of memory");
+    return NULL;
+  }
+  okc_shape_path(shape, w, h, r, heap, n + 1);
+  napi_status st = napi_create_string_latin1(env, heap, n, &s);
+  free(heap);
+  NAPI_CALL(env, st);
+  return s;
+}
+
+static napi_value ShapePath(napi_env env, napi_callback_info info)
+{
+  size_t argc = 4;
+  napi_value argv[4];
+  NAPI_CALL(env, napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
+  int32_t shape = 0;
+  double w = 0, h = 0, r = 0;
+  if (argc < 4 || napi_get_value_int32(env, argv[0], &shape) != napi_ok ||
+      napi_get_value_double(env, argv[1], &w) != napi_ok || napi_get_value_double(env, argv[2], &h) != napi_ok ||
+      napi_get_value_double(env, argv[3], &r) != napi_ok)
+  {
+    napi_throw_type_error(env, NULL, "expected (shapeCode, width, height, radius)");
+    return NULL;
+  }
+  return make_path_string(env, shape, w, h, r);
+}
+
+static napi_value ShapePaths(napi_env env, napi_callback_info info)
+{
+  size_t argc = 1;
+  napi_value argv[1];
+  NAPI_CALL(env, napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
+  ArrayView specs;
+  if (argc < 1 || !get_typed_array(env, argv[0], &specs) || specs.type != napi_float64_array)
+  {
+    napi_throw_type_error(env, NULL, "expected Float64Array [shape, w, h, r] x n");
+    return NULL;
+  }
+  const double *sp = (const double *)specs.data;
+  size_t n = specs.length / 4;
+  napi_value arr;
+  NAPI_CALL(env, napi_create_array_with_length(env, n, &arr));
+  for (size_t i = 0; i < n; ++i)
+  {
+    napi_value s = make_path_string(env, (int)sp[i * 4], sp[i * 4 + 1], sp[i * 4 + 2], sp[i * 4 + 3]);
+    if (!s)
+      return NULL;
+    NAPI_CALL(env, napi_set_element(env, arr, (uint32_t)i, s));
+  }
+  return arr;
+}
+
+// ---- 模块注册 ----
+static napi_value Init(napi_env env, napi_value exports)
+{
+  // 查表在主线程初始化一次，之后线程池任务只读
+  okc_rgb2oklch_init();
+  okc_extract_init();
+  napi_property_descriptor props[] = {
+      {"oklch2rgbBatch", NULL, Oklch2rgbBatch, NULL, NULL, NULL, napi_default, NULL},
+      {"oklch2rgbRelBatch", NULL, Oklch2rgbRelBatch, NULL, NULL, NULL, napi_default, NULL},
+      {"rgb2oklchBatch", NULL, Rgb2oklchBatch, NULL, NULL, NULL, napi_default, NULL},
+      {"oklch2rgbBatchAsync", NULL, Oklch2rgbBatchAsync, NULL, NULL, NULL, napi_default, NULL},
+      {"oklch2rgbRelBatchAsync", NULL, Oklch2rgbRelBatchAsync, NULL, NULL, NULL, napi_default, NULL},
+      {"rgb2oklchBatchAsync", NULL, Rgb2oklchBatchAsync, NULL, NULL, NULL, napi_default, NULL},
+      {"extractColors", NULL, ExtractColors, NULL, NULL, NULL, napi_default, NULL},
+      {"shapePath", NULL, ShapePath, NULL, NULL, NULL, napi_default, NULL},
+      {"shapePaths", NULL, ShapePaths, NULL, NULL, NULL, napi_default, NULL},
+  };
+  NAPI_CALL(env, napi_define_properties(env, exports, sizeof(props) / sizeof(props[0]), props));
+  return exports;
+}
+
+NAPI_MODULE(NODE_GYP_MODULE_NAME, Init)
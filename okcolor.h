@@ -0,0 +1,335 @@
+// okcolor.h —— libokcolor 公共头（C/C++ 服务、N-API 插件等直接链接调用，免去启动 CLI 进程）
+// 以 -DOKCOLOR_EMBED 编译 oklch2rgb.c / rgb2oklch.c / extract-colors.c / squircle_svg.c / palette_index.c
+// 即可得到下列符号（不含 main）；`make lib` 产出 libokcolor.a / libokcolor.so。
+// 批量接口只读写调用方提供的缓冲；上下文对象为不透明指针，由 *_create / *_destroy 管理。
+// ABI 约定：已发布的函数签名与结构体布局在同一主版本内保持不变，只追加不修改。
+// 线程安全：本头文件的 okc_* 函数可重入，不使用进程级输出缓冲，可从多个线程并发调用、无需加锁
+// （仅指原生嵌入构建；Wasm 导出带模块级状态，不在此列）；
+// 上下文对象（okc_extractor / okc_path_builder）不可跨线程共享，每个线程各建一个。
+
+#ifndef OKCOLOR_H
+#define OKCOLOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// 只追加接口时递增 MINOR，修复不改接口时递增 PATCH。各 MINOR 新增的接口（1.0 为首个发布）：
+//   1.1  okc_dedup_labels / okc_dedup_pairs          1.8  okc_palette_signature / okc_palette_index_*
+//   1.2  okc_render_slice                            1.9  okc_extractor_progressive_*
+//   1.3  okc_render_gradient                         1.10 okc_extract_colors_yuv / okc_extract_colors_y4m
+//   1.4  okc_blend_oklab                             1.11 okc_extract_colors_indexed
+//   1.5  okc_convert                                 1.12 okc_extractor_session_*
+//   1.6  okc_gamut_map_p3_image                      1.13 okc_extractor_hierarchy_*
+//   1.7  okc_cvd_simulate / okc_cvd_check
+// 运行时以 okc_version() >= 1 * 10000 + N * 100 判断库是否提供 1.N 的接口
+#define OKCOLOR_VERSION_MAJOR 1
+#define OKCOLOR_VERSION_MINOR 13
+#define OKCOLOR_VERSION_PATCH 0
+#define OKCOLOR_VERSION (OKCOLOR_VERSION_MAJOR * 10000 + OKCOLOR_VERSION_MINOR * 100 + OKCOLOR_VERSION_PATCH)
+
+// 共享库以 -fvisibility=hidden 构建，仅导出此处声明的符号
+#if defined(__GNUC__)
+#define OKC_API __attribute__((visibility("default")))
+#else
+#define OKC_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 运行时库版本（与 OKCOLOR_VERSION 比较可发现头文件/库不匹配）
+OKC_API int okc_version(void);
+
+// ---- oklch2rgb.c ----
+// lch: n 组 [L, C, h]（C 为绝对色度）；rgb: n 组 [R, G, B]（0..255，已做色域回退）
+OKC_API void okc_oklch_to_rgb8_batch(const double *lch, size_t n, uint8_t *rgb);
+// lhr: n 组 [L, h, rel]（rel ∈ [0,1] 为相对色度）；rgb 同上
+OKC_API void okc_oklch_rel_to_rgb8_batch(const double *lhr, size_t n, uint8_t *rgb);
+
+// 取色器切片渲染（类似 oklch.com 的背景）：x/y 轴见下，h 轴 [0, 360)，C 轴 [0, c_max]，L 轴自上而下 1 -> 0
+typedef enum
+{
+  OKC_SLICE_LC = 0, // x = C, y = L，fixed = h
+  OKC_SLICE_CH = 1, // x = h, y = C，fixed = L
+  OKC_SLICE_LH = 2  // x = h, y = L，fixed = C
+} okc_slice_plane;
+// rgba: width*height*4，目标色域外的像素全透明；p3 非零时目标色域为 Display-P3，并按 P3 编码输出。
+// mask 可为 NULL，否则每像素写入 0 = P3 之外、1 = 仅在 P3 内、2 = sRGB 内。
+// threads <= 0 时按在线 CPU 数按行带并行。成功返回 0，参数非法（边长 > 4096 等）返回 -1
+OKC_API int okc_render_slice(int plane, double fixed, double c_max, int width, int height, int p3, int threads,
+                             uint8_t *rgba, uint8_t *mask);
+
+// 二维渐变光栅化：停靠点插值与色域回退只在构建 4096 项查表时做一次，每像素求参数后查表
+typedef enum
+{
+  OKC_GRADIENT_LINEAR = 0,
+  OKC_GRADIENT_RADIAL = 1,
+  OKC_GRADIENT_CONIC = 2
+} okc_gradient_kind;
+
+typedef struct
+{
+  double pos;        // 0..1，须单调不减（小于前者的位置按前者处理）
+  double L, C, h;    // OKLCH（C 为绝对色度，h 为度）
+  double alpha;      // 0..1
+} okc_gradient_stop;
+
+typedef struct
+{
+  int kind;              // okc_gradient_kind
+  int oklab;             // 0 = OKLCH 插值（色相取短弧），1 = OKLab 插值；均为 alpha 预乘插值
+  int repeat;            // 0 = 两端延展，1 = 重复
+  int dither;            // 1 = 64×64 蓝噪声抖动（消除大面积渐变的色带）
+  double x0, y0, x1, y1; // 线性：起点与终点（像素）；径向/锥形：(x0, y0) 为圆心
+  double radius;         // 径向：半径（像素）
+  double angle;          // 锥形：起始角（度，0 = 正上方，顺时针，同 CSS conic-gradient）
+} okc_gradient;
+
+// rgba: width*height*4（非预乘）；threads <= 0 时按在线 CPU 数按行带并行。
+// 成功返回 0，参数非法（边长 > 16384、无停靠点等）或内存不足返回 -1
+OKC_API int okc_render_gradient(const okc_gradient *g, const okc_gradient_stop *stops, int nstops, int width,
+                                int height, int threads, uint8_t *rgba);
+
+// 广色域图像映射到 sRGB：src 为 Display-P3 编码的 RGBA8（alpha 原样保留），结果写入 dst（可与 src 相同）。
+// 色域内像素只做矩阵与查表编码；色域外像素保持 OKLCH 的 L、h 降低 C（同 okc_oklch_to_rgb8_batch 的回退），
+// 结果按颜色缓存。threads <= 0 时按在线 CPU 数按行带并行。返回色域外像素数；参数非法或内存不足返回 -1
+OKC_API int64_t okc_gamut_map_p3_image(const uint8_t *src, uint8_t *dst, int width, int height, int threads);
+
+// ---- rgb2oklch.c ----
+// 预先初始化查表（可选；首次使用时也会自动完成，线程安全）
+OKC_API void okc_rgb2oklch_init(void);
+// rgb: n 组 [R, G, B]（0..255）；lch: n 组 [L, C, h]
+OKC_API void okc_rgb8_to_oklch_batch(const uint8_t *rgb, size_t n, double *lch);
+
+// 调色板去重：deltaEOK（OKLab 欧氏距离）<= threshold 的颜色视为近似重复。
+// 颜色只转换一次，按 L 排序后分块比较；threads <= 0 时按在线 CPU 数并行。
+typedef struct
+{
+  uint32_t i, j;  // 输入下标，i < j
+  float distance; // deltaEOK
+} okc_pair;
+
+// labels: n 个输出，写入所在分组（传递闭包）的最小下标。返回分组数；失败返回 -1
+OKC_API int64_t okc_dedup_labels(const uint8_t *rgb, size_t n, double threshold, int threads, uint32_t *labels);
+// 按 (i, j) 升序写入至多 cap 个命中对，返回命中总数（可能大于 cap）；失败返回 -1
+OKC_API int64_t okc_dedup_pairs(const uint8_t *rgb, size_t n, double threshold, int threads, okc_pair *pairs,
+                                size_t cap);
+
+// OKLab 合成：在 OKLab 中求混合色，再按 W3C source-over 合成（非预乘 RGBA8）。
+// LIGHTEN/DARKEN 按 L 取整色；后四种为保色相类模式，色相/彩度由 a/b 向量缩放得到
+typedef enum
+{
+  OKC_BLEND_NORMAL = 0,
+  OKC_BLEND_LIGHTEN = 1,    // L 较大者
+  OKC_BLEND_DARKEN = 2,     // L 较小者
+  OKC_BLEND_LUMINOSITY = 3, // 前景 L，背景色相与彩度
+  OKC_BLEND_COLOR = 4,      // 背景 L，前景色相与彩度
+  OKC_BLEND_HUE = 5,        // 背景 L 与彩度，前景色相
+  OKC_BLEND_CHROMA = 6      // 背景 L 与色相，前景彩度
+} okc_blend_mode;
+
+// dst（背景）与 src（前景）各 n 个像素，结果写回 dst（可与 src 相同）；opacity 0..1 乘到前景 alpha。
+// 超出 sRGB 的混合结果逐通道裁剪。成功返回 0，模式或 opacity 无效返回 -1
+OKC_API int okc_blend_oklab(uint8_t *dst, const uint8_t *src, size_t n, okc_blend_mode mode, double opacity);
+
+// 任意两色彩空间之间的批量转换：相邻矩阵在计划中预乘，每对层级各有一份分块内核，不经整幅中间缓冲。
+// 编码 RGB 取 0..1（同 CSS color()），OKLCH 为 [L, C, h(度)]；不做色域映射或裁剪
+typedef enum
+{
+  OKC_SPACE_SRGB = 0,
+  OKC_SPACE_SRGB_LINEAR = 1,
+  OKC_SPACE_DISPLAY_P3 = 2,
+  OKC_SPACE_DISPLAY_P3_LINEAR = 3,
+  OKC_SPACE_XYZ_D65 = 4,
+  OKC_SPACE_LMS = 5, // OKLab 的线性 LMS
+  OKC_SPACE_OKLAB = 6,
+  OKC_SPACE_OKLCH = 7
+} okc_space;
+
+// in / out 各 n 组三元（可为同一缓冲）。成功返回 0，空间编号无效返回 -1
+OKC_API int okc_convert(okc_space src, okc_space dst, const double *in, size_t n, double *out);
+
+// 色觉缺陷模拟（Machado 2009 矩阵，作用于线性 sRGB）；severity ∈ [0,1]，1 为二色视，中间值与单位阵线性插值
+typedef enum
+{
+  OKC_CVD_PROTAN = 0,
+  OKC_CVD_DEUTAN = 1,
+  OKC_CVD_TRITAN = 2
+} okc_cvd;
+
+// rgba：n 个非预乘 RGBA8，就地替换为模拟结果（alpha 不变）。成功返回 0，类型或 severity 无效返回 -1
+OKC_API int okc_cvd_simulate(uint8_t *rgba, size_t n, okc_cvd type, double severity);
+
+typedef struct
+{
+  double distance; // 最小两两 deltaEOK；n < 2 时为 -1
+  uint32_t i, j;   // 取得最小值的一对，i < j
+} okc_cvd_min;
+
+// 调色板可分辨性：rgb 为 n 组 [R, G, B]（0..255）；out[0] 为正常视觉，out[1..3] 依次为 protan、deutan、tritan
+// 模拟下的结果。成功返回 0，severity 无效或内存不足返回 -1
+OKC_API int okc_cvd_check(const uint8_t *rgb, size_t n, double severity, okc_cvd_min out[4]);
+
+// ---- extract-colors.c ----
+typedef struct
+{
+  int pixels;                // 目标样本像素预算（默认 64000）
+  double distance;           // 归一化 RGB 合并距离（默认 0.22）
+  double saturationDistance; // 默认 0.2
+  double lightnessDistance;  // 默认 0.2
+  double hueDistance;        // 0..1（默认 1/12）
+  int alphaThreshold;        // 默认 250
+  int maxColors;             // 默认 16
+} okc_extract_options;
+
+typedef struct
+{
+  char hex[8]; // "#rrggbb"
+  int red, green, blue;
+  double hue, intensity, lightness, saturation, area;
+} okc_color;
+
+// 预先初始化查表（可选；首次使用时也会自动完成，线程安全）
+OKC_API void okc_extract_init(void);
+// 填充默认参数
+OKC_API void okc_extract_options_default(okc_extract_options *opt);
+// 从 RGBA8 像素取色，结果按 (intensity + 0.1) * (0.9 - area) 降序写入 out（最多 cap 个）。
+// 返回颜色数量；失败返回 -1。
+OKC_API int okc_extract_colors(const uint8_t *rgba, int width, int height, const okc_extract_options *opt,
+                               okc_color *out, int cap);
+
+// YUV 帧直接取色（视频缩略图）：只换算被采样到的像素，不生成 RGBA；所有像素视为不透明
+typedef enum
+{
+  OKC_YUV_I420 = 0, // Y、U、V 三个平面，色度 1/2 × 1/2
+  OKC_YUV_NV12 = 1, // Y 平面 + UV 交错平面（u 指向它，v 忽略）
+  OKC_YUV_I422 = 2, // 色度 1/2 × 1
+  OKC_YUV_I444 = 3,
+  OKC_YUV_GRAY = 4 // 只有 Y（u、v 忽略）
+} okc_yuv_format;
+#define OKC_YUV_BT709 1      // 否则 BT.601
+#define OKC_YUV_FULL_RANGE 2 // 否则 limited（Y 16..235）
+typedef struct
+{
+  const uint8_t *y, *u, *v;
+  size_t yStride, cStride; // 字节；NV12 的 cStride 为 UV 平面的行距
+  int width, height;
+  okc_yuv_format format;
+  int flags; // OKC_YUV_BT709 | OKC_YUV_FULL_RANGE
+} okc_yuv_frame;
+// 返回值同 okc_extract_colors；alphaThreshold 不起作用
+OKC_API int okc_extract_colors_yuv(const okc_yuv_frame *frame, const okc_extract_options *opt, okc_color *out,
+                                   int cap);
+// 内存中的 .y4m 流第 frame 帧（从 0 起）；8 位 C420* / C422 / C444 / Cmono，range 取 XCOLORRANGE（缺省 limited），
+// 矩阵按高度猜测（>= 720 为 BT.709）。流头无效或帧不完整返回 -1
+OKC_API int okc_extract_colors_y4m(const uint8_t *data, size_t len, int frame, const okc_extract_options *opt,
+                                   okc_color *out, int cap);
+
+// 索引色图（PNG 调色板 / GIF）直接取色：只统计被采样像素的调色板下标，不展开成 RGBA。
+// 结果与把图按调色板展开后调用 okc_extract_colors 相同（聚类随机初始化除外）
+typedef struct
+{
+  const uint8_t *indices; // 每像素 bitsPerIndex 位（1/2/4/8），不足一字节时高位在前（同 PNG）
+  size_t stride;          // 行距（字节）
+  int width, height;
+  int bitsPerIndex;
+  const uint8_t *palette; // paletteSize 项 RGBA8（非预乘）；alpha <= alphaThreshold 的项不计入
+  int paletteSize;        // 1..256；越界下标按透明处理
+} okc_indexed_image;
+// 返回值同 okc_extract_colors；参数无效返回 -1
+OKC_API int okc_extract_colors_indexed(const okc_indexed_image *image, const okc_extract_options *opt,
+                                       okc_color *out, int cap);
+
+// 取色上下文：复用直方图缓冲，适合长驻服务反复取色
+typedef struct okc_extractor okc_extractor;
+// opt 为 NULL 时使用默认参数；失败返回 NULL
+OKC_API okc_extractor *okc_extractor_create(const okc_extract_options *opt);
+OKC_API void okc_extractor_destroy(okc_extractor *ex);
+OKC_API void okc_extractor_set_options(okc_extractor *ex, const okc_extract_options *opt);
+// 整图取色，语义同 okc_extract_colors
+OKC_API int okc_extractor_run(okc_extractor *ex, const uint8_t *rgba, int width, int height, okc_color *out,
+                              int cap);
+// 分批喂入：begin 返回采样步长（失败返回 0）；feed 按从上到下的顺序传入连续行
+// （rows 行，行距 rowStride 字节，可多次调用）；finish 聚类并写出结果，返回值同 okc_extract_colors
+OKC_API int okc_extractor_begin(okc_extractor *ex, int width, int height);
+OKC_API void okc_extractor_feed(okc_extractor *ex, const uint8_t *rgba, int rows, size_t rowStride);
+OKC_API int okc_extractor_finish(okc_extractor *ex, okc_color *out, int cap);
+// 渐进取色（交互预览）：先按很稀的采样网格给出结果，再分 OKC_PROGRESSIVE_STAGES 级加密到完整精度。
+// begin 开始会话（rgba 须保持有效直到会话结束，成功返回 0）；与 begin/feed/finish 共用直方图，二者不可交错。
+// run 在 budget_us 微秒内推进若干级（会话第一级总会完成），写出目前最好的结果，返回值同 okc_extract_colors；
+// 可反复调用直到 stage 返回 OKC_PROGRESSIVE_STAGES（此时与 okc_extractor_run 同精度）
+#define OKC_PROGRESSIVE_STAGES 4
+OKC_API int okc_extractor_progressive_begin(okc_extractor *ex, const uint8_t *rgba, int width, int height,
+                                            size_t rowStride);
+OKC_API int okc_extractor_progressive_run(okc_extractor *ex, double budget_us, okc_color *out, int cap);
+OKC_API int okc_extractor_progressive_stage(const okc_extractor *ex);
+// 取色会话（调色板编辑器的滑块）：session_begin 绑定整图（rgba 行距 width*4，须保持有效直到下次 begin
+// 或销毁，成功返回 0）；session_run 按当前参数（okc_extractor_set_options）只重算受影响的阶段：
+// pixels / alphaThreshold 变化重新采样，maxColors 变化重新聚类，只改 distance / saturation / lightness / hue
+// 阈值时只重新合并（微秒级，沿用上次的聚类）。返回值同 okc_extract_colors；
+// session_recomputed 返回上次 run 重算了哪些阶段（OKC_SESSION_* 位）
+#define OKC_SESSION_SAMPLES 1
+#define OKC_SESSION_CLUSTERS 2
+#define OKC_SESSION_MERGE 4
+OKC_API int okc_extractor_session_begin(okc_extractor *ex, const uint8_t *rgba, int width, int height);
+OKC_API int okc_extractor_session_run(okc_extractor *ex, okc_color *out, int cap);
+OKC_API int okc_extractor_session_recomputed(const okc_extractor *ex);
+// 全部 K 的调色板（「颜色数」滑块）：hierarchy_build 按当前 pixels / alphaThreshold 采样整图，
+// 对直方图做一次自顶向下的二分层次聚类（每步拆开误差最大的一簇），rgba 随后即可释放；
+// 返回可取的最大 K（maxK <= 0 时为 OKC_HIERARCHY_MAX_K，受样本数限制；全透明图为 0），失败返回 -1。
+// hierarchy_palette 取 K = k（1..最大 K）时的各簇并按当前合并阈值合并，返回值同 okc_extract_colors；
+// 各 K 的结果相互嵌套（k + 1 只比 k 多拆开一簇）
+#define OKC_HIERARCHY_MAX_K 64
+OKC_API int okc_extractor_hierarchy_build(okc_extractor *ex, const uint8_t *rgba, int width, int height, int maxK);
+OKC_API int okc_extractor_hierarchy_palette(const okc_extractor *ex, int k, okc_color *out, int cap);
+
+// ---- squircle_svg.c ----
+#define OKC_SHAPE_SQUIRCLE 0
+#define OKC_SHAPE_CAPSULE 1
+// 生成 SVG path 写入 out（NUL 结尾，超长截断）；返回完整路径长度（不含 NUL），与 snprintf 语义一致。
+// shape 无效时返回 0。
+OKC_API size_t okc_shape_path(int shape, double width, double height, double radius, char *out, size_t cap);
+
+// 路径生成上下文：输出缓冲归上下文所有，下一次调用前有效
+typedef struct okc_path_builder okc_path_builder;
+OKC_API okc_path_builder *okc_path_builder_create(void);
+OKC_API void okc_path_builder_destroy(okc_path_builder *pb);
+// 单个路径；返回 NUL 结尾字符串，*outLen 为长度（可为 NULL）；失败返回 NULL
+OKC_API const char *okc_path_builder_build(okc_path_builder *pb, int shape, double width, double height,
+                                           double radius, size_t *outLen);
+// 批量：specs 为 n 组 [shape, width, height, radius]；所有路径紧密拼接（无分隔符）于返回的缓冲，
+// ranges（可为 NULL）写入 n 组 [offset, length]，未知 shape 的 length 为 0；*outLen 为总长度
+OKC_API const char *okc_path_builder_batch(okc_path_builder *pb, const double *specs, size_t n, size_t *ranges,
+                                           size_t *outLen);
+
+// ---- palette_index.c ----
+// 调色板签名：OKLab 空间 8 × 6 × 6 格的加权直方图（三线性摊分，总质量 255）；相似度为直方图交集 / 255 ∈ [0, 1]
+#define OKC_PALETTE_SIG_BYTES 288
+// 按 area 加权（extract-colors 的结果可直接传入）；权重全为 0 时签名全 0
+OKC_API void okc_palette_signature(const okc_color *colors, int n, uint8_t *sig);
+// 写索引文件：sigs 为 n 条紧密排列的签名，ids[i] 为非空的条目名；成功返回 0，失败返回 -1
+OKC_API int okc_palette_index_write(const char *path, const uint8_t *sigs, const char *const *ids, size_t n);
+
+// 只读索引（文件整体 mmap）；打开后可从多个线程并发查询
+typedef struct okc_palette_index okc_palette_index;
+typedef struct
+{
+  double similarity;
+  uint64_t index;
+  const char *id; // 指向映射内的 NUL 结尾名字，close 前有效
+} okc_palette_hit;
+// 文件不存在或格式无效返回 NULL
+OKC_API okc_palette_index *okc_palette_index_open(const char *path);
+OKC_API uint64_t okc_palette_index_count(const okc_palette_index *idx);
+// 与 sig 最相似的至多 k（1..4096）条，按相似度降序（同分按下标升序）写入 hits，返回条数；
+// threads <= 0 表示按在线 CPU 数；参数无效返回 -1
+OKC_API int okc_palette_index_query(const okc_palette_index *idx, const uint8_t *sig, int k, int threads,
+                                    okc_palette_hit *hits);
+OKC_API void okc_palette_index_close(okc_palette_index *idx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // OKCOLOR_H
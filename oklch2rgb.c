@@ -8,6 +8,11 @@
 //     rel（可选）∈ [0..1]：相对色度比例；提供该参数时将忽略 C
 // - 输出：三个整数 "R G B"（0..255），gamma 编码的 sRGB，并已夹取
 
+// 原生构建用到 POSIX 线程与 sysconf；-std=c11 下 glibc 需显式打开
+#if !defined(__EMSCRIPTEN__) && !defined(__APPLE__) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -15,11 +20,33 @@
 #include <math.h>
 #include <stdint.h>
 #include <stddef.h>
+#include <stdatomic.h>
+
+#ifndef __EMSCRIPTEN__
+#include <time.h>
+#endif
+
+#ifdef OKCOLOR_EMBED
+#include "okcolor.h"
+#endif
+#if !defined(__EMSCRIPTEN__) && !defined(OKCOLOR_EMBED)
+#include "css_color.h"
+#endif
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
 
+// 热路径整条调用链强制内联，使各 ISA 变体的批量内核（见「运行时 CPU 分派」）各自完整展开
+#ifndef INLINE
+#define INLINE inline __attribute__((always_inline))
+#endif
+#include "polar.h"
+#include "srgb8.h"
+#ifndef __EMSCRIPTEN__
+#include "cpu_dispatch.h"
+#endif
+
 static double clamp(double x, double lo, double hi)
 {
     if (x < lo)
@@ -29,6 +56,7 @@ static double clamp(double x, double lo, double hi)
     return x;
 }
 
+#if !defined(__EMSCRIPTEN__) && !defined(OKCOLOR_EMBED)
 // 解析一个浮点数（不允许 % 后缀）
 static int parse_number(const char *s, double *out)
 {
@@ -47,48 +75,36 @@ static int parse_number(const char *s, double *out)
     *out = v;
     return 1;
 }
+#endif
 
-static double linear_to_srgb(double u)
+// ---- 可选的色域路径计数器 ----
+// 以 -DOKCOLOR_STATS 编译时启用（如 make NATIVE_EXTRA=-DOKCOLOR_STATS），默认完全编译掉。
+// 计数器为每线程变量，读取的是调用线程的累计值；CLI 用 --batch --stats 输出，Wasm 用 oklch2rgb_stats_js 读取。
+#ifdef OKCOLOR_STATS
+typedef struct
 {
-    if (u <= 0.0)
-        return 0.0;
-    if (u >= 1.0)
-        return 1.0;
-    if (u <= 0.0031308)
-        return 12.92 * u;
-    return 1.055 * pow(u, 1.0 / 2.4) - 0.055;
-}
+    uint64_t fast_path;           // find_gamut_safe_chroma*：目标色度已在色域内，直接返回
+    uint64_t bisect_steps[2][21]; // 二分实际步数直方图：[0] 完整精度，[1] 8 位提前终止
+    uint64_t doubling[13];        // max_chroma_for_srgb：第 i 次倍增时越界（12 = 始终未越界）
+    uint64_t clamp_low;           // linear_to_srgb 输入 ≤ 0
+    uint64_t clamp_high;          // linear_to_srgb 输入 ≥ 1
+} GamutStats;
+static _Thread_local GamutStats g_stats;
+#define GAMUT_STAT(expr) ((void)(expr))
+#else
+#define GAMUT_STAT(expr) ((void)0)
+#endif
 
-// ---- OKLCH -> 线性 sRGB 以及色域回退的辅助函数 ----
-// 标准版：根据色相角（度）计算
-static void oklch_to_linear_rgb(double L, double C, double hdeg,
-                                double *r_lin, double *g_lin, double *b_lin)
+// 带裁剪计数的 linear_to_srgb（见 srgb8.h）；量化表的建表与查表不经过这里，因而不计入
+static INLINE double linear_to_srgb_stat(double u)
 {
-    // 包裹色相（范围归一到 0..360）
-    double h = fmod(hdeg, 360.0);
-    if (h < 0)
-        h += 360.0;
-    double hr = h * M_PI / 180.0;
-    double ch = cos(hr), sh = sin(hr);
-    // OKLCH -> OKLab（a,b 分量由 C·cos, C·sin 给出）
-    double a = C * ch;
-    double bb = C * sh;
-    // OKLab -> LMS（非线性）
-    double l = L + 0.3963377774 * a + 0.2158037573 * bb;
-    double m = L - 0.1055613458 * a - 0.0638541728 * bb;
-    double s = L - 0.0894841775 * a - 1.2914855480 * bb;
-    // 立方得到线性 LMS
-    double l3 = l * l * l;
-    double m3 = m * m * m;
-    double s3 = s * s * s;
-    // 由 LMS^3 转换为线性 sRGB
-    *r_lin = +4.0767416621 * l3 - 3.3077115913 * m3 + 0.2309699292 * s3;
-    *g_lin = -1.2684380046 * l3 + 2.6097574011 * m3 - 0.3413193965 * s3;
-    *b_lin = -0.0041960863 * l3 - 0.7034186147 * m3 + 1.7076147010 * s3;
+    GAMUT_STAT(u <= 0.0 ? g_stats.clamp_low++ : u >= 1.0 ? g_stats.clamp_high++ : 0);
+    return linear_to_srgb(u);
 }
 
-// 加速版：传入预计算的 cos(h), sin(h)，避免在循环中反复三角函数
-static inline void oklch_to_linear_rgb_fast(double L, double C, double ch, double sh,
+// ---- OKLCH -> 线性 sRGB 以及色域回退的辅助函数 ----
+// 传入预计算的 cos(h), sin(h)，避免在循环中反复三角函数
+static INLINE void oklch_to_linear_rgb_fast(double L, double C, double ch, double sh,
                                             double *r_lin, double *g_lin, double *b_lin)
 {
     // OKLCH -> OKLab
@@ -108,7 +124,7 @@ static inline void oklch_to_linear_rgb_fast(double L, double C, double ch, doubl
     *b_lin = -0.0041960863 * l3 - 0.7034186147 * m3 + 1.7076147010 * s3;
 }
 
-static int is_linear_in_srgb_gamut(double r, double g, double b)
+static INLINE int is_linear_in_srgb_gamut(double r, double g, double b)
 {
     const double eps = 1e-12; // 容忍极小的数值漂移
     return r >= -eps && r <= 1.0 + eps &&
@@ -116,24 +132,51 @@ static int is_linear_in_srgb_gamut(double r, double g, double b)
            b >= -eps && b <= 1.0 + eps;
 }
 
-// 给定 L、h 与目标色度 C，寻找区间 [0, C] 内最大的 C'，
-// 使得线性 sRGB 分量都落在 [0,1]。若已在色域内，直接返回 C。
-static double find_gamut_safe_chroma(double L, double C, double hdeg)
+// ---- 8 位量化判定（量化表见 srgb8.h，供提前终止的二分使用）----
+// 通道值在 [lo, hi] 上可能非单调（如接近极值时），仅比较两端编码不够：
+// 线性插值误差 ≤ max|f''|·w²/8，把两端值各向外放宽该量后仍落在同一编码桶才算确定
+static INLINE int channel_settled(double f0, double f1, double dev)
 {
-    // 预计算角度与三角值，避免循环中重复求值
-    double h = fmod(hdeg, 360.0);
-    if (h < 0)
-        h += 360.0;
-    double hr = h * M_PI / 180.0;
-    double ch = cos(hr), sh = sin(hr);
+    double a = f0 < f1 ? f0 : f1;
+    double b = f0 < f1 ? f1 : f0;
+    return quantize_srgb8(a - dev) == quantize_srgb8(b + dev);
+}
 
-    double r, g, b;
-    oklch_to_linear_rgb_fast(L, C, ch, sh, &r, &g, &b);
-    if (is_linear_in_srgb_gamut(r, g, b))
-        return C;
-    // 在缩放因子 k ∈ [0,1] 上进行二分搜索
-    double lo = 0.0, hi = 1.0;
-    for (int i = 0; i < 20; i++) // 20 次即可将比例误差收敛到 ~1e-6
+// 判断 k ∈ [lo, hi] 内所有点的 8 位编码是否已唯一确定。
+// 线性 sRGB 各通道 f(k) = Σ M_ij·lms_j(k)³，lms_j(k) = L + k·d_j 为 k 的一次式，
+// 故 |f''| ≤ Σ |M_ij|·6·d_j²·max(|lms_j(lo)|, |lms_j(hi)|)。
+static INLINE int bisect_rgb8_settled(double L, double C, double ch, double sh, double lo, double hi,
+                                      double r_lo, double g_lo, double b_lo,
+                                      double r_hi, double g_hi, double b_hi)
+{
+    double dl = C * (0.3963377774 * ch + 0.2158037573 * sh);
+    double dm = C * (-0.1055613458 * ch - 0.0638541728 * sh);
+    double ds = C * (-0.0894841775 * ch - 1.2914855480 * sh);
+    double tl = 6.0 * dl * dl * fmax(fabs(L + lo * dl), fabs(L + hi * dl));
+    double tm = 6.0 * dm * dm * fmax(fabs(L + lo * dm), fabs(L + hi * dm));
+    double ts = 6.0 * ds * ds * fmax(fabs(L + lo * ds), fabs(L + hi * ds));
+    double w2 = (hi - lo) * (hi - lo) * 0.125;
+    double dev_r = (4.0767416621 * tl + 3.3077115913 * tm + 0.2309699292 * ts) * w2;
+    double dev_g = (1.2684380046 * tl + 2.6097574011 * tm + 0.3413193965 * ts) * w2;
+    double dev_b = (0.0041960863 * tl + 0.7034186147 * tm + 1.7076147010 * ts) * w2;
+    return channel_settled(r_lo, r_hi, dev_r) && channel_settled(g_lo, g_hi, dev_g) &&
+           channel_settled(b_lo, b_hi, dev_b);
+}
+
+// 二分的最少步数：区间尚宽时端点几乎不可能同码，跳过判定省去查表
+#define GAMUT_STOP8_MIN_STEPS 6
+
+// 在缩放因子 k ∈ [lo, 1] 上二分（k=1 已知在色域外），共 steps 步，返回 C·lo。
+// stop8 非零时：一旦区间 [lo, hi] 内所有点都编码为同一 8 位三元组即停止——
+// 完整 20 步的结果也在区间内，量化结果必然相同，仅输出 8 位的调用方可用。
+static INLINE double gamut_bisect(double L, double C, double ch, double sh, double lo, int steps, int stop8,
+                                  double r_hi, double g_hi, double b_hi)
+{
+    double hi = 1.0;
+    double r_lo = 0.0, g_lo = 0.0, b_lo = 0.0;
+    int have_lo = 0;
+    int taken = steps;
+    for (int i = 0; i < steps; i++)
     {
         double mid = 0.5 * (lo + hi);
         double r2, g2, b2;
@@ -141,27 +184,75 @@ static double find_gamut_safe_chroma(double L, double C, double hdeg)
         if (is_linear_in_srgb_gamut(r2, g2, b2))
         {
             lo = mid; // 还能增大色度
+            r_lo = r2;
+            g_lo = g2;
+            b_lo = b2;
+            have_lo = 1;
         }
         else
         {
             hi = mid; // 过饱和
+            r_hi = r2;
+            g_hi = g2;
+            b_hi = b2;
+        }
+        // lo 仍为初值时其颜色未求值，不做判定
+        if (stop8 && have_lo && i >= GAMUT_STOP8_MIN_STEPS &&
+            bisect_rgb8_settled(L, C, ch, sh, lo, hi, r_lo, g_lo, b_lo, r_hi, g_hi, b_hi))
+        {
+            taken = i + 1;
+            break;
         }
     }
+    GAMUT_STAT(g_stats.bisect_steps[stop8 != 0][taken]++);
+    (void)taken;
     return C * lo;
 }
 
-// 计算给定 L 与 h 在 sRGB 色域内可达到的最大色度（Cmax）。
-// 策略：指数式增大 C，直到超出色域，再在该上界内用
-// find_gamut_safe_chroma 做精细二分。这样无需假定固定上界。
-static double max_chroma_for_srgb(double L, double hdeg)
+// 给定 L、色相的 cos/sin 与目标色度 C，寻找区间 [0, C] 内最大的 C'，
+// 使得线性 sRGB 分量都落在 [0,1]。若已在色域内，直接返回 C。
+static INLINE double gamut_safe_chroma_cs(double L, double C, double ch, double sh, int stop8)
 {
-    // 预计算角度与三角值
-    double h = fmod(hdeg, 360.0);
-    if (h < 0)
-        h += 360.0;
-    double hr = h * M_PI / 180.0;
-    double ch = cos(hr), sh = sin(hr);
+    double r, g, b;
+    oklch_to_linear_rgb_fast(L, C, ch, sh, &r, &g, &b);
+    if (is_linear_in_srgb_gamut(r, g, b))
+    {
+        GAMUT_STAT(g_stats.fast_path++);
+        return C;
+    }
+    if (stop8)
+        ensure_srgb8_lut();
+    // 20 次即可将比例误差收敛到 ~1e-6
+    return gamut_bisect(L, C, ch, sh, 0.0, 20, stop8, r, g, b);
+}
+
+static INLINE double gamut_safe_chroma_impl(double L, double C, double hdeg, int stop8)
+{
+    // 三角值只求一次，二分循环中复用
+    double sh, ch;
+    polar_sincos_deg(hdeg, &sh, &ch);
+    return gamut_safe_chroma_cs(L, C, ch, sh, stop8);
+}
+
+// 完整精度版本（结果继续参与浮点运算时使用，如 max_chroma_for_srgb）
+static INLINE double find_gamut_safe_chroma(double L, double C, double hdeg)
+{
+    return gamut_safe_chroma_impl(L, C, hdeg, 0);
+}
+
+// 8 位版本：结果只用于编码为 0..255 时使用，量化结果与完整精度版本逐位一致，
+// 但通常只需约一半的二分步数
+static INLINE double find_gamut_safe_chroma8(double L, double C, double hdeg)
+{
+    return gamut_safe_chroma_impl(L, C, hdeg, 1);
+}
 
+// 计算给定 L 与 h 在 sRGB 色域内可达到的最大色度（Cmax）。
+// 策略：指数式增大 C，直到超出色域，再在该上界内做精细二分。这样无需假定固定上界。
+// Cmax 会再乘以 rel，不能按 8 位提前终止；但倍增阶段已知 C/2 在色域内，
+// 而完整二分第一步恰好测试 C·0.5（与上一轮的 C 逐位相同），故直接从 lo=0.5 起步少测两次。
+static INLINE double max_chroma_cs(double L, double ch, double sh)
+{
     // 以较小的色度起步，逐步增大，直到超出色域。
     double C = 0.05;
     for (int i = 0; i < 12; i++)
@@ -170,64 +261,873 @@ static double max_chroma_for_srgb(double L, double hdeg)
         oklch_to_linear_rgb_fast(L, C, ch, sh, &r, &g, &b);
         if (!is_linear_in_srgb_gamut(r, g, b))
         {
+            GAMUT_STAT(g_stats.doubling[i]++);
             // 在区间 [0, C] 内细化到边界
-            return find_gamut_safe_chroma(L, C, hdeg);
+            if (i == 0)
+                return gamut_bisect(L, C, ch, sh, 0.0, 20, 0, r, g, b);
+            return gamut_bisect(L, C, ch, sh, 0.5, 19, 0, r, g, b);
         }
         C *= 2.0;
     }
+    GAMUT_STAT(g_stats.doubling[12]++);
     // 若仍在色域内（极不可能），也用二分法夹到边界。
-    return find_gamut_safe_chroma(L, C, hdeg);
+    return gamut_safe_chroma_cs(L, C, ch, sh, 0);
 }
 
-#ifdef __EMSCRIPTEN__
-// 导出最小接口，供 JS 从 Wasm 直接调用。
-// 输入：（L ∈ [0..1]，C ≥ 0，h 为角度）
-// 输出：返回指向 3 个 int32 值 [R,G,B]（0..255）的指针。
-static int32_t g_rgb_out[3];
+static INLINE double max_chroma_for_srgb(double L, double hdeg)
+{
+    double sh, ch;
+    polar_sincos_deg(hdeg, &sh, &ch);
+    return max_chroma_cs(L, ch, sh);
+}
 
-__attribute__((export_name("oklch2rgb_calc_js")))
-uint32_t
-oklch2rgb_calc_js(double L, double C, double hdeg)
+// 与 CLI 相同的流程：归一化 -> （可选）相对色度 -> 色域回退 -> sRGB 编码并取整；
+// ch / sh 为色相的 cos / sin（批量路径按块向量化预先求出）
+static INLINE void oklch_to_rgb8_cs(double L, double C, double ch, double sh, int use_rel, double rel, uint8_t *out)
 {
-    // 归一化输入
     if (L < 0.0)
         L = 0.0;
     if (L > 1.0)
         L = 1.0;
     if (C < 0.0)
         C = 0.0;
-    // 色域回退：如有需要，降低色度以适配 sRGB
-    double Csafe = find_gamut_safe_chroma(L, C, hdeg);
-    // 预计算当前色相
-    double h = fmod(hdeg, 360.0);
-    if (h < 0)
-        h += 360.0;
-    double hr = h * M_PI / 180.0;
-    double ch = cos(hr), sh = sin(hr);
+    if (use_rel)
+        C = rel > 0.0 ? clamp(rel, 0.0, 1.0) * max_chroma_cs(L, ch, sh) : 0.0; // rel=0 时无需求 Cmax
+    double Csafe = gamut_safe_chroma_cs(L, C, ch, sh, 1);
     double r_lin, g_lin, b_lin;
     oklch_to_linear_rgb_fast(L, Csafe, ch, sh, &r_lin, &g_lin, &b_lin);
-    // 编码为 sRGB 并夹取到 [0,1]
-    double r = linear_to_srgb(r_lin);
-    double g = linear_to_srgb(g_lin);
-    double b2 = linear_to_srgb(b_lin);
-    if (r < 0.0)
-        r = 0.0;
-    if (r > 1.0)
-        r = 1.0;
-    if (g < 0.0)
-        g = 0.0;
-    if (g > 1.0)
-        g = 1.0;
-    if (b2 < 0.0)
-        b2 = 0.0;
-    if (b2 > 1.0)
-        b2 = 1.0;
-    int R = (int)floor(r * 255.0 + 0.5);
-    int G = (int)floor(g * 255.0 + 0.5);
-    int B = (int)floor(b2 * 255.0 + 0.5);
-    g_rgb_out[0] = R;
-    g_rgb_out[1] = G;
-    g_rgb_out[2] = B;
+    out[0] = (uint8_t)floor(clamp(linear_to_srgb_stat(r_lin), 0.0, 1.0) * 255.0 + 0.5);
+    out[1] = (uint8_t)floor(clamp(linear_to_srgb_stat(g_lin), 0.0, 1.0) * 255.0 + 0.5);
+    out[2] = (uint8_t)floor(clamp(linear_to_srgb_stat(b_lin), 0.0, 1.0) * 255.0 + 0.5);
+}
+
+static INLINE void oklch_to_rgb8(double L, double C, double hdeg, int use_rel, double rel, uint8_t *out)
+{
+    double sh, ch;
+    polar_sincos_deg(hdeg, &sh, &ch);
+    oklch_to_rgb8_cs(L, C, ch, sh, use_rel, rel, out);
+}
+
+// ---- 取色器切片渲染（L×C、C×h、L×h 平面）----
+// 像素 (x, y) 的非线性 LMS 写成 lms = rowL + rowS·K[x]：
+//   L×C（h 固定）：rowL = L(y)，rowS = 1，    K[x] = C(x)·k(h)
+//   C×h（L 固定）：rowL = L，   rowS = C(y)，  K[x] = k(h(x))
+//   L×h（C 固定）：rowL = L(y)，rowS = 1，    K[x] = C·k(h(x))
+// 其中 k(h) = (0.396·cos h + 0.216·sin h, ...) 为 OKLab -> LMS 矩阵与 (cos h, sin h) 之积。
+// 三角函数与矩阵项按列预计算一次，行内只剩三次 FMA、立方与 3×3 矩阵，循环无分支可向量化；
+// 色域判定与 8 位编码（quantize_srgb8 查表）在第二趟标量循环中完成。
+#define SLICE_LC 0
+#define SLICE_CH 1
+#define SLICE_LH 2
+#define SLICE_MAX_SIDE 4096
+#define SLICE_CHUNK 256
+
+typedef struct
+{
+    int plane, width, height, p3;
+    double fixed, c_max;
+    const double *kl, *km, *ks; // 每列 K[x]
+} SliceSpec;
+
+// 第 y 行的 (rowL, rowS)；行从上到下取值递减，取像素中心
+static INLINE void slice_row_terms(const SliceSpec *sp, int y, double *rowL, double *rowS)
+{
+    double t = 1.0 - (y + 0.5) / sp->height;
+    *rowL = sp->plane == SLICE_CH ? sp->fixed : t;
+    *rowS = sp->plane == SLICE_CH ? t * sp->c_max : 1.0;
+}
+
+// 渲染 [y0, y1) 行。rgba 为整幅图像；mask 可为 NULL：0 = P3 之外，1 = 仅在 P3 内，2 = sRGB 内
+static INLINE void slice_rows_body(const SliceSpec *sp, int y0, int y1, uint8_t *rgba, uint8_t *mask)
+{
+    double lr[SLICE_CHUNK], lg[SLICE_CHUNK], lb[SLICE_CHUNK];
+    uint8_t cls[SLICE_CHUNK];
+    const double eps = 1e-12; // 与 is_linear_in_srgb_gamut 相同
+    const int need = sp->p3 ? 1 : 2;
+    for (int y = y0; y < y1; ++y)
+    {
+        double rowL, rowS;
+        slice_row_terms(sp, y, &rowL, &rowS);
+        uint8_t *out = rgba + (size_t)y * sp->width * 4;
+        uint8_t *mrow = mask ? mask + (size_t)y * sp->width : NULL;
+        for (int x0 = 0; x0 < sp->width; x0 += SLICE_CHUNK)
+        {
+            int m = sp->width - x0 < SLICE_CHUNK ? sp->width - x0 : SLICE_CHUNK;
+            const double *kl = sp->kl + x0, *km = sp->km + x0, *ks = sp->ks + x0;
+            for (int i = 0; i < m; ++i)
+            {
+                double l = rowL + rowS * kl[i];
+                double mm = rowL + rowS * km[i];
+                double s = rowL + rowS * ks[i];
+                double l3 = l * l * l, m3 = mm * mm * mm, s3 = s * s * s;
+                double r = +4.0767416621 * l3 - 3.3077115913 * m3 + 0.2309699292 * s3;
+                double g = -1.2684380046 * l3 + 2.6097574011 * m3 - 0.3413193965 * s3;
+                double b = -0.0041960863 * l3 - 0.7034186147 * m3 + 1.7076147010 * s3;
+                // LMS³ -> 线性 Display-P3（= P3←XYZ · XYZ←sRGB · 上面的矩阵）
+                double pr = +3.1277689872 * l3 - 2.2571357962 * m3 + 0.1293668090 * s3;
+                double pg = -1.0910090478 * l3 + 2.4133317587 * m3 - 0.3223227108 * s3;
+                double pb = -0.0260108130 * l3 - 0.5080413259 * m3 + 1.5340521389 * s3;
+                int in_srgb = (r >= -eps) & (r <= 1.0 + eps) & (g >= -eps) & (g <= 1.0 + eps) & (b >= -eps) &
+                              (b <= 1.0 + eps);
+                int in_p3 = (pr >= -eps) & (pr <= 1.0 + eps) & (pg >= -eps) & (pg <= 1.0 + eps) & (pb >= -eps) &
+                            (pb <= 1.0 + eps);
+                cls[i] = (uint8_t)(in_srgb ? 2 : in_p3);
+                lr[i] = sp->p3 ? pr : r;
+                lg[i] = sp->p3 ? pg : g;
+                lb[i] = sp->p3 ? pb : b;
+            }
+            uint8_t *o = out + (size_t)x0 * 4;
+            for (int i = 0; i < m; ++i, o += 4)
+            {
+                if (cls[i] >= need)
+                {
+                    // P3 与 sRGB 使用同一传递函数
+                    o[0] = (uint8_t)quantize_srgb8(lr[i]);
+                    o[1] = (uint8_t)quantize_srgb8(lg[i]);
+                    o[2] = (uint8_t)quantize_srgb8(lb[i]);
+                    o[3] = 255;
+                }
+                else
+                    o[0] = o[1] = o[2] = o[3] = 0;
+            }
+            if (mrow)
+                memcpy(mrow + x0, cls, (size_t)m);
+        }
+    }
+}
+
+// ---- 二维渐变光栅化（线性、径向、锥形）----
+// 停靠点插值与色域回退只在构建 GRAD_LUT_SIZE 项的 1D 查表时做一次（见 render_gradient），
+// 每像素只需求参数 t（第一趟，无分支可向量化）再查表、可选地加蓝噪声后取整（第二趟）。
+#define GRAD_LINEAR 0
+#define GRAD_RADIAL 1
+#define GRAD_CONIC 2
+#define GRAD_LUT_SIZE 4096
+#define GRAD_MAX_SIDE 16384
+#define GRAD_CHUNK 256
+#define BLUE_NOISE_SIZE 64
+
+typedef struct
+{
+    int kind, repeat, dither, width;
+    float x0, y0;     // 线性为起点，径向/锥形为圆心
+    float dx, dy;     // 线性：(终点 - 起点) / |终点 - 起点|²
+    float inv_r;      // 径向：1 / 半径
+    float turn0;      // 锥形：起始角（圈）
+    const float *lut; // GRAD_LUT_SIZE × RGBA（0..255 编码值，未取整）
+} GradientSpec;
+
+// 64×64 蓝噪声阈值表（void-and-cluster 生成），取值 (0, 1)
+static atomic_int g_blue_noise_state = 0;
+static float g_blue_noise[BLUE_NOISE_SIZE * BLUE_NOISE_SIZE];
+
+// 环面上以 p 为中心的高斯能量加到（sign = 1）或移出（sign = -1）energy
+static void blue_noise_splat(float *energy, const float *kern, int p, float sign)
+{
+    const int n = BLUE_NOISE_SIZE;
+    int px = p % n, py = p / n;
+    for (int y = 0; y < n; ++y)
+    {
+        const float *row = kern + ((y - py) & (n - 1)) * n;
+        float *e = energy + y * n;
+        for (int x = 0; x < n; ++x)
+            e[x] += sign * row[(x - px) & (n - 1)];
+    }
+}
+
+// want = 1：在已置位点中找能量最大者（最密的簇）；want = 0：在空位中找能量最小者（最大的空洞）
+static int blue_noise_extreme(const float *energy, const uint8_t *bits, int want)
+{
+    int best = -1;
+    for (int i = 0; i < BLUE_NOISE_SIZE * BLUE_NOISE_SIZE; ++i)
+    {
+        if (bits[i] != want)
+            continue;
+        if (best < 0 || (want ? energy[i] > energy[best] : energy[i] < energy[best]))
+            best = i;
+    }
+    return best;
+}
+
+// Ulichney 的 void-and-cluster：初始约 10% 随机点经“移出最密、填入最空”松弛为均匀分布，
+// 再从该图样出发向下逐个移出、向上逐个填入，移出/填入的次序即为阈值秩
+static void build_blue_noise(float *out)
+{
+    enum
+    {
+        N = BLUE_NOISE_SIZE * BLUE_NOISE_SIZE
+    };
+    static float kern[N], energy[N], energy0[N];
+    static uint8_t bits[N], bits0[N];
+    static uint16_t rank[N];
+    const double sigma = 1.5;
+    for (int y = 0; y < BLUE_NOISE_SIZE; ++y)
+        for (int x = 0; x < BLUE_NOISE_SIZE; ++x)
+        {
+            int dx = x < BLUE_NOISE_SIZE / 2 ? x : BLUE_NOISE_SIZE - x;
+            int dy = y < BLUE_NOISE_SIZE / 2 ? y : BLUE_NOISE_SIZE - y;
+            kern[y * BLUE_NOISE_SIZE + x] = (float)exp(-(dx * dx + dy * dy) / (2.0 * sigma * sigma));
+        }
+    memset(energy, 0, sizeof energy);
+    memset(bits, 0, sizeof bits);
+    int ones = 0;
+    uint32_t seed = 0x9e3779b9u;
+    while (ones < N / 10)
+    {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        int p = (int)(seed % N);
+        if (bits[p])
+            continue;
+        bits[p] = 1;
+        blue_noise_splat(energy, kern, p, 1.0f);
+        ones++;
+    }
+    for (int it = 0; it < N; ++it)
+    {
+        int c = blue_noise_extreme(energy, bits, 1);
+        bits[c] = 0;
+        blue_noise_splat(energy, kern, c, -1.0f);
+        int v = blue_noise_extreme(energy, bits, 0);
+        bits[v] = 1;
+        blue_noise_splat(energy, kern, v, 1.0f);
+        if (v == c)
+            break;
+    }
+    memcpy(bits0, bits, sizeof bits);
+    memcpy(energy0, energy, sizeof energy);
+    for (int r = ones - 1; r >= 0; --r)
+    {
+        int c = blue_noise_extreme(energy, bits, 1);
+        bits[c] = 0;
+        blue_noise_splat(energy, kern, c, -1.0f);
+        rank[c] = (uint16_t)r;
+    }
+    memcpy(bits, bits0, sizeof bits);
+    memcpy(energy, energy0, sizeof energy);
+    // 填过一半后“最大空洞”等价于少数派（空位）的最密簇，同一规则一路填满
+    for (int r = ones; r < N; ++r)
+    {
+        int v = blue_noise_extreme(energy, bits, 0);
+        bits[v] = 1;
+        blue_noise_splat(energy, kern, v, 1.0f);
+        rank[v] = (uint16_t)r;
+    }
+    for (int i = 0; i < N; ++i)
+        out[i] = (rank[i] + 0.5f) / N;
+}
+
+static void ensure_blue_noise(void)
+{
+    if (atomic_load_explicit(&g_blue_noise_state, memory_order_acquire) == 2)
+        return;
+    int expected = 0;
+    if (!atomic_compare_exchange_strong_explicit(&g_blue_noise_state, &expected, 1, memory_order_acquire,
+                                                 memory_order_acquire))
+    {
+        while (atomic_load_explicit(&g_blue_noise_state, memory_order_acquire) != 2)
+            ;
+        return;
+    }
+    build_blue_noise(g_blue_noise);
+    atomic_store_explicit(&g_blue_noise_state, 2, memory_order_release);
+}
+
+// 渲染 [y0, y1) 行到 rgba（整幅图像）
+static INLINE void gradient_rows_body(const GradientSpec *gs, int y0, int y1, uint8_t *rgba)
+{
+    float t[GRAD_CHUNK];
+    const float last = (float)(GRAD_LUT_SIZE - 1);
+    for (int y = y0; y < y1; ++y)
+    {
+        const float py = (float)y + 0.5f - gs->y0;
+        const float row = py * gs->dy;
+        const float *noise = g_blue_noise + (y & (BLUE_NOISE_SIZE - 1)) * BLUE_NOISE_SIZE;
+        uint8_t *out = rgba + (size_t)y * gs->width * 4;
+        for (int x0 = 0; x0 < gs->width; x0 += GRAD_CHUNK)
+        {
+            int m = gs->width - x0 < GRAD_CHUNK ? gs->width - x0 : GRAD_CHUNK;
+            const float bx = (float)x0 + 0.5f - gs->x0;
+            // 第一趟：像素中心 -> 参数 t -> 查表下标（浮点）
+            if (gs->kind == GRAD_LINEAR)
+                for (int i = 0; i < m; ++i)
+                    t[i] = ((float)i + bx) * gs->dx + row;
+            else if (gs->kind == GRAD_RADIAL)
+                for (int i = 0; i < m; ++i)
+                {
+                    float px = (float)i + bx;
+                    t[i] = sqrtf(px * px + py * py) * gs->inv_r;
+                }
+            else
+                // 0 = 正上方、顺时针（y 轴朝下）
+                for (int i = 0; i < m; ++i)
+                {
+                    float turn = polar_atan2_degf((float)i + bx, -py) * (1.0f / 360.0f) - gs->turn0;
+                    t[i] = turn - floorf(turn);
+                }
+            if (gs->repeat)
+                for (int i = 0; i < m; ++i)
+                    t[i] = (t[i] - floorf(t[i])) * last;
+            else
+                for (int i = 0; i < m; ++i)
+                    t[i] = (t[i] < 0.0f ? 0.0f : t[i] > 1.0f ? 1.0f : t[i]) * last;
+            // 第二趟：查表，抖动时以蓝噪声阈值代替 0.5 再向下取整
+            uint8_t *o = out + (size_t)x0 * 4;
+            for (int i = 0; i < m; ++i, o += 4)
+            {
+                const float *c = gs->lut + (int)(t[i] + 0.5f) * 4;
+                float d = gs->dither ? noise[(x0 + i) & (BLUE_NOISE_SIZE - 1)] : 0.5f;
+                o[0] = (uint8_t)(c[0] + d);
+                o[1] = (uint8_t)(c[1] + d);
+                o[2] = (uint8_t)(c[2] + d);
+                o[3] = (uint8_t)(c[3] + d);
+            }
+        }
+    }
+}
+
+// ---- 广色域图像的色域映射：Display-P3 RGBA8 -> sRGB RGBA8 ----
+// 每 GMAP_CHUNK 像素一段：查表解码 -> 线性 P3 -> 线性 sRGB（一个矩阵，float 无分支，可向量化）并标出色域内像素；
+// 色域内像素直接查表编码，色域外像素（通常只占少数）先查按 24 位颜色直接映射的共享缓存，
+// 未命中才转到 OKLCH，保持 L、h 按 find_gamut_safe_chroma8 降低色度（与 oklch_to_rgb8 相同的回退）。
+#define GMAP_CHUNK 256
+#define GMAP_CACHE_BITS 16
+#define GMAP_MAX_SIDE 32768
+// float 矩阵的舍入误差远小于此；越界不足 GMAP_EPS 的颜色按裁剪处理（编码差异 < 0.05 级）
+#define GMAP_EPS 1e-5f
+
+typedef struct
+{
+    const uint8_t *src;
+    uint8_t *dst; // 可与 src 相同
+    int width;
+    _Atomic uint64_t *cache;  // 1 << GMAP_CACHE_BITS 项：((P3 颜色 | 1 << 24) << 32) | sRGB 颜色，0 为空
+    atomic_llong *counts;     // [0] 色域外像素数，[1] 其中命中缓存数
+} GamutMapJob;
+
+// 线性 sRGB（可越界）-> OKLCH -> 色度回退 -> 8 位 sRGB
+static void gamut_map_color(double r, double g, double b, uint8_t *out)
+{
+    double l = cbrt(0.4122214708 * r + 0.5363325363 * g + 0.0514459929 * b);
+    double m = cbrt(0.2119034982 * r + 0.6806995451 * g + 0.1073969566 * b);
+    double s = cbrt(0.0883024619 * r + 0.2817188376 * g + 0.6299787005 * b);
+    double L = 0.2104542553 * l + 0.7936177850 * m - 0.0040720468 * s;
+    double A = 1.9779984951 * l - 2.4285922050 * m + 0.4505937099 * s;
+    double B = 0.0259040371 * l + 0.7827717662 * m - 0.8086757660 * s;
+    oklch_to_rgb8(L, sqrt(A * A + B * B), polar_atan2_deg(B, A), 0, 0.0, out);
+}
+
+static INLINE void gamut_map_rows_body(const GamutMapJob *job, int y0, int y1)
+{
+    float lr[GMAP_CHUNK], lg[GMAP_CHUNK], lb[GMAP_CHUNK];
+    uint8_t inside[GMAP_CHUNK];
+    const float *dec = g_srgb8_decode;
+    long long oog = 0, hits = 0;
+    for (int y = y0; y < y1; ++y)
+    {
+        for (int x0 = 0; x0 < job->width; x0 += GMAP_CHUNK)
+        {
+            int m = job->width - x0 < GMAP_CHUNK ? job->width - x0 : GMAP_CHUNK;
+            size_t off = ((size_t)y * job->width + x0) * 4;
+            const uint8_t *sp = job->src + off;
+            uint8_t *dp = job->dst + off;
+            for (int k = 0; k < m; ++k)
+            {
+                float pr = dec[sp[k * 4 + 0]], pg = dec[sp[k * 4 + 1]], pb = dec[sp[k * 4 + 2]];
+                float r = 1.22494017628056f * pr - 0.2249401762805601f * pg;
+                float g = -0.04205695470968811f * pr + 1.0420569547096883f * pg;
+                float b = -0.019637554590334404f * pr - 0.07863604555063183f * pg + 1.0982736001409663f * pb;
+                lr[k] = r;
+                lg[k] = g;
+                lb[k] = b;
+                inside[k] = (r >= -GMAP_EPS) & (r <= 1.0f + GMAP_EPS) & (g >= -GMAP_EPS) & (g <= 1.0f + GMAP_EPS) &
+                            (b >= -GMAP_EPS) & (b <= 1.0f + GMAP_EPS);
+            }
+            for (int k = 0; k < m; ++k)
+            {
+                uint32_t key = (uint32_t)sp[k * 4 + 0] << 16 | (uint32_t)sp[k * 4 + 1] << 8 | sp[k * 4 + 2];
+                uint8_t alpha = sp[k * 4 + 3];
+                if (inside[k])
+                {
+                    dp[k * 4 + 0] = (uint8_t)quantize_srgb8(lr[k]);
+                    dp[k * 4 + 1] = (uint8_t)quantize_srgb8(lg[k]);
+                    dp[k * 4 + 2] = (uint8_t)quantize_srgb8(lb[k]);
+                    dp[k * 4 + 3] = alpha;
+                    continue;
+                }
+                oog++;
+                // 各线程并发读写同一缓存：每项是一个 64 位原子字，相同的键总写入相同的值
+                _Atomic uint64_t *slot = &job->cache[(key * 2654435761u) >> (32 - GMAP_CACHE_BITS)];
+                uint64_t tag = (uint64_t)(key | 1u << 24) << 32;
+                uint64_t e = atomic_load_explicit(slot, memory_order_relaxed);
+                uint8_t rgb[3];
+                if ((e & 0xffffffff00000000ull) == tag)
+                {
+                    hits++;
+                    rgb[0] = (uint8_t)(e >> 16);
+                    rgb[1] = (uint8_t)(e >> 8);
+                    rgb[2] = (uint8_t)e;
+                }
+                else
+                {
+                    gamut_map_color(lr[k], lg[k], lb[k], rgb);
+                    atomic_store_explicit(slot, tag | (uint32_t)rgb[0] << 16 | (uint32_t)rgb[1] << 8 | rgb[2],
+                                          memory_order_relaxed);
+                }
+                dp[k * 4 + 0] = rgb[0];
+                dp[k * 4 + 1] = rgb[1];
+                dp[k * 4 + 2] = rgb[2];
+                dp[k * 4 + 3] = alpha;
+            }
+        }
+    }
+    atomic_fetch_add_explicit(&job->counts[0], oog, memory_order_relaxed);
+    atomic_fetch_add_explicit(&job->counts[1], hits, memory_order_relaxed);
+}
+
+#ifndef __EMSCRIPTEN__
+// ---- 运行时 CPU 分派（档位检测见 cpu_dispatch.h）----
+
+// in: n 组 [L, C, h]（use_rel=0）或 [L, h, rel]（use_rel=1）
+typedef void (*Oklch8BatchFn)(const double *in, size_t n, int use_rel, uint8_t *rgb);
+
+// 每 OKLCH8_CHUNK 个颜色一块：先在无分支循环中向量化求出全部色相的 sincos，再逐个做色域回退
+#define OKLCH8_CHUNK 256
+
+static INLINE void oklch8_batch_body(const double *in, size_t n, int use_rel, uint8_t *rgb)
+{
+    double cs[OKLCH8_CHUNK], sn[OKLCH8_CHUNK];
+    const int hk = use_rel ? 1 : 2; // 色相所在分量
+    for (size_t i0 = 0; i0 < n; i0 += OKLCH8_CHUNK)
+    {
+        size_t m = n - i0 < OKLCH8_CHUNK ? n - i0 : OKLCH8_CHUNK;
+        const double *p = in + i0 * 3;
+        for (size_t k = 0; k < m; ++k)
+            polar_sincos_deg(p[k * 3 + hk], &sn[k], &cs[k]);
+        for (size_t k = 0; k < m; ++k, p += 3)
+        {
+            if (use_rel)
+                oklch_to_rgb8_cs(p[0], 0.0, cs[k], sn[k], 1, p[2], rgb + (i0 + k) * 3);
+            else
+                oklch_to_rgb8_cs(p[0], p[1], cs[k], sn[k], 0, 0.0, rgb + (i0 + k) * 3);
+        }
+    }
+}
+
+static void oklch8_batch_baseline(const double *in, size_t n, int use_rel, uint8_t *rgb)
+{
+    oklch8_batch_body(in, n, use_rel, rgb);
+}
+
+#ifdef HAVE_X86_DISPATCH
+__attribute__((target("avx2,fma"))) static void oklch8_batch_avx2(const double *in, size_t n, int use_rel,
+                                                                  uint8_t *rgb)
+{
+    oklch8_batch_body(in, n, use_rel, rgb);
+}
+
+__attribute__((target("avx512f,avx512vl,avx512dq,avx512bw,avx2,fma"))) static void
+oklch8_batch_avx512(const double *in, size_t n, int use_rel, uint8_t *rgb)
+{
+    oklch8_batch_body(in, n, use_rel, rgb);
+}
+#endif
+
+typedef void (*SliceRowsFn)(const SliceSpec *sp, int y0, int y1, uint8_t *rgba, uint8_t *mask);
+
+static void slice_rows_baseline(const SliceSpec *sp, int y0, int y1, uint8_t *rgba, uint8_t *mask)
+{
+    slice_rows_body(sp, y0, y1, rgba, mask);
+}
+
+#ifdef HAVE_X86_DISPATCH
+__attribute__((target("avx2,fma"))) static void slice_rows_avx2(const SliceSpec *sp, int y0, int y1, uint8_t *rgba,
+                                                                uint8_t *mask)
+{
+    slice_rows_body(sp, y0, y1, rgba, mask);
+}
+
+__attribute__((target("avx512f,avx512vl,avx512dq,avx512bw,avx2,fma"))) static void
+slice_rows_avx512(const SliceSpec *sp, int y0, int y1, uint8_t *rgba, uint8_t *mask)
+{
+    slice_rows_body(sp, y0, y1, rgba, mask);
+}
+#endif
+
+typedef void (*GradientRowsFn)(const GradientSpec *gs, int y0, int y1, uint8_t *rgba);
+
+static void gradient_rows_baseline(const GradientSpec *gs, int y0, int y1, uint8_t *rgba)
+{
+    gradient_rows_body(gs, y0, y1, rgba);
+}
+
+#ifdef HAVE_X86_DISPATCH
+__attribute__((target("avx2,fma"))) static void gradient_rows_avx2(const GradientSpec *gs, int y0, int y1,
+                                                                   uint8_t *rgba)
+{
+    gradient_rows_body(gs, y0, y1, rgba);
+}
+
+__attribute__((target("avx512f,avx512vl,avx512dq,avx512bw,avx2,fma"))) static void
+gradient_rows_avx512(const GradientSpec *gs, int y0, int y1, uint8_t *rgba)
+{
+    gradient_rows_body(gs, y0, y1, rgba);
+}
+#endif
+
+typedef void (*GamutMapRowsFn)(const GamutMapJob *job, int y0, int y1);
+
+static void gamut_map_rows_baseline(const GamutMapJob *job, int y0, int y1)
+{
+    gamut_map_rows_body(job, y0, y1);
+}
+
+#ifdef HAVE_X86_DISPATCH
+__attribute__((target("avx2,fma"))) static void gamut_map_rows_avx2(const GamutMapJob *job, int y0, int y1)
+{
+    gamut_map_rows_body(job, y0, y1);
+}
+
+__attribute__((target("avx512f,avx512vl,avx512dq,avx512bw,avx2,fma"))) static void
+gamut_map_rows_avx512(const GamutMapJob *job, int y0, int y1)
+{
+    gamut_map_rows_body(job, y0, y1);
+}
+#endif
+
+static Oklch8BatchFn g_oklch8_batch = oklch8_batch_baseline;
+static SliceRowsFn g_slice_rows = slice_rows_baseline;
+static GradientRowsFn g_gradient_rows = gradient_rows_baseline;
+static GamutMapRowsFn g_gamut_map_rows = gamut_map_rows_baseline;
+static const char *g_cpu_path = "baseline";
+
+// 构造函数在 main / dlopen 返回前执行，之后只读，无需同步
+__attribute__((constructor)) static void select_cpu_path(void)
+{
+#ifdef HAVE_X86_DISPATCH
+    switch (detect_cpu_level())
+    {
+    case CPU_LEVEL_AVX512:
+        g_oklch8_batch = oklch8_batch_avx512;
+        g_slice_rows = slice_rows_avx512;
+        g_gradient_rows = gradient_rows_avx512;
+        g_gamut_map_rows = gamut_map_rows_avx512;
+        g_cpu_path = "avx512";
+        return;
+    case CPU_LEVEL_AVX2:
+        g_oklch8_batch = oklch8_batch_avx2;
+        g_slice_rows = slice_rows_avx2;
+        g_gradient_rows = gradient_rows_avx2;
+        g_gamut_map_rows = gamut_map_rows_avx2;
+        g_cpu_path = "avx2";
+        return;
+    default:
+        break;
+    }
+#endif
+    g_oklch8_batch = oklch8_batch_baseline;
+    g_slice_rows = slice_rows_baseline;
+    g_gradient_rows = gradient_rows_baseline;
+    g_gamut_map_rows = gamut_map_rows_baseline;
+    g_cpu_path = "baseline";
+}
+#endif
+
+// ---- 行带并行：切片与渐变共用 ----
+// 图像按 ROW_BAND 行一带，经原子计数器动态分给各线程；WebAssembly 单线程执行同一流程
+#define ROW_BAND 16
+// 小于此像素数时单线程（线程创建开销超过收益）
+#define ROW_BANDS_MT_MIN_PIXELS (128 * 128)
+
+typedef struct
+{
+    void (*rows)(const void *job, int y0, int y1);
+    const void *job;
+    int height;
+    atomic_int next;
+} RowBands;
+
+static void row_bands_worker(RowBands *rb)
+{
+    for (;;)
+    {
+        int y0 = atomic_fetch_add(&rb->next, ROW_BAND);
+        if (y0 >= rb->height)
+            break;
+        rb->rows(rb->job, y0, y0 + ROW_BAND < rb->height ? y0 + ROW_BAND : rb->height);
+    }
+}
+
+#ifndef __EMSCRIPTEN__
+static void row_bands_task(void *arg)
+{
+    row_bands_worker((RowBands *)arg);
+}
+#endif
+
+// threads <= 0 表示按在线 CPU 数
+static void run_row_bands(void (*rows)(const void *job, int y0, int y1), const void *job, int width, int height,
+                          int threads)
+{
+    RowBands rb = {rows, job, height, 0};
+#ifndef __EMSCRIPTEN__
+    int nbands = (height + ROW_BAND - 1) / ROW_BAND;
+    threads = pool_thread_count(threads, nbands > 0 ? (size_t)nbands : 0);
+    if ((long)width * height < ROW_BANDS_MT_MIN_PIXELS)
+        threads = 1;
+    // 各线程共用 rb，经原子计数器领取行带
+    pool_run(threads, row_bands_task, &rb, 0);
+#else
+    (void)width;
+    (void)threads;
+    row_bands_worker(&rb);
+#endif
+}
+
+// ---- 切片渲染驱动：按列预计算 K ----
+typedef struct
+{
+    const SliceSpec *sp;
+    uint8_t *rgba, *mask;
+} SliceJob;
+
+static void slice_band_rows(const void *job, int y0, int y1)
+{
+    const SliceJob *j = (const SliceJob *)job;
+#ifdef __EMSCRIPTEN__
+    slice_rows_body(j->sp, y0, y1, j->rgba, j->mask);
+#else
+    g_slice_rows(j->sp, y0, y1, j->rgba, j->mask);
+#endif
+}
+
+// 渲染一幅切片。plane 为 SLICE_*；fixed 为固定轴的值（L×C 为 h，C×h 为 L，L×h 为 C）；
+// C 轴取 [0, c_max]，h 轴取 [0, 360)。threads <= 0 表示按在线 CPU 数。参数非法返回 -1
+static int render_slice(int plane, double fixed, double c_max, int width, int height, int p3, int threads,
+                        uint8_t *rgba, uint8_t *mask)
+{
+    if (plane < SLICE_LC || plane > SLICE_LH || width <= 0 || height <= 0 || width > SLICE_MAX_SIDE ||
+        height > SLICE_MAX_SIDE || !(c_max >= 0.0) || !rgba)
+        return -1;
+    ensure_srgb8_lut();
+    double *k = (double *)malloc((size_t)width * 3 * sizeof(double));
+    if (!k)
+        return -1;
+    SliceSpec sp = {plane, width, height, p3 != 0, fixed, c_max, k, k + width, k + 2 * width};
+    if (plane == SLICE_CH)
+        sp.fixed = clamp(fixed, 0.0, 1.0);
+    for (int x = 0; x < width; ++x)
+    {
+        double u = (x + 0.5) / width;
+        double hdeg = plane == SLICE_LC ? fixed : u * 360.0;
+        double scale = plane == SLICE_LC ? u * c_max : plane == SLICE_LH ? (fixed < 0.0 ? 0.0 : fixed) : 1.0;
+        double ch, sh;
+        polar_sincos_deg(hdeg, &sh, &ch);
+        k[x] = scale * (0.3963377774 * ch + 0.2158037573 * sh);
+        k[width + x] = scale * (-0.1055613458 * ch - 0.0638541728 * sh);
+        k[2 * width + x] = scale * (-0.0894841775 * ch - 1.2914855480 * sh);
+    }
+    SliceJob job = {&sp, rgba, mask};
+    run_row_bands(slice_band_rows, &job, width, height, threads);
+    free(k);
+    return 0;
+}
+
+// ---- 渐变驱动：停靠点插值 -> 色域回退 -> 1D 查表 ----
+// 单个停靠点（L、C 为 OKLCH，h 为度，alpha 0..1）
+typedef struct
+{
+    double pos, L, C, h, alpha;
+} GradientStop;
+
+// 几何与选项（字段与 okcolor.h 的 okc_gradient 一一对应）
+typedef struct
+{
+    int kind;   // GRAD_*
+    int oklab;  // 0 = OKLCH 插值（色相取短弧），1 = OKLab 插值
+    int repeat; // 0 = 两端延展，1 = 重复
+    int dither; // 1 = 蓝噪声抖动
+    double x0, y0, x1, y1; // 线性：起点、终点；径向/锥形：(x0, y0) 为圆心
+    double radius;         // 径向半径
+    double angle;          // 锥形起始角（度，0 = 正上方，顺时针）
+} GradientDef;
+
+// 按 CSS 规则在 t 处插值：alpha 预乘，OKLCH 色相取短弧，无色（C≈0）一端沿用另一端的色相
+static void gradient_color_at(const GradientStop *st, int n, int oklab, double t, double *L, double *C, double *h,
+                              double *alpha)
+{
+    int i = 0;
+    while (i < n && st[i].pos <= t)
+        i++;
+    if (i == 0 || i == n)
+    {
+        const GradientStop *e = &st[i == 0 ? 0 : n - 1];
+        *L = e->L;
+        *C = e->C;
+        *h = e->h;
+        *alpha = e->alpha;
+        return;
+    }
+    const GradientStop *s0 = &st[i - 1], *s1 = &st[i];
+    double u = (t - s0->pos) / (s1->pos - s0->pos);
+    double a = s0->alpha + (s1->alpha - s0->alpha) * u;
+    // alpha 为 0 时退化为非预乘插值
+    double w0 = a > 0.0 ? s0->alpha * (1.0 - u) / a : 1.0 - u;
+    double w1 = a > 0.0 ? s1->alpha * u / a : u;
+    *alpha = a;
+    *L = s0->L * w0 + s1->L * w1;
+    if (oklab)
+    {
+        double h0 = s0->h * M_PI / 180.0, h1 = s1->h * M_PI / 180.0;
+        double A = s0->C * cos(h0) * w0 + s1->C * cos(h1) * w1;
+        double B = s0->C * sin(h0) * w0 + s1->C * sin(h1) * w1;
+        *C = sqrt(A * A + B * B);
+        *h = atan2(B, A) * 180.0 / M_PI;
+        return;
+    }
+    double h0 = s0->C < 1e-9 ? s1->h : s0->h;
+    double h1 = s1->C < 1e-9 ? s0->h : s1->h;
+    double dh = fmod(h1 - h0, 360.0);
+    if (dh > 180.0)
+        dh -= 360.0;
+    else if (dh < -180.0)
+        dh += 360.0;
+    *C = s0->C * w0 + s1->C * w1;
+    *h = h0 + dh * u;
+}
+
+// 停靠点位置须单调不减（CSS：小于前者的位置提升为前者）；构建 GRAD_LUT_SIZE 项 RGBA 表，
+// 颜色经与 oklch_to_rgb8 相同的色域回退与 sRGB 编码，保留小数供抖动
+static void build_gradient_lut(const GradientStop *st, int n, int oklab, float *lut)
+{
+    for (int k = 0; k < GRAD_LUT_SIZE; ++k)
+    {
+        double L, C, h, alpha;
+        gradient_color_at(st, n, oklab, (double)k / (GRAD_LUT_SIZE - 1), &L, &C, &h, &alpha);
+        L = clamp(L, 0.0, 1.0);
+        double sh, ch;
+        polar_sincos_deg(h, &sh, &ch);
+        double Csafe = gamut_safe_chroma_cs(L, C < 0.0 ? 0.0 : C, ch, sh, 0);
+        double r, g, b;
+        oklch_to_linear_rgb_fast(L, Csafe, ch, sh, &r, &g, &b);
+        lut[k * 4 + 0] = (float)(clamp(linear_to_srgb_stat(r), 0.0, 1.0) * 255.0);
+        lut[k * 4 + 1] = (float)(clamp(linear_to_srgb_stat(g), 0.0, 1.0) * 255.0);
+        lut[k * 4 + 2] = (float)(clamp(linear_to_srgb_stat(b), 0.0, 1.0) * 255.0);
+        lut[k * 4 + 3] = (float)(clamp(alpha, 0.0, 1.0) * 255.0);
+    }
+}
+
+typedef struct
+{
+    const GradientSpec *gs;
+    uint8_t *rgba;
+} GradientJob;
+
+static void gradient_band_rows(const void *job, int y0, int y1)
+{
+    const GradientJob *j = (const GradientJob *)job;
+#ifdef __EMSCRIPTEN__
+    gradient_rows_body(j->gs, y0, y1, j->rgba);
+#else
+    g_gradient_rows(j->gs, y0, y1, j->rgba);
+#endif
+}
+
+// 光栅化一幅渐变到 rgba（width*height*4，非预乘）。至少 1 个停靠点；threads <= 0 表示按在线 CPU 数。
+// 参数非法或内存不足返回 -1
+static int render_gradient(const GradientDef *def, const GradientStop *stops, int nstops, int width, int height,
+                           int threads, uint8_t *rgba)
+{
+    if (!def || def->kind < GRAD_LINEAR || def->kind > GRAD_CONIC || !stops || nstops < 1 || width <= 0 ||
+        height <= 0 || width > GRAD_MAX_SIDE || height > GRAD_MAX_SIDE || !rgba)
+        return -1;
+    GradientStop *st = (GradientStop *)malloc((size_t)nstops * sizeof(GradientStop));
+    float *lut = (float *)malloc(GRAD_LUT_SIZE * 4 * sizeof(float));
+    if (!st || !lut)
+    {
+        free(st);
+        free(lut);
+        return -1;
+    }
+    for (int i = 0; i < nstops; ++i)
+    {
+        st[i] = stops[i];
+        if (i > 0 && st[i].pos < st[i - 1].pos)
+            st[i].pos = st[i - 1].pos;
+    }
+    ensure_srgb8_lut();
+    build_gradient_lut(st, nstops, def->oklab, lut);
+    if (def->dither)
+        ensure_blue_noise();
+
+    GradientSpec gs = {def->kind, def->repeat != 0, def->dither != 0, width, (float)def->x0, (float)def->y0,
+                       0.0f, 0.0f, 0.0f, 0.0f, lut};
+    if (def->kind == GRAD_LINEAR)
+    {
+        // t = ((p - p0)·d) / |d|²；起点与终点重合时整幅取首个停靠点
+        double dx = def->x1 - def->x0, dy = def->y1 - def->y0;
+        double d2 = dx * dx + dy * dy;
+        gs.dx = d2 > 0.0 ? (float)(dx / d2) : 0.0f;
+        gs.dy = d2 > 0.0 ? (float)(dy / d2) : 0.0f;
+    }
+    else if (def->kind == GRAD_RADIAL)
+        gs.inv_r = def->radius > 0.0 ? (float)(1.0 / def->radius) : 0.0f;
+    else
+        gs.turn0 = (float)(def->angle / 360.0 - floor(def->angle / 360.0));
+    GradientJob job = {&gs, rgba};
+    run_row_bands(gradient_band_rows, &job, width, height, threads);
+    free(lut);
+    free(st);
+    return 0;
+}
+
+// ---- 图像色域映射驱动 ----
+static void gamut_map_band_rows(const void *job, int y0, int y1)
+{
+#ifdef __EMSCRIPTEN__
+    gamut_map_rows_body((const GamutMapJob *)job, y0, y1);
+#else
+    g_gamut_map_rows((const GamutMapJob *)job, y0, y1);
+#endif
+}
+
+// Display-P3 RGBA8 -> sRGB RGBA8（dst 可与 src 相同）。返回色域外像素数，*cache_hits（可为 NULL）
+// 为其中命中缓存的数目；参数非法或内存不足返回 -1。threads <= 0 表示按在线 CPU 数
+static int64_t gamut_map_image(const uint8_t *src, uint8_t *dst, int width, int height, int threads,
+                               int64_t *cache_hits)
+{
+    if (!src || !dst || width <= 0 || height <= 0 || width > GMAP_MAX_SIDE || height > GMAP_MAX_SIDE)
+        return -1;
+    ensure_srgb8_lut();
+    _Atomic uint64_t *cache = (_Atomic uint64_t *)calloc((size_t)1 << GMAP_CACHE_BITS, sizeof(uint64_t));
+    if (!cache)
+        return -1;
+    atomic_llong counts[2] = {0, 0};
+    GamutMapJob job = {src, dst, width, cache, counts};
+    run_row_bands(gamut_map_band_rows, &job, width, height, threads);
+    free(cache);
+    if (cache_hits)
+        *cache_hits = atomic_load(&counts[1]);
+    return atomic_load(&counts[0]);
+}
+
+#ifdef __EMSCRIPTEN__
+// 导出最小接口，供 JS 从 Wasm 直接调用。
+// 输入：（L ∈ [0..1]，C ≥ 0，h 为角度）
+// 输出：返回指向 3 个 int32 值 [R,G,B]（0..255）的指针。
+static int32_t g_rgb_out[3];
+
+__attribute__((export_name("oklch2rgb_calc_js")))
+uint32_t
+oklch2rgb_calc_js(double L, double C, double hdeg)
+{
+    // 与 CLI / 批量内核同一路径：归一化 -> 色域回退 -> sRGB 编码并取整
+    uint8_t o[3];
+    oklch_to_rgb8(L, C, hdeg, 0, 0.0, o);
+    g_rgb_out[0] = o[0];
+    g_rgb_out[1] = o[1];
+    g_rgb_out[2] = o[2];
     return (uint32_t)(uintptr_t)g_rgb_out;
 }
 
@@ -237,67 +1137,483 @@ __attribute__((export_name("oklch2rgb_calc_rel_js")))
 uint32_t
 oklch2rgb_calc_rel_js(double L, double hdeg, double rel)
 {
-    if (L < 0.0)
-        L = 0.0;
-    if (L > 1.0)
-        L = 1.0;
-    if (rel < 0.0)
-        rel = 0.0;
-    if (rel > 1.0)
-        rel = 1.0;
+    uint8_t o[3];
+    oklch_to_rgb8(L, 0.0, hdeg, 1, rel, o);
+    g_rgb_out[0] = o[0];
+    g_rgb_out[1] = o[1];
+    g_rgb_out[2] = o[2];
+    return (uint32_t)(uintptr_t)g_rgb_out;
+}
+
+// 打包版本：结果以返回值 0x00RRGGBB 给出，不经过共享的静态缓冲 g_rgb_out，
+// 结果不会被后续调用覆盖。
+__attribute__((export_name("oklch2rgb_packed_js")))
+uint32_t
+oklch2rgb_packed_js(double L, double C, double hdeg)
+{
+    uint8_t o[3];
+    oklch_to_rgb8(L, C, hdeg, 0, 0.0, o);
+    return ((uint32_t)o[0] << 16) | ((uint32_t)o[1] << 8) | (uint32_t)o[2];
+}
 
-    double Cmax = max_chroma_for_srgb(L, hdeg);
-    double C_use = rel * Cmax;
-    // 最后一轮安全校正以抵消数值漂移
-    double Csafe = find_gamut_safe_chroma(L, C_use, hdeg);
+__attribute__((export_name("oklch2rgb_rel_packed_js")))
+uint32_t
+oklch2rgb_rel_packed_js(double L, double hdeg, double rel)
+{
+    uint8_t o[3];
+    oklch_to_rgb8(L, 0.0, hdeg, 1, rel, o);
+    return ((uint32_t)o[0] << 16) | ((uint32_t)o[1] << 8) | (uint32_t)o[2];
+}
 
-    // 预计算色相
-    double h = fmod(hdeg, 360.0);
-    if (h < 0)
-        h += 360.0;
-    double hr = h * M_PI / 180.0;
-    double ch = cos(hr), sh = sin(hr);
-    double r_lin, g_lin, b_lin;
-    oklch_to_linear_rgb_fast(L, Csafe, ch, sh, &r_lin, &g_lin, &b_lin);
-    double r = linear_to_srgb(r_lin);
-    double g = linear_to_srgb(g_lin);
-    double b2 = linear_to_srgb(b_lin);
-    if (r < 0.0)
-        r = 0.0;
-    if (r > 1.0)
-        r = 1.0;
-    if (g < 0.0)
-        g = 0.0;
-    if (g > 1.0)
-        g = 1.0;
-    if (b2 < 0.0)
-        b2 = 0.0;
-    if (b2 > 1.0)
-        b2 = 1.0;
-    int R = (int)floor(r * 255.0 + 0.5);
-    int G = (int)floor(g * 255.0 + 0.5);
-    int B = (int)floor(b2 * 255.0 + 0.5);
-    g_rgb_out[0] = R;
-    g_rgb_out[1] = G;
-    g_rgb_out[2] = B;
-    return (uint32_t)(uintptr_t)g_rgb_out;
+// 计数器快照：返回指向 58 个 f64 的指针（JS 用 Float64Array 读取），未以 OKCOLOR_STATS 编译时返回 0。
+// 布局：[0] fast_path，[1] clamp_low，[2] clamp_high，
+//       [3..23] 完整精度二分步数 0..20，[24..44] 8 位二分步数 0..20，[45..57] 倍增越界次序 0..12
+__attribute__((export_name("oklch2rgb_stats_js")))
+uint32_t
+oklch2rgb_stats_js(void)
+{
+#ifdef OKCOLOR_STATS
+    static double snap[58];
+    snap[0] = (double)g_stats.fast_path;
+    snap[1] = (double)g_stats.clamp_low;
+    snap[2] = (double)g_stats.clamp_high;
+    for (int i = 0; i < 21; ++i)
+    {
+        snap[3 + i] = (double)g_stats.bisect_steps[0][i];
+        snap[24 + i] = (double)g_stats.bisect_steps[1][i];
+    }
+    for (int i = 0; i < 13; ++i)
+        snap[45 + i] = (double)g_stats.doubling[i];
+    return (uint32_t)(uintptr_t)snap;
+#else
+    return 0;
+#endif
 }
+
+__attribute__((export_name("oklch2rgb_stats_reset_js")))
+void
+oklch2rgb_stats_reset_js(void)
+{
+#ifdef OKCOLOR_STATS
+    memset(&g_stats, 0, sizeof g_stats);
 #endif
+}
+
+// 取色器切片：rgba_ptr 为 width*height*4 字节，mask_ptr 为 width*height 字节或 0。
+// plane: 0 = L×C（fixed 为 h），1 = C×h（fixed 为 L），2 = L×h（fixed 为 C）。
+// 单线程；以 -msimd128 构建时行内循环为 SIMD。成功返回 0，参数非法返回 -1
+__attribute__((export_name("oklch2rgb_slice_js")))
+int
+oklch2rgb_slice_js(int plane, double fixed, double c_max, int width, int height, int p3, uint32_t rgba_ptr,
+                   uint32_t mask_ptr)
+{
+    return render_slice(plane, fixed, c_max, width, height, p3, 1, (uint8_t *)(uintptr_t)rgba_ptr,
+                        (uint8_t *)(uintptr_t)mask_ptr);
+}
+
+// 渐变光栅化：spec_ptr 为 10 个 f64 [kind, oklab, repeat, dither, x0, y0, x1, y1, radius, angle]
+// （kind: 0 = 线性，1 = 径向，2 = 锥形），stops_ptr 为 nstops 组 f64 [pos, L, C, h, alpha]，
+// rgba_ptr 为 width*height*4 字节（非预乘）。单线程。成功返回 0，失败返回 -1
+__attribute__((export_name("oklch2rgb_gradient_js")))
+int
+oklch2rgb_gradient_js(uint32_t spec_ptr, uint32_t stops_ptr, int nstops, int width, int height, uint32_t rgba_ptr)
+{
+    const double *v = (const double *)(uintptr_t)spec_ptr;
+    GradientDef def = {(int)v[0], (int)v[1], (int)v[2], (int)v[3], v[4], v[5], v[6], v[7], v[8], v[9]};
+    return render_gradient(&def, (const GradientStop *)(uintptr_t)stops_ptr, nstops, width, height, 1,
+                           (uint8_t *)(uintptr_t)rgba_ptr);
+}
+
+// 广色域图像映射：src_ptr 为 width*height 个 Display-P3 RGBA8，结果（sRGB RGBA8）写入 dst_ptr（可相同）。
+// 单线程。返回色域外像素数，失败返回 -1
+__attribute__((export_name("oklch2rgb_gamut_map_js")))
+int
+oklch2rgb_gamut_map_js(uint32_t src_ptr, uint32_t dst_ptr, int width, int height)
+{
+    return (int)gamut_map_image((const uint8_t *)(uintptr_t)src_ptr, (uint8_t *)(uintptr_t)dst_ptr, width, height,
+                                1, NULL);
+}
+
+// 供 JS 分配切片/渐变/图像缓冲；size 为字节数
+__attribute__((export_name("oklch2rgb_alloc_js")))
+uint32_t
+oklch2rgb_alloc_js(uint32_t size)
+{
+    return (uint32_t)(uintptr_t)malloc(size ? size : 1);
+}
+
+__attribute__((export_name("oklch2rgb_free_js")))
+void oklch2rgb_free_js(uint32_t ptr)
+{
+    free((void *)(uintptr_t)ptr);
+}
+#endif
+
+#ifdef OKCOLOR_EMBED
+// ---- 原生嵌入接口（见 okcolor.h）----
+int okc_version(void)
+{
+    return OKCOLOR_VERSION;
+}
+
+void okc_oklch_to_rgb8_batch(const double *lch, size_t n, uint8_t *rgb)
+{
+    g_oklch8_batch(lch, n, 0, rgb);
+}
+
+void okc_oklch_rel_to_rgb8_batch(const double *lhr, size_t n, uint8_t *rgb)
+{
+    g_oklch8_batch(lhr, n, 1, rgb);
+}
+
+int okc_render_slice(int plane, double fixed, double c_max, int width, int height, int p3, int threads, uint8_t *rgba,
+                     uint8_t *mask)
+{
+    return render_slice(plane, fixed, c_max, width, height, p3, threads, rgba, mask);
+}
+
+int okc_render_gradient(const okc_gradient *g, const okc_gradient_stop *stops, int nstops, int width, int height,
+                        int threads, uint8_t *rgba)
+{
+    if (!g || !stops || nstops < 1)
+        return -1;
+    GradientDef def = {g->kind, g->oklab, g->repeat, g->dither, g->x0, g->y0, g->x1, g->y1, g->radius, g->angle};
+    GradientStop *st = (GradientStop *)malloc((size_t)nstops * sizeof(GradientStop));
+    if (!st)
+        return -1;
+    for (int i = 0; i < nstops; ++i)
+        st[i] = (GradientStop){stops[i].pos, stops[i].L, stops[i].C, stops[i].h, stops[i].alpha};
+    int rc = render_gradient(&def, st, nstops, width, height, threads, rgba);
+    free(st);
+    return rc;
+}
+
+int64_t okc_gamut_map_p3_image(const uint8_t *src, uint8_t *dst, int width, int height, int threads)
+{
+    return gamut_map_image(src, dst, width, height, threads, NULL);
+}
+#endif
+
+#if !defined(__EMSCRIPTEN__) && !defined(OKCOLOR_EMBED)
+// 输出本线程的色域路径计数器（--batch --stats，写到 stderr，不干扰 stdout 的结果）
+static void print_stats(void)
+{
+#ifdef OKCOLOR_STATS
+    fprintf(stderr, "fast_path: %llu\n", (unsigned long long)g_stats.fast_path);
+    fprintf(stderr, "srgb_clamp: low=%llu high=%llu\n", (unsigned long long)g_stats.clamp_low,
+            (unsigned long long)g_stats.clamp_high);
+    static const char *const names[2] = {"bisect_steps", "bisect8_steps"};
+    for (int m = 0; m < 2; ++m)
+    {
+        fprintf(stderr, "%s:", names[m]);
+        for (int i = 0; i < 21; ++i)
+            if (g_stats.bisect_steps[m][i])
+                fprintf(stderr, " %d=%llu", i, (unsigned long long)g_stats.bisect_steps[m][i]);
+        fprintf(stderr, "\n");
+    }
+    fprintf(stderr, "doubling:");
+    for (int i = 0; i < 13; ++i)
+        if (g_stats.doubling[i])
+            fprintf(stderr, " %d=%llu", i, (unsigned long long)g_stats.doubling[i]);
+    fprintf(stderr, "\n");
+#else
+    fprintf(stderr, "stats: not compiled in (rebuild with -DOKCOLOR_STATS)\n");
+#endif
+}
+
+// 批量模式的一行：三个数值（"L C h"，--rel 时为 "L h rel"），或（非 --rel 时）CSS oklch() 颜色。
+// 成功返回 1，v 写入 3 个分量、alpha 写入不透明度
+static int parse_batch_line(const char *p, const char *end, int use_rel, double *v, double *alpha)
+{
+    *alpha = 1.0;
+    if (!use_rel && isalpha((unsigned char)*p))
+    {
+        CssColor c;
+        p = css_parse_color(p, end, &c);
+        if (!p || c.kind != CSS_COLOR_OKLCH)
+            return 0;
+        v[0] = c.v[0];
+        v[1] = c.v[1];
+        v[2] = c.v[2];
+        *alpha = c.alpha;
+        return css_skip_space(p, end) == end;
+    }
+    for (int k = 0; k < 3; ++k)
+    {
+        p = css_skip_space(p, end);
+        if (!css_parse_number(&p, end, &v[k]))
+            return 0;
+    }
+    return css_skip_space(p, end) == end;
+}
+
+// 批量模式：stdin 每行一个颜色（见 parse_batch_line），stdout 每行 "R G B"（--css 时为 "#rrggbb[aa]"）
+// 读行与分块由 css_run_batch 驱动，每块调用分派后的批量内核并整块写出
+#define BATCH_CHUNK 4096
+typedef struct
+{
+    int use_rel, css_out;
+    double in[BATCH_CHUNK * 3];
+    double alpha[BATCH_CHUNK];
+    uint8_t out[BATCH_CHUNK * 3];
+    char text[BATCH_CHUNK * 16];
+} BatchState;
+
+static int batch_parse(void *ctx, const char *p, const char *end, size_t slot)
+{
+    BatchState *s = (BatchState *)ctx;
+    return parse_batch_line(p, end, s->use_rel, s->in + slot * 3, &s->alpha[slot]);
+}
+
+static void batch_flush(void *ctx, size_t n)
+{
+    BatchState *s = (BatchState *)ctx;
+    g_oklch8_batch(s->in, n, s->use_rel, s->out);
+    char *t = s->text;
+    for (size_t i = 0; i < n; ++i)
+    {
+        const uint8_t *o = s->out + i * 3;
+        if (s->css_out)
+            t = css_format_hex(t, o, s->alpha[i]);
+        else
+        {
+            t = css_format_u8(t, o[0]);
+            *t++ = ' ';
+            t = css_format_u8(t, o[1]);
+            *t++ = ' ';
+            t = css_format_u8(t, o[2]);
+        }
+        *t++ = '\n';
+    }
+    fwrite(s->text, 1, (size_t)(t - s->text), stdout);
+}
+
+static int run_batch(int use_rel, int css_out)
+{
+    static BatchState s;
+    s.use_rel = use_rel;
+    s.css_out = css_out;
+    return css_run_batch(BATCH_CHUNK, batch_parse, batch_flush, &s, use_rel ? "L h rel" : "L C h or oklch(...)");
+}
+
+// 切片模式：渲染一幅切片，以 PAM（P7, RGB_ALPHA）写到 stdout
+static int run_slice(int argc, char **argv)
+{
+    static const char *const planes[] = {"lc", "ch", "lh"};
+    int plane = -1, width = 512, height = 512, p3 = 0, threads = 0;
+    double fixed, c_max = 0.37;
+    for (int k = 0; k < 3; ++k)
+        if (argc > 2 && strcmp(argv[2], planes[k]) == 0)
+            plane = k;
+    int ok = plane >= 0 && argc > 3 && parse_number(argv[3], &fixed);
+    for (int i = 4; ok && i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--p3") == 0)
+            p3 = 1;
+        else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc)
+            ok = sscanf(argv[++i], "%dx%d", &width, &height) == 2;
+        else if (strcmp(argv[i], "--cmax") == 0 && i + 1 < argc)
+            ok = parse_number(argv[++i], &c_max);
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            threads = atoi(argv[++i]);
+        else
+            ok = 0;
+    }
+    uint8_t *rgba = ok && width > 0 && height > 0 ? (uint8_t *)malloc((size_t)width * height * 4) : NULL;
+    if (!rgba || render_slice(plane, fixed, c_max, width, height, p3, threads, rgba, NULL) != 0)
+    {
+        free(rgba);
+        fprintf(stderr, "Usage: %s --slice lc|ch|lh VALUE [--size WxH] [--cmax C] [--p3] [--threads N] > out.pam\n"
+                        "  lc: x = C, y = L, VALUE = h; ch: x = h, y = C, VALUE = L; lh: x = h, y = L, VALUE = C\n",
+                argv[0]);
+        return 1;
+    }
+    write_pam(rgba, width, height);
+    free(rgba);
+    return 0;
+}
+
+// 色域映射模式：读入 Display-P3 编码的 PAM（"-" 为 stdin），映射到 sRGB 后以 PAM 写到 stdout；
+// 色域外比例、缓存命中与吞吐（百万像素/秒，不含读写文件）写到 stderr
+static int run_gamut_map(int argc, char **argv)
+{
+    int threads = 0, ok = argc > 2;
+    for (int i = 3; ok && i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            threads = atoi(argv[++i]);
+        else
+            ok = 0;
+    }
+    if (!ok)
+    {
+        fprintf(stderr, "Usage: %s --gamut-map IN.pam [--threads N] > out.pam   (IN: Display-P3 RGB(A), 8-bit)\n",
+                argv[0]);
+        return 1;
+    }
+    int width, height;
+    uint8_t *rgba = read_pam(argv[2], &width, &height);
+    if (!rgba)
+    {
+        fprintf(stderr, "Failed to read PAM image (P7, DEPTH 3/4, MAXVAL 255).\n");
+        return 1;
+    }
+    struct timespec t0, t1;
+    int64_t hits = 0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    int64_t oog = gamut_map_image(rgba, rgba, width, height, threads, &hits);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    if (oog < 0)
+    {
+        fprintf(stderr, "Gamut mapping failed (image too large or out of memory).\n");
+        free(rgba);
+        return 1;
+    }
+    double sec = (double)(t1.tv_sec - t0.tv_sec) + (double)(t1.tv_nsec - t0.tv_nsec) * 1e-9;
+    double px = (double)width * height;
+    fprintf(stderr, "%dx%d: %lld out of gamut (%.2f%%), %lld cache hits, %.2f ms, %.1f MP/s\n", width, height,
+            (long long)oog, 100.0 * (double)oog / px, (long long)hits, sec * 1e3, sec > 0.0 ? px / sec * 1e-6 : 0.0);
+    write_pam(rgba, width, height);
+    free(rgba);
+    return 0;
+}
+
+// 渐变模式：KIND GEOMETRY STOP... ，停靠点为 "oklch(...) [pos%]"；省略的位置按 CSS 规则补齐
+// （首尾缺省为 0% / 100%，中间缺省者在两侧已知位置之间均分）
+static int run_gradient(int argc, char **argv)
+{
+    static const char *const kinds[] = {"linear", "radial", "conic"};
+    const double unset = -1e300; // -ffast-math 下不能依赖 NaN 判定，用哨兵值标记缺省位置
+    GradientDef def = {-1, 0, 0, 0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+    GradientStop *st = (GradientStop *)malloc((size_t)argc * sizeof(GradientStop));
+    int width = 512, height = 512, threads = 0, n = 0;
+    for (int k = 0; k < 3; ++k)
+        if (argc > 2 && strcmp(argv[2], kinds[k]) == 0)
+            def.kind = k;
+    int ok = st && def.kind >= 0 && argc > 3;
+    if (ok && def.kind == GRAD_LINEAR)
+        ok = sscanf(argv[3], "%lf,%lf,%lf,%lf", &def.x0, &def.y0, &def.x1, &def.y1) == 4;
+    else if (ok)
+        ok = sscanf(argv[3], "%lf,%lf,%lf", &def.x0, &def.y0, def.kind == GRAD_RADIAL ? &def.radius : &def.angle) == 3;
+    for (int i = 4; ok && i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--oklab") == 0)
+            def.oklab = 1;
+        else if (strcmp(argv[i], "--repeat") == 0)
+            def.repeat = 1;
+        else if (strcmp(argv[i], "--dither") == 0)
+            def.dither = 1;
+        else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc)
+            ok = sscanf(argv[++i], "%dx%d", &width, &height) == 2;
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            threads = atoi(argv[++i]);
+        else
+        {
+            const char *end = argv[i] + strlen(argv[i]);
+            CssColor c;
+            const char *q = css_parse_color(argv[i], end, &c);
+            ok = q && c.kind == CSS_COLOR_OKLCH;
+            if (!ok)
+                break;
+            GradientStop *g = &st[n++];
+            *g = (GradientStop){unset, c.v[0], c.v[1], c.v[2], c.alpha};
+            q = css_skip_space(q, end);
+            if (q < end)
+            {
+                ok = css_parse_number(&q, end, &g->pos) && q < end && *q == '%' && css_skip_space(q + 1, end) == end;
+                g->pos /= 100.0;
+            }
+        }
+    }
+    ok = ok && n > 0;
+    if (ok)
+    {
+        if (st[0].pos == unset)
+            st[0].pos = 0.0;
+        if (st[n - 1].pos == unset)
+            st[n - 1].pos = n > 1 ? 1.0 : 0.0;
+        for (int i = 1; i < n - 1; ++i)
+        {
+            if (st[i].pos != unset)
+                continue;
+            int j = i;
+            while (st[j].pos == unset)
+                j++;
+            for (int k = i; k < j; ++k)
+                st[k].pos = st[i - 1].pos + (st[j].pos - st[i - 1].pos) * (k - i + 1) / (j - i + 1);
+        }
+    }
+    uint8_t *rgba = ok && width > 0 && height > 0 ? (uint8_t *)malloc((size_t)width * height * 4) : NULL;
+    if (!rgba || render_gradient(&def, st, n, width, height, threads, rgba) != 0)
+    {
+        free(rgba);
+        free(st);
+        fprintf(stderr,
+                "Usage: %s --gradient linear X0,Y0,X1,Y1 | radial CX,CY,R | conic CX,CY,DEG  STOP...\n"
+                "          [--size WxH] [--oklab] [--repeat] [--dither] [--threads N] > out.pam\n"
+                "  STOP: \"oklch(L C h [/ a]) [pos%%]\"; colors interpolate in OKLCH (shorter hue arc)\n"
+                "        unless --oklab; conic angles start at 12 o'clock and run clockwise\n",
+                argv[0]);
+        return 1;
+    }
+    write_pam(rgba, width, height);
+    free(rgba);
+    free(st);
+    return 0;
+}
 
-#ifndef __EMSCRIPTEN__
 int main(int argc, char **argv)
 {
+    if (argc == 2 && strcmp(argv[1], "--cpu-info") == 0)
+    {
+        print_cpu_info(g_cpu_path);
+        return 0;
+    }
+    if (argc >= 2 && strcmp(argv[1], "--slice") == 0)
+        return run_slice(argc, argv);
+    if (argc >= 2 && strcmp(argv[1], "--gradient") == 0)
+        return run_gradient(argc, argv);
+    if (argc >= 2 && strcmp(argv[1], "--gamut-map") == 0)
+        return run_gamut_map(argc, argv);
+    if (argc >= 2 && strcmp(argv[1], "--batch") == 0)
+    {
+        int use_rel = 0, stats = 0, css_out = 0;
+        for (int i = 2; i < argc; ++i)
+        {
+            if (strcmp(argv[i], "--rel") == 0)
+                use_rel = 1;
+            else if (strcmp(argv[i], "--stats") == 0)
+                stats = 1;
+            else if (strcmp(argv[i], "--css") == 0)
+                css_out = 1;
+            else
+            {
+                fprintf(stderr, "Usage: %s --batch [--rel] [--css] [--stats] < input\n", argv[0]);
+                return 1;
+            }
+        }
+        int rc = run_batch(use_rel, css_out);
+        if (stats)
+            print_stats();
+        return rc;
+    }
     if (argc != 4 && argc != 5)
     {
         fprintf(stderr,
                 "Usage:\n"
-                "  %s L C h [rel]\n\n"
+                "  %s L C h [rel]\n"
+                "  %s --batch [--rel] [--css] [--stats] < input\n"
+                "      (lines \"L C h\", \"oklch(70%% 0.2 30)\" or with --rel \"L h rel\"; --css prints #rrggbb)\n"
+                "  %s --slice lc|ch|lh VALUE [--size WxH] [--cmax C] [--p3] > out.pam\n"
+                "  %s --gradient linear|radial|conic GEOMETRY STOP... [--dither] > out.pam\n"
+                "  %s --gamut-map IN.pam [--threads N] > out.pam   (Display-P3 image -> sRGB)\n"
+                "  %s --cpu-info\n\n"
                 "Notes:\n"
                 "  - L in [0..1], C >= 0, h in degrees [0..360)\n"
                 "  - rel (optional) in [0..1]. When provided, C is ignored and\n"
                 "    chroma becomes rel * Cmax(L,h) where Cmax fits sRGB gamut.\n"
                 "  - Output is sRGB 0..255 integers: R G B\n",
-                argv[0]);
+                argv[0], argv[0], argv[0], argv[0], argv[0], argv[0]);
         return 1;
     }
 
@@ -338,15 +1654,15 @@ int main(int argc, char **argv)
     }
 
     // Gamut-safe conversion: scale C down if needed so linear sRGB ∈ [0,1]
-    double Csafe = find_gamut_safe_chroma(L, C_use, h);
+    double Csafe = find_gamut_safe_chroma8(L, C_use, h);
     double r_lin, g_lin, b_lin;
     // 用预计算三角加速
-    double hr = h * M_PI / 180.0;
-    double ch = cos(hr), sh = sin(hr);
+    double ch, sh;
+    polar_sincos_deg(h, &sh, &ch);
     oklch_to_linear_rgb_fast(L, Csafe, ch, sh, &r_lin, &g_lin, &b_lin);
-    double r = linear_to_srgb(r_lin);
-    double g = linear_to_srgb(g_lin);
-    double b2 = linear_to_srgb(b_lin);
+    double r = linear_to_srgb_stat(r_lin);
+    double g = linear_to_srgb_stat(g_lin);
+    double b2 = linear_to_srgb_stat(b_lin);
     int R = (int)floor(clamp(r, 0.0, 1.0) * 255.0 + 0.5);
     int G = (int)floor(clamp(g, 0.0, 1.0) * 255.0 + 0.5);
     int B = (int)floor(clamp(b2, 0.0, 1.0) * 255.0 + 0.5);
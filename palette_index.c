@@ -0,0 +1,793 @@
+// 调色板签名索引：按主色相似度检索图像（extract-colors 的输出 -> 定长签名 -> 内存映射索引 -> top-k 查询）
+// 实现说明：
+// - 签名：每个颜色（sRGB + 面积占比）转到 OKLab，按权重三线性地摊到 L × a × b = 8 × 6 × 6 个格点上
+//   （a、b 取 [-0.3, 0.3]，超出的夹到边缘格），总质量归一化为 255，存为 288 个 u8。
+// - 相似度：两签名逐格取 min 再求和（直方图交集）/ 255 ∈ [0, 1]，1 为相同。
+//   三线性摊分使相近颜色在相邻格点上也有重叠，交集因此近似一个只在相邻格点间搬运的 EMD，
+//   而查询只是 u8 的 min + 累加，块内循环按 CPU 分派自动向量化。
+// - 索引文件（本机字节序，x86 / ARM 均为小端）：
+//     [0, 64)          头：magic "OKPIDX01"、u32 格数、u32 保留、u64 条数 n、u64 名字表偏移
+//     [64, 64 + 288n)  签名，逐条紧密排列
+//     名字表           （8 字节对齐）u64 偏移 × (n + 1)，随后为 NUL 结尾的名字
+//   查询时整个文件 mmap 进来，签名区按 SCAN_BLOCK 条一块由各线程经原子计数器领取，
+//   每线程维护自己的 top-k 小顶堆，最后合并。
+// - 仅原生构建（依赖 mmap 与 POSIX 线程），不提供 Wasm 导出。
+// - 用法：
+//     palette_index build OUT.okpi < paths.txt            每行一个 extract-colors 的 JSON 文件路径（即条目名）
+//     palette_index query INDEX.okpi PALETTE.json|- [-k K] [--threads N]
+//   调色板文件为 extract-colors 的 JSON（取 "hex" 与 "area"），或每行 "#rrggbb [权重]"。
+
+// POSIX 线程、mmap 与 sysconf；-std=c11 下 glibc 需显式打开
+#if !defined(__APPLE__) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include <time.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef OKCOLOR_EMBED
+#include "okcolor.h"
+#else
+#include "css_color.h"
+#endif
+
+#ifndef INLINE
+#define INLINE inline __attribute__((always_inline))
+#endif
+
+#include "color_space.h"
+#include "cpu_dispatch.h"
+
+#define SIG_NL 8
+#define SIG_NA 6
+#define SIG_NB 6
+#define SIG_BINS (SIG_NL * SIG_NA * SIG_NB)
+#define SIG_AB_RANGE 0.3
+#define SIG_MASS 255.0
+
+#define INDEX_MAGIC "OKPIDX01"
+#define INDEX_HEADER_BYTES 64
+
+typedef struct
+{
+    char magic[8];
+    uint32_t bins;
+    uint32_t reserved;
+    uint64_t count;
+    uint64_t names_offset;
+    uint8_t pad[INDEX_HEADER_BYTES - 32];
+} IndexHeader;
+
+_Static_assert(sizeof(IndexHeader) == INDEX_HEADER_BYTES, "index header must be 64 bytes");
+
+// ---- 签名 ----
+// 坐标 u（以格点为单位）落在相邻两格 i、i+1 之间，f 为 i+1 一侧的权重；越界夹到两端
+static void sig_axis(double u, int cells, int *i, double *f)
+{
+    u = u < 0.0 ? 0.0 : u > cells - 1 ? cells - 1 : u;
+    int k = (int)u;
+    if (k > cells - 2)
+        k = cells - 2;
+    *i = k;
+    *f = u - k;
+}
+
+// rgb: n 组 0..255 的 [R, G, B]；weight: n 个非负权重（如 extract-colors 的 area），NULL 表示等权。
+// 权重全为 0 时签名全 0（与任何签名的相似度都是 0）
+static void palette_signature(const double *rgb, const double *weight, size_t n, uint8_t *sig)
+{
+    double acc[SIG_BINS] = {0}, total = 0.0;
+    for (size_t k = 0; k < n; ++k)
+        total += weight ? (weight[k] > 0.0 ? weight[k] : 0.0) : 1.0;
+    memset(sig, 0, SIG_BINS);
+    if (!(total > 0.0))
+        return;
+
+    CsPlan plan;
+    cs_plan_init(&plan, CS_SRGB, CS_OKLAB);
+    for (size_t k = 0; k < n; ++k)
+    {
+        double w = weight ? weight[k] : 1.0;
+        if (!(w > 0.0))
+            continue;
+        double v[3] = {rgb[k * 3 + 0] / 255.0, rgb[k * 3 + 1] / 255.0, rgb[k * 3 + 2] / 255.0}, lab[3];
+        cs_convert(&plan, v, 1, lab);
+        int il, ia, ib;
+        double fl, fa, fb;
+        sig_axis(lab[0] * SIG_NL - 0.5, SIG_NL, &il, &fl);
+        sig_axis((lab[1] + SIG_AB_RANGE) * (SIG_NA / (2.0 * SIG_AB_RANGE)) - 0.5, SIG_NA, &ia, &fa);
+        sig_axis((lab[2] + SIG_AB_RANGE) * (SIG_NB / (2.0 * SIG_AB_RANGE)) - 0.5, SIG_NB, &ib, &fb);
+        w *= SIG_MASS / total;
+        for (int c = 0; c < 8; ++c)
+        {
+            int dl = c >> 2, da = (c >> 1) & 1, db = c & 1;
+            double cw = (dl ? fl : 1.0 - fl) * (da ? fa : 1.0 - fa) * (db ? fb : 1.0 - fb);
+            acc[((il + dl) * SIG_NA + ia + da) * SIG_NB + ib + db] += w * cw;
+        }
+    }
+    // 最大余数法取整，使总质量恰为 255：相同调色板的交集正好是 1
+    int left = (int)SIG_MASS;
+    for (int k = 0; k < SIG_BINS; ++k)
+    {
+        double q = floor(acc[k]);
+        sig[k] = (uint8_t)q;
+        acc[k] -= q;
+        left -= sig[k];
+    }
+    for (; left > 0; --left)
+    {
+        int best = 0;
+        for (int k = 1; k < SIG_BINS; ++k)
+            if (acc[k] > acc[best])
+                best = k;
+        sig[best]++;
+        acc[best] = -1.0;
+    }
+}
+
+// ---- 索引写入：签名流式写出，名字攒在内存里，结束时补名字表并回填头 ----
+typedef struct
+{
+    FILE *f;
+    uint64_t count;
+    uint64_t *name_off; // count + 1 项
+    size_t off_cap;
+    char *names;
+    size_t names_len, names_cap;
+} IndexWriter;
+
+static void iw_discard(IndexWriter *w)
+{
+    if (w->f)
+        fclose(w->f);
+    free(w->name_off);
+    free(w->names);
+    memset(w, 0, sizeof *w);
+}
+
+static int iw_open(IndexWriter *w, const char *path)
+{
+    memset(w, 0, sizeof *w);
+    w->f = fopen(path, "wb");
+    if (!w->f)
+        return -1;
+    IndexHeader h;
+    memset(&h, 0, sizeof h); // 头最后回填；中途失败时留下的文件 magic 为空，打不开
+    if (fwrite(&h, sizeof h, 1, w->f) != 1)
+    {
+        iw_discard(w);
+        return -1;
+    }
+    return 0;
+}
+
+static int iw_add(IndexWriter *w, const uint8_t *sig, const char *id)
+{
+    size_t len = strlen(id) + 1;
+    if (w->count + 2 > w->off_cap)
+    {
+        size_t cap = w->off_cap ? w->off_cap * 2 : 1024;
+        uint64_t *no = (uint64_t *)realloc(w->name_off, cap * sizeof(uint64_t));
+        if (!no)
+            return -1;
+        w->name_off = no;
+        w->off_cap = cap;
+    }
+    if (w->names_len + len > w->names_cap)
+    {
+        size_t cap = w->names_cap ? w->names_cap * 2 : 65536;
+        while (cap < w->names_len + len)
+            cap *= 2;
+        char *nn = (char *)realloc(w->names, cap);
+        if (!nn)
+            return -1;
+        w->names = nn;
+        w->names_cap = cap;
+    }
+    if (fwrite(sig, SIG_BINS, 1, w->f) != 1)
+        return -1;
+    w->name_off[w->count++] = w->names_len;
+    memcpy(w->names + w->names_len, id, len);
+    w->names_len += len;
+    return 0;
+}
+
+// 成功返回 0；无论成败都释放 w
+static int iw_finish(IndexWriter *w)
+{
+    static const uint8_t zeros[8] = {0};
+    uint64_t sig_end = INDEX_HEADER_BYTES + w->count * (uint64_t)SIG_BINS;
+    uint64_t names_offset = (sig_end + 7) & ~(uint64_t)7;
+    int rc = -1;
+    if (!w->name_off && !(w->name_off = (uint64_t *)malloc(sizeof(uint64_t))))
+        goto done;
+    w->name_off[w->count] = w->names_len;
+    if (fwrite(zeros, 1, (size_t)(names_offset - sig_end), w->f) != (size_t)(names_offset - sig_end) ||
+        fwrite(w->name_off, sizeof(uint64_t), (size_t)w->count + 1, w->f) != (size_t)w->count + 1 ||
+        (w->names_len && fwrite(w->names, 1, w->names_len, w->f) != w->names_len))
+        goto done;
+    IndexHeader h;
+    memset(&h, 0, sizeof h);
+    memcpy(h.magic, INDEX_MAGIC, 8);
+    h.bins = SIG_BINS;
+    h.count = w->count;
+    h.names_offset = names_offset;
+    if (fseek(w->f, 0, SEEK_SET) != 0 || fwrite(&h, sizeof h, 1, w->f) != 1)
+        goto done;
+    rc = fclose(w->f) == 0 ? 0 : -1;
+    w->f = NULL;
+done:
+    iw_discard(w);
+    return rc;
+}
+
+// ---- 索引读取（mmap） ----
+typedef struct
+{
+    const uint8_t *base;
+    size_t size;
+    uint64_t count;
+    const uint8_t *sigs;
+    const uint64_t *name_off;
+    const char *names;
+} PaletteIndex;
+
+static int index_open(PaletteIndex *ix, const char *path)
+{
+    memset(ix, 0, sizeof *ix);
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return -1;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (uint64_t)st.st_size < INDEX_HEADER_BYTES)
+    {
+        close(fd);
+        return -1;
+    }
+    void *m = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (m == MAP_FAILED)
+        return -1;
+    const IndexHeader *h = (const IndexHeader *)m;
+    uint64_t size = (uint64_t)st.st_size;
+    // 逐项核对，避免截断或损坏的文件让查询越界
+    int ok = memcmp(h->magic, INDEX_MAGIC, 8) == 0 && h->bins == SIG_BINS &&
+             h->count <= (size - INDEX_HEADER_BYTES) / SIG_BINS && h->names_offset % 8 == 0 &&
+             h->names_offset >= INDEX_HEADER_BYTES + h->count * SIG_BINS && h->names_offset <= size && (size - h->names_offset) / 8 > h->count;
+    if (ok)
+    {
+        const uint64_t *off = (const uint64_t *)((const uint8_t *)m + h->names_offset);
+        uint64_t blob = h->names_offset + (h->count + 1) * 8;
+        const char *names = (const char *)m + blob;
+        ok = off[0] == 0 && off[h->count] <= size - blob;
+        // 每个名字非空且以 NUL 结尾
+        for (uint64_t i = 0; ok && i < h->count; ++i)
+            ok = off[i] < off[i + 1] && names[off[i + 1] - 1] == '\0';
+        if (ok)
+        {
+            ix->count = h->count;
+            ix->name_off = off;
+            ix->names = names;
+        }
+    }
+    if (!ok)
+    {
+        munmap(m, (size_t)st.st_size);
+        return -1;
+    }
+    ix->base = (const uint8_t *)m;
+    ix->size = (size_t)st.st_size;
+    ix->sigs = ix->base + INDEX_HEADER_BYTES;
+    return 0;
+}
+
+static void index_close(PaletteIndex *ix)
+{
+    if (ix->base)
+        munmap((void *)ix->base, ix->size);
+    memset(ix, 0, sizeof *ix);
+}
+
+static const char *index_name(const PaletteIndex *ix, uint64_t i)
+{
+    return ix->names + ix->name_off[i];
+}
+
+// ---- 扫描内核：n 条签名各自与查询签名的交集（整数分数 0..255） ----
+static INLINE void scan_rows_body(const uint8_t *q, const uint8_t *sigs, size_t n, uint32_t *score)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        const uint8_t *s = sigs + i * SIG_BINS;
+        uint32_t acc = 0;
+        for (int k = 0; k < SIG_BINS; ++k)
+            acc += q[k] < s[k] ? q[k] : s[k];
+        score[i] = acc;
+    }
+}
+
+// ---- 运行时 CPU 分派（档位检测见 cpu_dispatch.h）----
+// 扫描内核按 baseline / AVX2 / AVX-512 各编译一份，进程启动时按 CPUID 选定一次；
+// 环境变量 OKCOLOR_CPU=baseline|avx2|avx512 可强制降级（同 oklch2rgb / rgb2oklch）。
+
+static void scan_rows_baseline(const uint8_t *q, const uint8_t *sigs, size_t n, uint32_t *score)
+{
+    scan_rows_body(q, sigs, n, score);
+}
+
+#ifdef HAVE_X86_DISPATCH
+__attribute__((target("avx2,fma"))) static void scan_rows_avx2(const uint8_t *q, const uint8_t *sigs, size_t n,
+                                                               uint32_t *score)
+{
+    scan_rows_body(q, sigs, n, score);
+}
+
+__attribute__((target("avx512f,avx512vl,avx512dq,avx512bw,avx2,fma"))) static void
+scan_rows_avx512(const uint8_t *q, const uint8_t *sigs, size_t n, uint32_t *score)
+{
+    scan_rows_body(q, sigs, n, score);
+}
+#endif
+
+static void (*g_scan_rows)(const uint8_t *q, const uint8_t *sigs, size_t n, uint32_t *score) = scan_rows_baseline;
+static const char *g_cpu_path = "baseline";
+
+// 构造函数在 main / dlopen 返回前执行，之后只读，无需同步
+__attribute__((constructor)) static void select_cpu_path(void)
+{
+#ifdef HAVE_X86_DISPATCH
+    switch (detect_cpu_level())
+    {
+    case CPU_LEVEL_AVX512:
+        g_scan_rows = scan_rows_avx512;
+        g_cpu_path = "avx512";
+        return;
+    case CPU_LEVEL_AVX2:
+        g_scan_rows = scan_rows_avx2;
+        g_cpu_path = "avx2";
+        return;
+    default:
+        break;
+    }
+#endif
+    g_scan_rows = scan_rows_baseline;
+    g_cpu_path = "baseline";
+}
+
+// ---- top-k 查询 ----
+#define SCAN_BLOCK 4096
+#define SCAN_MAX_K 4096
+
+typedef struct
+{
+    uint32_t score;
+    uint64_t index;
+} ScanHit;
+
+// 排序次序：分数高者在前，同分按下标升序（结果与线程数无关）
+static int hit_better(const ScanHit *a, const ScanHit *b)
+{
+    return a->score != b->score ? a->score > b->score : a->index < b->index;
+}
+
+static int hit_cmp(const void *pa, const void *pb)
+{
+    const ScanHit *a = (const ScanHit *)pa, *b = (const ScanHit *)pb;
+    return hit_better(a, b) ? -1 : hit_better(b, a) ? 1 : 0;
+}
+
+// 小顶堆（堆顶为当前 top-k 中最差的一条）
+static void heap_sift_down(ScanHit *h, int n, int i)
+{
+    for (;;)
+    {
+        int l = 2 * i + 1, r = l + 1, m = i;
+        if (l < n && hit_better(&h[m], &h[l]))
+            m = l;
+        if (r < n && hit_better(&h[m], &h[r]))
+            m = r;
+        if (m == i)
+            return;
+        ScanHit t = h[i];
+        h[i] = h[m];
+        h[m] = t;
+        i = m;
+    }
+}
+
+static void heap_push(ScanHit *h, int *n, ScanHit v)
+{
+    int i = (*n)++;
+    while (i > 0)
+    {
+        int p = (i - 1) / 2;
+        if (!hit_better(&h[p], &v))
+            break;
+        h[i] = h[p];
+        i = p;
+    }
+    h[i] = v;
+}
+
+typedef struct
+{
+    const PaletteIndex *ix;
+    const uint8_t *q;
+    int k;
+    atomic_size_t *next;
+    size_t nblocks;
+    ScanHit *heap; // k 项
+    int size;
+} ScanWorker;
+
+static void scan_worker_run(ScanWorker *w)
+{
+    uint32_t score[SCAN_BLOCK];
+    for (;;)
+    {
+        size_t blk = atomic_fetch_add_explicit(w->next, 1, memory_order_relaxed);
+        if (blk >= w->nblocks)
+            return;
+        size_t i0 = blk * SCAN_BLOCK;
+        size_t m = w->ix->count - i0 < SCAN_BLOCK ? (size_t)(w->ix->count - i0) : SCAN_BLOCK;
+        g_scan_rows(w->q, w->ix->sigs + i0 * SIG_BINS, m, score);
+        for (size_t j = 0; j < m; ++j)
+        {
+            // 块内下标递增：与堆顶同分的后来者必然更差
+            if (w->size == w->k && score[j] <= w->heap[0].score)
+                continue;
+            ScanHit v = {score[j], i0 + j};
+            if (w->size < w->k)
+                heap_push(w->heap, &w->size, v);
+            else
+            {
+                w->heap[0] = v;
+                heap_sift_down(w->heap, w->size, 0);
+            }
+        }
+    }
+}
+
+static void scan_task(void *arg)
+{
+    scan_worker_run((ScanWorker *)arg);
+}
+
+// 返回与 q 最相似的至多 k 条（按 hit_cmp 排序）写入 out，返回条数；参数无效或内存不足返回 -1。
+// threads <= 0 表示按在线 CPU 数
+static int index_query(const PaletteIndex *ix, const uint8_t *q, int k, int threads, ScanHit *out)
+{
+    if (k <= 0 || k > SCAN_MAX_K)
+        return -1;
+    if ((uint64_t)k > ix->count)
+        k = (int)ix->count;
+    if (k == 0)
+        return 0;
+    size_t nblocks = (size_t)((ix->count + SCAN_BLOCK - 1) / SCAN_BLOCK);
+    threads = pool_thread_count(threads, nblocks);
+
+    ScanHit *heaps = (ScanHit *)malloc((size_t)threads * k * sizeof(ScanHit));
+    if (!heaps)
+        return -1;
+    ScanWorker w[POOL_MAX_THREADS];
+    atomic_size_t next = 0;
+    for (int t = 0; t < threads; ++t)
+        w[t] = (ScanWorker){ix, q, k, &next, nblocks, heaps + (size_t)t * k, 0};
+
+    // 线程创建失败无妨：剩余块会被其它线程领走（该线程的堆保持为空）
+    pool_run(threads, scan_task, w, sizeof w[0]);
+
+    // 各堆紧凑到一起后整体排序取前 k
+    size_t total = 0;
+    for (int t = 0; t < threads; ++t)
+    {
+        memmove(heaps + total, w[t].heap, (size_t)w[t].size * sizeof(ScanHit));
+        total += (size_t)w[t].size;
+    }
+    qsort(heaps, total, sizeof(ScanHit), hit_cmp);
+    memcpy(out, heaps, (size_t)k * sizeof(ScanHit));
+    free(heaps);
+    return k;
+}
+
+#ifdef OKCOLOR_EMBED
+// ---- libokcolor 导出（见 okcolor.h）----
+struct okc_palette_index
+{
+    PaletteIndex ix;
+};
+
+OKC_API void okc_palette_signature(const okc_color *colors, int n, uint8_t *sig)
+{
+    double *rgb = n > 0 ? (double *)malloc((size_t)n * 4 * sizeof(double)) : NULL;
+    if (!rgb)
+    {
+        memset(sig, 0, SIG_BINS);
+        return;
+    }
+    double *w = rgb + (size_t)n * 3;
+    for (int i = 0; i < n; ++i)
+    {
+        rgb[i * 3 + 0] = colors[i].red;
+        rgb[i * 3 + 1] = colors[i].green;
+        rgb[i * 3 + 2] = colors[i].blue;
+        w[i] = colors[i].area;
+    }
+    palette_signature(rgb, w, (size_t)n, sig);
+    free(rgb);
+}
+
+OKC_API int okc_palette_index_write(const char *path, const uint8_t *sigs, const char *const *ids, size_t n)
+{
+    IndexWriter w;
+    if (iw_open(&w, path) != 0)
+        return -1;
+    for (size_t i = 0; i < n; ++i)
+        if (iw_add(&w, sigs + i * SIG_BINS, ids[i]) != 0)
+        {
+            iw_discard(&w);
+            return -1;
+        }
+    return iw_finish(&w);
+}
+
+OKC_API okc_palette_index *okc_palette_index_open(const char *path)
+{
+    okc_palette_index *idx = (okc_palette_index *)malloc(sizeof *idx);
+    if (idx && index_open(&idx->ix, path) != 0)
+    {
+        free(idx);
+        idx = NULL;
+    }
+    return idx;
+}
+
+OKC_API uint64_t okc_palette_index_count(const okc_palette_index *idx)
+{
+    return idx->ix.count;
+}
+
+OKC_API int okc_palette_index_query(const okc_palette_index *idx, const uint8_t *sig, int k, int threads,
+                                    okc_palette_hit *hits)
+{
+    ScanHit *tmp = k > 0 ? (ScanHit *)malloc((size_t)k * sizeof(ScanHit)) : NULL;
+    if (!tmp)
+        return -1;
+    int m = index_query(&idx->ix, sig, k, threads, tmp);
+    for (int i = 0; i < m; ++i)
+        hits[i] = (okc_palette_hit){tmp[i].score / SIG_MASS, tmp[i].index, index_name(&idx->ix, tmp[i].index)};
+    free(tmp);
+    return m;
+}
+
+OKC_API void okc_palette_index_close(okc_palette_index *idx)
+{
+    if (!idx)
+        return;
+    index_close(&idx->ix);
+    free(idx);
+}
+#endif
+
+#ifndef OKCOLOR_EMBED
+// ---- CLI ----
+// 读一个调色板：extract-colors 的 JSON（每个对象一行，取 "hex" 与 "area"），或每行 "#rrggbb [权重]"；
+// 空行、"[" 与 "]" 忽略。成功返回颜色数（可为 0），解析失败返回 -1
+static long read_palette(FILE *f, double **rgb_out, double **w_out)
+{
+    double *rgb = NULL, *w = NULL;
+    size_t n = 0, cap = 0;
+    char line[1024];
+    while (fgets(line, sizeof line, f))
+    {
+        const char *end = line + strlen(line);
+        const char *p = css_skip_space(line, end);
+        while (end > p && css_is_space(end[-1]))
+            end--;
+        if (p == end || (end - p == 1 && (*p == '[' || *p == ']')))
+            continue;
+        double weight = 1.0;
+        const char *hex = strstr(p, "\"hex\": \"#");
+        if (hex)
+        {
+            const char *area = strstr(p, "\"area\": ");
+            if (area)
+                weight = strtod(area + 8, NULL);
+            p = hex + 8;
+        }
+        CssColor c;
+        const char *q = *p == '#' ? css_parse_hex(p + 1, end, &c) : NULL;
+        if (!q)
+            goto fail;
+        if (!hex)
+        {
+            q = css_skip_space(q, end);
+            if (q != end && (!css_parse_number(&q, end, &weight) || css_skip_space(q, end) != end))
+                goto fail;
+        }
+        if (n == cap)
+        {
+            cap = cap ? cap * 2 : 64;
+            double *nr = (double *)realloc(rgb, cap * 3 * sizeof(double));
+            if (!nr)
+                goto fail;
+            rgb = nr;
+            double *nw = (double *)realloc(w, cap * sizeof(double));
+            if (!nw)
+                goto fail;
+            w = nw;
+        }
+        memcpy(rgb + n * 3, c.v, 3 * sizeof(double));
+        w[n++] = weight;
+    }
+    *rgb_out = rgb;
+    *w_out = w;
+    return (long)n;
+fail:
+    free(rgb);
+    free(w);
+    return -1;
+}
+
+static int signature_from_file(const char *path, uint8_t *sig)
+{
+    FILE *f = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+    if (!f)
+        return -1;
+    double *rgb = NULL, *w = NULL;
+    long n = read_palette(f, &rgb, &w);
+    if (f != stdin)
+        fclose(f);
+    if (n < 0)
+        return -1;
+    palette_signature(rgb, w, (size_t)n, sig);
+    free(rgb);
+    free(w);
+    return 0;
+}
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+// stdin 每行一个调色板文件路径，路径即条目名
+static int run_build(const char *out)
+{
+    IndexWriter w;
+    if (iw_open(&w, out) != 0)
+    {
+        fprintf(stderr, "Cannot create %s\n", out);
+        return 1;
+    }
+    double t0 = now_ms();
+    char line[4096];
+    long lineno = 0;
+    while (fgets(line, sizeof line, stdin))
+    {
+        lineno++;
+        size_t len = strlen(line);
+        while (len && (line[len - 1] == '\n' || line[len - 1] == '\r'))
+            line[--len] = '\0';
+        if (!len)
+            continue;
+        uint8_t sig[SIG_BINS];
+        if (signature_from_file(line, sig) != 0)
+        {
+            fprintf(stderr, "Failed to read palette %s (line %ld)\n", line, lineno);
+            iw_discard(&w);
+            return 1;
+        }
+        if (iw_add(&w, sig, line) != 0)
+        {
+            fprintf(stderr, "Failed to write %s\n", out);
+            iw_discard(&w);
+            return 1;
+        }
+    }
+    uint64_t count = w.count;
+    if (iw_finish(&w) != 0)
+    {
+        fprintf(stderr, "Failed to write %s\n", out);
+        return 1;
+    }
+    fprintf(stderr, "palette_index: %llu signatures in %.1f ms\n", (unsigned long long)count, now_ms() - t0);
+    return 0;
+}
+
+// 输出 k 行 "相似度 名字"，按相似度降序
+static int run_query(const char *index_path, const char *palette, int k, int threads)
+{
+    uint8_t q[SIG_BINS];
+    if (signature_from_file(palette, q) != 0)
+    {
+        fprintf(stderr, "Failed to read palette %s\n", palette);
+        return 1;
+    }
+    PaletteIndex ix;
+    if (index_open(&ix, index_path) != 0)
+    {
+        fprintf(stderr, "Cannot open index %s\n", index_path);
+        return 1;
+    }
+    ScanHit *hits = (ScanHit *)malloc((size_t)k * sizeof(ScanHit));
+    double t0 = now_ms();
+    int m = hits ? index_query(&ix, q, k, threads, hits) : -1;
+    double ms = now_ms() - t0;
+    if (m < 0)
+    {
+        fprintf(stderr, "Query failed.\n");
+        free(hits);
+        index_close(&ix);
+        return 1;
+    }
+    for (int i = 0; i < m; ++i)
+        printf("%.4f %s\n", hits[i].score / SIG_MASS, index_name(&ix, hits[i].index));
+    fprintf(stderr, "palette_index: scanned %llu signatures in %.2f ms (%s)\n", (unsigned long long)ix.count, ms,
+            g_cpu_path);
+    free(hits);
+    index_close(&ix);
+    return 0;
+}
+
+static void print_usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage:\n"
+            "  %s build OUT.okpi < paths.txt\n"
+            "  %s query INDEX.okpi PALETTE.json|- [-k K] [--threads N]\n"
+            "  %s --cpu-info\n\n"
+            "Palette files are extract-colors JSON output (\"hex\" weighted by \"area\"),\n"
+            "or one \"#rrggbb [weight]\" per line. Query prints \"similarity id\" lines, best first;\n"
+            "similarity is the histogram intersection of OKLab signatures (1 = identical).\n",
+            prog, prog, prog);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc == 2 && strcmp(argv[1], "--cpu-info") == 0)
+    {
+        print_cpu_info(g_cpu_path);
+        return 0;
+    }
+    if (argc == 3 && strcmp(argv[1], "build") == 0)
+        return run_build(argv[2]);
+    if (argc >= 4 && strcmp(argv[1], "query") == 0)
+    {
+        int k = 10, threads = 0;
+        for (int i = 4; i < argc; ++i)
+        {
+            if (strcmp(argv[i], "-k") == 0 && i + 1 < argc)
+                k = atoi(argv[++i]);
+            else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+                threads = atoi(argv[++i]);
+            else
+            {
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
+        if (k <= 0 || k > SCAN_MAX_K)
+        {
+            fprintf(stderr, "-k must be in 1..%d\n", SCAN_MAX_K);
+            return 1;
+        }
+        return run_query(argv[2], argv[3], k, threads);
+    }
+    print_usage(argv[0]);
+    return 1;
+}
+#endif
@@ -8,18 +8,44 @@
 // - 输入：三个命令行参数 R G B（0–255，按 sRGB 8 位分量解释）
 // - 输出：打印三个数值 "L C h"（当 C≈0 时，h 被强制为 0）
 
+// 原生构建用到 POSIX 线程与 sysconf；-std=c11 下 glibc 需显式打开
+#if !defined(__EMSCRIPTEN__) && !defined(__APPLE__) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <limits.h>
 #include <math.h>
 #include <stdint.h>
 #include <stddef.h>
+#include <stdatomic.h>
+
+#ifdef OKCOLOR_EMBED
+#include "okcolor.h"
+#endif
+#if !defined(__EMSCRIPTEN__) && !defined(OKCOLOR_EMBED)
+#include "css_color.h"
+#endif
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
 
+// 热路径整条调用链强制内联，使各 ISA 变体的批量内核（见「运行时 CPU 分派」）各自完整展开
+#ifndef INLINE
+#define INLINE inline __attribute__((always_inline))
+#endif
+
+#include "color_space.h"
+#include "polar.h"
+#include "srgb8.h"
+#ifndef __EMSCRIPTEN__
+#include "cpu_dispatch.h"
+#endif
+
 typedef struct
 {
     double r; // 0..255
@@ -34,7 +60,7 @@ typedef struct
     double h; // hue in degrees [0,360)
 } OKLCH;
 
-static double clamp(double x, double lo, double hi)
+static INLINE double clamp(double x, double lo, double hi)
 {
     if (x < lo)
         return lo;
@@ -43,6 +69,7 @@ static double clamp(double x, double lo, double hi)
     return x;
 }
 
+#if !defined(__EMSCRIPTEN__) && !defined(OKCOLOR_EMBED)
 // 解析一个 0..255 的纯数字，不允许出现 %
 static int parse_0_255_number(const char *s, double *out)
 {
@@ -63,10 +90,11 @@ static int parse_0_255_number(const char *s, double *out)
     *out = clamp(val, 0.0, 255.0);
     return 1;
 }
+#endif
 
-// 不做 CSS 解析；仅支持数值型命令行输入。
+// 单次模式不做 CSS 解析，仅支持数值型命令行输入；批量模式另见 css_color.h。
 
-static double srgb_to_linear(double u)
+static INLINE double srgb_to_linear(double u)
 {
     // u 为 0..1 的 sRGB
     if (u <= 0.04045)
@@ -75,12 +103,23 @@ static double srgb_to_linear(double u)
 }
 
 // 针对 8 位 sRGB 输入的快速解码查表（用于 Wasm 导出路径）
-static int g_gamma_lut_inited = 0;
+// 线程安全的一次性初始化：0=未初始化，1=填表中，2=已发布。
+// CAS 成功的线程填表后以 release 发布；其余线程自旋等待（仅 256 项，极短）。
+static atomic_int g_gamma_lut_state = 0;
 static double g_srgb_u8_to_linear[256];
+static float g_srgb_u8_to_linear_f[256]; // 同表的 float 版（合成内核用）
 static inline void ensure_gamma_lut(void)
 {
-    if (g_gamma_lut_inited)
+    if (atomic_load_explicit(&g_gamma_lut_state, memory_order_acquire) == 2)
+        return;
+    int expected = 0;
+    if (!atomic_compare_exchange_strong_explicit(&g_gamma_lut_state, &expected, 1, memory_order_acquire,
+                                                 memory_order_acquire))
+    {
+        while (atomic_load_explicit(&g_gamma_lut_state, memory_order_acquire) != 2)
+            ;
         return;
+    }
     for (int i = 0; i < 256; ++i)
     {
         double u = (double)i / 255.0;
@@ -88,22 +127,14 @@ static inline void ensure_gamma_lut(void)
             g_srgb_u8_to_linear[i] = u / 12.92;
         else
             g_srgb_u8_to_linear[i] = pow((u + 0.055) / 1.055, 2.4);
+        g_srgb_u8_to_linear_f[i] = (float)g_srgb_u8_to_linear[i];
     }
-    g_gamma_lut_inited = 1;
+    atomic_store_explicit(&g_gamma_lut_state, 2, memory_order_release);
 }
 
-static OKLCH rgb_to_oklch(RGB255 in)
+// 线性 sRGB（0..1）-> OKLab
+static INLINE void linear_srgb_to_oklab(double r, double g, double b, double *L, double *a, double *bb)
 {
-    // 归一化到 0..1 的 sRGB
-    double rs = clamp(in.r / 255.0, 0.0, 1.0);
-    double gs = clamp(in.g / 255.0, 0.0, 1.0);
-    double bs = clamp(in.b / 255.0, 0.0, 1.0);
-
-    // 线性化
-    double r = srgb_to_linear(rs);
-    double g = srgb_to_linear(gs);
-    double b = srgb_to_linear(bs);
-
     // 通过 OKLab 矩阵将线性 sRGB 转为 LMS
     double l_ = 0.4122214708 * r + 0.5363325363 * g + 0.0514459929 * b;
     double m_ = 0.2119034982 * r + 0.6806995451 * g + 0.1073969566 * b;
@@ -115,31 +146,901 @@ static OKLCH rgb_to_oklch(RGB255 in)
     double s = cbrt(s_);
 
     // OKLab
-    double L = 0.2104542553 * l + 0.7936177850 * m - 0.0040720468 * s;
-    double a = 1.9779984951 * l - 2.4285922050 * m + 0.4505937099 * s;
-    double bb = 0.0259040371 * l + 0.7827717662 * m - 0.8086757660 * s;
+    *L = 0.2104542553 * l + 0.7936177850 * m - 0.0040720468 * s;
+    *a = 1.9779984951 * l - 2.4285922050 * m + 0.4505937099 * s;
+    *bb = 0.0259040371 * l + 0.7827717662 * m - 0.8086757660 * s;
+}
 
-    // OKLCH
+// OKLab -> OKLCH 的极坐标部分；atan2 为 polar.h 的多项式版，无分支，放在循环里可向量化
+static INLINE OKLCH oklab_to_oklch(double L, double a, double bb)
+{
     double C = sqrt(a * a + bb * bb);
-    double h = 0.0;
-    if (C > 1e-12)
+    double h = polar_atan2_deg(bb, a);
+    // 近乎无彩（接近灰阶）时，强制 C、h 为 0 以符合预期标准
+    OKLCH out = (OKLCH){L, C > 1e-12 ? C : 0.0, C > 1e-12 ? h : 0.0};
+    return out;
+}
+
+// 线性 sRGB（0..1）-> OKLCH
+static INLINE OKLCH linear_srgb_to_oklch(double r, double g, double b)
+{
+    double L, a, bb;
+    linear_srgb_to_oklab(r, g, b, &L, &a, &bb);
+    return oklab_to_oklch(L, a, bb);
+}
+
+static INLINE OKLCH rgb_to_oklch(RGB255 in)
+{
+    // 归一化到 0..1 的 sRGB
+    double rs = clamp(in.r / 255.0, 0.0, 1.0);
+    double gs = clamp(in.g / 255.0, 0.0, 1.0);
+    double bs = clamp(in.b / 255.0, 0.0, 1.0);
+
+    // 线性化
+    double r = srgb_to_linear(rs);
+    double g = srgb_to_linear(gs);
+    double b = srgb_to_linear(bs);
+
+    return linear_srgb_to_oklch(r, g, b);
+}
+
+// ---- 调色板去重：deltaEOK（OKLab 欧氏距离）阈值近邻 ----
+// 颜色只转换一次（8 位查表 + 上面的 OKLab 矩阵），按 L 升序存为 float SoA。
+// |ΔL| 超过阈值的对不可能命中，故每行只扫描 L 窗口 [i+1, lim[i]) 内的列；
+// 列按 DEDUP_TILE 分块，一个行块遍历同一列块时列数据常驻 L1。
+// 内层距离循环无分支，可被自动向量化（各 ISA 变体见「运行时 CPU 分派」），命中才进入标量路径。
+#define DEDUP_TILE 256
+
+typedef struct
+{
+    uint32_t i, j; // 原始下标，i < j
+    float d;       // deltaEOK
+} DedupPair;
+
+typedef struct
+{
+    const float *L, *a, *b; // 按 L 升序
+    const uint32_t *idx;    // 排序位置 -> 原始下标
+    const uint32_t *lim;    // 行 i 的列窗口上界（不含），随 i 单调不减
+    size_t n;
+    float thr2;
+} DedupSet;
+
+// 命中的去向：parent 非 NULL 时并入并查集，否则追加到 pairs
+typedef struct
+{
+    uint32_t *parent;
+    DedupPair *pairs;
+    size_t count, cap;
+    int oom;
+} DedupSink;
+
+static INLINE uint32_t uf_find(uint32_t *parent, uint32_t x)
+{
+    while (parent[x] != x)
+    {
+        parent[x] = parent[parent[x]]; // 路径减半
+        x = parent[x];
+    }
+    return x;
+}
+
+// 总以较小下标为根，合并结束后根即分量内最小的原始下标
+static INLINE void uf_union(uint32_t *parent, uint32_t x, uint32_t y)
+{
+    x = uf_find(parent, x);
+    y = uf_find(parent, y);
+    if (x < y)
+        parent[y] = x;
+    else if (y < x)
+        parent[x] = y;
+}
+
+// 追加一个命中对（pairs 模式）
+static void dedup_emit(DedupSink *sink, uint32_t x, uint32_t y, float d2)
+{
+    if (sink->count == sink->cap)
+    {
+        size_t cap = sink->cap ? sink->cap * 2 : 256;
+        DedupPair *np = (DedupPair *)realloc(sink->pairs, cap * sizeof(DedupPair));
+        if (!np)
+        {
+            sink->oom = 1;
+            return;
+        }
+        sink->pairs = np;
+        sink->cap = cap;
+    }
+    DedupPair *p = &sink->pairs[sink->count++];
+    p->i = x < y ? x : y;
+    p->j = x < y ? y : x;
+    p->d = sqrtf(d2);
+}
+
+// 处理排序后的行 [i0, i1) 与其右侧窗口内的所有列
+static INLINE void dedup_rows_body(const DedupSet *set, size_t i0, size_t i1, DedupSink *sink)
+{
+    const float *restrict Lp = set->L;
+    const float *restrict ap = set->a;
+    const float *restrict bp = set->b;
+    const float thr2 = set->thr2;
+    float d2[DEDUP_TILE];
+    size_t jend = set->lim[i1 - 1];
+    for (size_t j0 = i0 + 1; j0 < jend; j0 += DEDUP_TILE)
+    {
+        size_t j1 = j0 + DEDUP_TILE < jend ? j0 + DEDUP_TILE : jend;
+        for (size_t i = i0; i < i1; ++i)
+        {
+            size_t js = i + 1 > j0 ? i + 1 : j0;
+            size_t je = set->lim[i] < j1 ? set->lim[i] : j1;
+            if (js >= je)
+                continue;
+            const float Li = Lp[i], ai = ap[i], bi = bp[i];
+            const size_t m = je - js;
+            int any = 0;
+            for (size_t k = 0; k < m; ++k)
+            {
+                float dl = Lp[js + k] - Li;
+                float da = ap[js + k] - ai;
+                float db = bp[js + k] - bi;
+                d2[k] = dl * dl + da * da + db * db;
+                any |= d2[k] <= thr2;
+            }
+            // 绝大多数行段没有命中：跳过逐项扫描
+            if (!any)
+                continue;
+            if (!sink->parent)
+            {
+                for (size_t k = 0; k < m; ++k)
+                    if (d2[k] <= thr2)
+                        dedup_emit(sink, set->idx[i], set->idx[js + k], d2[k]);
+                continue;
+            }
+            // 并查集模式：行 i 的根只求一次，命中列已在同一分量时不再合并
+            uint32_t *parent = sink->parent;
+            uint32_t ri = uf_find(parent, set->idx[i]);
+            for (size_t k = 0; k < m; ++k)
+            {
+                if (d2[k] > thr2)
+                    continue;
+                uint32_t rj = uf_find(parent, set->idx[js + k]);
+                if (rj < ri)
+                {
+                    parent[ri] = rj;
+                    ri = rj;
+                }
+                else if (ri < rj)
+                    parent[rj] = ri;
+            }
+        }
+    }
+}
+
+// ---- OKLab 合成：两幅非预乘 RGBA8 在 OKLab 中按模式混合后做 source-over ----
+// 每 BLEND_TILE 像素一块：查表线性化（标量）-> OKLab（快速立方根）-> 混合与合成 -> 线性 sRGB
+// -> 查表编码（标量）。中间量为 float SoA，一块约 12 KB 常驻 L1；中间各段无分支，可自动向量化。
+#define BLEND_NORMAL 0     // 取前景
+#define BLEND_LIGHTEN 1    // L 较大者的整色
+#define BLEND_DARKEN 2     // L 较小者的整色
+#define BLEND_LUMINOSITY 3 // 前景 L + 背景 a/b
+#define BLEND_COLOR 4      // 背景 L + 前景 a/b
+#define BLEND_HUE 5        // 背景 L、C + 前景色相
+#define BLEND_CHROMA 6     // 背景 L、色相 + 前景 C
+#define BLEND_MODES 7
+#define BLEND_TILE 256
+
+// 快速立方根：指数除以 3 的位运算初值（相对误差约 3%），两步 Halley 迭代（三阶收敛）后达 float 精度。
+// 输入下限 1e-30 避免立方落入非规格数（-ffast-math 下会被冲零）
+static INLINE float fast_cbrtf(float x)
+{
+    x = x > 1e-30f ? x : 1e-30f;
+    union
+    {
+        float f;
+        uint32_t u;
+    } v = {x};
+    v.u = v.u / 3u + 709921077u;
+    float y = v.f;
+    for (int k = 0; k < 2; ++k)
+    {
+        float y3 = y * y * y;
+        y = y * (y3 + 2.0f * x) / (2.0f * y3 + x);
+    }
+    return y;
+}
+
+// 一块 RGBA8 -> OKLab SoA 与 alpha（0..1）
+static INLINE void blend_load(const uint8_t *px, size_t m, float *L, float *A, float *B, float *alpha)
+{
+    float r[BLEND_TILE], g[BLEND_TILE], b[BLEND_TILE];
+    for (size_t k = 0; k < m; ++k)
+    {
+        r[k] = g_srgb_u8_to_linear_f[px[k * 4 + 0]];
+        g[k] = g_srgb_u8_to_linear_f[px[k * 4 + 1]];
+        b[k] = g_srgb_u8_to_linear_f[px[k * 4 + 2]];
+        alpha[k] = px[k * 4 + 3] * (1.0f / 255.0f);
+    }
+    for (size_t k = 0; k < m; ++k)
+    {
+        float l = fast_cbrtf(0.4122214708f * r[k] + 0.5363325363f * g[k] + 0.0514459929f * b[k]);
+        float mm = fast_cbrtf(0.2119034982f * r[k] + 0.6806995451f * g[k] + 0.1073969566f * b[k]);
+        float s = fast_cbrtf(0.0883024619f * r[k] + 0.2817188376f * g[k] + 0.6299787005f * b[k]);
+        L[k] = 0.2104542553f * l + 0.7936177850f * mm - 0.0040720468f * s;
+        A[k] = 1.9779984951f * l - 2.4285922050f * mm + 0.4505937099f * s;
+        B[k] = 0.0259040371f * l + 0.7827717662f * mm - 0.8086757660f * s;
+    }
+}
+
+// 混合函数 B(背景, 前景)：色相/彩度按 a/b 向量缩放求得，不需要三角函数。
+// 近乎无彩的颜色色相无定义（float 下灰阶的 a/b 只剩舍入噪声）：HUE 模式保留背景，CHROMA 模式结果仍为灰
+static INLINE void blend_mix(int mode, float Lb, float ab, float bb, float Ls, float as, float bs, float *L, float *a,
+                             float *b)
+{
+    const float eps = 1e-4f;
+    switch (mode)
+    {
+    case BLEND_LIGHTEN:
+    case BLEND_DARKEN:
+    {
+        int pick = mode == BLEND_LIGHTEN ? Ls > Lb : Ls < Lb;
+        *L = pick ? Ls : Lb;
+        *a = pick ? as : ab;
+        *b = pick ? bs : bb;
+        return;
+    }
+    case BLEND_LUMINOSITY:
+        *L = Ls;
+        *a = ab;
+        *b = bb;
+        return;
+    case BLEND_COLOR:
+        *L = Lb;
+        *a = as;
+        *b = bs;
+        return;
+    case BLEND_HUE:
+    {
+        float Cb = sqrtf(ab * ab + bb * bb), Cs = sqrtf(as * as + bs * bs);
+        float k = Cb / (Cs > eps ? Cs : eps);
+        *L = Lb;
+        *a = Cs > eps ? as * k : ab;
+        *b = Cs > eps ? bs * k : bb;
+        return;
+    }
+    case BLEND_CHROMA:
+    {
+        float Cb = sqrtf(ab * ab + bb * bb), Cs = sqrtf(as * as + bs * bs);
+        float k = Cb > eps ? Cs / Cb : 0.0f;
+        *L = Lb;
+        *a = ab * k;
+        *b = bb * k;
+        return;
+    }
+    default:
+        *L = Ls;
+        *a = as;
+        *b = bs;
+        return;
+    }
+}
+
+// 混合 + 合成（W3C Compositing：co = αs(1-αb)·Cs + αs·αb·B + (1-αs)αb·Cb，再除以 αo）+ 回到线性 sRGB。
+// mode 为常量实参时每个模式各展开一份无分支循环；超出 sRGB 的结果逐通道裁剪
+static INLINE void blend_composite(int mode, size_t m, float opacity, float *L, float *A, float *B, float *ab,
+                                   const float *sL, const float *sA, const float *sB, const float *as)
+{
+    for (size_t k = 0; k < m; ++k)
+    {
+        float Lm, am, bm;
+        blend_mix(mode, L[k], A[k], B[k], sL[k], sA[k], sB[k], &Lm, &am, &bm);
+        float fa = as[k] * opacity, ba = ab[k];
+        float ao = fa + ba * (1.0f - fa);
+        float inv = ao > 0.0f ? 1.0f / ao : 0.0f;
+        float ws = fa * (1.0f - ba) * inv, wm = fa * ba * inv, wb = (1.0f - fa) * ba * inv;
+        float Lo = ws * sL[k] + wm * Lm + wb * L[k];
+        float Ao = ws * sA[k] + wm * am + wb * A[k];
+        float Bo = ws * sB[k] + wm * bm + wb * B[k];
+
+        float l = Lo + 0.3963377774f * Ao + 0.2158037573f * Bo;
+        float mm = Lo - 0.1055613458f * Ao - 0.0638541728f * Bo;
+        float s = Lo - 0.0894841775f * Ao - 1.2914855480f * Bo;
+        l = l * l * l;
+        mm = mm * mm * mm;
+        s = s * s * s;
+        float r = 4.0767416621f * l - 3.3077115913f * mm + 0.2309699292f * s;
+        float g = -1.2684380046f * l + 2.6097574011f * mm - 0.3413193965f * s;
+        float b = -0.0041960863f * l - 0.7034186147f * mm + 1.7076147010f * s;
+        // 复用 L/A/B/ab 存放线性 RGB 与输出 alpha
+        L[k] = r < 0.0f ? 0.0f : r > 1.0f ? 1.0f : r;
+        A[k] = g < 0.0f ? 0.0f : g > 1.0f ? 1.0f : g;
+        B[k] = b < 0.0f ? 0.0f : b > 1.0f ? 1.0f : b;
+        ab[k] = ao;
+    }
+}
+
+// dst（背景，就地写回）与 src（前景）各 n 个像素；调用前需 ensure_gamma_lut / ensure_srgb8_lut
+static INLINE void blend_body(uint8_t *dst, const uint8_t *src, size_t n, int mode, float opacity)
+{
+    float bL[BLEND_TILE], bA[BLEND_TILE], bB[BLEND_TILE], bAlpha[BLEND_TILE];
+    float sL[BLEND_TILE], sA[BLEND_TILE], sB[BLEND_TILE], sAlpha[BLEND_TILE];
+    for (size_t i0 = 0; i0 < n; i0 += BLEND_TILE)
+    {
+        size_t m = n - i0 < BLEND_TILE ? n - i0 : BLEND_TILE;
+        uint8_t *d = dst + i0 * 4;
+        blend_load(d, m, bL, bA, bB, bAlpha);
+        blend_load(src + i0 * 4, m, sL, sA, sB, sAlpha);
+        switch (mode)
+        {
+#define BLEND_CASE(md)                                                              \
+    case md:                                                                        \
+        blend_composite(md, m, opacity, bL, bA, bB, bAlpha, sL, sA, sB, sAlpha);    \
+        break;
+            BLEND_CASE(BLEND_NORMAL)
+            BLEND_CASE(BLEND_LIGHTEN)
+            BLEND_CASE(BLEND_DARKEN)
+            BLEND_CASE(BLEND_LUMINOSITY)
+            BLEND_CASE(BLEND_COLOR)
+            BLEND_CASE(BLEND_HUE)
+            BLEND_CASE(BLEND_CHROMA)
+#undef BLEND_CASE
+        default:
+            return;
+        }
+        for (size_t k = 0; k < m; ++k)
+        {
+            d[k * 4 + 0] = quantize_srgb8f(bL[k]);
+            d[k * 4 + 1] = quantize_srgb8f(bA[k]);
+            d[k * 4 + 2] = quantize_srgb8f(bB[k]);
+            d[k * 4 + 3] = (uint8_t)(bAlpha[k] * 255.0f + 0.5f);
+        }
+    }
+}
+
+// ---- 色觉缺陷（CVD）模拟 ----
+// Machado、Oliveira、Fernandes（2009）的模拟矩阵，作用于线性 sRGB；表中为严重度 1（二色视）。
+// 严重度 s ∈ [0,1] 取 (1-s)·I + s·M（论文对中间严重度另列矩阵，线性插值只是近似）；每行之和为 1，灰阶不变。
+// 每 BLEND_TILE 像素一块：查表线性化（标量）-> 3×3 矩阵（无分支，可向量化）-> 查表编码（含裁剪）
+#define CVD_PROTAN 0
+#define CVD_DEUTAN 1
+#define CVD_TRITAN 2
+#define CVD_TYPES 3
+
+static const float k_cvd_machado[CVD_TYPES][9] = {
+    {0.152286f, 1.052583f, -0.204868f, 0.114503f, 0.786281f, 0.099216f, -0.003882f, -0.048116f, 1.051998f},
+    {0.367322f, 0.860646f, -0.227968f, 0.280085f, 0.672501f, 0.047413f, -0.011820f, 0.042940f, 0.968881f},
+    {1.255528f, -0.076749f, -0.178779f, -0.078411f, 0.930809f, 0.147602f, 0.004733f, 0.691367f, 0.303900f},
+};
+
+static void cvd_matrix(int type, double severity, float mat[9])
+{
+    for (int k = 0; k < 9; ++k)
+        mat[k] = (float)((1.0 - severity) * (k % 4 == 0) + severity * k_cvd_machado[type][k]);
+}
+
+// n 个 RGBA8 就地替换为模拟结果，alpha 不变；调用前需 ensure_gamma_lut / ensure_srgb8_lut
+static INLINE void cvd_body(uint8_t *rgba, size_t n, const float *mat)
+{
+    float r[BLEND_TILE], g[BLEND_TILE], b[BLEND_TILE];
+    for (size_t i0 = 0; i0 < n; i0 += BLEND_TILE)
+    {
+        size_t m = n - i0 < BLEND_TILE ? n - i0 : BLEND_TILE;
+        uint8_t *px = rgba + i0 * 4;
+        for (size_t k = 0; k < m; ++k)
+        {
+            r[k] = g_srgb_u8_to_linear_f[px[k * 4 + 0]];
+            g[k] = g_srgb_u8_to_linear_f[px[k * 4 + 1]];
+            b[k] = g_srgb_u8_to_linear_f[px[k * 4 + 2]];
+        }
+        for (size_t k = 0; k < m; ++k)
+        {
+            float rr = mat[0] * r[k] + mat[1] * g[k] + mat[2] * b[k];
+            float gg = mat[3] * r[k] + mat[4] * g[k] + mat[5] * b[k];
+            float bb = mat[6] * r[k] + mat[7] * g[k] + mat[8] * b[k];
+            r[k] = rr;
+            g[k] = gg;
+            b[k] = bb;
+        }
+        for (size_t k = 0; k < m; ++k)
+        {
+            px[k * 4 + 0] = quantize_srgb8f(r[k]);
+            px[k * 4 + 1] = quantize_srgb8f(g[k]);
+            px[k * 4 + 2] = quantize_srgb8f(b[k]);
+        }
+    }
+}
+
+#ifndef __EMSCRIPTEN__
+// ---- 运行时 CPU 分派（档位检测见 cpu_dispatch.h）----
+
+// rgb8: n 组 8 位 [R,G,B]（查表线性化，调用前需 ensure_gamma_lut）
+// rgbf: n 组 0..255 浮点 [R,G,B]（与 CLI 单次转换逐位一致）
+// 输出 n 组 [L, C, h]
+typedef struct
+{
+    void (*rgb8)(const uint8_t *rgb, size_t n, double *lch);
+    void (*rgbf)(const double *rgb, size_t n, double *lch);
+    void (*dedup_rows)(const DedupSet *set, size_t i0, size_t i1, DedupSink *sink);
+    void (*blend)(uint8_t *dst, const uint8_t *src, size_t n, int mode, float opacity);
+    void (*convert)(const CsPlan *plan, const double *in, size_t n, double *out);
+    void (*cvd)(uint8_t *rgba, size_t n, const float *mat);
+} Rgb2OklchKernels;
+
+// 批量正向转换每 LCH_CHUNK 个颜色一块：先求 OKLab 存为 SoA（立方根仍走 libm），
+// 再在无分支循环中统一做极坐标换算（sqrt + polar_atan2_deg），该循环按 CPU 分派向量化
+#define LCH_CHUNK 256
+
+static INLINE void oklab_chunk_to_lch(const double *L, const double *a, const double *b, size_t m, double *lch)
+{
+    for (size_t k = 0; k < m; ++k)
+    {
+        OKLCH o = oklab_to_oklch(L[k], a[k], b[k]);
+        lch[k * 3 + 0] = o.L;
+        lch[k * 3 + 1] = o.C;
+        lch[k * 3 + 2] = o.h;
+    }
+}
+
+static INLINE void rgb8_batch_body(const uint8_t *rgb, size_t n, double *lch)
+{
+    double L[LCH_CHUNK], a[LCH_CHUNK], b[LCH_CHUNK];
+    for (size_t i0 = 0; i0 < n; i0 += LCH_CHUNK)
+    {
+        size_t m = n - i0 < LCH_CHUNK ? n - i0 : LCH_CHUNK;
+        const uint8_t *p = rgb + i0 * 3;
+        for (size_t k = 0; k < m; ++k)
+            linear_srgb_to_oklab(g_srgb_u8_to_linear[p[k * 3 + 0]], g_srgb_u8_to_linear[p[k * 3 + 1]],
+                                 g_srgb_u8_to_linear[p[k * 3 + 2]], &L[k], &a[k], &b[k]);
+        oklab_chunk_to_lch(L, a, b, m, lch + i0 * 3);
+    }
+}
+
+static INLINE void rgbf_batch_body(const double *rgb, size_t n, double *lch)
+{
+    double L[LCH_CHUNK], a[LCH_CHUNK], b[LCH_CHUNK];
+    for (size_t i0 = 0; i0 < n; i0 += LCH_CHUNK)
+    {
+        size_t m = n - i0 < LCH_CHUNK ? n - i0 : LCH_CHUNK;
+        const double *p = rgb + i0 * 3;
+        for (size_t k = 0; k < m; ++k)
+            linear_srgb_to_oklab(srgb_to_linear(clamp(p[k * 3 + 0] / 255.0, 0.0, 1.0)),
+                                 srgb_to_linear(clamp(p[k * 3 + 1] / 255.0, 0.0, 1.0)),
+                                 srgb_to_linear(clamp(p[k * 3 + 2] / 255.0, 0.0, 1.0)), &L[k], &a[k], &b[k]);
+        oklab_chunk_to_lch(L, a, b, m, lch + i0 * 3);
+    }
+}
+
+// 为一个 ISA 变体生成各批量内核
+#define DEFINE_BATCH_KERNELS(suffix, attr)                                      \
+    attr static void rgb8_batch_##suffix(const uint8_t *rgb, size_t n, double *lch) \
+    {                                                                           \
+        rgb8_batch_body(rgb, n, lch);                                           \
+    }                                                                           \
+    attr static void rgbf_batch_##suffix(const double *rgb, size_t n, double *lch)  \
+    {                                                                           \
+        rgbf_batch_body(rgb, n, lch);                                           \
+    }                                                                           \
+    attr static void dedup_rows_##suffix(const DedupSet *set, size_t i0, size_t i1, \
+                                         DedupSink *sink)                       \
+    {                                                                           \
+        dedup_rows_body(set, i0, i1, sink);                                     \
+    }                                                                           \
+    attr static void blend_##suffix(uint8_t *dst, const uint8_t *src, size_t n, int mode, \
+                                    float opacity)                              \
+    {                                                                           \
+        blend_body(dst, src, n, mode, opacity);                                 \
+    }                                                                           \
+    attr static void convert_##suffix(const CsPlan *plan, const double *in, size_t n, \
+                                      double *out)                              \
+    {                                                                           \
+        cs_convert(plan, in, n, out);                                           \
+    }                                                                           \
+    attr static void cvd_##suffix(uint8_t *rgba, size_t n, const float *mat)    \
+    {                                                                           \
+        cvd_body(rgba, n, mat);                                                 \
+    }
+
+DEFINE_BATCH_KERNELS(baseline, )
+#ifdef HAVE_X86_DISPATCH
+DEFINE_BATCH_KERNELS(avx2, __attribute__((target("avx2,fma"))))
+DEFINE_BATCH_KERNELS(avx512, __attribute__((target("avx512f,avx512vl,avx512dq,avx512bw,avx2,fma"))))
+#endif
+
+static Rgb2OklchKernels g_kernels = {rgb8_batch_baseline, rgbf_batch_baseline, dedup_rows_baseline, blend_baseline,
+                                  convert_baseline,    cvd_baseline};
+static const char *g_cpu_path = "baseline";
+
+// 构造函数在 main / dlopen 返回前执行，之后只读，无需同步
+__attribute__((constructor)) static void select_cpu_path(void)
+{
+#ifdef HAVE_X86_DISPATCH
+    switch (detect_cpu_level())
+    {
+    case CPU_LEVEL_AVX512:
+        g_kernels = (Rgb2OklchKernels){rgb8_batch_avx512, rgbf_batch_avx512, dedup_rows_avx512, blend_avx512,
+                                  convert_avx512,    cvd_avx512};
+        g_cpu_path = "avx512";
+        return;
+    case CPU_LEVEL_AVX2:
+        g_kernels = (Rgb2OklchKernels){rgb8_batch_avx2, rgbf_batch_avx2, dedup_rows_avx2, blend_avx2,
+                                  convert_avx2,    cvd_avx2};
+        g_cpu_path = "avx2";
+        return;
+    default:
+        break;
+    }
+#endif
+    g_kernels = (Rgb2OklchKernels){rgb8_batch_baseline, rgbf_batch_baseline, dedup_rows_baseline, blend_baseline,
+                                  convert_baseline,    cvd_baseline};
+    g_cpu_path = "baseline";
+}
+#endif
+
+// ---- 去重驱动：转换一次、按 L 排序、行块并行 ----
+// 原生构建把行块（DEDUP_TILE 行）经原子计数器动态分给各线程；WebAssembly 单线程执行同一流程。
+// labels 模式每个额外线程各持一份 n 项并查集，总量超出此预算时减少线程
+#define DEDUP_FOREST_BUDGET ((size_t)256 << 20)
+
+typedef struct
+{
+    float L, a, b;
+    uint32_t idx;
+} DedupKey;
+
+static int dedup_key_cmp(const void *x, const void *y)
+{
+    const DedupKey *p = (const DedupKey *)x;
+    const DedupKey *q = (const DedupKey *)y;
+    // 先按 L，再按 a、b、下标：完全相同的颜色相邻，且首个为最小下标
+    if (p->L != q->L)
+        return p->L < q->L ? -1 : 1;
+    if (p->a != q->a)
+        return p->a < q->a ? -1 : 1;
+    if (p->b != q->b)
+        return p->b < q->b ? -1 : 1;
+    return (p->idx > q->idx) - (p->idx < q->idx);
+}
+
+static int dedup_pair_cmp(const void *x, const void *y)
+{
+    const DedupPair *p = (const DedupPair *)x;
+    const DedupPair *q = (const DedupPair *)y;
+    if (p->i != q->i)
+        return p->i < q->i ? -1 : 1;
+    return (p->j > q->j) - (p->j < q->j);
+}
+
+// 8 位 RGB -> 按 L 排序的 OKLab SoA，并算出每行的 L 窗口。
+// parent 非 NULL（labels 模式）时完全相同的颜色只保留最小下标参与比较，其余直接挂到它下面；
+// 距离为 0 必然命中，故这不改变结果。成功返回 0，内存由 *mem 持有
+static int dedup_prepare(const uint8_t *rgb, size_t n, float thr2, uint32_t *parent, DedupSet *set, void **mem)
+{
+    ensure_gamma_lut();
+    DedupKey *keys = (DedupKey *)malloc((n ? n : 1) * sizeof(DedupKey));
+    if (!keys)
+        return -1;
+    for (size_t i = 0; i < n; ++i)
+    {
+        double L, a, bb;
+        linear_srgb_to_oklab(g_srgb_u8_to_linear[rgb[i * 3 + 0]], g_srgb_u8_to_linear[rgb[i * 3 + 1]],
+                             g_srgb_u8_to_linear[rgb[i * 3 + 2]], &L, &a, &bb);
+        keys[i] = (DedupKey){(float)L, (float)a, (float)bb, (uint32_t)i};
+    }
+    qsort(keys, n, sizeof(DedupKey), dedup_key_cmp);
+
+    size_t m = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (parent && m > 0 && keys[i].L == keys[m - 1].L && keys[i].a == keys[m - 1].a &&
+            keys[i].b == keys[m - 1].b)
+        {
+            parent[keys[i].idx] = keys[m - 1].idx;
+            continue;
+        }
+        keys[m++] = keys[i];
+    }
+
+    float *f = (float *)malloc((m ? m : 1) * (3 * sizeof(float) + 2 * sizeof(uint32_t)));
+    if (!f)
+    {
+        free(keys);
+        return -1;
+    }
+    float *Lp = f, *ap = f + m, *bp = f + 2 * m;
+    uint32_t *idx = (uint32_t *)(f + 3 * m);
+    uint32_t *lim = idx + m;
+    for (size_t i = 0; i < m; ++i)
+    {
+        Lp[i] = keys[i].L;
+        ap[i] = keys[i].a;
+        bp[i] = keys[i].b;
+        idx[i] = keys[i].idx;
+    }
+    free(keys);
+
+    // 双指针：L 有序，窗口上界随 i 单调不减
+    size_t j = 0;
+    for (size_t i = 0; i < m; ++i)
+    {
+        if (j < i + 1)
+            j = i + 1;
+        while (j < m && (Lp[j] - Lp[i]) * (Lp[j] - Lp[i]) <= thr2)
+            j++;
+        lim[i] = (uint32_t)j;
+    }
+
+    *set = (DedupSet){Lp, ap, bp, idx, lim, m, thr2};
+    *mem = f;
+    return 0;
+}
+
+typedef struct
+{
+    const DedupSet *set;
+    atomic_size_t *next;
+    size_t nblocks;
+    DedupSink sink;
+} DedupWorker;
+
+static void dedup_worker_run(DedupWorker *w)
+{
+    for (;;)
+    {
+        size_t blk = atomic_fetch_add(w->next, 1);
+        if (blk >= w->nblocks || w->sink.oom)
+            break;
+        size_t i0 = blk * DEDUP_TILE;
+        size_t i1 = i0 + DEDUP_TILE < w->set->n ? i0 + DEDUP_TILE : w->set->n;
+#ifdef __EMSCRIPTEN__
+        dedup_rows_body(w->set, i0, i1, &w->sink);
+#else
+        g_kernels.dedup_rows(w->set, i0, i1, &w->sink);
+#endif
+    }
+}
+
+#ifndef __EMSCRIPTEN__
+static void dedup_task(void *arg)
+{
+    dedup_worker_run((DedupWorker *)arg);
+}
+#endif
+
+// threads <= 0 表示按在线 CPU 数；forest_bytes 为每个额外线程的私有并查集大小（pairs 模式为 0）
+static int dedup_thread_count(int threads, size_t nblocks, size_t forest_bytes)
+{
+#ifdef __EMSCRIPTEN__
+    (void)threads;
+    (void)nblocks;
+    (void)forest_bytes;
+    return 1;
+#else
+    threads = pool_thread_count(threads, nblocks);
+    if (forest_bytes && (size_t)threads > DEDUP_FOREST_BUDGET / forest_bytes + 1)
+        threads = (int)(DEDUP_FOREST_BUDGET / forest_bytes) + 1;
+    return threads;
+#endif
+}
+
+// 阈值近邻去重（deltaEOK <= threshold）。
+// labels 非 NULL：写入每个颜色所在分组的代表（组内最小下标），返回分组数；
+// 否则返回命中对数，*pairs_out 为按 (i, j) 升序、由调用方 free 的数组。失败返回 -1
+static int64_t dedup_run(const uint8_t *rgb, size_t n, double threshold, int threads, uint32_t *labels,
+                         DedupPair **pairs_out)
+{
+    if (!(threshold >= 0.0) || n > UINT32_MAX)
+        return -1;
+    float thr2 = (float)(threshold * threshold);
+    if (labels)
+        for (size_t i = 0; i < n; ++i)
+            labels[i] = (uint32_t)i;
+    else
+        *pairs_out = NULL;
+
+    DedupSet set;
+    void *mem;
+    if (dedup_prepare(rgb, n, thr2, labels, &set, &mem) != 0)
+        return -1;
+
+    size_t nblocks = (set.n + DEDUP_TILE - 1) / DEDUP_TILE;
+    int nt = dedup_thread_count(threads, nblocks, labels ? n * sizeof(uint32_t) : 0);
+#ifdef __EMSCRIPTEN__
+    DedupWorker w[1];
+#else
+    DedupWorker w[POOL_MAX_THREADS];
+#endif
+    atomic_size_t next = 0;
+    int64_t ret = -1;
+    int t;
+    for (t = 0; t < nt; ++t)
+    {
+        w[t] = (DedupWorker){&set, &next, nblocks, {NULL, NULL, 0, 0, 0}};
+        if (!labels)
+            continue;
+        if (t == 0)
+        {
+            w[t].sink.parent = labels;
+            continue;
+        }
+        w[t].sink.parent = (uint32_t *)malloc((n ? n : 1) * sizeof(uint32_t));
+        if (!w[t].sink.parent)
+            break;
+        for (size_t i = 0; i < n; ++i)
+            w[t].sink.parent[i] = (uint32_t)i;
+    }
+    nt = t; // 私有并查集分配失败时少开线程
+
+#ifndef __EMSCRIPTEN__
+    // 线程创建失败无妨：剩余行块会被其它线程领走（该线程的私有森林保持初值，合并时无影响）
+    pool_run(nt, dedup_task, w, sizeof w[0]);
+#else
+    dedup_worker_run(&w[0]);
+#endif
+
+    int oom = 0;
+    for (t = 0; t < nt; ++t)
+        oom |= w[t].sink.oom;
+
+    if (labels)
     {
-        double hRad = atan2(bb, a);
-        h = hRad * 180.0 / M_PI;
-        if (h < 0)
-            h += 360.0;
+        // 合并各线程的森林：每条 x -> parent[x] 边都连通同一分量
+        for (t = 1; t < nt; ++t)
+        {
+            for (size_t i = 0; i < n; ++i)
+                if (w[t].sink.parent[i] != i)
+                    uf_union(labels, (uint32_t)i, w[t].sink.parent[i]);
+            free(w[t].sink.parent);
+        }
+        int64_t groups = 0;
+        for (size_t i = 0; i < n; ++i)
+        {
+            labels[i] = uf_find(labels, (uint32_t)i);
+            groups += labels[i] == i;
+        }
+        ret = oom ? -1 : groups;
     }
     else
     {
-        // 近乎无彩（接近灰阶）时，强制 h=0 以符合预期标准
-        C = 0.0;
-        h = 0.0;
+        size_t total = 0;
+        for (t = 0; t < nt; ++t)
+            total += w[t].sink.count;
+        DedupPair *all = oom ? NULL : (DedupPair *)malloc((total ? total : 1) * sizeof(DedupPair));
+        if (all)
+        {
+            size_t k = 0;
+            for (t = 0; t < nt; ++t)
+            {
+                memcpy(all + k, w[t].sink.pairs, w[t].sink.count * sizeof(DedupPair));
+                k += w[t].sink.count;
+            }
+            qsort(all, total, sizeof(DedupPair), dedup_pair_cmp);
+            *pairs_out = all;
+            ret = (int64_t)total;
+        }
+        for (t = 0; t < nt; ++t)
+            free(w[t].sink.pairs);
     }
+    free(mem);
+    return ret;
+}
 
-    OKLCH out = (OKLCH){L, C, h};
-    return out;
+// OKLab 合成：dst（背景）就地写回，src（前景）的 alpha 再乘 opacity。成功返回 0，参数无效返回 -1
+static int blend_run(uint8_t *dst, const uint8_t *src, size_t n, int mode, double opacity)
+{
+    if (mode < 0 || mode >= BLEND_MODES || !(opacity >= 0.0))
+        return -1;
+    ensure_gamma_lut();
+    ensure_srgb8_lut();
+    float op = opacity > 1.0 ? 1.0f : (float)opacity;
+#ifdef __EMSCRIPTEN__
+    blend_body(dst, src, n, mode, op);
+#else
+    g_kernels.blend(dst, src, n, mode, op);
+#endif
+    return 0;
+}
+
+// 任意空间转换（见 color_space.h）：in / out 各 n 组三元，可为同一缓冲。成功返回 0，空间编号无效返回 -1
+static int convert_run(int src, int dst, const double *in, size_t n, double *out)
+{
+    CsPlan plan;
+    if (cs_plan_init(&plan, src, dst) != 0)
+        return -1;
+#ifdef __EMSCRIPTEN__
+    cs_convert(&plan, in, n, out);
+#else
+    g_kernels.convert(&plan, in, n, out);
+#endif
+    return 0;
+}
+
+// CVD 模拟：rgba 为 n 个 RGBA8，就地写回。成功返回 0，类型或严重度无效返回 -1
+static int cvd_run(uint8_t *rgba, size_t n, int type, double severity)
+{
+    if (type < 0 || type >= CVD_TYPES || !(severity >= 0.0 && severity <= 1.0))
+        return -1;
+    ensure_gamma_lut();
+    ensure_srgb8_lut();
+    float mat[9];
+    cvd_matrix(type, severity, mat);
+#ifdef __EMSCRIPTEN__
+    cvd_body(rgba, n, mat);
+#else
+    g_kernels.cvd(rgba, n, mat);
+#endif
+    return 0;
+}
+
+// ---- 调色板可分辨性：正常视觉与各 CVD 模拟下的最小两两 deltaEOK ----
+// 模拟在 double 线性 sRGB 中进行并裁剪到 [0,1]（不量化），再转 OKLab 存为 SoA；
+// 每行先做无分支的最小值归约（可向量化），只有刷新全局最小的行才回头找下标。调色板通常只有几十色，O(n²) 足够
+typedef struct
+{
+    double distance; // n < 2 时为 -1
+    uint32_t i, j;   // 取得最小值的一对，i < j
+} CvdMin;
+
+static double cvd_row_min(const double *L, const double *a, const double *b, size_t i, size_t n)
+{
+    double best = INFINITY;
+    for (size_t j = i + 1; j < n; ++j)
+    {
+        double dL = L[j] - L[i], da = a[j] - a[i], db = b[j] - b[i];
+        double d2 = dL * dL + da * da + db * db;
+        best = d2 < best ? d2 : best;
+    }
+    return best;
+}
+
+// rgb 为 n 组 8 位 [R,G,B]；out[0] 为正常视觉，out[1 + type] 为各模拟。成功返回 0，参数无效或内存不足返回 -1
+static int cvd_check(const uint8_t *rgb, size_t n, double severity, CvdMin out[CVD_TYPES + 1])
+{
+    if (!(severity >= 0.0 && severity <= 1.0) || n > UINT32_MAX)
+        return -1;
+    double *lab = (double *)malloc((n ? n : 1) * 3 * sizeof(double));
+    if (!lab)
+        return -1;
+    double *L = lab, *a = lab + n, *b = lab + 2 * n;
+    ensure_gamma_lut();
+    for (int v = 0; v <= CVD_TYPES; ++v)
+    {
+        float mat[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+        if (v > 0)
+            cvd_matrix(v - 1, severity, mat);
+        for (size_t k = 0; k < n; ++k)
+        {
+            double r = g_srgb_u8_to_linear[rgb[k * 3 + 0]], g = g_srgb_u8_to_linear[rgb[k * 3 + 1]],
+                   bl = g_srgb_u8_to_linear[rgb[k * 3 + 2]];
+            linear_srgb_to_oklab(clamp(mat[0] * r + mat[1] * g + mat[2] * bl, 0.0, 1.0),
+                                 clamp(mat[3] * r + mat[4] * g + mat[5] * bl, 0.0, 1.0),
+                                 clamp(mat[6] * r + mat[7] * g + mat[8] * bl, 0.0, 1.0), &L[k], &a[k], &b[k]);
+        }
+        CvdMin best = {-1.0, 0, 0};
+        double best2 = INFINITY;
+        for (size_t i = 0; i + 1 < n; ++i)
+        {
+            if (!(cvd_row_min(L, a, b, i, n) < best2))
+                continue;
+            for (size_t j = i + 1; j < n; ++j)
+            {
+                double dL = L[j] - L[i], da = a[j] - a[i], db = b[j] - b[i];
+                double d2 = dL * dL + da * da + db * db;
+                if (d2 < best2)
+                {
+                    best2 = d2;
+                    best.i = (uint32_t)i;
+                    best.j = (uint32_t)j;
+                }
+            }
+        }
+        if (n >= 2)
+            best.distance = sqrt(best2);
+        out[v] = best;
+    }
+    free(lab);
+    return 0;
 }
 
+#if !defined(__EMSCRIPTEN__) && !defined(OKCOLOR_EMBED)
 static void trim_number(char *s)
 {
     // 去除末尾多余的 0 以及多余的小数点
@@ -184,6 +1085,7 @@ static void print_oklch(const OKLCH *o)
     // 纯数值输出：L C h
     printf("%s %s %s\n", Ls, Cs, hs);
 }
+#endif
 
 // ---- 面向 JS 的最简 WASM 导出（无需 Emscripten 胶水）----
 // 以最小化设置编译到 WebAssembly 时，通过暴露一个纯函数并通过内存返回结果，
@@ -192,12 +1094,11 @@ static void print_oklch(const OKLCH *o)
 // 用于存放 [L, C, h] 三个 double 值的静态缓冲区。
 static double g_oklch_out[3];
 
-// 从 8 位 sRGB 计算 OKLCH，并返回一个指向 Wasm 线性内存的指针（偏移），
-// 其中按顺序存放 3 个 double：[L, C, h]。返回值是 32 位的线性内存地址，
-// JS 可通过 Float64Array 视图读取。该签名便于 JS 直接调用而无需 malloc。
-__attribute__((export_name("rgb2oklch_calc_js")))
+// 调用方缓冲版本：结果写入调用方提供的 out_ptr（3 个 double，8 字节对齐），返回 out_ptr。
+// 不经过静态输出缓冲 g_oklch_out，结果不会被后续调用覆盖。
+__attribute__((export_name("rgb2oklch_into_js")))
 uint32_t
-rgb2oklch_calc_js(int r, int g, int b)
+rgb2oklch_into_js(int r, int g, int b, uint32_t out_ptr)
 {
     // 快速路径：直接对 8 位输入进行查表线性化
     ensure_gamma_lut();
@@ -207,56 +1108,671 @@ rgb2oklch_calc_js(int r, int g, int b)
     double rl = g_srgb_u8_to_linear[(int)rs];
     double gl = g_srgb_u8_to_linear[(int)gs];
     double bl = g_srgb_u8_to_linear[(int)bs];
-    // 通过 OKLab 矩阵将线性 sRGB 转为 LMS
-    double l_ = 0.4122214708 * rl + 0.5363325363 * gl + 0.0514459929 * bl;
-    double m_ = 0.2119034982 * rl + 0.6806995451 * gl + 0.1073969566 * bl;
-    double s_ = 0.0883024619 * rl + 0.2817188376 * gl + 0.6299787005 * bl;
-    // 立方根
-    double l = cbrt(l_);
-    double m = cbrt(m_);
-    double s = cbrt(s_);
-    // OKLab
-    double L = 0.2104542553 * l + 0.7936177850 * m - 0.0040720468 * s;
-    double a = 1.9779984951 * l - 2.4285922050 * m + 0.4505937099 * s;
-    double bb = 0.0259040371 * l + 0.7827717662 * m - 0.8086757660 * s;
-    // OKLCH
-    double C = sqrt(a * a + bb * bb);
-    double h = 0.0;
-    if (C > 1e-12)
-    {
-        double hRad = atan2(bb, a);
-        h = hRad * 180.0 / M_PI;
-        if (h < 0)
-            h += 360.0;
-    }
-    else
-    {
-        C = 0.0;
-        h = 0.0;
-    }
-    OKLCH o = (OKLCH){L, C, h};
-    g_oklch_out[0] = o.L;
-    g_oklch_out[1] = o.C;
-    g_oklch_out[2] = o.h;
-    return (uint32_t)(uintptr_t)g_oklch_out;
+    OKLCH o = linear_srgb_to_oklch(rl, gl, bl);
+    double *out = (double *)(uintptr_t)out_ptr;
+    out[0] = o.L;
+    out[1] = o.C;
+    out[2] = o.h;
+    return out_ptr;
+}
+
+// 从 8 位 sRGB 计算 OKLCH，并返回一个指向 Wasm 线性内存的指针（偏移），
+// 其中按顺序存放 3 个 double：[L, C, h]。返回值是 32 位的线性内存地址，
+// JS 可通过 Float64Array 视图读取。该签名便于 JS 直接调用而无需 malloc。
+__attribute__((export_name("rgb2oklch_calc_js")))
+uint32_t
+rgb2oklch_calc_js(int r, int g, int b)
+{
+    return rgb2oklch_into_js(r, g, b, (uint32_t)(uintptr_t)g_oklch_out);
+}
+
+// 供调用方分配自己的输出区；size 为字节数
+__attribute__((export_name("rgb2oklch_alloc_js")))
+uint32_t
+rgb2oklch_alloc_js(uint32_t size)
+{
+    return (uint32_t)(uintptr_t)malloc(size ? size : 1);
+}
+
+__attribute__((export_name("rgb2oklch_free_js")))
+void rgb2oklch_free_js(uint32_t ptr)
+{
+    free((void *)(uintptr_t)ptr);
+}
+
+// 调色板去重：rgb_ptr 为 n 组 [R, G, B]（u8），labels_ptr 写入 n 个 uint32（所在分组的最小下标）。
+// 返回分组数，失败返回 -1
+__attribute__((export_name("rgb2oklch_dedup_labels_js")))
+int
+rgb2oklch_dedup_labels_js(uint32_t rgb_ptr, uint32_t n, double threshold, uint32_t labels_ptr)
+{
+    return (int)dedup_run((const uint8_t *)(uintptr_t)rgb_ptr, n, threshold, 1, (uint32_t *)(uintptr_t)labels_ptr,
+                          NULL);
+}
+
+// 同上，输出命中对：pairs_ptr 每项 12 字节 [i: u32, j: u32, d: f32]，按 (i, j) 升序，最多 cap 项。
+// 返回命中总数（可能大于 cap）；超过 INT_MAX 时饱和为 INT_MAX（表示溢出，仅前 cap 项有效）。失败返回 -1
+__attribute__((export_name("rgb2oklch_dedup_pairs_js")))
+int
+rgb2oklch_dedup_pairs_js(uint32_t rgb_ptr, uint32_t n, double threshold, uint32_t pairs_ptr, uint32_t cap)
+{
+    DedupPair *pairs;
+    int64_t total = dedup_run((const uint8_t *)(uintptr_t)rgb_ptr, n, threshold, 1, NULL, &pairs);
+    if (total < 0)
+        return -1;
+    memcpy((void *)(uintptr_t)pairs_ptr, pairs, (size_t)(total < cap ? total : cap) * sizeof(DedupPair));
+    free(pairs);
+    return total > INT_MAX ? INT_MAX : (int)total;
+}
+
+// OKLab 合成：dst_ptr / src_ptr 各 n 个非预乘 RGBA8，结果写回 dst_ptr；mode 0..6 依次为
+// normal、lighten、darken、luminosity、color、hue、chroma。成功返回 0，参数无效返回 -1
+__attribute__((export_name("rgb2oklch_blend_js")))
+int
+rgb2oklch_blend_js(uint32_t dst_ptr, uint32_t src_ptr, uint32_t n, int mode, double opacity)
+{
+    return blend_run((uint8_t *)(uintptr_t)dst_ptr, (const uint8_t *)(uintptr_t)src_ptr, n, mode, opacity);
+}
+
+// 任意空间转换：in_ptr / out_ptr 各 n 组 3 个 f64（可相同）；空间编号 0..7 依次为 srgb、srgb-linear、
+// display-p3、display-p3-linear、xyz-d65、lms、oklab、oklch。成功返回 0，编号无效返回 -1
+__attribute__((export_name("rgb2oklch_convert_js")))
+int
+rgb2oklch_convert_js(int src, int dst, uint32_t in_ptr, uint32_t n, uint32_t out_ptr)
+{
+    return convert_run(src, dst, (const double *)(uintptr_t)in_ptr, n, (double *)(uintptr_t)out_ptr);
+}
+
+// CVD 模拟：rgba_ptr 为 n 个 RGBA8，就地写回；type 0..2 依次为 protan、deutan、tritan，severity 0..1。
+// 成功返回 0，参数无效返回 -1
+__attribute__((export_name("rgb2oklch_cvd_js")))
+int
+rgb2oklch_cvd_js(uint32_t rgba_ptr, uint32_t n, int type, double severity)
+{
+    return cvd_run((uint8_t *)(uintptr_t)rgba_ptr, n, type, severity);
+}
+
+// 调色板可分辨性：rgb_ptr 为 n 组 RGB8；out_ptr 写入 4 项 [f64 distance, u32 i, u32 j]（每项 16 字节），
+// 依次为正常视觉、protan、deutan、tritan。成功返回 0，失败返回 -1
+__attribute__((export_name("rgb2oklch_cvd_check_js")))
+int
+rgb2oklch_cvd_check_js(uint32_t rgb_ptr, uint32_t n, double severity, uint32_t out_ptr)
+{
+    return cvd_check((const uint8_t *)(uintptr_t)rgb_ptr, n, severity, (CvdMin *)(uintptr_t)out_ptr);
+}
+#endif
+
+#ifdef OKCOLOR_EMBED
+// ---- 原生嵌入接口（见 okcolor.h）----
+void okc_rgb2oklch_init(void)
+{
+    ensure_gamma_lut();
+}
+
+void okc_rgb8_to_oklch_batch(const uint8_t *rgb, size_t n, double *lch)
+{
+    ensure_gamma_lut();
+    g_kernels.rgb8(rgb, n, lch);
+}
+
+int64_t okc_dedup_labels(const uint8_t *rgb, size_t n, double threshold, int threads, uint32_t *labels)
+{
+    return dedup_run(rgb, n, threshold, threads, labels, NULL);
+}
+
+int64_t okc_dedup_pairs(const uint8_t *rgb, size_t n, double threshold, int threads, okc_pair *pairs, size_t cap)
+{
+    DedupPair *all;
+    int64_t total = dedup_run(rgb, n, threshold, threads, NULL, &all);
+    if (total < 0)
+        return -1;
+    for (size_t k = 0; k < (size_t)total && k < cap; ++k)
+        pairs[k] = (okc_pair){all[k].i, all[k].j, all[k].d};
+    free(all);
+    return total;
+}
+
+int okc_blend_oklab(uint8_t *dst, const uint8_t *src, size_t n, okc_blend_mode mode, double opacity)
+{
+    return blend_run(dst, src, n, (int)mode, opacity);
+}
+
+int okc_convert(okc_space src, okc_space dst, const double *in, size_t n, double *out)
+{
+    return convert_run((int)src, (int)dst, in, n, out);
+}
+
+int okc_cvd_simulate(uint8_t *rgba, size_t n, okc_cvd type, double severity)
+{
+    return cvd_run(rgba, n, (int)type, severity);
+}
+
+int okc_cvd_check(const uint8_t *rgb, size_t n, double severity, okc_cvd_min out[4])
+{
+    CvdMin m[CVD_TYPES + 1];
+    if (cvd_check(rgb, n, severity, m) != 0)
+        return -1;
+    for (int v = 0; v <= CVD_TYPES; ++v)
+        out[v] = (okc_cvd_min){m[v].distance, m[v].i, m[v].j};
+    return 0;
 }
 #endif
 
+#if !defined(__EMSCRIPTEN__) && !defined(OKCOLOR_EMBED)
 static void usage(const char *prog)
 {
     fprintf(stderr,
             "Usage:\n"
-            "  %s R G B\n\n"
+            "  %s R G B\n"
+            "  %s --batch [--css] < input   (lines \"R G B\", \"#rrggbb\" or \"rgb(...)\";\n"
+            "                               output lines \"L C h\", or \"oklch(L C h)\" with --css)\n"
+            "  %s --dedup T [--pairs] [--threads N] < input\n"
+            "                               (same input lines; groups colors within deltaEOK T:\n"
+            "                               one group label per line, or \"i j d\" lines with --pairs)\n"
+            "  %s --blend MODE BACKDROP.pam SOURCE.pam [--opacity A] > out.pam\n"
+            "                               (MODE: normal|lighten|darken|luminosity|color|hue|chroma;\n"
+            "                               mixes in OKLab, then source-over; PAM P7 RGB(A) 8-bit)\n"
+            "  %s --convert SRC DST [--hex] < input\n"
+            "                               (lines of three numbers; spaces: srgb, srgb-linear, display-p3,\n"
+            "                               display-p3-linear, xyz-d65, lms, oklab, oklch; RGB in 0..1)\n"
+            "  %s --cvd protan|deutan|tritan IN.pam [--severity S] > out.pam\n"
+            "                               (color-vision-deficiency simulation, S in 0..1, default 1)\n"
+            "  %s --cvd-check [--severity S] [--min D] < palettes\n"
+            "                               (palettes separated by blank lines; also oklch(...) and\n"
+            "                               extract-colors JSON; per palette: count, then min deltaEOK\n"
+            "                               and its pair for normal/protan/deutan/tritan; exit 2 if < D)\n"
+            "  %s --cpu-info\n\n"
             "Notes:\n"
             "  - R,G,B: 0-255 numbers\n"
             "Examples:\n"
             "  %s 255 255 255            -> 1 0 0\n",
-            prog, prog);
+            prog, prog, prog, prog, prog, prog, prog, prog, prog);
+}
+
+// 与 print_oklch 逐字节一致的无 printf 版本（批量模式整块写出用）；
+// css 非零时输出 "oklch(L C h[ / a])"，否则为 "L C h"
+static char *format_oklch(char *dst, const OKLCH *o, int css, double alpha)
+{
+    double L = fabs(o->L) < 1e-15 ? 0.0 : o->L;
+    double C = fabs(o->C) < 1e-15 ? 0.0 : o->C;
+    double h = fabs(o->h) < 1e-15 ? 0.0 : o->h;
+    char Cs[64];
+    char *ce = css_format_fixed6(Cs, C);
+    if (ce - Cs == 1 && Cs[0] == '0')
+        h = 0.0;
+    if (css)
+        return css_format_oklch(dst, L, C, h, alpha);
+    dst = css_format_fixed6(dst, L);
+    *dst++ = ' ';
+    memcpy(dst, Cs, (size_t)(ce - Cs));
+    dst += ce - Cs;
+    *dst++ = ' ';
+    return css_format_fixed6(dst, h);
+}
+
+// 批量模式的一行："R G B"（0..255，可为小数）或 CSS 颜色（#rgb[a]、#rrggbb[aa]、rgb()/rgba()）。
+// 成功返回 1，v 写入夹取到 0..255 的分量、alpha 写入不透明度
+static int parse_batch_line(const char *p, const char *end, double *v, double *alpha)
+{
+    *alpha = 1.0;
+    if (*p == '#' || isalpha((unsigned char)*p))
+    {
+        CssColor c;
+        p = css_parse_color(p, end, &c);
+        if (!p || c.kind != CSS_COLOR_RGB)
+            return 0;
+        for (int k = 0; k < 3; ++k)
+            v[k] = clamp(c.v[k], 0.0, 255.0);
+        *alpha = c.alpha;
+        return css_skip_space(p, end) == end;
+    }
+    for (int k = 0; k < 3; ++k)
+    {
+        p = css_skip_space(p, end);
+        if (!css_parse_number(&p, end, &v[k]))
+            return 0;
+        v[k] = clamp(v[k], 0.0, 255.0);
+    }
+    return css_skip_space(p, end) == end;
+}
+
+// 批量模式：stdin 每行一个颜色（见 parse_batch_line），stdout 每行 "L C h"（格式同单次模式；
+// --css 时为 "oklch(L C h)"）。读行与分块由 css_run_batch 驱动，每块调用分派后的批量内核并整块写出
+#define BATCH_CHUNK 4096
+typedef struct
+{
+    int css_out;
+    double in[BATCH_CHUNK * 3];
+    double alpha[BATCH_CHUNK];
+    double out[BATCH_CHUNK * 3];
+    char text[BATCH_CHUNK * 96];
+} BatchState;
+
+static int batch_parse(void *ctx, const char *p, const char *end, size_t slot)
+{
+    BatchState *s = (BatchState *)ctx;
+    return parse_batch_line(p, end, s->in + slot * 3, &s->alpha[slot]);
+}
+
+static void batch_flush(void *ctx, size_t n)
+{
+    BatchState *s = (BatchState *)ctx;
+    g_kernels.rgbf(s->in, n, s->out);
+    char *t = s->text;
+    for (size_t i = 0; i < n; ++i)
+    {
+        OKLCH o = {s->out[i * 3 + 0], s->out[i * 3 + 1], s->out[i * 3 + 2]};
+        t = format_oklch(t, &o, s->css_out, s->alpha[i]);
+        *t++ = '\n';
+    }
+    fwrite(s->text, 1, (size_t)(t - s->text), stdout);
+}
+
+static int run_batch(int css_out)
+{
+    static BatchState s;
+    s.css_out = css_out;
+    return css_run_batch(BATCH_CHUNK, batch_parse, batch_flush, &s, "R G B, #rrggbb or rgb(...)");
+}
+
+// 去重模式：读入全部颜色（分量取整到 8 位），labels 模式每行输出所在分组的代表行号（0 起、不计空行），
+// --pairs 时输出 "i j d"；分组数/命中数写到 stderr
+static int run_dedup(double threshold, int pairs_out, int threads)
+{
+    uint8_t *rgb = NULL;
+    size_t n = 0, cap = 0;
+    char line[512];
+    long lineno = 0;
+    while (fgets(line, sizeof line, stdin))
+    {
+        lineno++;
+        const char *end = line + strlen(line);
+        const char *p = css_skip_space(line, end);
+        if (p == end)
+            continue;
+        double v[3], alpha;
+        if (!parse_batch_line(p, end, v, &alpha))
+        {
+            fprintf(stderr, "Failed to parse line %ld. Expect: R G B, #rrggbb or rgb(...)\n", lineno);
+            free(rgb);
+            return 1;
+        }
+        if (n == cap)
+        {
+            cap = cap ? cap * 2 : 4096;
+            uint8_t *nr = (uint8_t *)realloc(rgb, cap * 3);
+            if (!nr)
+            {
+                free(rgb);
+                fprintf(stderr, "Out of memory.\n");
+                return 1;
+            }
+            rgb = nr;
+        }
+        for (int k = 0; k < 3; ++k)
+            rgb[n * 3 + k] = (uint8_t)(v[k] + 0.5);
+        n++;
+    }
+
+    int rc = 0;
+    if (pairs_out)
+    {
+        DedupPair *pairs;
+        int64_t total = dedup_run(rgb, n, threshold, threads, NULL, &pairs);
+        if (total < 0)
+            rc = 1;
+        for (int64_t k = 0; k < total; ++k)
+            printf("%u %u %.6f\n", pairs[k].i, pairs[k].j, pairs[k].d);
+        if (total >= 0)
+        {
+            fprintf(stderr, "pairs: %lld\n", (long long)total);
+            free(pairs);
+        }
+    }
+    else
+    {
+        uint32_t *labels = (uint32_t *)malloc((n ? n : 1) * sizeof(uint32_t));
+        int64_t groups = labels ? dedup_run(rgb, n, threshold, threads, labels, NULL) : -1;
+        if (groups < 0)
+            rc = 1;
+        for (int64_t k = 0; k < (groups < 0 ? 0 : (int64_t)n); ++k)
+            printf("%u\n", labels[k]);
+        if (groups >= 0)
+            fprintf(stderr, "groups: %lld\n", (long long)groups);
+        free(labels);
+    }
+    if (rc)
+        fprintf(stderr, "Dedup failed (out of memory or invalid threshold).\n");
+    free(rgb);
+    return rc;
+}
+
+// 转换模式：stdin 每行三个数值（SRC 空间），stdout 每行三个数值（DST 空间，格式同批量模式）；
+// --hex 时把编码 RGB 结果裁剪到 0..1 后输出 #rrggbb
+static int run_convert(int src, int dst, int hex)
+{
+    static double buf[BATCH_CHUNK * 3];
+    static char text[BATCH_CHUNK * 96];
+    char line[512];
+    size_t n = 0;
+    long lineno = 0;
+    int eof = 0;
+    while (!eof)
+    {
+        eof = fgets(line, sizeof line, stdin) == NULL;
+        if (!eof)
+        {
+            lineno++;
+            const char *end = line + strlen(line);
+            const char *p = css_skip_space(line, end);
+            if (p == end)
+                continue;
+            for (int k = 0; k < 3 && p; ++k)
+            {
+                p = css_skip_space(p, end);
+                if (!css_parse_number(&p, end, &buf[n * 3 + k]))
+                    p = NULL;
+            }
+            if (!p || css_skip_space(p, end) != end)
+            {
+                fprintf(stderr, "Failed to parse line %ld. Expect three numbers\n", lineno);
+                return 1;
+            }
+            if (++n < BATCH_CHUNK)
+                continue;
+        }
+        convert_run(src, dst, buf, n, buf);
+        char *t = text;
+        for (size_t i = 0; i < n; ++i)
+        {
+            const double *v = buf + i * 3;
+            if (hex)
+            {
+                uint8_t rgb[3];
+                for (int k = 0; k < 3; ++k)
+                    rgb[k] = (uint8_t)floor(clamp(v[k], 0.0, 1.0) * 255.0 + 0.5);
+                t = css_format_hex(t, rgb, 1.0);
+            }
+            else if (dst == CS_OKLCH)
+            {
+                OKLCH o = {v[0], v[1], v[2]};
+                t = format_oklch(t, &o, 0, 1.0); // 彩度显示为 0 时色相同样置 0
+            }
+            else
+                for (int k = 0; k < 3; ++k)
+                {
+                    if (k)
+                        *t++ = ' ';
+                    t = css_format_fixed6(t, fabs(v[k]) < 5e-7 ? 0.0 : v[k]); // 避免输出 "-0"
+                }
+            *t++ = '\n';
+        }
+        fwrite(text, 1, (size_t)(t - text), stdout);
+        n = 0;
+    }
+    return 0;
+}
+
+// 合成模式：MODE BACKDROP.pam SOURCE.pam [--opacity A]，两图尺寸须一致，结果以 PAM 写到 stdout
+// 调色板的一行 -> 8 位 RGB。除批量模式的写法外，还接受 oklch(...)（转到 sRGB 后裁剪，不做色域映射）
+// 以及 extract-colors JSON 输出中带 "hex": "#rrggbb" 字段的行。成功返回 1
+static int parse_palette_line(const char *p, const char *end, uint8_t rgb[3])
+{
+    const char *hex = strstr(p, "\"hex\": \"#");
+    if (hex)
+    {
+        p = hex + 8;
+        end = end - p > 7 ? p + 7 : end;
+    }
+    double v[3], alpha;
+    if (*p == 'o')
+    {
+        CssColor c;
+        const char *q = css_parse_color(p, end, &c);
+        if (!q || c.kind != CSS_COLOR_OKLCH || css_skip_space(q, end) != end)
+            return 0;
+        CsPlan plan;
+        cs_plan_init(&plan, CS_OKLCH, CS_SRGB);
+        cs_convert(&plan, c.v, 1, v);
+        for (int k = 0; k < 3; ++k)
+            v[k] = clamp(v[k], 0.0, 1.0) * 255.0;
+    }
+    else if (!parse_batch_line(p, end, v, &alpha))
+        return 0;
+    for (int k = 0; k < 3; ++k)
+        rgb[k] = (uint8_t)(v[k] + 0.5);
+    return 1;
+}
+
+// 可分辨性检查：stdin 为一个或多个调色板（空行或 JSON 的 "]" 分隔，每行见 parse_palette_line），
+// 每个调色板输出一行：颜色数，以及正常视觉与 protan / deutan / tritan 模拟下的最小 deltaEOK 和对应的一对下标。
+// min > 0 时任一模拟低于 min 则在 stderr 报告并返回 2（供流水线做门槛）
+static int run_cvd_check(double severity, double min)
+{
+    static const char *const names[CVD_TYPES + 1] = {"normal", "protan", "deutan", "tritan"};
+    uint8_t *rgb = NULL;
+    size_t n = 0, cap = 0;
+    char line[512];
+    long lineno = 0, palette = 0;
+    int rc = 0, eof = 0;
+    while (!eof)
+    {
+        eof = fgets(line, sizeof line, stdin) == NULL;
+        const char *end = eof ? line : line + strlen(line);
+        const char *p = eof ? line : css_skip_space(line, end);
+        while (end > p && css_is_space(end[-1]))
+            end--;
+        if (!eof)
+            lineno++;
+        if (!eof && p != end && !(end - p == 1 && *p == ']') && !(end - p == 1 && *p == '['))
+        {
+            if (n == cap)
+            {
+                cap = cap ? cap * 2 : 256;
+                uint8_t *nr = (uint8_t *)realloc(rgb, cap * 3);
+                if (!nr)
+                {
+                    fprintf(stderr, "Out of memory.\n");
+                    rc = 1;
+                    break;
+                }
+                rgb = nr;
+            }
+            if (!parse_palette_line(p, end, rgb + n * 3))
+            {
+                fprintf(stderr, "Failed to parse line %ld. Expect: R G B, #rrggbb, rgb(...) or oklch(...)\n", lineno);
+                rc = 1;
+                break;
+            }
+            n++;
+            continue;
+        }
+        if (n == 0 || (!eof && *p == '['))
+            continue;
+        CvdMin m[CVD_TYPES + 1];
+        if (cvd_check(rgb, n, severity, m) != 0)
+        {
+            fprintf(stderr, "Out of memory.\n");
+            rc = 1;
+            break;
+        }
+        printf("%zu", n);
+        for (int v = 0; v <= CVD_TYPES; ++v)
+        {
+            printf(" %s %.6f %u %u", names[v], m[v].distance, m[v].i, m[v].j);
+            if (v > 0 && n >= 2 && m[v].distance < min)
+            {
+                fprintf(stderr, "palette %ld: %s deltaEOK %.6f < %g (colors %u, %u)\n", palette, names[v],
+                        m[v].distance, min, m[v].i, m[v].j);
+                rc = 2;
+            }
+        }
+        printf("\n");
+        palette++;
+        n = 0;
+    }
+    free(rgb);
+    return rc;
+}
+
+static int run_cvd(int argc, char **argv)
+{
+    static const char *const types[CVD_TYPES] = {"protan", "deutan", "tritan"};
+    int type = -1;
+    double severity = 1.0;
+    for (int k = 0; k < CVD_TYPES; ++k)
+        if (argc > 2 && strcmp(argv[2], types[k]) == 0)
+            type = k;
+    int ok = type >= 0 && argc > 3;
+    for (int i = 4; ok && i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--severity") == 0 && i + 1 < argc)
+        {
+            char *e;
+            severity = strtod(argv[++i], &e);
+            ok = *e == '\0' && severity >= 0.0 && severity <= 1.0;
+        }
+        else
+            ok = 0;
+    }
+    if (!ok)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+    int w, h;
+    uint8_t *img = read_pam(argv[3], &w, &h);
+    if (!img)
+    {
+        fprintf(stderr, "Failed to read PAM image (P7, DEPTH 3/4, MAXVAL 255).\n");
+        return 1;
+    }
+    cvd_run(img, (size_t)w * h, type, severity);
+    write_pam(img, w, h);
+    free(img);
+    return 0;
+}
+
+static int run_blend(int argc, char **argv)
+{
+    static const char *const modes[BLEND_MODES] = {"normal", "lighten", "darken", "luminosity",
+                                                   "color",  "hue",     "chroma"};
+    int mode = -1;
+    double opacity = 1.0;
+    for (int k = 0; k < BLEND_MODES; ++k)
+        if (argc > 2 && strcmp(argv[2], modes[k]) == 0)
+            mode = k;
+    int ok = mode >= 0 && argc > 4;
+    for (int i = 5; ok && i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--opacity") == 0 && i + 1 < argc)
+        {
+            char *e;
+            opacity = strtod(argv[++i], &e);
+            ok = *e == '\0' && opacity >= 0.0 && opacity <= 1.0;
+        }
+        else
+            ok = 0;
+    }
+    if (!ok)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+    int w, h, sw, sh;
+    uint8_t *dst = read_pam(argv[3], &w, &h);
+    uint8_t *src = read_pam(argv[4], &sw, &sh);
+    int rc = 1;
+    if (!dst || !src)
+        fprintf(stderr, "Failed to read PAM image (P7, DEPTH 3/4, MAXVAL 255).\n");
+    else if (w != sw || h != sh)
+        fprintf(stderr, "Image sizes differ: %dx%d vs %dx%d.\n", w, h, sw, sh);
+    else
+    {
+        blend_run(dst, src, (size_t)w * h, mode, opacity);
+        write_pam(dst, w, h);
+        rc = 0;
+    }
+    free(dst);
+    free(src);
+    return rc;
 }
 
-#ifndef __EMSCRIPTEN__
 int main(int argc, char **argv)
 {
+    if (argc == 2 && strcmp(argv[1], "--cpu-info") == 0)
+    {
+        print_cpu_info(g_cpu_path);
+        return 0;
+    }
+    if (argc >= 2 && strcmp(argv[1], "--batch") == 0)
+    {
+        int css_out = argc == 3 && strcmp(argv[2], "--css") == 0;
+        if (argc > 3 || (argc == 3 && !css_out))
+        {
+            usage(argv[0]);
+            return 1;
+        }
+        return run_batch(css_out);
+    }
+    if (argc >= 3 && strcmp(argv[1], "--dedup") == 0)
+    {
+        char *e;
+        double threshold = strtod(argv[2], &e);
+        int pairs_out = 0, threads = 0;
+        if (e == argv[2] || *e || !(threshold >= 0.0))
+        {
+            usage(argv[0]);
+            return 1;
+        }
+        for (int i = 3; i < argc; ++i)
+        {
+            if (strcmp(argv[i], "--pairs") == 0)
+                pairs_out = 1;
+            else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+                threads = atoi(argv[++i]);
+            else
+            {
+                usage(argv[0]);
+                return 1;
+            }
+        }
+        return run_dedup(threshold, pairs_out, threads);
+    }
+    if (argc >= 2 && strcmp(argv[1], "--blend") == 0)
+        return run_blend(argc, argv);
+    if (argc >= 2 && strcmp(argv[1], "--cvd") == 0)
+        return run_cvd(argc, argv);
+    if (argc >= 2 && strcmp(argv[1], "--cvd-check") == 0)
+    {
+        double severity = 1.0, min = 0.0;
+        for (int i = 2; i < argc; ++i)
+        {
+            char *e = NULL;
+            if (strcmp(argv[i], "--severity") == 0 && i + 1 < argc)
+                severity = strtod(argv[++i], &e);
+            else if (strcmp(argv[i], "--min") == 0 && i + 1 < argc)
+                min = strtod(argv[++i], &e);
+            if (!e || *e || !(severity >= 0.0 && severity <= 1.0) || !(min >= 0.0))
+            {
+                usage(argv[0]);
+                return 1;
+            }
+        }
+        return run_cvd_check(severity, min);
+    }
+    if (argc >= 4 && argc <= 5 && strcmp(argv[1], "--convert") == 0)
+    {
+        int src = cs_space_from_name(argv[2]), dst = cs_space_from_name(argv[3]);
+        int hex = argc == 5 && strcmp(argv[4], "--hex") == 0;
+        if (src < 0 || dst < 0 || (argc == 5 && !hex) || (hex && k_cs_spaces[dst].level != CS_LEVEL_ENCODED))
+        {
+            usage(argv[0]);
+            return 1;
+        }
+        return run_convert(src, dst, hex);
+    }
+
     RGB255 rgb;
     int ok = 0;
     if (argc == 4)
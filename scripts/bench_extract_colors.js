@@ -0,0 +1,91 @@
+#!/usr/bin/env node
+/*
+Measure end-to-end latency of extract-colors.wasm for 64-color results:
+copy pixels -> extract_colors_from_rgba_js -> decode the fixed result layout
+(sorting and hex strings are produced on the C side).
+
+Usage: node scripts/bench_extract_colors.js [runs]
+*/
+const fs = require('node:fs');
+const path = require('node:path');
+
+const OUT_MAX_COLORS = 64;
+const OUT_NUMS_LEN = 1 + 8 * OUT_MAX_COLORS;
+
+function stubImports(mod) {
+  const imports = {};
+  for (const imp of WebAssembly.Module.imports(mod)) {
+    if (imp.kind !== 'function') continue;
+    (imports[imp.module] ??= {})[imp.name] = () => 0;
+  }
+  return imports;
+}
+
+// 64 个色块（8×8 平铺），合并阈值为 0 时能稳定得到 64 个颜色
+function makeImage(w, h) {
+  const data = new Uint8Array(w * h * 4);
+  const tw = w / 8, th = h / 8;
+  for (let y = 0; y < h; y++) {
+    for (let x = 0; x < w; x++) {
+      const t = Math.floor(y / th) * 8 + Math.floor(x / tw);
+      const o = (y * w + x) * 4;
+      data[o] = (t * 37) & 255;
+      data[o + 1] = (t * 91) & 255;
+      data[o + 2] = (t * 53) & 255;
+      data[o + 3] = 255;
+    }
+  }
+  return data;
+}
+
+function decode(mem, outPtr) {
+  const f64 = new Float64Array(mem.buffer, outPtr, OUT_NUMS_LEN);
+  const hexU8 = new Uint8Array(mem.buffer, outPtr + OUT_NUMS_LEN * 8, OUT_MAX_COLORS * 8);
+  const m = Math.max(0, Math.min(OUT_MAX_COLORS, f64[0] | 0));
+  const out = new Array(m);
+  for (let i = 0; i < m; i++) {
+    const base = 1 + i * 8;
+    const o = i * 8;
+    out[i] = {
+      hex: String.fromCharCode(hexU8[o], hexU8[o + 1], hexU8[o + 2], hexU8[o + 3], hexU8[o + 4], hexU8[o + 5], hexU8[o + 6]),
+      red: f64[base + 0], green: f64[base + 1], blue: f64[base + 2],
+      area: f64[base + 7], hue: f64[base + 3], saturation: f64[base + 6],
+      lightness: f64[base + 5], intensity: f64[base + 4],
+    };
+  }
+  return out;
+}
+
+function main() {
+  const runs = Math.max(1, parseInt(process.argv[2] || '200', 10));
+  const buf = fs.readFileSync(path.join(__dirname, '..', 'wasm', 'extract-colors.wasm'));
+  const mod = new WebAssembly.Module(buf);
+  const { exports } = new WebAssembly.Instance(mod, stubImports(mod));
+  const w = 256, h = 256;
+  const img = makeImage(w, h);
+
+  const times = [];
+  let colors = null;
+  for (let i = 0; i < runs + 10; i++) {
+    const t0 = process.hrtime.bigint();
+    const ptr = exports.get_pixels_buffer(img.byteLength) >>> 0;
+    new Uint8Array(exports.memory.buffer, ptr, img.byteLength).set(img);
+    const outPtr = exports.extract_colors_from_rgba_js(ptr, w, h, 64000, 0, 0, 0, 0, 250, OUT_MAX_COLORS) >>> 0;
+    if (!outPtr) throw new Error('extract_colors_from_rgba_js returned 0');
+    colors = decode(exports.memory, outPtr);
+    const t1 = process.hrtime.bigint();
+    if (i >= 10) times.push(Number(t1 - t0) / 1e6); // 前 10 次热身
+  }
+  times.sort((a, b) => a - b);
+  const pct = (p) => times[Math.min(times.length - 1, Math.floor(p * times.length))];
+  for (let i = 1; i < colors.length; i++) {
+    const pa = (colors[i - 1].intensity + 0.1) * (0.9 - colors[i - 1].area);
+    const pb = (colors[i].intensity + 0.1) * (0.9 - colors[i].area);
+    if (pb > pa + 1e-12) throw new Error('result not sorted at index ' + i);
+    if (!/^#[0-9a-f]{6}$/.test(colors[i].hex)) throw new Error('bad hex at index ' + i + ': ' + colors[i].hex);
+  }
+  console.log(`[bench] extract-colors ${w}x${h}, ${colors.length} colors, ${runs} runs`);
+  console.log(`[bench] median ${pct(0.5).toFixed(3)} ms, p95 ${pct(0.95).toFixed(3)} ms, min ${times[0].toFixed(3)} ms`);
+}
+
+main();
@@ -0,0 +1,45 @@
+#!/usr/bin/env node
+/*
+Per-frame cost of the batch squircle API: fill specs -> squircle_paths_batch_js
+-> decode once and slice, for N shapes per frame (target: < 1 ms for hundreds).
+
+Usage: node scripts/bench_squircle_batch.js [shapesPerFrame] [frames]
+*/
+const fs = require('node:fs');
+const path = require('node:path');
+
+function main() {
+  const n = Math.max(1, parseInt(process.argv[2] || '500', 10));
+  const frames = Math.max(1, parseInt(process.argv[3] || '300', 10));
+  const buf = fs.readFileSync(path.join(__dirname, '..', 'wasm', 'squircle-svg.wasm'));
+  const { exports } = new WebAssembly.Instance(new WebAssembly.Module(buf), {});
+  const dec = new TextDecoder();
+  const times = [];
+  let paths = null;
+  for (let f = 0; f < frames + 10; f++) {
+    const t0 = process.hrtime.bigint();
+    const specPtr = exports.squircle_batch_specs_js(n) >>> 0;
+    const specs = new Float64Array(exports.memory.buffer, specPtr, n * 4);
+    for (let i = 0; i < n; i++) {
+      specs[i * 4] = i & 1;
+      specs[i * 4 + 1] = 200 + ((f + i) % 600);
+      specs[i * 4 + 2] = 120 + (i % 80);
+      specs[i * 4 + 3] = 16 + (i % 8);
+    }
+    const tabPtr = exports.squircle_paths_batch_js(n) >>> 0;
+    if (!tabPtr) throw new Error('squircle_paths_batch_js returned 0');
+    const tab = new Uint32Array(exports.memory.buffer, tabPtr, 2 + n * 2);
+    const all = dec.decode(new Uint8Array(exports.memory.buffer, tab[0], tab[1]));
+    paths = new Array(n);
+    for (let i = 0; i < n; i++) paths[i] = all.substring(tab[2 + i * 2], tab[2 + i * 2] + tab[3 + i * 2]);
+    const t1 = process.hrtime.bigint();
+    if (f >= 10) times.push(Number(t1 - t0) / 1e6); // 前 10 帧热身
+  }
+  times.sort((a, b) => a - b);
+  const pct = (p) => times[Math.min(times.length - 1, Math.floor(p * times.length))];
+  if (!paths[0].startsWith('M0 ') || !paths[1].startsWith('M ')) throw new Error('unexpected path output');
+  console.log(`[bench] squircle batch: ${n} shapes/frame, ${frames} frames`);
+  console.log(`[bench] median ${pct(0.5).toFixed(3)} ms/frame, p95 ${pct(0.95).toFixed(3)} ms/frame`);
+}
+
+main();
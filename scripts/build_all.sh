@@ -20,8 +20,8 @@ fail() { printf "${RED}[FAIL]${NC} %s\n" " $*"; }
 
 # 1) Build native binaries (macOS)
 say "Building native binaries (clang)"
-clang -O3 -march=native -ffast-math -std=c11 oklch2rgb.c -o oklch2rgb
-clang -O3 -march=native -ffast-math -std=c11 rgb2oklch.c -o rgb2oklch
+clang -O3 -march=native -ffast-math -std=c11 oklch2rgb.c -o oklch2rgb -pthread
+clang -O3 -march=native -ffast-math -std=c11 rgb2oklch.c -o rgb2oklch -pthread
 # extract-colors needs Apple frameworks
 clang -O3 -ffast-math -std=c11 extract-colors.c -o extract-colors \
   -framework ImageIO -framework CoreGraphics -framework CoreFoundation
@@ -35,21 +35,64 @@ fi
 mkdir -p wasm
 say "Building WASM (standalone, no entry)"
 # oklch2rgb.wasm
-emcc -O3 -ffast-math -s STANDALONE_WASM=1 \
+emcc -O3 -ffast-math -msimd128 -s STANDALONE_WASM=1 \
+  -s ALLOW_MEMORY_GROWTH=1 \
   -Wl,--no-entry \
   -Wl,--export=oklch2rgb_calc_js \
   -Wl,--export=oklch2rgb_calc_rel_js \
+  -Wl,--export=oklch2rgb_packed_js \
+  -Wl,--export=oklch2rgb_rel_packed_js \
+  -Wl,--export=oklch2rgb_stats_js \
+  -Wl,--export=oklch2rgb_stats_reset_js \
+  -Wl,--export=oklch2rgb_slice_js \
+  -Wl,--export=oklch2rgb_gradient_js \
+  -Wl,--export=oklch2rgb_gamut_map_js \
+  -Wl,--export=oklch2rgb_alloc_js \
+  -Wl,--export=oklch2rgb_free_js \
   oklch2rgb.c -o wasm/oklch2rgb.wasm
 # rgb2oklch.wasm
-emcc -O3 -ffast-math -s STANDALONE_WASM=1 \
+emcc -O3 -ffast-math -msimd128 -s STANDALONE_WASM=1 \
+  -s ALLOW_MEMORY_GROWTH=1 \
   -Wl,--no-entry \
   -Wl,--export=rgb2oklch_calc_js \
+  -Wl,--export=rgb2oklch_into_js \
+  -Wl,--export=rgb2oklch_alloc_js \
+  -Wl,--export=rgb2oklch_free_js \
+  -Wl,--export=rgb2oklch_dedup_labels_js \
+  -Wl,--export=rgb2oklch_dedup_pairs_js \
+  -Wl,--export=rgb2oklch_blend_js \
+  -Wl,--export=rgb2oklch_convert_js \
+  -Wl,--export=rgb2oklch_cvd_js \
+  -Wl,--export=rgb2oklch_cvd_check_js \
   rgb2oklch.c -o wasm/rgb2oklch.wasm
 # extract-colors.wasm
 emcc -O3 -ffast-math -s STANDALONE_WASM=1 \
+  -s ALLOW_MEMORY_GROWTH=1 -s MAXIMUM_MEMORY=4GB \
   -Wl,--no-entry \
   -Wl,--export=get_pixels_buffer \
+  -Wl,--export=release_pixels_buffer \
+  -Wl,--export=wasm_memory_stats_js \
   -Wl,--export=extract_colors_from_rgba_js \
+  -Wl,--export=extract_colors_into_js \
+  -Wl,--export=extract_colors_yuv_into_js \
+  -Wl,--export=extract_colors_indexed_into_js \
+  -Wl,--export=extract_colors_y4m_into_js \
+  -Wl,--export=extract_out_size_js \
+  -Wl,--export=extract_alloc_js \
+  -Wl,--export=extract_free_js \
+  -Wl,--export=extract_stream_begin_js \
+  -Wl,--export=extract_stream_feed_js \
+  -Wl,--export=extract_stream_finish_js \
+  -Wl,--export=extract_progressive_begin_js \
+  -Wl,--export=extract_progressive_run_js \
+  -Wl,--export=extract_progressive_state_js \
+  -Wl,--export=extract_progressive_end_js \
+  -Wl,--export=extract_session_begin_js \
+  -Wl,--export=extract_session_run_js \
+  -Wl,--export=extract_session_recomputed_js \
+  -Wl,--export=extract_session_end_js \
+  -Wl,--export=extract_hierarchy_build_js \
+  -Wl,--export=extract_hierarchy_palette_js \
   extract-colors.c -o wasm/extract-colors.wasm
 ok "WASM build done"
 
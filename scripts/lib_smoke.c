@@ -0,0 +1,233 @@
+// libokcolor 最小烟测：链接 libokcolor.a，核对与 CLI 相同的结果
+// 用法：make test-lib
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "okcolor.h"
+
+static int g_fail = 0;
+
+#define CHECK(cond, ...)                  \
+  do                                      \
+  {                                       \
+    if (!(cond))                          \
+    {                                     \
+      fprintf(stderr, "[FAIL] ");         \
+      fprintf(stderr, __VA_ARGS__);       \
+      fprintf(stderr, "\n");              \
+      g_fail = 1;                         \
+    }                                     \
+  } while (0)
+
+int main(void)
+{
+  CHECK(okc_version() == OKCOLOR_VERSION, "okc_version %d != %d", okc_version(), OKCOLOR_VERSION);
+
+  // oklch2rgb 0.7 0.2 30 => 255 101 81
+  double lch[3] = {0.7, 0.2, 30.0};
+  uint8_t rgb[3];
+  okc_oklch_to_rgb8_batch(lch, 1, rgb);
+  CHECK(rgb[0] == 255 && rgb[1] == 101 && rgb[2] == 81, "oklch2rgb => %d %d %d", rgb[0], rgb[1], rgb[2]);
+
+  // 切片：h=30 的 L×C 平面，左上角（高 L、低 C）在 sRGB 内，右下角（低 L、高 C）在 P3 之外
+  uint8_t slice[8 * 8 * 4], smask[8 * 8];
+  CHECK(okc_render_slice(OKC_SLICE_LC, 30.0, 0.37, 8, 8, 0, 1, slice, smask) == 0, "okc_render_slice failed");
+  CHECK(smask[0] == 2 && slice[3] == 255 && smask[63] == 0 && slice[63 * 4 + 3] == 0, "slice mask %d/%d", smask[0],
+        smask[63]);
+
+  // 渐变：两个相同停靠点的线性渐变，每个像素都等于该颜色单独转换的结果
+  okc_gradient grad = {OKC_GRADIENT_LINEAR, 0, 0, 0, 0, 0, 8, 0, 0, 0};
+  okc_gradient_stop gstops[2] = {{0, 0.7, 0.2, 30, 1}, {1, 0.7, 0.2, 30, 1}};
+  uint8_t gimg[8 * 2 * 4];
+  CHECK(okc_render_gradient(&grad, gstops, 2, 8, 2, 1, gimg) == 0, "okc_render_gradient failed");
+  CHECK(gimg[60] == 255 && gimg[61] == 101 && gimg[62] == 81 && gimg[63] == 255, "gradient => %d %d %d %d", gimg[60],
+        gimg[61], gimg[62], gimg[63]);
+
+  // 色域映射：P3 纯红在 sRGB 之外，映射后仍偏红；P3 灰原样保留，alpha 不变
+  uint8_t p3[8] = {255, 0, 0, 200, 128, 128, 128, 255}, p3out[8];
+  int64_t oog = okc_gamut_map_p3_image(p3, p3out, 2, 1, 1);
+  CHECK(oog == 1 && p3out[0] == 255 && p3out[1] < 64 && p3out[3] == 200, "gamut map red => %lld: %d %d %d %d",
+        (long long)oog, p3out[0], p3out[1], p3out[2], p3out[3]);
+  CHECK(p3out[4] == 128 && p3out[5] == 128 && p3out[6] == 128 && p3out[7] == 255, "gamut map gray => %d %d %d",
+        p3out[4], p3out[5], p3out[6]);
+
+  // rgb2oklch 255 255 255 => 1 0 0
+  okc_rgb2oklch_init();
+  uint8_t white[3] = {255, 255, 255};
+  double w[3];
+  okc_rgb8_to_oklch_batch(white, 1, w);
+  CHECK(w[0] > 0.9999 && w[0] < 1.0001 && w[1] < 1e-4, "rgb2oklch => %g %g %g", w[0], w[1], w[2]);
+
+  // 去重：白与 #fefefe 相距约 0.003，黑单独成组
+  uint8_t trio[9] = {255, 255, 255, 254, 254, 254, 0, 0, 0};
+  uint32_t lab[3];
+  okc_pair pr[2];
+  int64_t groups = okc_dedup_labels(trio, 3, 0.02, 0, lab);
+  CHECK(groups == 2 && lab[0] == 0 && lab[1] == 0 && lab[2] == 2, "dedup labels => %lld", (long long)groups);
+  int64_t np = okc_dedup_pairs(trio, 3, 0.02, 2, pr, 2);
+  CHECK(np == 1 && pr[0].i == 0 && pr[0].j == 1 && pr[0].distance < 0.01f, "dedup pairs => %lld", (long long)np);
+
+  // 合成：白色前景以 darken 叠到 #ff6551 上保留背景；normal 不透明时等于前景
+  uint8_t bg[8] = {255, 101, 81, 255, 255, 101, 81, 255}, fg[8] = {255, 255, 255, 255, 0, 0, 0, 255};
+  CHECK(okc_blend_oklab(bg, fg, 1, OKC_BLEND_DARKEN, 1.0) == 0 && bg[0] == 255 && bg[1] == 101 && bg[2] == 81,
+        "blend darken => %d %d %d", bg[0], bg[1], bg[2]);
+  CHECK(okc_blend_oklab(bg + 4, fg + 4, 1, OKC_BLEND_NORMAL, 1.0) == 0 && bg[4] == 0 && bg[5] == 0 && bg[7] == 255,
+        "blend normal => %d %d %d %d", bg[4], bg[5], bg[6], bg[7]);
+  CHECK(okc_blend_oklab(bg, fg, 1, (okc_blend_mode)7, 1.0) == -1, "blend invalid mode accepted");
+
+  // 任意空间转换：P3 白 -> OKLCH 为 (1, 0, 0)；sRGB -> Display-P3 -> sRGB 往返不失真
+  double cw[6] = {1, 1, 1, 0.8, 0.2, 0.4}, cb[3];
+  CHECK(okc_convert(OKC_SPACE_DISPLAY_P3, OKC_SPACE_OKLCH, cw, 1, cb) == 0 && cb[0] > 0.9999 && cb[0] < 1.0001 &&
+            cb[1] < 1e-4,
+        "convert p3 -> oklch => %g %g %g", cb[0], cb[1], cb[2]);
+  okc_convert(OKC_SPACE_SRGB, OKC_SPACE_DISPLAY_P3, cw + 3, 1, cb);
+  okc_convert(OKC_SPACE_DISPLAY_P3, OKC_SPACE_SRGB, cb, 1, cb);
+  CHECK(fabs(cb[0] - 0.8) < 1e-9 && fabs(cb[1] - 0.2) < 1e-9 && fabs(cb[2] - 0.4) < 1e-9, "convert round trip => %g %g %g",
+        cb[0], cb[1], cb[2]);
+
+  // CVD：灰不受模拟影响；红绿在 deutan 下的最小 deltaEOK 远小于正常视觉
+  uint8_t cg[4] = {128, 128, 128, 77};
+  CHECK(okc_cvd_simulate(cg, 1, OKC_CVD_PROTAN, 1.0) == 0 && cg[0] == 128 && cg[1] == 128 && cg[2] == 128 && cg[3] == 77,
+        "cvd gray => %d %d %d %d", cg[0], cg[1], cg[2], cg[3]);
+  CHECK(okc_cvd_simulate(cg, 1, OKC_CVD_TRITAN, 1.5) == -1, "cvd invalid severity accepted");
+  uint8_t rg[6] = {255, 0, 0, 0, 170, 0};
+  okc_cvd_min cm[4];
+  CHECK(okc_cvd_check(rg, 2, 1.0, cm) == 0 && cm[0].distance > 0.3 && cm[2].distance < 0.05 && cm[2].j == 1,
+        "cvd check => normal %g deutan %g", cm[0].distance, cm[2].distance);
+
+  // 取色：左红右蓝的 64x64 图，整图与分批喂入结果一致
+  enum { W = 64, H = 64 };
+  uint8_t *img = (uint8_t *)malloc((size_t)W * H * 4);
+  for (int y = 0; y < H; ++y)
+    for (int x = 0; x < W; ++x)
+    {
+      uint8_t *p = img + ((size_t)y * W + x) * 4;
+      p[0] = x < W / 2 ? 255 : 0;
+      p[1] = 0;
+      p[2] = x < W / 2 ? 0 : 255;
+      p[3] = 255;
+    }
+  okc_color a[16], b[16];
+  okc_extractor *ex = okc_extractor_create(NULL);
+  CHECK(ex != NULL, "okc_extractor_create");
+  int na = okc_extractor_run(ex, img, W, H, a, 16);
+  CHECK(na == 2, "extractor_run => %d colors", na);
+  okc_extractor_begin(ex, W, H);
+  for (int y = 0; y < H; y += 7)
+    okc_extractor_feed(ex, img + (size_t)y * W * 4, (H - y) < 7 ? (H - y) : 7, (size_t)W * 4);
+  int nb = okc_extractor_finish(ex, b, 16);
+  CHECK(nb == na, "extractor feed => %d colors (run %d)", nb, na);
+  for (int i = 0; i < na && i < nb; ++i)
+    CHECK(strcmp(a[i].hex, b[i].hex) == 0 && a[i].area == b[i].area, "color %d: %s vs %s", i, a[i].hex, b[i].hex);
+  // 渐进：零预算只完成第一级，仍给出两色；不限预算走完全部级数，与整图结果一致
+  CHECK(okc_extractor_progressive_begin(ex, img, W, H, (size_t)W * 4) == 0, "progressive_begin failed");
+  int np0 = okc_extractor_progressive_run(ex, 0.0, b, 16);
+  CHECK(np0 == 2 && okc_extractor_progressive_stage(ex) == 1, "progressive first stage => %d colors, stage %d", np0,
+        okc_extractor_progressive_stage(ex));
+  int np1 = okc_extractor_progressive_run(ex, 1e9, b, 16);
+  CHECK(np1 == na && okc_extractor_progressive_stage(ex) == OKC_PROGRESSIVE_STAGES, "progressive => %d colors, stage %d",
+        np1, okc_extractor_progressive_stage(ex));
+  for (int i = 0; i < na && i < np1; ++i)
+    CHECK(strcmp(a[i].hex, b[i].hex) == 0, "progressive color %d: %s vs %s", i, a[i].hex, b[i].hex);
+  // 会话：首次全部计算；只改合并阈值时只重新合并，改 maxColors 重新聚类，改 pixels 重新采样
+  okc_extract_options so;
+  okc_extract_options_default(&so);
+  CHECK(okc_extractor_session_begin(ex, img, W, H) == 0, "session_begin failed");
+  int ns = okc_extractor_session_run(ex, b, 16);
+  CHECK(ns == na && okc_extractor_session_recomputed(ex) == 7, "session => %d colors, recomputed %d", ns,
+        okc_extractor_session_recomputed(ex));
+  so.distance = 0.3;
+  so.hueDistance = 0.1;
+  okc_extractor_set_options(ex, &so);
+  ns = okc_extractor_session_run(ex, b, 16);
+  CHECK(ns == na && okc_extractor_session_recomputed(ex) == OKC_SESSION_MERGE, "session merge => %d, recomputed %d",
+        ns, okc_extractor_session_recomputed(ex));
+  so.maxColors = 8;
+  okc_extractor_set_options(ex, &so);
+  okc_extractor_session_run(ex, b, 16);
+  CHECK(okc_extractor_session_recomputed(ex) == (OKC_SESSION_CLUSTERS | OKC_SESSION_MERGE), "session K => %d",
+        okc_extractor_session_recomputed(ex));
+  so.pixels = 1000;
+  okc_extractor_set_options(ex, &so);
+  okc_extractor_session_run(ex, b, 16);
+  CHECK(okc_extractor_session_recomputed(ex) == 7, "session pixels => %d", okc_extractor_session_recomputed(ex));
+  // 全部 K：两种颜色只能拆出 K = 1、2；K = 1 为两色的均值，K = 2 与整图结果一致
+  okc_extract_options_default(&so);
+  okc_extractor_set_options(ex, &so);
+  int levels = okc_extractor_hierarchy_build(ex, img, W, H, 0);
+  CHECK(levels == 2, "hierarchy levels => %d", levels);
+  int nk1 = okc_extractor_hierarchy_palette(ex, 1, b, 16);
+  CHECK(nk1 == 1 && strcmp(b[0].hex, "#800080") == 0, "hierarchy K=1 => %d %s", nk1, nk1 > 0 ? b[0].hex : "");
+  int nk2 = okc_extractor_hierarchy_palette(ex, 2, b, 16);
+  // 红蓝面积与亮度相同，排序不分先后
+  int swap = nk2 == 2 && strcmp(a[0].hex, b[0].hex) != 0;
+  CHECK(nk2 == na && strcmp(a[0].hex, b[swap].hex) == 0 && strcmp(a[1].hex, b[!swap].hex) == 0,
+        "hierarchy K=2 => %d %s", nk2, nk2 > 0 ? b[0].hex : "");
+  CHECK(okc_extractor_hierarchy_palette(ex, 3, b, 16) == -1, "hierarchy K=3 should fail");
+  okc_extractor_destroy(ex);
+  free(img);
+
+  // 调色板索引：红蓝、纯绿两条；以红蓝查询时自身排第一且相似度为 1，与纯绿无交集
+  okc_color pal[3] = {{"#ff0000", 255, 0, 0, 0, 0, 0, 0, 0.75},
+                      {"#0000ff", 0, 0, 255, 0, 0, 0, 0, 0.25},
+                      {"#00ff00", 0, 255, 0, 0, 0, 0, 0, 1.0}};
+  uint8_t sigs[2 * OKC_PALETTE_SIG_BYTES];
+  okc_palette_signature(pal, 2, sigs);
+  okc_palette_signature(pal + 2, 1, sigs + OKC_PALETTE_SIG_BYTES);
+  const char *ids[2] = {"red-blue", "green"};
+  CHECK(okc_palette_index_write("build/lib/smoke.okpi", sigs, ids, 2) == 0, "okc_palette_index_write failed");
+  okc_palette_index *pidx = okc_palette_index_open("build/lib/smoke.okpi");
+  CHECK(pidx && okc_palette_index_count(pidx) == 2, "okc_palette_index_open failed");
+  if (pidx)
+  {
+    okc_palette_hit hits[2];
+    int nh = okc_palette_index_query(pidx, sigs, 2, 2, hits);
+    CHECK(nh == 2 && hits[0].index == 0 && hits[0].similarity == 1.0 && strcmp(hits[0].id, "red-blue") == 0 &&
+              hits[1].similarity < 0.05,
+          "palette query => %d: %g %s / %g", nh, nh > 0 ? hits[0].similarity : 0.0, nh > 0 ? hits[0].id : "",
+          nh > 1 ? hits[1].similarity : 0.0);
+    okc_palette_index_close(pidx);
+  }
+
+  // YUV：BT.601 limited 的纯红 NV12 帧直接取色 => #ff0000；GRAY 不需要色度平面
+  uint8_t yplane[16], uv[8];
+  memset(yplane, 81, sizeof yplane);
+  for (int i = 0; i < 8; i += 2)
+  {
+    uv[i] = 90;
+    uv[i + 1] = 240;
+  }
+  okc_yuv_frame yf = {yplane, uv, NULL, 4, 4, 4, 4, OKC_YUV_NV12, 0};
+  okc_extract_options eo;
+  okc_extract_options_default(&eo);
+  okc_color yc[4];
+  int ny = okc_extract_colors_yuv(&yf, &eo, yc, 4);
+  CHECK(ny == 1 && strcmp(yc[0].hex, "#ff0000") == 0, "yuv nv12 => %d %s", ny, ny > 0 ? yc[0].hex : "");
+  yf.format = OKC_YUV_GRAY;
+  yf.u = NULL;
+  CHECK(okc_extract_colors_yuv(&yf, &eo, yc, 4) == 1, "yuv gray failed");
+
+  // 索引色：4 位下标，3/4 为红、1/4 为透明项 => 只剩 #ff0000
+  const uint8_t ipal[8] = {255, 0, 0, 255, 0, 0, 255, 0};
+  const uint8_t idx4[4] = {0x00, 0x01, 0x00, 0x01};
+  okc_indexed_image ii = {idx4, 1, 2, 4, 4, ipal, 2};
+  int ni = okc_extract_colors_indexed(&ii, &eo, yc, 4);
+  CHECK(ni == 1 && strcmp(yc[0].hex, "#ff0000") == 0, "indexed => %d %s", ni, ni > 0 ? yc[0].hex : "");
+
+  // 路径：上下文批量与单次 okc_shape_path 一致
+  char one[4096];
+  size_t n1 = okc_shape_path(OKC_SHAPE_CAPSULE, 300, 80, 40, one, sizeof one);
+  okc_path_builder *pb = okc_path_builder_create();
+  double specs[8] = {OKC_SHAPE_SQUIRCLE, 200, 120, 16, OKC_SHAPE_CAPSULE, 300, 80, 40};
+  size_t ranges[4], total = 0;
+  const char *data = okc_path_builder_batch(pb, specs, 2, ranges, &total);
+  CHECK(data && ranges[3] == n1 && memcmp(data + ranges[2], one, n1) == 0, "path_builder_batch capsule mismatch");
+  CHECK(total == ranges[1] + ranges[3], "path_builder_batch total %zu", total);
+  okc_path_builder_destroy(pb);
+
+  if (!g_fail)
+    printf("[OK] libokcolor\n");
+  return g_fail;
+}
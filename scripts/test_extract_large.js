@@ -0,0 +1,91 @@
+#!/usr/bin/env node
+/*
+Large-image check for extract-colors.wasm under Node with a synthetic 100 MP input:
+- chunked feeding (extract_stream_*) keeps peak linear memory small
+- the whole-image path grows memory geometrically up to the 4 GB limit
+- release_pixels_buffer frees the pixel buffer for long-lived pages
+
+Usage: node scripts/test_extract_large.js [megapixels]
+*/
+const fs = require('node:fs');
+const path = require('node:path');
+
+function stubImports(mod) {
+  const imports = {};
+  for (const imp of WebAssembly.Module.imports(mod)) {
+    if (imp.kind !== 'function') continue;
+    (imports[imp.module] ??= {})[imp.name] = () => 0;
+  }
+  return imports;
+}
+
+function fillRow(dst, w, y) {
+  for (let x = 0, o = 0; x < w; x++, o += 4) {
+    dst[o] = (x * 7 + y) & 255;
+    dst[o + 1] = (y * 3) & 255;
+    dst[o + 2] = (x ^ y) & 255;
+    dst[o + 3] = 255;
+  }
+}
+
+function stats(ex) {
+  const f64 = new Float64Array(ex.memory.buffer, ex.wasm_memory_stats_js() >>> 0, 4);
+  return { current: f64[0], peak: f64[1], pixelsBuffer: f64[2], pixelsBufferPeak: f64[3] };
+}
+
+const MB = 1024 * 1024;
+function fail(msg) { console.error('[FAIL]', msg); process.exit(1); }
+
+function main() {
+  const mp = Math.max(1, parseFloat(process.argv[2] || '100'));
+  const w = 10000;
+  const h = Math.round((mp * 1e6) / w);
+  const buf = fs.readFileSync(path.join(__dirname, '..', 'wasm', 'extract-colors.wasm'));
+  const mod = new WebAssembly.Module(buf);
+  const ex = new WebAssembly.Instance(mod, stubImports(mod)).exports;
+
+  // 1) 分块喂入：只生成/拷贝被采样的行
+  let t0 = Date.now();
+  const step = ex.extract_stream_begin_js(w, h, 64000, 250);
+  if (step <= 0) fail('extract_stream_begin_js returned ' + step);
+  const rowBytes = w * 4;
+  const bandRows = 64;
+  const ptr = ex.get_pixels_buffer(bandRows * rowBytes) >>> 0;
+  if (!ptr) fail('get_pixels_buffer (band) returned 0');
+  const band = new Uint8Array(ex.memory.buffer, ptr, bandRows * rowBytes);
+  let rows = 0;
+  for (let y = 0; y < h; y += step) {
+    fillRow(band.subarray(rows * rowBytes), w, y);
+    if (++rows === bandRows) { ex.extract_stream_feed_js(ptr, rows); rows = 0; }
+  }
+  if (rows) ex.extract_stream_feed_js(ptr, rows);
+  const outPtr = ex.extract_stream_finish_js(0.22, 0.2, 0.2, 1 / 12, 16) >>> 0;
+  if (!outPtr) fail('extract_stream_finish_js returned 0');
+  const m = new Float64Array(ex.memory.buffer, outPtr, 1)[0];
+  const s1 = stats(ex);
+  if (!(m > 0)) fail('no colors from chunked path');
+  if (s1.peak > 64 * MB) fail(`chunked path peak memory too high: ${(s1.peak / MB).toFixed(1)} MB`);
+  console.log(`[OK] chunked ${w}x${h}: step ${step}, ${m} colors, peak ${(s1.peak / MB).toFixed(1)} MB, ${Date.now() - t0} ms`);
+
+  // 2) 整图路径：一次拷入 100 MP，验证内存可增长
+  t0 = Date.now();
+  const len = w * h * 4;
+  const p2 = ex.get_pixels_buffer(len) >>> 0;
+  if (!p2) fail('get_pixels_buffer (whole image) returned 0');
+  const heap = new Uint8Array(ex.memory.buffer, p2, len);
+  for (let y = 0; y < h; y++) fillRow(heap.subarray(y * rowBytes), w, y);
+  const out2 = ex.extract_colors_from_rgba_js(p2, w, h, 64000, 0.22, 0.2, 0.2, 1 / 12, 250, 16) >>> 0;
+  if (!out2) fail('extract_colors_from_rgba_js returned 0');
+  const m2 = new Float64Array(ex.memory.buffer, out2, 1)[0];
+  if (m2 !== m) console.log(`[WARN] chunked/whole color count differ (${m} vs ${m2}); k-means seeding is random`);
+  const s2 = stats(ex);
+  console.log(`[OK] whole image: ${m2} colors, memory ${(s2.current / MB).toFixed(1)} MB (peak ${(s2.peak / MB).toFixed(1)} MB), ${Date.now() - t0} ms`);
+
+  // 3) 释放
+  ex.release_pixels_buffer(0);
+  const s3 = stats(ex);
+  if (s3.pixelsBuffer !== 0) fail('release_pixels_buffer did not free the buffer');
+  console.log(`[OK] released pixel buffer (peak buffer ${(s3.pixelsBufferPeak / MB).toFixed(1)} MB)`);
+}
+
+main();
@@ -6,10 +6,14 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <stdarg.h>
+#include <stdint.h>
 #include <ctype.h>
 #include <math.h>
 
+#ifdef OKCOLOR_EMBED
+#include "okcolor.h"
+#endif
+
 typedef struct
 {
   double r160, r103, r075, r010, r054, r020, r035, r096;
@@ -46,53 +50,52 @@ static size_t fmt3(double x, char *out, size_t out_size)
 
   long long s = (long long)rounded;
   int neg = (s < 0);
-  unsigned long long us = (unsigned long long)(neg ? -s : s);
+  unsigned long long us = neg ? 0ULL - (unsigned long long)s : (unsigned long long)s;
   unsigned long long ip = us / 1000ULL;
-  unsigned long long frac = us % 1000ULL;
+  unsigned frac = (unsigned)(us % 1000ULL);
 
-  char buf[64];
-  size_t p = 0;
-  if (neg)
-    buf[p++] = '-';
-
-  // 写整数部分（反向生成再反转）
-  char tmp[32];
-  size_t ti = 0;
-  if (ip == 0ULL)
-    tmp[ti++] = '0';
-  else
+  // 从缓冲末尾向前写：小数部分、整数部分、符号
+  char buf[32];
+  char *e = buf + sizeof(buf);
+  char *b = e;
+  if (frac != 0u)
   {
-    while (ip > 0ULL && ti < sizeof(tmp))
+    int flen = 3; // 去除末尾 0，保留中间的 0（如 296.076）
+    while (frac % 10u == 0u)
     {
-      tmp[ti++] = (char)('0' + (ip % 10ULL));
-      ip /= 10ULL;
+      frac /= 10u;
+      --flen;
+    }
+    for (int i = 0; i < flen; ++i)
+    {
+      *--b = (char)('0' + frac % 10u);
+      frac /= 10u;
     }
+    *--b = '.';
   }
-  for (size_t i = 0; i < ti && p < sizeof(buf); ++i)
-    buf[p++] = tmp[ti - 1 - i];
-
-  if (frac != 0ULL)
+  // 整数部分多在 32 位范围内，用 32 位除法
+  if (ip <= 0xFFFFFFFFULL)
   {
-    // 打印固定 3 位再去除末尾 0，避免丢失中间的 0（如 296.076）
-    char ft3[3];
-    ft3[0] = (char)('0' + (int)((frac / 100ULL) % 10ULL));
-    ft3[1] = (char)('0' + (int)((frac / 10ULL) % 10ULL));
-    ft3[2] = (char)('0' + (int)(frac % 10ULL));
-
-    int flen = 3;
-    while (flen > 0 && ft3[flen - 1] == '0')
-      --flen; // 仅移除末尾 0
-
-    if (flen > 0)
+    uint32_t ip32 = (uint32_t)ip;
+    do
     {
-      buf[p++] = '.';
-      for (int i = 0; i < flen && p < (int)sizeof(buf); ++i)
-        buf[p++] = ft3[i];
-    }
+      *--b = (char)('0' + ip32 % 10u);
+      ip32 /= 10u;
+    } while (ip32);
   }
-
+  else
+  {
+    do
+    {
+      *--b = (char)('0' + (int)(ip % 10ULL));
+      ip /= 10ULL;
+    } while (ip);
+  }
+  if (neg)
+    *--b = '-';
+  size_t p = (size_t)(e - b);
   size_t n = (p < out_size - 1) ? p : (out_size - 1);
-  memcpy(out, buf, n);
+  memcpy(out, b, n);
   out[n] = '\0';
   return n;
 }
@@ -102,13 +105,15 @@ typedef struct
   char *data;
   size_t len;
   size_t cap;
+  int oom; // 扩容失败后置 1（粘滞）：之后的写入全部跳过，内容不完整，调用方据此报告失败
 } StrBuf;
 
 static void sb_init(StrBuf *sb, size_t cap)
 {
   sb->data = (char *)malloc(cap);
   sb->len = 0;
-  sb->cap = cap;
+  sb->cap = sb->data ? cap : 0;
+  sb->oom = !sb->data;
   if (sb->data)
     sb->data[0] = '\0';
 }
@@ -118,69 +123,28 @@ static void sb_free(StrBuf *sb)
   free(sb->data);
   sb->data = NULL;
   sb->len = sb->cap = 0;
+  sb->oom = 0;
 }
 
-static void sb_ensure(StrBuf *sb, size_t extra)
+// 保证还能写入 extra 字节（外加 NUL）；失败返回 0 并置 oom，原有内容保持不变
+static int sb_ensure(StrBuf *sb, size_t extra)
 {
+  if (sb->oom)
+    return 0;
   if (sb->len + extra + 1 <= sb->cap)
-    return;
+    return 1;
   size_t ncap = sb->cap ? sb->cap : 256;
   while (sb->len + extra + 1 > ncap)
     ncap *= 2;
   char *nd = (char *)realloc(sb->data, ncap);
   if (!nd)
-    return; // 失败时静默，后续写入会出错，但避免崩溃
-  sb->data = nd;
-  sb->cap = ncap;
-}
-
-static void sb_append(StrBuf *sb, const char *s)
-{
-  size_t sl = strlen(s);
-  sb_ensure(sb, sl);
-  if (!sb->data)
-    return;
-  memcpy(sb->data + sb->len, s, sl);
-  sb->len += sl;
-  sb->data[sb->len] = '\0';
-}
-
-static void sb_append_len(StrBuf *sb, const char *s, size_t sl)
-{
-  sb_ensure(sb, sl);
-  if (!sb->data)
-    return;
-  memcpy(sb->data + sb->len, s, sl);
-  sb->len += sl;
-  sb->data[sb->len] = '\0';
-}
-
-#define SB_APP_LIT(sb, lit) sb_append_len((sb), (lit), sizeof(lit) - 1)
-
-static void sb_appendf(StrBuf *sb, const char *fmt, ...)
-{
-  va_list ap;
-  va_start(ap, fmt);
-  // 试探性写入
-  char tmp[512];
-  int n = vsnprintf(tmp, sizeof(tmp), fmt, ap);
-  va_end(ap);
-  if (n < 0)
-    return;
-  if ((size_t)n < sizeof(tmp))
   {
-    sb_append(sb, tmp);
-    return;
+    sb->oom = 1;
+    return 0;
   }
-  // 需要更大缓冲
-  char *buf = (char *)malloc((size_t)n + 1);
-  if (!buf)
-    return;
-  va_start(ap, fmt);
-  vsnprintf(buf, (size_t)n + 1, fmt, ap);
-  va_end(ap);
-  sb_append(sb, buf);
-  free(buf);
+  sb->data = nd;
+  sb->cap = ncap;
+  return 1;
 }
 
 typedef struct
@@ -200,6 +164,20 @@ typedef struct
   size_t hm_r160_len, hm_r103_len, hm_r075_len, hm_r054_len, hm_r035_len, hm_r020_len, hm_r010_len, hm_r096_len;
 } PreFmt;
 
+// 路径按游标直接写入预留好的缓冲：数字字段整块复制 32 字节（定长 memcpy 编译为几条 store），
+// 再按实际长度前进；每条路径不超过 67 个数字（各 <= 24 字节）与 128 字节字面量，
+// 末个数字最多多写 32 字节，故一次预留 SHAPE_PATH_RESERVE 即可，不必逐段检查容量
+#define SHAPE_PATH_RESERVE (68 * 32 + 128)
+#define PF_PUT(p, pf, f) (memcpy((p), (pf).f, sizeof((pf).f)), (p) += (pf).f##_len)
+#define LIT_PUT(p, lit) (memcpy((p), (lit), sizeof(lit) - 1), (p) += sizeof(lit) - 1)
+
+// 游标写完后提交长度并补 NUL
+static inline void sb_commit(StrBuf *sb, char *end)
+{
+  sb->len = (size_t)(end - sb->data);
+  sb->data[sb->len] = '\0';
+}
+
 static void precompute_fmt(double w, double h, double r, const RadiusVals *v, PreFmt *pf)
 {
   pf->w_len = fmt3(w, pf->w, sizeof(pf->w));
@@ -232,322 +210,383 @@ static void precompute_fmt(double w, double h, double r, const RadiusVals *v, Pr
   pf->hm_r096_len = fmt3(h - v->r096, pf->hm_r096, sizeof(pf->hm_r096));
 }
 
-static char *build_path_squircle(double w, double h, double r)
+// 将路径追加到 sb 末尾（不分配新缓冲，批量接口复用同一 StrBuf）
+static void append_path_squircle(StrBuf *sb, double w, double h, double r)
 {
   RadiusVals v = get_radius_values(r);
   PreFmt pf;
   precompute_fmt(w, h, r, &v, &pf);
-  StrBuf sb;
-  sb_init(&sb, 2048);
+  if (!sb_ensure(sb, SHAPE_PATH_RESERVE))
+    return;
+  char *p = sb->data + sb->len;
 
   // 为避免过多格式占位，按段拼接
-  SB_APP_LIT(&sb, "M0 ");
-  sb_append_len(&sb, pf.r160, pf.r160_len);
-  SB_APP_LIT(&sb, " C0 ");
-  sb_append_len(&sb, pf.r103, pf.r103_len);
-  SB_APP_LIT(&sb, " 0 ");
-  sb_append_len(&sb, pf.r075, pf.r075_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.r010, pf.r010_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.r054, pf.r054_len);
-
-  SB_APP_LIT(&sb, " C ");
-  sb_append_len(&sb, pf.r020, pf.r020_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.r035, pf.r035_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.r035, pf.r035_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.r020, pf.r020_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.r054, pf.r054_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.r010, pf.r010_len);
-
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.r075, pf.r075_len);
-  SB_APP_LIT(&sb, " 0 ");
-  sb_append_len(&sb, pf.r103, pf.r103_len);
-  SB_APP_LIT(&sb, " 0 ");
-  sb_append_len(&sb, pf.r160, pf.r160_len);
-  SB_APP_LIT(&sb, " 0 H ");
-  sb_append_len(&sb, pf.wm_r160, pf.wm_r160_len);
-
-  SB_APP_LIT(&sb, " C ");
-  sb_append_len(&sb, pf.wm_r103, pf.wm_r103_len);
-  SB_APP_LIT(&sb, " 0 ");
-  sb_append_len(&sb, pf.wm_r075, pf.wm_r075_len);
-  SB_APP_LIT(&sb, " 0 ");
-  sb_append_len(&sb, pf.wm_r054, pf.wm_r054_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.r010, pf.r010_len);
-
-  SB_APP_LIT(&sb, " C ");
-  sb_append_len(&sb, pf.wm_r035, pf.wm_r035_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.r020, pf.r020_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.wm_r020, pf.wm_r020_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.r035, pf.r035_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.wm_r010, pf.wm_r010_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.r054, pf.r054_len);
-
-  SB_APP_LIT(&sb, " C ");
-  sb_append_len(&sb, pf.w, pf.w_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.r075, pf.r075_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.w, pf.w_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.r103, pf.r103_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.w, pf.w_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.r160, pf.r160_len);
-
-  SB_APP_LIT(&sb, " V ");
-  sb_append_len(&sb, pf.hm_r160, pf.hm_r160_len);
-  SB_APP_LIT(&sb, " C ");
-  sb_append_len(&sb, pf.w, pf.w_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.hm_r103, pf.hm_r103_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.w, pf.w_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.hm_r075, pf.hm_r075_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.wm_r010, pf.wm_r010_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.hm_r054, pf.hm_r054_len);
-
-  SB_APP_LIT(&sb, " C ");
-  sb_append_len(&sb, pf.wm_r020, pf.wm_r020_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.hm_r035, pf.hm_r035_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.wm_r035, pf.wm_r035_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.hm_r020, pf.hm_r020_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.wm_r054, pf.wm_r054_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.hm_r010, pf.hm_r010_len);
-
-  SB_APP_LIT(&sb, " C ");
-  sb_append_len(&sb, pf.wm_r075, pf.wm_r075_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.h, pf.h_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.wm_r103, pf.wm_r103_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.h, pf.h_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.wm_r160, pf.wm_r160_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.h, pf.h_len);
-
-  SB_APP_LIT(&sb, " H ");
-  sb_append_len(&sb, pf.r160, pf.r160_len);
-  SB_APP_LIT(&sb, " C ");
-  sb_append_len(&sb, pf.r103, pf.r103_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.h, pf.h_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.r075, pf.r075_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.h, pf.h_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.r054, pf.r054_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.hm_r010, pf.hm_r010_len);
-
-  SB_APP_LIT(&sb, " C ");
-  sb_append_len(&sb, pf.r035, pf.r035_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.hm_r020, pf.hm_r020_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.r020, pf.r020_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.hm_r035, pf.hm_r035_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.r010, pf.r010_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.hm_r054, pf.hm_r054_len);
-
-  SB_APP_LIT(&sb, " C 0 ");
-  sb_append_len(&sb, pf.hm_r075, pf.hm_r075_len);
-  SB_APP_LIT(&sb, " 0 ");
-  sb_append_len(&sb, pf.hm_r103, pf.hm_r103_len);
-  SB_APP_LIT(&sb, " 0 ");
-  sb_append_len(&sb, pf.hm_r160, pf.hm_r160_len);
-  SB_APP_LIT(&sb, " V ");
-  sb_append_len(&sb, pf.r160, pf.r160_len);
-  SB_APP_LIT(&sb, " Z");
+  LIT_PUT(p, "M0 ");
+  PF_PUT(p, pf, r160);
+  LIT_PUT(p, " C0 ");
+  PF_PUT(p, pf, r103);
+  LIT_PUT(p, " 0 ");
+  PF_PUT(p, pf, r075);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, r010);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, r054);
+
+  LIT_PUT(p, " C ");
+  PF_PUT(p, pf, r020);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, r035);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, r035);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, r020);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, r054);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, r010);
+
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, r075);
+  LIT_PUT(p, " 0 ");
+  PF_PUT(p, pf, r103);
+  LIT_PUT(p, " 0 ");
+  PF_PUT(p, pf, r160);
+  LIT_PUT(p, " 0 H ");
+  PF_PUT(p, pf, wm_r160);
+
+  LIT_PUT(p, " C ");
+  PF_PUT(p, pf, wm_r103);
+  LIT_PUT(p, " 0 ");
+  PF_PUT(p, pf, wm_r075);
+  LIT_PUT(p, " 0 ");
+  PF_PUT(p, pf, wm_r054);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, r010);
+
+  LIT_PUT(p, " C ");
+  PF_PUT(p, pf, wm_r035);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, r020);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, wm_r020);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, r035);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, wm_r010);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, r054);
+
+  LIT_PUT(p, " C ");
+  PF_PUT(p, pf, w);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, r075);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, w);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, r103);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, w);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, r160);
+
+  LIT_PUT(p, " V ");
+  PF_PUT(p, pf, hm_r160);
+  LIT_PUT(p, " C ");
+  PF_PUT(p, pf, w);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, hm_r103);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, w);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, hm_r075);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, wm_r010);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, hm_r054);
+
+  LIT_PUT(p, " C ");
+  PF_PUT(p, pf, wm_r020);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, hm_r035);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, wm_r035);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, hm_r020);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, wm_r054);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, hm_r010);
+
+  LIT_PUT(p, " C ");
+  PF_PUT(p, pf, wm_r075);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, h);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, wm_r103);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, h);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, wm_r160);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, h);
+
+  LIT_PUT(p, " H ");
+  PF_PUT(p, pf, r160);
+  LIT_PUT(p, " C ");
+  PF_PUT(p, pf, r103);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, h);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, r075);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, h);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, r054);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, hm_r010);
+
+  LIT_PUT(p, " C ");
+  PF_PUT(p, pf, r035);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, hm_r020);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, r020);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, hm_r035);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, r010);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, hm_r054);
+
+  LIT_PUT(p, " C 0 ");
+  PF_PUT(p, pf, hm_r075);
+  LIT_PUT(p, " 0 ");
+  PF_PUT(p, pf, hm_r103);
+  LIT_PUT(p, " 0 ");
+  PF_PUT(p, pf, hm_r160);
+  LIT_PUT(p, " V ");
+  PF_PUT(p, pf, r160);
+  LIT_PUT(p, " Z");
+  sb_commit(sb, p);
+}
 
+#ifndef OKCOLOR_EMBED
+// 单个路径的独立缓冲（CLI 与 Wasm 单路径导出用；嵌入接口走 okc_path_builder）
+static char *build_path_squircle(double w, double h, double r)
+{
+  StrBuf sb;
+  sb_init(&sb, 2048);
+  append_path_squircle(&sb, w, h, r);
+  if (sb.oom)
+  {
+    sb_free(&sb);
+    return NULL;
+  }
   return sb.data; // 交由调用者 free()
 }
+#endif
 
-static char *build_path_capsule(double w, double h, double r)
+// 将路径追加到 sb 末尾（不分配新缓冲，批量接口复用同一 StrBuf）
+static void append_path_capsule(StrBuf *sb, double w, double h, double r)
 {
   RadiusVals v = get_radius_values(r);
   PreFmt pf;
   precompute_fmt(w, h, r, &v, &pf);
+  if (!sb_ensure(sb, SHAPE_PATH_RESERVE))
+    return;
+  char *p = sb->data + sb->len;
+
+  LIT_PUT(p, "M ");
+  PF_PUT(p, pf, wm_r160);
+  LIT_PUT(p, " 0 H ");
+  PF_PUT(p, pf, r160);
+
+  LIT_PUT(p, " C ");
+  PF_PUT(p, pf, r103);
+  LIT_PUT(p, " 0 ");
+  PF_PUT(p, pf, r075);
+  LIT_PUT(p, " 0 ");
+  PF_PUT(p, pf, r054);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, r010);
+
+  LIT_PUT(p, " C ");
+  PF_PUT(p, pf, r035);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, r020);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, r020);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, r035);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, r010);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, r054);
+
+  LIT_PUT(p, " C 0 ");
+  PF_PUT(p, pf, r075);
+  LIT_PUT(p, " 0 ");
+  PF_PUT(p, pf, r096);
+  LIT_PUT(p, " 0 ");
+  PF_PUT(p, pf, r);
+
+  LIT_PUT(p, " C 0 ");
+  PF_PUT(p, pf, hm_r096);
+  LIT_PUT(p, " 0 ");
+  PF_PUT(p, pf, hm_r075);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, r010);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, hm_r054);
+
+  LIT_PUT(p, " C ");
+  PF_PUT(p, pf, r020);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, hm_r035);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, r035);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, hm_r020);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, r054);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, hm_r010);
+
+  LIT_PUT(p, " C ");
+  PF_PUT(p, pf, r075);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, h);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, r103);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, h);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, r160);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, h);
+
+  LIT_PUT(p, " H ");
+  PF_PUT(p, pf, wm_r160);
+  LIT_PUT(p, " H ");
+  PF_PUT(p, pf, wm_r160);
+
+  LIT_PUT(p, " C ");
+  PF_PUT(p, pf, wm_r103);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, h);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, wm_r075);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, h);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, wm_r054);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, hm_r010);
+
+  LIT_PUT(p, " C ");
+  PF_PUT(p, pf, wm_r035);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, hm_r020);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, wm_r020);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, hm_r035);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, wm_r010);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, hm_r054);
+
+  LIT_PUT(p, " C ");
+  PF_PUT(p, pf, w);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, hm_r075);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, w);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, hm_r096);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, w);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, r);
+
+  LIT_PUT(p, " C ");
+  PF_PUT(p, pf, w);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, r096);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, w);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, r075);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, wm_r010);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, r054);
+
+  LIT_PUT(p, " C ");
+  PF_PUT(p, pf, wm_r020);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, r035);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, wm_r035);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, r020);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, wm_r054);
+  LIT_PUT(p, " ");
+  PF_PUT(p, pf, r010);
+
+  LIT_PUT(p, " C ");
+  PF_PUT(p, pf, wm_r075);
+  LIT_PUT(p, " 0 ");
+  PF_PUT(p, pf, wm_r103);
+  LIT_PUT(p, " 0 ");
+  PF_PUT(p, pf, wm_r160);
+  LIT_PUT(p, " 0 Z");
+  sb_commit(sb, p);
+}
+
+#ifndef OKCOLOR_EMBED
+static char *build_path_capsule(double w, double h, double r)
+{
   StrBuf sb;
   sb_init(&sb, 2048);
+  append_path_capsule(&sb, w, h, r);
+  if (sb.oom)
+  {
+    sb_free(&sb);
+    return NULL;
+  }
+  return sb.data;
+}
+#endif
 
-  SB_APP_LIT(&sb, "M ");
-  sb_append_len(&sb, pf.wm_r160, pf.wm_r160_len);
-  SB_APP_LIT(&sb, " 0 H ");
-  sb_append_len(&sb, pf.r160, pf.r160_len);
-
-  SB_APP_LIT(&sb, " C ");
-  sb_append_len(&sb, pf.r103, pf.r103_len);
-  SB_APP_LIT(&sb, " 0 ");
-  sb_append_len(&sb, pf.r075, pf.r075_len);
-  SB_APP_LIT(&sb, " 0 ");
-  sb_append_len(&sb, pf.r054, pf.r054_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.r010, pf.r010_len);
-
-  SB_APP_LIT(&sb, " C ");
-  sb_append_len(&sb, pf.r035, pf.r035_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.r020, pf.r020_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.r020, pf.r020_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.r035, pf.r035_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.r010, pf.r010_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.r054, pf.r054_len);
-
-  SB_APP_LIT(&sb, " C 0 ");
-  sb_append_len(&sb, pf.r075, pf.r075_len);
-  SB_APP_LIT(&sb, " 0 ");
-  sb_append_len(&sb, pf.r096, pf.r096_len);
-  SB_APP_LIT(&sb, " 0 ");
-  sb_append_len(&sb, pf.r, pf.r_len);
-
-  SB_APP_LIT(&sb, " C 0 ");
-  sb_append_len(&sb, pf.hm_r096, pf.hm_r096_len);
-  SB_APP_LIT(&sb, " 0 ");
-  sb_append_len(&sb, pf.hm_r075, pf.hm_r075_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.r010, pf.r010_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.hm_r054, pf.hm_r054_len);
-
-  SB_APP_LIT(&sb, " C ");
-  sb_append_len(&sb, pf.r020, pf.r020_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.hm_r035, pf.hm_r035_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.r035, pf.r035_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.hm_r020, pf.hm_r020_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.r054, pf.r054_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.hm_r010, pf.hm_r010_len);
-
-  SB_APP_LIT(&sb, " C ");
-  sb_append_len(&sb, pf.r075, pf.r075_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.h, pf.h_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.r103, pf.r103_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.h, pf.h_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.r160, pf.r160_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.h, pf.h_len);
-
-  SB_APP_LIT(&sb, " H ");
-  sb_append_len(&sb, pf.wm_r160, pf.wm_r160_len);
-  SB_APP_LIT(&sb, " H ");
-  sb_append_len(&sb, pf.wm_r160, pf.wm_r160_len);
-
-  SB_APP_LIT(&sb, " C ");
-  sb_append_len(&sb, pf.wm_r103, pf.wm_r103_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.h, pf.h_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.wm_r075, pf.wm_r075_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.h, pf.h_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.wm_r054, pf.wm_r054_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.hm_r010, pf.hm_r010_len);
-
-  SB_APP_LIT(&sb, " C ");
-  sb_append_len(&sb, pf.wm_r035, pf.wm_r035_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.hm_r020, pf.hm_r020_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.wm_r020, pf.wm_r020_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.hm_r035, pf.hm_r035_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.wm_r010, pf.wm_r010_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.hm_r054, pf.hm_r054_len);
-
-  SB_APP_LIT(&sb, " C ");
-  sb_append_len(&sb, pf.w, pf.w_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.hm_r075, pf.hm_r075_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.w, pf.w_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.hm_r096, pf.hm_r096_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.w, pf.w_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.r, pf.r_len);
-
-  SB_APP_LIT(&sb, " C ");
-  sb_append_len(&sb, pf.w, pf.w_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.r096, pf.r096_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.w, pf.w_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.r075, pf.r075_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.wm_r010, pf.wm_r010_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.r054, pf.r054_len);
-
-  SB_APP_LIT(&sb, " C ");
-  sb_append_len(&sb, pf.wm_r020, pf.wm_r020_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.r035, pf.r035_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.wm_r035, pf.wm_r035_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.r020, pf.r020_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.wm_r054, pf.wm_r054_len);
-  SB_APP_LIT(&sb, " ");
-  sb_append_len(&sb, pf.r010, pf.r010_len);
-
-  SB_APP_LIT(&sb, " C ");
-  sb_append_len(&sb, pf.wm_r075, pf.wm_r075_len);
-  SB_APP_LIT(&sb, " 0 ");
-  sb_append_len(&sb, pf.wm_r103, pf.wm_r103_len);
-  SB_APP_LIT(&sb, " 0 ");
-  sb_append_len(&sb, pf.wm_r160, pf.wm_r160_len);
-  SB_APP_LIT(&sb, " 0 Z");
+// 批量/嵌入接口的 shape 编码（与 okcolor.h 的 OKC_SHAPE_* 一致）
+#define SQUIRCLE_SHAPE_SQUIRCLE 0
+#define SQUIRCLE_SHAPE_CAPSULE 1
 
-  return sb.data;
+#if defined(__EMSCRIPTEN__) || defined(OKCOLOR_EMBED)
+// 生成路径写入调用方缓冲（NUL 结尾，超长截断），返回完整长度（snprintf 语义）；
+// 仅使用局部 StrBuf，可重入
+static size_t shape_path_into(int shape, double width, double height, double radius, char *out, size_t cap)
+{
+  StrBuf sb;
+  sb_init(&sb, 2048);
+  if (shape == SQUIRCLE_SHAPE_SQUIRCLE)
+    append_path_squircle(&sb, width, height, radius);
+  else if (shape == SQUIRCLE_SHAPE_CAPSULE)
+    append_path_capsule(&sb, width, height, radius);
+  size_t n = sb.oom ? 0 : sb.len;
+  if (out && cap > 0)
+  {
+    size_t k = n < cap - 1 ? n : cap - 1;
+    if (k)
+      memcpy(out, sb.data, k);
+    out[k] = '\0';
+  }
+  sb_free(&sb);
+  return n;
 }
+#endif
 
 #ifdef __EMSCRIPTEN__
 // 为 Wasm 导出：返回指向内部静态缓冲的指针（UTF-8, NUL 终止）
@@ -584,8 +623,171 @@ capsule_path_js(double w, double h, double r)
   free(tmp);
   return (uint32_t)(uintptr_t)g_path_out;
 }
+
+// 调用方缓冲版本：路径写入调用方提供的 out_ptr（cap 字节，NUL 结尾，超长截断），
+// 返回完整路径长度（不含 NUL；>= cap 表示被截断，可按该长度重新分配后重试）。
+// 不经过 g_path_out / 批量缓冲，结果不会被后续调用覆盖。
+__attribute__((export_name("shape_path_into_js")))
+uint32_t
+shape_path_into_js(int shape, double w, double h, double r, uint32_t out_ptr, uint32_t cap)
+{
+  return (uint32_t)shape_path_into(shape, w, h, r, (char *)(uintptr_t)out_ptr, cap);
+}
+
+__attribute__((export_name("squircle_alloc_js")))
+uint32_t
+squircle_alloc_js(uint32_t size)
+{
+  return (uint32_t)(uintptr_t)malloc(size ? size : 1);
+}
+
+__attribute__((export_name("squircle_free_js")))
+void squircle_free_js(uint32_t ptr)
+{
+  free((void *)(uintptr_t)ptr);
+}
+
+// ---- 批量接口：一次 Wasm 调用生成多条路径（供逐帧动画同步调用） ----
+// 输入：squircle_batch_specs_js(n) 返回 n*4 个 double 的写入区，JS 直接填写：
+//   [shape(0=squircle, 1=capsule), width, height, radius] × n
+// 输出：squircle_paths_batch_js(n) 返回指向 uint32 表的指针：
+//   [data_ptr, total_len, off0, len0, off1, len1, ...]
+//   所有路径紧密拼接在 data_ptr 处（ASCII，无分隔符）；off/len 为字节范围，未知 shape 的 len 为 0
+//   n == 0 返回 total_len 为 0 的空表；返回 0 仅表示缓冲不可用或分配失败
+// 缓冲在调用之间复用，只增不减，稳态下每帧零分配。
+static double *g_batch_specs = NULL;
+static uint32_t *g_batch_ranges = NULL;
+static size_t g_batch_cap = 0; // 以 spec 个数计
+static StrBuf g_batch_sb = {NULL, 0, 0, 0};
+
+__attribute__((export_name("squircle_batch_specs_js")))
+uint32_t
+squircle_batch_specs_js(uint32_t n)
+{
+  // n == 0 也分配最小缓冲：空批次是合法输入，返回 0 仅表示分配失败
+  if (n == 0)
+    n = 1;
+  if (n > g_batch_cap)
+  {
+    double *ns = (double *)realloc(g_batch_specs, (size_t)n * 4 * sizeof(double));
+    if (!ns)
+      return 0;
+    g_batch_specs = ns;
+    uint32_t *nr = (uint32_t *)realloc(g_batch_ranges, (2 + (size_t)n * 2) * sizeof(uint32_t));
+    if (!nr)
+      return 0;
+    g_batch_ranges = nr;
+    g_batch_cap = n;
+  }
+  return (uint32_t)(uintptr_t)g_batch_specs;
+}
+
+__attribute__((export_name("squircle_paths_batch_js")))
+uint32_t
+squircle_paths_batch_js(uint32_t n)
+{
+  if (n > g_batch_cap || !g_batch_specs || !g_batch_ranges)
+    return 0;
+  if (!g_batch_sb.data)
+    sb_init(&g_batch_sb, (size_t)n * 512 + 1);
+  if (!g_batch_sb.data)
+    return 0;
+  g_batch_sb.len = 0;
+  g_batch_sb.oom = 0; // 上一帧扩容失败时缓冲仍完好，本帧重新尝试
+  for (uint32_t i = 0; i < n; ++i)
+  {
+    const double *sp = g_batch_specs + (size_t)i * 4;
+    size_t start = g_batch_sb.len;
+    int shape = (int)sp[0];
+    if (shape == SQUIRCLE_SHAPE_SQUIRCLE)
+      append_path_squircle(&g_batch_sb, sp[1], sp[2], sp[3]);
+    else if (shape == SQUIRCLE_SHAPE_CAPSULE)
+      append_path_capsule(&g_batch_sb, sp[1], sp[2], sp[3]);
+    if (g_batch_sb.oom)
+      return 0;
+    g_batch_ranges[2 + (size_t)i * 2] = (uint32_t)start;
+    g_batch_ranges[3 + (size_t)i * 2] = (uint32_t)(g_batch_sb.len - start);
+  }
+  g_batch_ranges[0] = (uint32_t)(uintptr_t)g_batch_sb.data;
+  g_batch_ranges[1] = (uint32_t)g_batch_sb.len;
+  return (uint32_t)(uintptr_t)g_batch_ranges;
+}
+#endif
+
+#ifdef OKCOLOR_EMBED
+// ---- 原生嵌入接口（见 okcolor.h）----
+size_t okc_shape_path(int shape, double width, double height, double radius, char *out, size_t cap)
+{
+  return shape_path_into(shape, width, height, radius, out, cap);
+}
+
+// 路径生成上下文：持有可复用的输出缓冲，稳态下零分配
+struct okc_path_builder
+{
+  StrBuf sb;
+};
+
+okc_path_builder *okc_path_builder_create(void)
+{
+  okc_path_builder *pb = (okc_path_builder *)malloc(sizeof(okc_path_builder));
+  if (!pb)
+    return NULL;
+  sb_init(&pb->sb, 2048);
+  if (!pb->sb.data)
+  {
+    free(pb);
+    return NULL;
+  }
+  return pb;
+}
+
+void okc_path_builder_destroy(okc_path_builder *pb)
+{
+  if (!pb)
+    return;
+  sb_free(&pb->sb);
+  free(pb);
+}
+
+const char *okc_path_builder_build(okc_path_builder *pb, int shape, double width, double height, double radius,
+                                   size_t *outLen)
+{
+  double spec[4] = {(double)shape, width, height, radius};
+  return okc_path_builder_batch(pb, spec, 1, NULL, outLen);
+}
+
+const char *okc_path_builder_batch(okc_path_builder *pb, const double *specs, size_t n, size_t *ranges,
+                                   size_t *outLen)
+{
+  if (!pb)
+    return NULL;
+  pb->sb.len = 0;
+  pb->sb.oom = 0; // 上次扩容失败时缓冲仍完好，本次重新尝试
+  pb->sb.data[0] = '\0';
+  for (size_t i = 0; i < n; ++i)
+  {
+    const double *sp = specs + i * 4;
+    size_t start = pb->sb.len;
+    int shape = (int)sp[0];
+    if (shape == SQUIRCLE_SHAPE_SQUIRCLE)
+      append_path_squircle(&pb->sb, sp[1], sp[2], sp[3]);
+    else if (shape == SQUIRCLE_SHAPE_CAPSULE)
+      append_path_capsule(&pb->sb, sp[1], sp[2], sp[3]);
+    if (pb->sb.oom)
+      return NULL;
+    if (ranges)
+    {
+      ranges[i * 2] = start;
+      ranges[i * 2 + 1] = pb->sb.len - start;
+    }
+  }
+  if (outLen)
+    *outLen = pb->sb.len;
+  return pb->sb.data;
+}
 #endif
 
+#if !defined(__EMSCRIPTEN__) && !defined(OKCOLOR_EMBED)
 static int ieq(const char *a, const char *b)
 {
   // 不区分大小写比较
@@ -600,12 +802,20 @@ static int ieq(const char *a, const char *b)
 static void print_usage(FILE *out)
 {
   fprintf(out, "Usage: squircle_svg <shape> <width> <height> <radius>\n");
+  fprintf(out, "       squircle_svg --cpu-info\n");
   fprintf(out, "  <shape>: squircle | capsule\n");
   fprintf(out, "  <width>/<height>/<radius>: number\n");
 }
 
 int main(int argc, char **argv)
 {
+  if (argc == 2 && strcmp(argv[1], "--cpu-info") == 0)
+  {
+    // 路径生成以数字格式化与字符串拼接为主，无可向量化的热循环，不做 ISA 分派
+    printf("kernel: baseline\n");
+    printf("features: (no ISA-specific kernels; formatting-bound)\n");
+    return 0;
+  }
   if (argc != 5)
   {
     print_usage(stderr);
@@ -660,3 +870,4 @@ int main(int argc, char **argv)
   free(path);
   return 0;
 }
+#endif
@@ -0,0 +1,163 @@
+// srgb8.h —— 8 位 sRGB 编码量化表与 PAM 读写（仅头文件，oklch2rgb.c / rgb2oklch.c 共用）
+// 线性 -> 8 位编码统一定义为 floor(linear_to_srgb(u) * 255 + 0.5)。量化表在首次使用时按该定义逐 ulp 求出边界，
+// 之后 quantize_srgb8（double 输入）/ quantize_srgb8f（float 输入）只需查表再比较一两次，结果与直接编码逐位一致。
+// 各翻译单元各有一份静态表，由 ensure_srgb8_lut() 一次性建好（线程安全）。
+
+#ifndef OKCOLOR_SRGB8_H
+#define OKCOLOR_SRGB8_H
+
+#include <math.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef __EMSCRIPTEN__
+#include <stdio.h>
+#endif
+
+#ifndef INLINE
+#define INLINE inline __attribute__((always_inline))
+#endif
+
+// sRGB 传递函数（线性 -> 编码），输入先裁剪到 [0, 1]
+static INLINE double linear_to_srgb(double u)
+{
+  if (u <= 0.0)
+    return 0.0;
+  if (u >= 1.0)
+    return 1.0;
+  if (u <= 0.0031308)
+    return 12.92 * u;
+  return 1.055 * pow(u, 1.0 / 2.4) - 0.055;
+}
+
+static inline int encode_srgb8(double u)
+{
+  return (int)floor(linear_to_srgb(u) * 255.0 + 0.5);
+}
+
+// g_srgb8_edge[q]：编码由 q 变为 q+1 的最小线性值；g_srgb8_edgef[q] 为不小于它的最小 float，
+// 故 float 输入与 float 边界比较和按 double 比较结果相同。
+// g_srgb8_cell[i]：线性值落在 [i/CELLS, (i+1)/CELLS) 时编码的下界，之后最多前进一两格。
+// g_srgb8_decode[q]：反方向的 8 位解码（sRGB 与 Display-P3 共用传递函数）。
+#define SRGB8_CELLS 4096
+static atomic_int g_srgb8_lut_state = 0;
+static double g_srgb8_edge[255];
+static float g_srgb8_edgef[255];
+static uint8_t g_srgb8_cell[SRGB8_CELLS];
+static float g_srgb8_decode[256];
+
+static inline void ensure_srgb8_lut(void)
+{
+  if (atomic_load_explicit(&g_srgb8_lut_state, memory_order_acquire) == 2)
+    return;
+  int expected = 0;
+  if (!atomic_compare_exchange_strong_explicit(&g_srgb8_lut_state, &expected, 1, memory_order_acquire,
+                                               memory_order_acquire))
+  {
+    while (atomic_load_explicit(&g_srgb8_lut_state, memory_order_acquire) != 2)
+      ;
+    return;
+  }
+  for (int q = 0; q < 255; ++q)
+  {
+    // 由反变换给出近似边界，再按 ulp 修正到恰好的最小值
+    double t = (q + 0.5) / 255.0;
+    double u = t <= 0.04045 ? t / 12.92 : pow((t + 0.055) / 1.055, 2.4);
+    while (encode_srgb8(u) > q)
+      u = nextafter(u, 0.0);
+    while (encode_srgb8(u) <= q)
+      u = nextafter(u, 2.0);
+    g_srgb8_edge[q] = u;
+    float f = (float)u;
+    g_srgb8_edgef[q] = (double)f < u ? nextafterf(f, 2.0f) : f;
+  }
+  int q = 0;
+  for (int i = 0; i < SRGB8_CELLS; ++i)
+  {
+    double u = (double)i / SRGB8_CELLS;
+    while (q < 255 && u >= g_srgb8_edge[q])
+      q++;
+    g_srgb8_cell[i] = (uint8_t)q;
+  }
+  for (int i = 0; i < 256; ++i)
+  {
+    double t = i / 255.0;
+    g_srgb8_decode[i] = (float)(t <= 0.04045 ? t / 12.92 : pow((t + 0.055) / 1.055, 2.4));
+  }
+  atomic_store_explicit(&g_srgb8_lut_state, 2, memory_order_release);
+}
+
+// 线性值 -> 8 位编码（与 encode_srgb8 一致，但不调用 pow）；调用前需 ensure_srgb8_lut
+static INLINE int quantize_srgb8(double u)
+{
+  if (u <= 0.0)
+    return 0;
+  if (u >= 1.0)
+    return 255;
+  int q = g_srgb8_cell[(int)(u * SRGB8_CELLS)];
+  while (q < 255 && u >= g_srgb8_edge[q])
+    q++;
+  return q;
+}
+
+// 同上，float 输入（全程 float 比较）
+static INLINE uint8_t quantize_srgb8f(float u)
+{
+  if (u <= 0.0f)
+    return 0;
+  if (u >= 1.0f)
+    return 255;
+  int q = g_srgb8_cell[(int)(u * SRGB8_CELLS)];
+  while (q < 255 && u >= g_srgb8_edgef[q])
+    q++;
+  return (uint8_t)q;
+}
+
+#ifndef __EMSCRIPTEN__
+// 读入 PAM（P7，DEPTH 3/4，MAXVAL 255；"-" 为 stdin），返回 malloc 的 RGBA8（DEPTH 3 时 alpha 补 255）；
+// 失败返回 NULL
+static inline uint8_t *read_pam(const char *path, int *width, int *height)
+{
+  FILE *f = strcmp(path, "-") == 0 ? stdin : fopen(path, "rb");
+  if (!f)
+    return NULL;
+  char line[256];
+  int w = 0, h = 0, depth = 0, maxval = 0, ok = fgets(line, sizeof line, f) && strncmp(line, "P7", 2) == 0;
+  while (ok && fgets(line, sizeof line, f) && strncmp(line, "ENDHDR", 6) != 0)
+  {
+    sscanf(line, "WIDTH %d", &w);
+    sscanf(line, "HEIGHT %d", &h);
+    sscanf(line, "DEPTH %d", &depth);
+    sscanf(line, "MAXVAL %d", &maxval);
+  }
+  uint8_t *rgba = NULL;
+  if (ok && w > 0 && h > 0 && (depth == 3 || depth == 4) && maxval == 255 && (size_t)w * h <= ((size_t)1 << 28))
+    rgba = (uint8_t *)malloc((size_t)w * h * 4);
+  if (rgba && fread(rgba, (size_t)depth, (size_t)w * h, f) != (size_t)w * h)
+  {
+    free(rgba);
+    rgba = NULL;
+  }
+  if (f != stdin)
+    fclose(f);
+  if (rgba && depth == 3)
+    for (size_t i = (size_t)w * h; i-- > 0;)
+    {
+      memmove(rgba + i * 4, rgba + i * 3, 3);
+      rgba[i * 4 + 3] = 255;
+    }
+  *width = w;
+  *height = h;
+  return rgba;
+}
+
+// RGBA 图像以 PAM（P7, RGB_ALPHA）写到 stdout
+static inline void write_pam(const uint8_t *rgba, int width, int height)
+{
+  printf("P7\nWIDTH %d\nHEIGHT %d\nDEPTH 4\nMAXVAL 255\nTUPLTYPE RGB_ALPHA\nENDHDR\n", width, height);
+  fwrite(rgba, 4, (size_t)width * height, stdout);
+}
+#endif
+
+#endif // OKCOLOR_SRGB8_H
@@ -1,11 +1,20 @@
 // 可复用的 WASM 加载与取色工具（浏览器端 ESM）
 // API 对齐 Namide/extract-colors：默认导出 extractColors，另导出 initExtractColorsWasm
+// 以及内存管理：getWasmMemoryStats（当前/峰值线性内存）、releaseExtractColorsMemory（长驻页面释放大图缓冲）
 
 // ---- 内部状态 ----
 let extractExports = null; // wasm 导出对象
 let extractMemory = null;  // WebAssembly.Memory
 let _wasmPromise = null;   // 单例加载承诺
 
+// 结果缓冲布局（需与 extract-colors.c 的 ExtractOut 保持一致）
+const OUT_MAX_COLORS = 64;
+const OUT_NUMS_LEN = 1 + 8 * OUT_MAX_COLORS;
+
+// 超过该字节数的输入走分块喂入：只拷贝被采样的行，按行带送入 Wasm，避免整图常驻线性内存
+const STREAM_THRESHOLD_BYTES = 32 * 1024 * 1024;
+const STREAM_BAND_BYTES = 4 * 1024 * 1024;
+
 // 复用一个 Canvas/Context，避免频繁创建
 let _sharedCanvas = null;
 function getSharedCanvas() {
@@ -23,7 +32,7 @@ function getShared2DContext() {
 }
 
 // 顶层 env 资源，供可能的 env.memory 导入复用
-const ENV_MEMORY = new WebAssembly.Memory({ initial: 256, maximum: 2048 });
+const ENV_MEMORY = new WebAssembly.Memory({ initial: 256, maximum: 65536 }); // 最大 4 GB（wasm32 上限）
 const ENV_TABLE = new WebAssembly.Table({ initial: 0, element: 'anyfunc' });
 
 async function instantiateWasmWithFallback(asset) {
@@ -123,26 +132,8 @@ export default async function extractColors(input, opts) {
 
   const { width, height, data } = imageData;
   const hasCustomValidator = typeof (opts && opts.colorValidator) === 'function';
+  const validator = hasCustomValidator ? opts.colorValidator : null;
   const len = data.byteLength >>> 0;
-  const ptr = extractExports.get_pixels_buffer(len) >>> 0;
-  if (!ptr) throw new Error('get_pixels_buffer 失败');
-  const heapU8 = new Uint8Array(extractMemory.buffer, ptr, len);
-  if (hasCustomValidator) {
-    const validator = opts.colorValidator;
-    for (let i = 0; i < len; i += 4) {
-      const r = data[i];
-      const g = data[i + 1];
-      const b = data[i + 2];
-      const a = data[i + 3];
-      if (!validator(r, g, b, a)) {
-        heapU8[i] = r; heapU8[i + 1] = g; heapU8[i + 2] = b; heapU8[i + 3] = 0;
-      } else {
-        heapU8[i] = r; heapU8[i + 1] = g; heapU8[i + 2] = b; heapU8[i + 3] = a;
-      }
-    }
-  } else {
-    heapU8.set(data);
-  }
 
   const pixels = Math.max(1, Math.floor((opts && opts.pixels) ?? 64000));
   const distance = clamp01((opts && opts.distance) ?? 0.22);
@@ -150,48 +141,108 @@ export default async function extractColors(input, opts) {
   const lightDist = clamp01((opts && opts.lightnessDistance) ?? 0.2);
   const hueDist = clamp01((opts && opts.hueDistance) ?? 1 / 12);
   const alphaThreshold = hasCustomValidator ? 1 : 250;
-  const maxColors = 64;
-
-  const outPtr = extractExports.extract_colors_from_rgba_js(
-    ptr,
-    width | 0,
-    height | 0,
-    pixels | 0,
-    +distance,
-    +satDist,
-    +lightDist,
-    +hueDist,
-    alphaThreshold | 0,
-    maxColors | 0
-  ) >>> 0;
+  const maxColors = OUT_MAX_COLORS;
+
+  let outPtr = 0;
+  if (len > STREAM_THRESHOLD_BYTES) {
+    // 大图：仅拷贝 y % step == 0 的行，按行带分块喂入
+    const step = extractExports.extract_stream_begin_js(width | 0, height | 0, pixels | 0, alphaThreshold | 0) | 0;
+    if (step <= 0) throw new Error('extract_stream_begin_js 失败');
+    const rowBytes = width * 4;
+    const bandRows = Math.max(1, Math.floor(STREAM_BAND_BYTES / rowBytes));
+    const ptr = extractExports.get_pixels_buffer(bandRows * rowBytes) >>> 0;
+    if (!ptr) throw new Error('get_pixels_buffer 失败');
+    let rows = 0;
+    const heapU8 = new Uint8Array(extractMemory.buffer, ptr, bandRows * rowBytes);
+    for (let y = 0; y < height; y += step) {
+      const src = data.subarray(y * rowBytes, (y + 1) * rowBytes);
+      copyRgba(heapU8.subarray(rows * rowBytes, (rows + 1) * rowBytes), src, validator);
+      if (++rows === bandRows) {
+        extractExports.extract_stream_feed_js(ptr, rows);
+        rows = 0;
+      }
+    }
+    if (rows > 0) extractExports.extract_stream_feed_js(ptr, rows);
+    outPtr = extractExports.extract_stream_finish_js(+distance, +satDist, +lightDist, +hueDist, maxColors | 0) >>> 0;
+  } else {
+    const ptr = extractExports.get_pixels_buffer(len) >>> 0;
+    if (!ptr) throw new Error('get_pixels_buffer 失败');
+    // 注意：get_pixels_buffer 可能触发内存增长，视图需在其后创建
+    const heapU8 = new Uint8Array(extractMemory.buffer, ptr, len);
+    copyRgba(heapU8, data, validator);
+    outPtr = extractExports.extract_colors_from_rgba_js(
+      ptr,
+      width | 0,
+      height | 0,
+      pixels | 0,
+      +distance,
+      +satDist,
+      +lightDist,
+      +hueDist,
+      alphaThreshold | 0,
+      maxColors | 0
+    ) >>> 0;
+  }
   if (!outPtr) throw new Error('extract_colors_from_rgba_js 失败');
 
-  const f64 = new Float64Array(extractMemory.buffer, outPtr, 1 + 8 * 64);
-  const m = Math.max(0, Math.min(64, Math.floor(f64[0])));
-  const out = [];
+  // 固定布局：[M, 64×8 个 double][64×8 字节 hex]；C 端已完成排序与 hex 编码
+  const f64 = new Float64Array(extractMemory.buffer, outPtr, OUT_NUMS_LEN);
+  const hexU8 = new Uint8Array(extractMemory.buffer, outPtr + OUT_NUMS_LEN * 8, OUT_MAX_COLORS * 8);
+  const m = Math.max(0, Math.min(OUT_MAX_COLORS, f64[0] | 0));
+  const out = new Array(m);
   for (let i = 0; i < m; i++) {
     const base = 1 + i * 8;
-    const red = Math.round(f64[base + 0]);
-    const green = Math.round(f64[base + 1]);
-    const blue = Math.round(f64[base + 2]);
-    const hue = f64[base + 3];
-    const intensity = f64[base + 4];
-    const lightness = f64[base + 5];
-    const saturation = f64[base + 6];
-    const area = f64[base + 7];
-    const hex = `#${[red, green, blue].map(v => v.toString(16).padStart(2, '0')).join('')}`;
+    const o = i * 8;
+    const hex = String.fromCharCode(hexU8[o], hexU8[o + 1], hexU8[o + 2], hexU8[o + 3], hexU8[o + 4], hexU8[o + 5], hexU8[o + 6]);
     // 保持与 TS 版本一致的字段顺序
-    out.push({ hex, red, green, blue, area, hue, saturation, lightness, intensity });
+    out[i] = {
+      hex,
+      red: f64[base + 0],
+      green: f64[base + 1],
+      blue: f64[base + 2],
+      area: f64[base + 7],
+      hue: f64[base + 3],
+      saturation: f64[base + 6],
+      lightness: f64[base + 5],
+      intensity: f64[base + 4],
+    };
   }
-  out.sort((a, b) => {
-    const bPower = (b.intensity + 0.1) * (0.9 - b.area);
-    const aPower = (a.intensity + 0.1) * (0.9 - a.area);
-    return bPower - aPower;
-  });
   return out;
 }
 
+/**
+ * Wasm 内存计数（字节）：{ current, peak, pixelsBuffer, pixelsBufferPeak }
+ */
+export async function getWasmMemoryStats() {
+  await ensureWasmReady();
+  const f64 = new Float64Array(extractMemory.buffer, extractExports.wasm_memory_stats_js() >>> 0, 4);
+  return { current: f64[0], peak: f64[1], pixelsBuffer: f64[2], pixelsBufferPeak: f64[3] };
+}
+
+/**
+ * 释放（或收缩到 keepBytes）像素缓冲。线性内存不会缩小，但空间可被后续分配复用。
+ */
+export async function releaseExtractColorsMemory(keepBytes = 0) {
+  await ensureWasmReady();
+  extractExports.release_pixels_buffer(Math.max(0, Math.floor(keepBytes)) >>> 0);
+}
+
 // ---- 辅助函数 ----
+function copyRgba(dst, src, validator) {
+  if (!validator) {
+    dst.set(src);
+    return;
+  }
+  const len = dst.length;
+  for (let i = 0; i < len; i += 4) {
+    const r = src[i];
+    const g = src[i + 1];
+    const b = src[i + 2];
+    const a = src[i + 3];
+    dst[i] = r; dst[i + 1] = g; dst[i + 2] = b;
+    dst[i + 3] = validator(r, g, b, a) ? a : 0;
+  }
+}
 function isImageData(x) {
   return x && typeof x === 'object' && typeof x.width === 'number' && typeof x.height === 'number' && x.data instanceof Uint8ClampedArray;
 }
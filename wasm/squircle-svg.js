@@ -3,6 +3,10 @@
 //   getPath(shape, width, height, radius) => Promise<string>
 //   getSquircle(width, height, radius) => Promise<string>
 //   getCapsule(width, height, radius) => Promise<string>
+//   init(options) => Promise<void>                       —— 预加载，之后可使用同步批量接口
+//   getPathsSync(items) => string[]                      —— 一次 Wasm 调用生成多条路径
+//   getPathRangesSync(items) => { bytes, ranges }        —— 同上，返回字节范围（零拷贝视图）
+//   items: [[shape, width, height, radius], ...] 或 [{ shape, width, height, radius }, ...]
 
 function createWasiStub(memory) {
   function ret0() { return 0; }
@@ -70,12 +74,18 @@ async function ensureReady(options = {}) {
   return _initPromise;
 }
 
+const _decoder = new TextDecoder();
+
 function readCString(ptr) {
   ptr = ptr >>> 0;
   const u8 = new Uint8Array(_mem.buffer);
   let end = ptr;
   while (end < u8.length && u8[end] !== 0) end++;
-  return new TextDecoder().decode(u8.subarray(ptr, end));
+  return _decoder.decode(u8.subarray(ptr, end));
+}
+
+export async function init(options) {
+  await ensureReady(options);
 }
 
 export async function getSquircle(width, height, radius, options) {
@@ -98,3 +108,56 @@ export async function getPath(shape, width, height, radius, options) {
   if (s === 'capsule') return getCapsule(width, height, radius, options);
   throw new Error('Unknown shape: ' + shape);
 }
+
+// ---- 同步批量接口（需先 await init()） ----
+// shape 编码需与 squircle_svg.c 的 SQUIRCLE_SHAPE_* 保持一致
+const SHAPE_CODES = { squircle: 0, capsule: 1 };
+
+function runBatch(items) {
+  if (!_ready) throw new Error('squircle-svg 未初始化，请先 await init()');
+  const n = items.length >>> 0;
+  const specPtr = _inst.squircle_batch_specs_js(n) >>> 0;
+  if (!specPtr) throw new Error('squircle_batch_specs_js returned 0');
+  const specs = new Float64Array(_mem.buffer, specPtr, n * 4);
+  for (let i = 0; i < n; i++) {
+    const it = items[i];
+    const isArr = Array.isArray(it);
+    const shape = isArr ? it[0] : it.shape;
+    const code = SHAPE_CODES[String(shape).toLowerCase()];
+    if (code === undefined) throw new Error('Unknown shape: ' + shape);
+    const o = i * 4;
+    specs[o] = code;
+    specs[o + 1] = +(isArr ? it[1] : it.width);
+    specs[o + 2] = +(isArr ? it[2] : it.height);
+    specs[o + 3] = +(isArr ? it[3] : it.radius);
+  }
+  const tabPtr = _inst.squircle_paths_batch_js(n) >>> 0;
+  if (!tabPtr) throw new Error('squircle_paths_batch_js returned 0');
+  // 注意：生成过程中内存可能增长，视图需在调用之后再创建
+  const tab = new Uint32Array(_mem.buffer, tabPtr, 2 + n * 2);
+  const bytes = new Uint8Array(_mem.buffer, tab[0], tab[1]);
+  return { bytes, ranges: tab.subarray(2) };
+}
+
+/**
+ * 批量生成路径，返回字节范围：bytes 为 Wasm 内存视图，ranges 为 [off0, len0, off1, len1, ...]。
+ * 视图在下一次批量调用前有效；适合直接写入其他缓冲或自行解码。
+ */
+export function getPathRangesSync(items) {
+  return runBatch(items);
+}
+
+/**
+ * 批量生成路径字符串：整体只解码一次，再按范围切片（路径为纯 ASCII，字节偏移即字符偏移）。
+ */
+export function getPathsSync(items) {
+  const { bytes, ranges } = runBatch(items);
+  const all = _decoder.decode(bytes);
+  const n = ranges.length >>> 1;
+  const out = new Array(n);
+  for (let i = 0; i < n; i++) {
+    const off = ranges[i * 2];
+    out[i] = all.substring(off, off + ranges[i * 2 + 1]);
+  }
+  return out;
+}